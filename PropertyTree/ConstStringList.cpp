@@ -8,23 +8,112 @@
  */
 
 #include "ConstStringList.h"
-#include <algorithm>
+#include <string.h>
 #include "yasli/STL.h"
 #include "yasli/Archive.h"
 
 ConstStringList globalConstStringList;
 
+static const size_t CONST_STRING_BLOCK_SIZE = 16384;
+
+ConstStringList::ConstStringList()
+: entries_(64)
+, count_(0)
+, blockPos_(0)
+, blockLeft_(0)
+, allocated_(0)
+{
+	for(size_t i = 0; i < entries_.size(); ++i)
+		entries_[i].string = 0;
+}
+
+ConstStringList::~ConstStringList()
+{
+	for(size_t i = 0; i < blocks_.size(); ++i)
+		delete[] blocks_[i];
+}
+
 const char* ConstStringList::findOrAdd(const char* string)
 {
-	// TODO: try sorted vector of const char*
-	Strings::iterator it = std::find(strings_.begin(), strings_.end(), string);
-	if(it == strings_.end()){
-		strings_.push_back(string);
-		return strings_.back().c_str();
+	// FNV-1a
+	unsigned int hash = 2166136261u;
+	const char* end = string;
+	for(; *end; ++end)
+		hash = (hash ^ (unsigned char)*end) * 16777619u;
+	size_t length = end - string;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	size_t mask = entries_.size() - 1;
+	size_t index = hash & mask;
+	while(entries_[index].string){
+		const Entry& entry = entries_[index];
+		if(entry.hash == hash && strcmp(entry.string, string) == 0)
+			return entry.string;
+		index = (index + 1) & mask;
+	}
+
+	Entry& entry = entries_[index];
+	entry.hash = hash;
+	entry.string = allocate(string, length);
+	const char* result = entry.string;
+	if(++count_ * 2 > entries_.size())
+		grow();
+	return result;
+}
+
+size_t ConstStringList::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return count_;
+}
+
+size_t ConstStringList::memoryUsed() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return allocated_ + entries_.size() * sizeof(Entry) + blocks_.size() * sizeof(char*);
+}
+
+const char* ConstStringList::allocate(const char* string, size_t length)
+{
+	size_t size = length + 1;
+	char* result;
+	if(size > CONST_STRING_BLOCK_SIZE / 4){
+		// long strings get their own block, so current one is not wasted
+		result = new char[size];
+		blocks_.push_back(result);
+		allocated_ += size;
 	}
 	else{
-		return it->c_str();
+		if(size > blockLeft_){
+			blockPos_ = new char[CONST_STRING_BLOCK_SIZE];
+			blockLeft_ = CONST_STRING_BLOCK_SIZE;
+			blocks_.push_back(blockPos_);
+			allocated_ += CONST_STRING_BLOCK_SIZE;
+		}
+		result = blockPos_;
+		blockPos_ += size;
+		blockLeft_ -= size;
+	}
+	memcpy(result, string, size);
+	return result;
+}
+
+void ConstStringList::grow()
+{
+	std::vector<Entry> entries(entries_.size() * 2);
+	for(size_t i = 0; i < entries.size(); ++i)
+		entries[i].string = 0;
+	size_t mask = entries.size() - 1;
+	for(size_t i = 0; i < entries_.size(); ++i){
+		const Entry& entry = entries_[i];
+		if(!entry.string)
+			continue;
+		size_t index = entry.hash & mask;
+		while(entries[index].string)
+			index = (index + 1) & mask;
+		entries[index] = entry;
 	}
+	entries_.swap(entries);
 }
 
 
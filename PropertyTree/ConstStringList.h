@@ -9,7 +9,8 @@
 
 #pragma once
 
-#include <list>
+#include <vector>
+#include <mutex>
 #include "yasli/Config.h"
 
 class ConstStringWrapper;
@@ -18,12 +19,37 @@ namespace yasli { class Archive; }
 
 bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, ConstStringWrapper &wrapper, const char* name, const char* label);
 
+// Interns strings referenced by PropertyRows: returned pointers stay valid
+// until the list is destroyed. Lookup is done through open-addressing hash
+// set, strings are stored in arena blocks. All methods are thread-safe, so
+// one list can be shared by several PropertyTreeModels.
 class ConstStringList{
 public:
+	ConstStringList();
+	~ConstStringList();
+
 	const char* findOrAdd(const char* string);
+	size_t size() const;
+	size_t memoryUsed() const;
 protected:
-	typedef std::list<yasli::string> Strings;
-	Strings strings_;
+	struct Entry{
+		unsigned int hash;
+		const char* string;
+	};
+
+	const char* allocate(const char* string, size_t length);
+	void grow();
+
+	std::vector<Entry> entries_;
+	size_t count_;
+	std::vector<char*> blocks_;
+	char* blockPos_;
+	size_t blockLeft_;
+	size_t allocated_;
+	mutable std::mutex mutex_;
+
+	ConstStringList(const ConstStringList&);
+	ConstStringList& operator=(const ConstStringList&);
 };
 
 class ConstStringWrapper{
@@ -26,6 +26,7 @@ PropertyIArchive::PropertyIArchive(PropertyTreeModel* model, PropertyRow* root)
 , currentNode_(0)
 , lastNode_(0)
 , root_(root)
+, skipUnchanged_(false)
 {
 	stack_.push_back(Level());
 
@@ -213,12 +214,20 @@ bool PropertyIArchive::operator()(yasli::ContainerInterface& ser, const char* na
 	const char* typeName = ser.containerType().name();
 	if(!openRow(name, label, typeName))
         return false;
+	if(skipUnchanged_ && !currentNode_->dirty()){
+		closeRow(name);
+		return true;
+	}
 
     size_t size = 0;
+	bool skipUnchanged = skipUnchanged_;
 	if(currentNode_->multiValue())
 		size = ser.size();
 	else{
 		size = currentNode_->count();
+		// elements that were inserted or removed shift the rest
+		if(size != ser.size())
+			skipUnchanged_ = false;
 		size = ser.resize(size);
 	}
 
@@ -234,6 +243,7 @@ bool PropertyIArchive::operator()(yasli::ContainerInterface& ser, const char* na
         }
 
 	stack_.pop_back();
+	skipUnchanged_ = skipUnchanged;
 
     closeRow(name);
 	return true;
@@ -250,6 +260,10 @@ bool PropertyIArchive::operator()(const yasli::Serializer& ser, const char* name
 				return true;
 			}
 		}
+		else if(skipUnchanged_ && !currentNode_->dirty()){
+			closeRow(name);
+			return true;
+		}
 		else
 			nonLeaf = currentNode_;
     }
@@ -285,6 +299,10 @@ bool PropertyIArchive::operator()(yasli::PointerInterface& ser, const char* name
 			closeRow(name);
 			return false;
 		}
+		if(skipUnchanged_ && !row->dirty()){
+			closeRow(name);
+			return true;
+		}
 		row->assignTo(ser);
 	}
 	else
@@ -21,6 +21,10 @@ class PropertyTreeModel;
 class PropertyIArchive : public yasli::Archive{
 public:
 	PropertyIArchive(PropertyTreeModel* model, PropertyRow* root = 0);
+	// Skips structs, containers and pointers whose rows are not dirty, i.e.
+	// were not changed since the last apply, see PropertyTreeModel::setRowDirty.
+	// operator() returns true for them, so objects keep their current values.
+	void setSkipUnchanged(bool skipUnchanged) { skipUnchanged_ = skipUnchanged; }
 
 	bool operator()(yasli::StringInterface& value, const char* name, const char* label) override;
 	bool operator()(yasli::WStringInterface& value, const char* name, const char* label) override;
@@ -64,5 +68,6 @@ private:
 	PropertyRow* currentNode_;
 	PropertyRow* lastNode_;
 	PropertyRow* root_;
+	bool skipUnchanged_;
 };
 
@@ -36,6 +36,7 @@ PropertyOArchive::PropertyOArchive(PropertyTreeModel* model, PropertyRow* root)
 , lastNode_(0)
 , updateMode_(false)
 , defaultValueCreationMode_(false)
+, skipUnchanged_(false)
 , rootNode_(root)
 {
 	stack_.push_back(Level());
@@ -51,6 +52,7 @@ PropertyOArchive::PropertyOArchive(PropertyTreeModel* model, bool forDefaultType
 , lastNode_(0)
 , updateMode_(false)
 , defaultValueCreationMode_(forDefaultType)
+, skipUnchanged_(false)
 , rootNode_(0)
 {
 	rootNode_ = new PropertyRow();
@@ -77,6 +79,33 @@ PropertyRow* PropertyOArchive::defaultValueRootNode()
 	return rootNode_->childByIndex(0);
 }
 
+void PropertyOArchive::checkContained(const void* address, size_t size)
+{
+	Level& level = stack_.back();
+	const char* p = (const char*)address;
+	if(level.selfContained && (p < level.begin || p + size > level.end))
+		level.selfContained = false;
+}
+
+unsigned int PropertyOArchive::contentHash(const yasli::Serializer& ser) const
+{
+	// FNV-1a over filter, address and bytes of the struct
+	unsigned int hash = 2166136261u;
+	int filter = getFilter();
+	void* pointer = ser.pointer();
+	const unsigned char* p = (const unsigned char*)&filter;
+	for(size_t i = 0; i < sizeof(filter); ++i)
+		hash = (hash ^ p[i]) * 16777619u;
+	p = (const unsigned char*)&pointer;
+	for(size_t i = 0; i < sizeof(pointer); ++i)
+		hash = (hash ^ p[i]) * 16777619u;
+	p = (const unsigned char*)pointer;
+	size_t size = ser.size();
+	for(size_t i = 0; i < size; ++i)
+		hash = (hash ^ p[i]) * 16777619u;
+	return hash;
+}
+
 void PropertyOArchive::enterNode(PropertyRow* row, bool isBlock)
 {
 	currentNode_ = row;
@@ -122,8 +151,12 @@ RowType* PropertyOArchive::updateRow(const char* name, const char* label, const
 	else{
 		Level& level = stack_.back();
 		int rowIndex;
-		PropertyRow* oldRow = currentNode_->findFromIndex(&rowIndex, name, typeName, level.rowIndex, !isBlock);
+		PropertyRow* oldRow = 0;
+		if(isBlock || level.updatedCount < int(currentNode_->count()))
+			oldRow = currentNode_->findFromIndex(&rowIndex, name, typeName, level.rowIndex, !isBlock);
 		if(oldRow){
+			if(!oldRow->updated_)
+				++level.updatedCount;
 			oldRow->setMultiValue(false);
 			newRow = static_cast<RowType*>(oldRow);
 			level.rowIndex = rowIndex + 1;
@@ -140,6 +173,7 @@ RowType* PropertyOArchive::updateRow(const char* name, const char* label, const
 		
 			newRow->setNames(name, label, typeName);
 			currentNode_->insertAfterUpdated(newRow, level.realIndex);
+			++level.updatedCount;
 
 			// for new rows we should mark all parents with labelChanged_
 			newRow->setLabelChanged();
@@ -179,7 +213,10 @@ PropertyRow* PropertyOArchive::updateRowPrimitive(const char* name, const char*
 
 	int rowIndex;
 	Level& level = stack_.back();
-	PropertyRow* oldRow = currentNode_->findFromIndex(&rowIndex, name, typeName, level.rowIndex, true);
+	PropertyRow* oldRow = 0;
+	if(level.updatedCount < int(currentNode_->count()))
+		oldRow = currentNode_->findFromIndex(&rowIndex, name, typeName, level.rowIndex, true);
+	++level.updatedCount;
 	if(oldRow){
 		oldRow->setMultiValue(false);
 		newRow.reset(static_cast<RowType*>(oldRow));
@@ -213,14 +250,27 @@ bool PropertyOArchive::operator()(const yasli::Serializer& ser, const char* name
 	PropertyRow* row = updateRow<PropertyRow>(name, label, typeName, ser);
 	PropertyRow* nonLeaf = 0;
 	if(!row->isLeaf() || currentNode_ == 0){
+		if(skipUnchanged_ && updateMode_ && ser && row->matchContentHash(contentHash(ser))){
+			row->setUpdateSkipped(true);
+			checkContained(ser.pointer(), size);
+			lastNode_ = row;
+			return true;
+		}
+
 		enterNode(row);
 
 		if(currentNode_->isLeaf())
 			return false;
 		else
 			nonLeaf = currentNode_;
+
+		Level& level = stack_.back();
+		level.begin = (const char*)ser.pointer();
+		level.end = level.begin + size;
+		level.selfContained = skipUnchanged_ && ser;
 	}
 	else{
+		checkContained(ser.pointer(), size);
 		lastNode_ = row;
 		return true;
 	}
@@ -231,7 +281,13 @@ bool PropertyOArchive::operator()(const yasli::Serializer& ser, const char* name
 	if (nonLeaf)
 		nonLeaf->closeNonLeaf(ser);
 
+	bool selfContained = stack_.back().selfContained;
+	nonLeaf->setContentHash(selfContained ? contentHash(ser) : 0, selfContained);
     closeStruct(name);
+	if(selfContained)
+		checkContained(ser.pointer(), size);
+	else
+		setNotContained();
 	return true;
 }
 
@@ -251,24 +307,28 @@ std::string escape(const char* str)
 
 bool PropertyOArchive::operator()(yasli::StringInterface& value, const char* name, const char* label)
 {
+	setNotContained();
 	lastNode_ = updateRowPrimitive<PropertyRowString>(name, label, "string", escape(value.get()).c_str());
 	return true;
 }
 
 bool PropertyOArchive::operator()(yasli::WStringInterface& value, const char* name, const char* label)
 {
+	setNotContained();
 	lastNode_ = updateRowPrimitive<PropertyRowString>(name, label, "string", value.get());
 	return true;
 }
 
 bool PropertyOArchive::operator()(bool& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowBool>(name, label, "bool", value);
 	return true;
 }
 
 bool PropertyOArchive::operator()(char& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<char> >(name, label, "char", value);
 	return true;
 }
@@ -277,24 +337,28 @@ bool PropertyOArchive::operator()(char& value, const char* name, const char* lab
 
 bool PropertyOArchive::operator()(yasli::i8& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<yasli::i8> >(name, label, "int8", value);
 	return true;
 }
 
 bool PropertyOArchive::operator()(yasli::i16& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<yasli::i16> >(name, label, "int16", value);
 	return true;
 }
 
 bool PropertyOArchive::operator()(yasli::i32& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<yasli::i32> >(name, label, "int32", value);
 	return true;
 }
 
 bool PropertyOArchive::operator()(yasli::i64& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<yasli::i64> >(name, label, "int64", value);
 	return true;
 }
@@ -303,24 +367,28 @@ bool PropertyOArchive::operator()(yasli::i64& value, const char* name, const cha
 
 bool PropertyOArchive::operator()(yasli::u8& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<yasli::u8> >(name, label, "uint8", value);
 	return true;
 }
 
 bool PropertyOArchive::operator()(yasli::u16& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<yasli::u16> >(name, label, "uint16", value);
 	return true;
 }
 
 bool PropertyOArchive::operator()(yasli::u32& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<yasli::u32> >(name, label, "uint32", value);
 	return true;
 }
 
 bool PropertyOArchive::operator()(yasli::u64& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<yasli::u64> >(name, label, "uint64", value);
 	return true;
 }
@@ -329,12 +397,14 @@ bool PropertyOArchive::operator()(yasli::u64& value, const char* name, const cha
 
 bool PropertyOArchive::operator()(float& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<float> >(name, label, "float", value);
 	return true;
 }
 
 bool PropertyOArchive::operator()(double& value, const char* name, const char* label)
 {
+	checkContained(&value, sizeof(value));
 	lastNode_ = updateRowPrimitive<PropertyRowNumber<double> >(name, label, "double", value);
 	return true;
 }
@@ -344,8 +414,18 @@ bool PropertyOArchive::operator()(yasli::ContainerInterface& ser, const char *na
 {
 	const char* elementTypeName = ser.elementType().name();
 	bool fixedSizeContainer = ser.isFixedSize();
+	// elements of fixed size arrays are stored inline, the rest is on the heap
+	Level parentLevel = stack_.back();
+	if(!fixedSizeContainer)
+		setNotContained();
 	lastNode_ = currentNode_;
 	enterNode(updateRow<PropertyRowContainer>(name, label, ser.containerType().name(), ser));
+	if(fixedSizeContainer){
+		Level& level = stack_.back();
+		level.begin = parentLevel.begin;
+		level.end = parentLevel.end;
+		level.selfContained = parentLevel.selfContained;
+	}
 
 	if (!model_->defaultTypeRegistered(elementTypeName)) {
 		PropertyOArchive ar(model_, true);
@@ -364,12 +444,16 @@ bool PropertyOArchive::operator()(yasli::ContainerInterface& ser, const char *na
 		}
 	currentNode_->eraseOld();
 	currentNode_->labelChanged();
+	bool selfContained = stack_.back().selfContained;
 	closeStruct(name);
+	if(!selfContained)
+		setNotContained();
 	return true;
 }
 
 bool PropertyOArchive::operator()(yasli::PointerInterface& ptr, const char *name, const char *label)
 {
+	setNotContained();
 	lastNode_ = currentNode_;
 	PropertyRow* row = updateRow<PropertyRowPointer>(name, label, ptr.baseType().name(), ptr);
 	enterNode(row);
@@ -422,6 +506,7 @@ bool PropertyOArchive::operator()(yasli::PointerInterface& ptr, const char *name
 bool PropertyOArchive::operator()(yasli::Object& obj, const char *name, const char *label)
 {
 	const char* typeName = obj.type().name();
+	setNotContained();
 
 	PropertyRowObject* row = 0;
 	if (typeName_.empty())
@@ -436,13 +521,22 @@ bool PropertyOArchive::openBlock(const char* name, const char* label)
 {
 	PropertyRow* row = updateRow<PropertyRow>(name, label, "block", Serializer(), true);
 	lastNode_ = currentNode_;
+	Level parentLevel = stack_.back();
 	enterNode(row, true);
+	// block fields belong to the enclosing struct
+	Level& level = stack_.back();
+	level.begin = parentLevel.begin;
+	level.end = parentLevel.end;
+	level.selfContained = parentLevel.selfContained;
 	return true;
 }
 
 void PropertyOArchive::closeBlock()
 {
+	bool selfContained = stack_.back().selfContained;
 	closeStruct("block", true);
+	if(!selfContained)
+		setNotContained();
 }
 
 // vim:ts=4 sw=4:
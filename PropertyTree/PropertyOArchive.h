@@ -23,6 +23,10 @@ public:
 	~PropertyOArchive();
 	
 	void finalize();
+	// In update mode skips structs whose bytes are the same as during previous
+	// update. Children of skipped rows are kept as they are. Applies only to
+	// structs that consist of primitive fields stored within the struct itself.
+	void setSkipUnchanged(bool skipUnchanged) { skipUnchanged_ = skipUnchanged; }
 
 	bool operator()(yasli::StringInterface& value, const char* name, const char* label) override;
 	bool operator()(yasli::WStringInterface& value, const char* name, const char* label) override;
@@ -57,10 +61,20 @@ private:
 	struct Level {
 		int rowIndex;
 		int realIndex;
-		Level(int realIndex = 0) : rowIndex(0), realIndex(realIndex) {}
+		// number of children marked as updated, lets skip search when all of them are
+		int updatedCount;
+		// memory range of the struct being serialized, for setSkipUnchanged
+		const char* begin;
+		const char* end;
+		bool selfContained;
+		Level(int realIndex = 0) : rowIndex(0), realIndex(realIndex), updatedCount(realIndex), begin(0), end(0), selfContained(false) {}
 	};
 	std::vector<Level> stack_;
 
+	void checkContained(const void* address, size_t size);
+	void setNotContained() { stack_.back().selfContained = false; }
+	unsigned int contentHash(const yasli::Serializer& ser) const;
+
 	template<class RowType, class ValueType>
 	PropertyRow* updateRowPrimitive(const char* name, const char* label, const char* typeName, const ValueType& value);
 
@@ -73,6 +87,7 @@ private:
 
 	bool updateMode_;
 	bool defaultValueCreationMode_;
+	bool skipUnchanged_;
 	PropertyTreeModel* model_;
 	SharedPtr<PropertyRow> currentNode_;
 	SharedPtr<PropertyRow> lastNode_;
@@ -52,6 +52,8 @@ ConstStringList* PropertyRow::constStrings_ = 0;
 PropertyRow::PropertyRow()
 {
 	parent_ = 0;
+	childIndex_ = 0;
+	layoutIndex_ = 0;
 
 	expanded_ = false;
 	selected_ = false;
@@ -66,6 +68,7 @@ PropertyRow::PropertyRow()
 	textPos_ = 0;
 	textSizeInitial_ = 0;
 	textHash_ = 0;
+	contentHash_ = 0;
 	textSize_ = 0;
 	widgetPos_ = 0;
     widgetSize_ = 0;
@@ -73,6 +76,7 @@ PropertyRow::PropertyRow()
 	
 	name_ = "";
 	typeName_ = "";
+	nameHash_ = calculateNameHash(name_, typeName_);
 	
 	pulledUp_ = false;
 	pulledBefore_ = false;
@@ -83,18 +87,32 @@ PropertyRow::PropertyRow()
 	multiValue_ = false;
 	userHideChildren_ = false;
 	updated_ = false;
+	updateSkipped_ = false;
+	contentHashValid_ = false;
+	lazyLayout_ = false;
+	dirty_ = false;
 	
 	label_ = "";
 	labelChanged_ = true;
 	layoutChanged_ = true;
 }
 
+PropertyRow::PropertyRow(const PropertyRow& original)
+: PropertyRow()
+{
+	name_ = original.name_;
+	label_ = original.label_;
+	typeName_ = original.typeName_;
+	nameHash_ = original.nameHash_;
+}
+
 PropertyRow::~PropertyRow()
 {
 	size_t count = children_.size();
 	for (size_t i = 0; i < count; ++i)
 		if (children_[i]->parent() == this)
 			children_[i]->setParent(0);
+	invalidateChildIndex();
 }
 
 void PropertyRow::setNames(const char* name, const char* label, const char* typeName)
@@ -104,6 +122,14 @@ void PropertyRow::setNames(const char* name, const char* label, const char* type
 	label_ = label ? label : "";
 	YASLI_ASSERT(strlen(typeName));
 	typeName_ = typeName;
+	updateNameHash();
+	if(parent_)
+		parent_->invalidateChildIndex();
+}
+
+unsigned int PropertyRow::calculateNameHash(const char* name, const char* typeName)
+{
+	return calcHash(typeName, calcHash(name));
 }
 
 PropertyRow* PropertyRow::childByIndex(int index)
@@ -181,33 +207,44 @@ void PropertyRow::add(PropertyRow* row)
 {
 	children_.push_back(row);
 	row->setParent(this);
+	appendToChildIndex(int(children_.size()) - 1);
 }
 
 void PropertyRow::insertAfterUpdated(PropertyRow* row, int index)
 {
 	row->setParent(this);
-	if(!index){
+	if(!index && !children_.empty()){
+		invalidateChildIndex();
 		children_.insert(children_.begin(), row);
 		return;
 	}
-	for(Rows::iterator i = children_.begin(); i != children_.end(); ++i)
-		if((*i)->updated_)
-			if(!--index){
-				children_.insert(i + 1, row);
-				return;
-			}
+	// there can't be more than size() updated rows, so row goes to the end
+	if(index < int(children_.size())){
+		for(Rows::iterator i = children_.begin(); i != children_.end(); ++i)
+			if((*i)->updated_)
+				if(!--index){
+					if(i + 1 == children_.end())
+						break;
+					invalidateChildIndex();
+					children_.insert(i + 1, row);
+					return;
+				}
+	}
 	children_.push_back(row);
+	appendToChildIndex(int(children_.size()) - 1);
 }
 
 void PropertyRow::addAfter(PropertyRow* row, PropertyRow* after)
 {
 	iterator it = std::find(children_.begin(), children_.end(), after);
-	if(it != children_.end()){
+	if(it != children_.end() && it + 1 != children_.end()){
 		++it;
+		invalidateChildIndex();
 		children_.insert(it, row);
 	}
 	else{
 		children_.push_back(row);
+		appendToChildIndex(int(children_.size()) - 1);
 	}
 
 	row->setParent(this);
@@ -259,6 +296,7 @@ void PropertyRow::replaceAndPreserveState(PropertyRow* oldRow, PropertyRow* newR
 	Rows::iterator it = std::find(children_.begin(), children_.end(), oldRow);
 	YASLI_ASSERT(it != children_.end());
 	if(it != children_.end()){
+		invalidateChildIndex();
 		newRow->assignRowProperties(*it);
 		newRow->labelChanged_ = true;
 		if(preserveChildren)
@@ -272,12 +310,16 @@ void PropertyRow::erase(PropertyRow* row)
 	row->setParent(0);
 	Rows::iterator it = std::find(children_.begin(), children_.end(), row);
 	YASLI_ASSERT(it != children_.end());
-	if(it != children_.end())
+	if(it != children_.end()){
+		invalidateChildIndex();
 		children_.erase(it);
+	}
 }
 
 void PropertyRow::swapChildren(PropertyRow* row)
 {
+	invalidateChildIndex();
+	row->invalidateChildIndex();
 	children_.swap(row->children_);
 	iterator it;
 	for( it = children_.begin(); it != children_.end(); ++it)
@@ -289,8 +331,10 @@ void PropertyRow::swapChildren(PropertyRow* row)
 void PropertyRow::eraseOld()
 {
 	for(Rows::iterator i = children_.begin(); i != children_.end();)
-		if(!(*i)->updated_)
+		if(!(*i)->updated_){
+			invalidateChildIndex();
 			i = children_.erase(i);
+		}
 		else
 			++i;
 }
@@ -298,9 +342,16 @@ void PropertyRow::eraseOld()
 void PropertyRow::eraseOldRecursive()
 {
 	updated_ = false;
+	if(updateSkipped_){
+		// children were not visited by PropertyOArchive, they are still valid
+		updateSkipped_ = false;
+		return;
+	}
 	for(Rows::iterator i = children_.begin(); i != children_.end();)
-		if(!(*i)->updated_)
+		if(!(*i)->updated_){
+			invalidateChildIndex();
 			i = children_.erase(i);
+		}
 		else{
 			(*i)->eraseOldRecursive();
 			++i;
@@ -319,14 +370,14 @@ std::size_t PropertyRow::countUpdated() const
 
 void PropertyRow::addBefore(PropertyRow* row, PropertyRow* before)
 {
-	if(before == 0)
-		children_.push_back(row);
+	iterator it = before ? std::find(children_.begin(), children_.end(), before) : children_.end();
+	if(it != children_.end()){
+		invalidateChildIndex();
+		children_.insert(it, row);
+	}
 	else{
-		iterator it = std::find(children_.begin(), children_.end(), before);
-		if(it != children_.end())
-			children_.insert(it, row);
-		else
-			children_.push_back(row);
+		children_.push_back(row);
+		appendToChildIndex(int(children_.size()) - 1);
 	}
 	row->setParent(this);
 }
@@ -341,32 +392,354 @@ yasli::string PropertyRow::valueAsString() const
 	return yasli::string();
 }
 
+// Most rows of a tree share a handful of names, so interned pointers are
+// remembered by source pointer in a small direct-mapped table.
+struct PropertyRow::CloneContext
+{
+	enum { CACHE_SIZE = 256 };
+
+	ConstStringList* constStrings;
+	const char* sources[CACHE_SIZE];
+	const char* interned[CACHE_SIZE];
+
+	explicit CloneContext(ConstStringList* list)
+	: constStrings(list ? list : &globalConstStringList)
+	, allocated(0)
+	{
+		memset(sources, 0, sizeof(sources));
+		memset(interned, 0, sizeof(interned));
+	}
+
+	const char* intern(const char* str)
+	{
+		if(!str)
+			return 0;
+		size_t slot = (size_t(str) >> 3) & (CACHE_SIZE - 1);
+		if(sources[slot] != str){
+			sources[slot] = str;
+			interned[slot] = constStrings->findOrAdd(str);
+		}
+		return interned[slot];
+	}
+
+	// copy of the row without children
+	PropertyRow* copy(const PropertyRow& row, bool copyState)
+	{
+		PropertyRow* result = row.cloneRow(constStrings);
+		YASLI_ASSERT(yasli::ClassFactory<PropertyRow>::the().getTypeID(result) == yasli::ClassFactory<PropertyRow>::the().getTypeID(const_cast<PropertyRow*>(&row)) &&
+					 "cloneRow is not overriden in derived row type");
+		result->name_ = intern(row.name_);
+		result->label_ = intern(row.label_);
+		result->typeName_ = intern(row.typeName_);
+		result->nameHash_ = row.nameHash_;
+		if(copyState){
+			result->expanded_ = row.expanded_;
+			result->selected_ = row.selected_;
+		}
+		result->children_.reserve(row.children_.size());
+		allocated += result->memoryUsed();
+		return result;
+	}
+
+	size_t allocated;
+
+	// Failed sameTree leaves number of equal children for each row on the
+	// path to the difference, deepest row first, so that cloneSharedRecursive
+	// of the same rows doesn't compare them again.
+	struct SameChildren
+	{
+		const PropertyRow* row;
+		const PropertyRow* previous;
+		size_t count;
+	};
+	std::vector<SameChildren> sameChildren;
+
+	// number of children of row known to be equal to ones of previous, -1 if
+	// the rows weren't compared
+	int popSameChildren(const PropertyRow* row, const PropertyRow* previous)
+	{
+		if(sameChildren.empty() || sameChildren.back().row != row || sameChildren.back().previous != previous)
+			return -1;
+		int result = int(sameChildren.back().count);
+		sameChildren.pop_back();
+		return result;
+	}
+};
+
+PropertyRow* PropertyRow::cloneRecursive(CloneContext& context) const
+{
+	PropertyRow* result = context.copy(*this, false);
+	size_t count = children_.size();
+	for(size_t i = 0; i < count; ++i){
+		if(!children_[i])
+			continue;
+		PropertyRow* child = children_[i]->cloneRecursive(context);
+		child->parent_ = result;
+		result->children_.push_back(child);
+	}
+	return result;
+}
+
 SharedPtr<PropertyRow> PropertyRow::clone(ConstStringList* constStrings) const
 {
-	PropertyRow::setConstStrings(constStrings);
+	CloneContext context(constStrings);
+	return cloneRecursive(context);
+}
+
+static bool sameString(const char* a, const char* b)
+{
+	return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+bool PropertyRow::sameRow(const PropertyRow& row) const
+{
+	if(nameHash_ != row.nameHash_ || expanded_ != row.expanded_ || selected_ != row.selected_)
+		return false;
+	if(!sameString(name_, row.name_) || !sameString(label_, row.label_) || !sameString(typeName_, row.typeName_))
+		return false;
+	yasli::ClassFactory<PropertyRow>& factory = yasli::ClassFactory<PropertyRow>::the();
+	if(factory.getTypeID(const_cast<PropertyRow*>(this)) != factory.getTypeID(const_cast<PropertyRow*>(&row)))
+		return false;
+	return sameValue(row);
+}
+
+bool PropertyRow::sameTree(const PropertyRow& row, CloneContext* context) const
+{
+	size_t count = children_.size();
+	if(count != row.children_.size() || !sameRow(row))
+		return false;
+	for(size_t i = 0; i < count; ++i){
+		if(!children_[i] || !children_[i]->sameTree(*row.children_[i], context)){
+			if(context){
+				CloneContext::SameChildren same = { this, &row, i };
+				context->sameChildren.push_back(same);
+			}
+			return false;
+		}
+	}
+	return true;
+}
+
+static PropertyRow* childAt(PropertyRow* row, int index)
+{
+	if(!row || index < 0 || index >= int(row->count()))
+		return 0;
+	return row->childByIndex(index);
+}
+
+PropertyRow* PropertyRow::cloneSharedRecursive(PropertyRow* previous, CloneContext& context) const
+{
+	// Row is copied only when it or one of its children differs from previous
+	// one, children before the first difference are taken from previous row.
+	PropertyRow* result = 0;
+	// children before sameCount are equal to children of previous and the one
+	// at sameCount differs, when sameTree has compared these rows already
+	int sameCount = context.popSameChildren(this, previous);
+	if(sameCount < 0 && (!previous || !sameRow(*previous)))
+		result = context.copy(*this, true);
+
+	size_t count = children_.size();
+	size_t previousCount = previous ? previous->children_.size() : 0;
+	// shift between indices of equal children, as after insertion or removal
+	// of container elements
+	int offset = 0;
+	for(size_t i = 0; i < count; ++i){
+		PropertyRow* child = 0;
+		bool copied = false;
+		if(const PropertyRow* source = children_[i]){
+			PropertyRow* candidate = childAt(previous, int(i) + offset);
+			if(int(i) < sameCount)
+				child = candidate;
+			else if(candidate && int(i) != sameCount && source->sameTree(*candidate, &context))
+				child = candidate;
+			else if(PropertyRow* next = childAt(previous, int(i) + offset + 1)){
+				if(source->sameTree(*next, 0)){
+					child = next;
+					++offset;
+				}
+			}
+			if(!child){
+				PropertyRow* prior = childAt(previous, int(i) + offset - 1);
+				if(prior && source->sameTree(*prior, 0)){
+					child = prior;
+					--offset;
+				}
+				else{
+					child = source->cloneSharedRecursive(candidate, context);
+					copied = true;
+				}
+			}
+		}
+
+		if(!result){
+			if(child && i < previousCount && child == previous->children_[i])
+				continue;
+			result = context.copy(*this, true);
+			result->children_.insert(result->children_.end(), previous->children_.begin(), previous->children_.begin() + i);
+		}
+		if(!child)
+			continue;
+		if(copied)
+			child->parent_ = result;
+		result->children_.push_back(child);
+	}
+
+	if(!result){
+		if(count == previousCount)
+			return previous;
+		result = context.copy(*this, true);
+		result->children_.insert(result->children_.end(), previous->children_.begin(), previous->children_.begin() + count);
+	}
+	return result;
+}
+
+SharedPtr<PropertyRow> PropertyRow::cloneShared(PropertyRow* previous, ConstStringList* constStrings, size_t* allocatedBytes) const
+{
+	CloneContext context(constStrings);
+	SharedPtr<PropertyRow> result = cloneSharedRecursive(previous, context);
+	if(allocatedBytes)
+		*allocatedBytes += context.allocated;
+	return result;
+}
+
+namespace {
+
+struct RowValueSerializer
+{
+	PropertyRow* row;
+	void YASLI_SERIALIZE_METHOD(yasli::Archive& ar) { row->serializeValue(ar); }
+};
+
+}
+
+PropertyRow* PropertyRow::cloneRow(ConstStringList* constStrings) const
+{
+	yasli::ClassFactory<PropertyRow>& factory = yasli::ClassFactory<PropertyRow>::the();
+	TypeID type = factory.getTypeID(const_cast<PropertyRow*>(this));
+	if(type == TypeID::get<PropertyRow>())
+		return new PropertyRow(*this);
+
+	// derived row that doesn't implement cloneRow: value is passed through BinArchive
+	PropertyRow* result = factory.create(type);
+	YASLI_ESCAPE(result != 0, return new PropertyRow(*this));
+	result->name_ = name_;
+	result->label_ = label_;
+	result->typeName_ = typeName_;
+	result->nameHash_ = nameHash_;
+
+	yasli::BinOArchive oa;
+	RowValueSerializer source = { const_cast<PropertyRow*>(this) };
+	oa(source, "value", "Value");
+	yasli::BinIArchive ia;
+	ia.open(oa);
+	yasli::Context constStringsContext(ia, constStrings);
+	RowValueSerializer destination = { result };
+	ia(destination, "value", "Value");
+	return result;
+}
+
+bool PropertyRow::sameValue(const PropertyRow& row) const
+{
+	yasli::ClassFactory<PropertyRow>& factory = yasli::ClassFactory<PropertyRow>::the();
+	if(factory.getTypeID(const_cast<PropertyRow*>(this)) == TypeID::get<PropertyRow>())
+		return true;
+
+	// derived row that doesn't implement sameValue: serialized values are compared
+	yasli::BinOArchive oa;
+	RowValueSerializer value = { const_cast<PropertyRow*>(this) };
+	oa(value, "value", "Value");
+	yasli::BinOArchive rowOA;
+	RowValueSerializer rowValue = { const_cast<PropertyRow*>(&row) };
+	rowOA(rowValue, "value", "Value");
+	return oa.length() == rowOA.length() && memcmp(oa.buffer(), rowOA.buffer(), oa.length()) == 0;
+}
+
+size_t PropertyRow::memoryUsed() const
+{
+	size_t size = yasli::ClassFactory<PropertyRow>::the().sizeOf(yasli::ClassFactory<PropertyRow>::the().getTypeID(const_cast<PropertyRow*>(this)));
+	if(size == 0)
+		size = sizeof(PropertyRow);
+	return size + children_.capacity() * sizeof(children_[0]);
+}
+
+SharedPtr<PropertyRow> PropertyRow::cloneSerialized(ConstStringList* constStrings) const
+{
 	yasli::BinOArchive oa;
 	SharedPtr<PropertyRow> self(const_cast<PropertyRow*>(this));
 	oa(self, "row", "Row");
 
 	yasli::BinIArchive ia;
 	ia.open(oa);
+	yasli::Context constStringsContext(ia, constStrings);
 	SharedPtr<PropertyRow> clonedRow;
 	ia(clonedRow, "row", "Row");
-	PropertyRow::setConstStrings(0);
 	return clonedRow;
 }
 
+// Children as a container of archives, in the format of std::vector, so rows
+// are read and written in place.
+class RowArrayContainer : public yasli::ContainerInterface
+{
+public:
+	explicit RowArrayContainer(PropertyRow::Rows* rows) : rows_(rows), index_(0) {}
+
+	size_t size() const{ return rows_->size(); }
+	size_t resize(size_t size){
+		rows_->resize(size);
+		index_ = 0;
+		return size;
+	}
+
+	void* pointer() const{ return reinterpret_cast<void*>(rows_); }
+	yasli::TypeID elementType() const{ return yasli::TypeID::get<SharedPtr<PropertyRow> >(); }
+	yasli::TypeID containerType() const{ return yasli::TypeID::get<vector<SharedPtr<PropertyRow> > >(); }
+
+	bool next(){
+		YASLI_ESCAPE(index_ < rows_->size(), return false);
+		return ++index_ < rows_->size();
+	}
+	void* elementPointer() const{ return &(*rows_)[index_]; }
+
+	bool operator()(Archive& ar, const char* name, const char* label){
+		if(index_ == rows_->size())
+			rows_->push_back(SharedPtr<PropertyRow>());
+		return ar((*rows_)[index_], name, label);
+	}
+	operator bool() const{ return rows_ != 0; }
+	void serializeNewElement(Archive& ar, const char* name, const char* label) const{
+		SharedPtr<PropertyRow> row;
+		ar(row, name, label);
+	}
+
+private:
+	PropertyRow::Rows* rows_;
+	size_t index_;
+};
+
+ConstStringList* PropertyRow::constStrings(Archive& ar)
+{
+	if(ConstStringList* list = ar.context<ConstStringList>())
+		return list;
+	return constStrings_;
+}
+
 void PropertyRow::YASLI_SERIALIZE_METHOD(Archive& ar)
 {
 	serializeValue(ar);
 
-	ar(ConstStringWrapper(constStrings_, name_), "name", "name");
-	ar(ConstStringWrapper(constStrings_, label_), "label", "label");
-	ar(ConstStringWrapper(constStrings_, typeName_), "type", "type");
-	ar(reinterpret_cast<std::vector<SharedPtr<PropertyRow> >&>(children_), "children", "!^children");	
+	ConstStringList* list = constStrings(ar);
+	ar(ConstStringWrapper(list, name_), "name", "name");
+	ar(ConstStringWrapper(list, label_), "label", "label");
+	ar(ConstStringWrapper(list, typeName_), "type", "type");
+	if(ar.isInput())
+		invalidateChildIndex();
+	RowArrayContainer children(&children_);
+	ar(static_cast<yasli::ContainerInterface&>(children), "children", "!^children");
 	if(ar.isInput()){
 		labelChanged_ = true;
 		layoutChanged_ = true;
+		contentHashValid_ = false;
+		updateNameHash();
 		PropertyRow::iterator it;
 		for(it = begin(); it != end(); ){
 			PropertyRow* row = *it;
@@ -412,7 +785,9 @@ void PropertyRow::setLayoutChangedToChildren()
 	size_t numChildren = children_.size();
 	for (size_t i = 0; i < numChildren; ++i) {
 		children_[i]->layoutChanged_ = true;
-		children_[i]->setLayoutChangedToChildren();
+		// lazily laid out elements are relaid with all of their children
+		if (!lazyLayout_)
+			children_[i]->setLayoutChangedToChildren();
 	}
 }
 
@@ -426,6 +801,111 @@ void PropertyRow::setLabel(const char* label)
 	}
 }
 
+// Containers with at least this many elements lay them out lazily.
+static const int LAZY_LAYOUT_MIN_SIZE = 128;
+
+// Heights of element subtrees (element row with its expanded children) kept in
+// Fenwick tree: offset of any element, element at given offset and change of
+// element height take logarithmic time.
+struct PropertyRow::LayoutIndex
+{
+	std::vector<int> heights;
+	// one-based, sums[i] covers heights (i - (i & -i), i]
+	std::vector<int> sums;
+	int total;
+	// position of the first element and elements placed by last layout pass
+	int top;
+	int placedBegin;
+	int placedEnd;
+	// heights of changed elements have to be estimated again
+	bool refresh;
+
+	LayoutIndex() : total(0), top(0), placedBegin(0), placedEnd(0), refresh(true) {}
+
+	int size() const { return int(heights.size()); }
+
+	void build()
+	{
+		int count = size();
+		sums.assign(count + 1, 0);
+		total = 0;
+		for (int i = 1; i <= count; ++i) {
+			sums[i] += heights[i - 1];
+			total += heights[i - 1];
+			int next = i + (i & -i);
+			if (next <= count)
+				sums[next] += sums[i];
+		}
+	}
+
+	void set(int index, int height)
+	{
+		int delta = height - heights[index];
+		if (delta == 0)
+			return;
+		heights[index] = height;
+		total += delta;
+		int count = size();
+		for (int i = index + 1; i <= count; i += i & -i)
+			sums[i] += delta;
+	}
+
+	// sum of heights of first count elements
+	int offset(int count) const
+	{
+		int result = 0;
+		for (int i = count; i > 0; i -= i & -i)
+			result += sums[i];
+		return result;
+	}
+
+	// element that covers given offset, size() when it is past the last one
+	int find(int offset) const
+	{
+		if (offset < 0)
+			return 0;
+		int count = size();
+		int step = 1;
+		while (step * 2 <= count)
+			step *= 2;
+		int index = 0;
+		for (; step > 0; step /= 2) {
+			if (index + step <= count && sums[index + step] <= offset) {
+				index += step;
+				offset -= sums[index];
+			}
+		}
+		return index;
+	}
+};
+
+void PropertyRow::destroyLayoutIndex() const
+{
+	delete layoutIndex_;
+	layoutIndex_ = 0;
+}
+
+PropertyRow::LayoutIndex& PropertyRow::updateLayoutIndex(const PropertyTree* tree)
+{
+	int numChildren = (int)children_.size();
+	bool rebuild = !layoutIndex_ || layoutIndex_->size() != numChildren;
+	if (!layoutIndex_)
+		layoutIndex_ = new LayoutIndex();
+	LayoutIndex& index = *layoutIndex_;
+	if (rebuild)
+		index.heights.resize(numChildren);
+	if (rebuild || index.refresh) {
+		for (int i = 0; i < numChildren; ++i) {
+			const PropertyRow* row = children_[i];
+			if (rebuild || row->labelChanged_ || row->layoutChanged_)
+				index.heights[i] = row->visible(tree) ? row->layoutHeight(tree) : 0;
+		}
+		index.build();
+		index.refresh = false;
+	}
+	return index;
+}
+
 void PropertyRow::updateLabel(const PropertyTree* tree, int index)
 {
 	if (!labelChanged_) {
@@ -437,12 +917,23 @@ void PropertyRow::updateLabel(const PropertyTree* tree, int index)
 	hasPulled_ = false;
 
 	int numChildren = (int)children_.size();
-	for (int i = 0; i < numChildren; ++i) {
-		PropertyRow* row = children_[i];
-		row->updateLabel(tree, i);
+	// labels of elements of large containers are parsed when they get near
+	// visible area, see adjustElementPositions
+	lazyLayout_ = false;
+	if (isContainer() && numChildren >= LAZY_LAYOUT_MIN_SIZE) {
+		parseControlCodes(label_, true);
+		// codes in brackets are applied to children after their own ones
+		lazyLayout_ = !userHideChildren_ && !memchr(label_, '[', labelUndecorated_ - label_);
 	}
 
-	parseControlCodes(label_, true);
+	if (!lazyLayout_) {
+		for (int i = 0; i < numChildren; ++i) {
+			PropertyRow* row = children_[i];
+			row->updateLabel(tree, i);
+		}
+
+		parseControlCodes(label_, true);
+	}
 	visible_ = *labelUndecorated_ != '\0' || userFullRow_ || pulledUp_ || isRoot();
 	if (userHideChildren_) {
 		for (int i = 0; i < numChildren; ++i) {
@@ -705,24 +1196,35 @@ void PropertyRow::calculateMinimalSize(const PropertyTree* tree, int posX, bool
 
 	size_.setX(textSize_ + widgetSize_);
 
-	for (int i = 0; i < numChildren; ++i) {
-		PropertyRow* row = children_[i];
-		if(!row->visible(tree)) {
-			DEBUG_TRACE_ROW("skipping invisible child: %s", row->label());
-			continue;
+	if (lazyLayout_) {
+		// elements are laid out in adjustElementPositions
+		if (force) {
+			for (int i = 0; i < numChildren; ++i)
+				children_[i]->layoutChanged_ = true;
 		}
-		if(row->pulledUp()){
-			if(!row->pulledBefore()){
-				if(!widgetPos_)
-					widgetPos_ = posX;
-				row->calculateMinimalSize(tree, posX, force, &extraSize, i);
-				posX += row->size_.x();
+		if (layoutIndex_)
+			layoutIndex_->refresh = true;
+	}
+	else {
+		for (int i = 0; i < numChildren; ++i) {
+			PropertyRow* row = children_[i];
+			if(!row->visible(tree)) {
+				DEBUG_TRACE_ROW("skipping invisible child: %s", row->label());
+				continue;
 			}
-			size_.setX(size_.x() + row->size_.x());
-			size_.setY(max(size_.y(), row->size_.y()));
+			if(row->pulledUp()){
+				if(!row->pulledBefore()){
+					if(!widgetPos_)
+						widgetPos_ = posX;
+					row->calculateMinimalSize(tree, posX, force, &extraSize, i);
+					posX += row->size_.x();
+				}
+				size_.setX(size_.x() + row->size_.x());
+				size_.setY(max(size_.y(), row->size_.y()));
+			}
+			else if(expanded())
+				row->calculateMinimalSize(tree, nonPulled->plusRect(tree).right(), force, &extraSize, i);
 		}
-		else if(expanded())
-			row->calculateMinimalSize(tree, nonPulled->plusRect(tree).right(), force, &extraSize, i);
 	}
 
 	if (widgetPlace == WIDGET_AFTER_PULLED)
@@ -747,8 +1249,15 @@ void PropertyRow::adjustVerticalPosition(const PropertyTree* tree, int& totalHei
 
 	DEBUG_TRACE_ROW("adjustRect: %s %i %i %i %i, totalHeight: %i %s", label(), pos_.x(), pos_.y(), size_.x(), size_.y(), totalHeight, pulledUp() ? "pulled" : "");
 
+	if (lazyLayout_) {
+		adjustElementPositions(tree, totalHeight, (expanded_ || hasPulled_) && nonPulled->expanded());
+		return;
+	}
+	if (layoutIndex_)
+		destroyLayoutIndex();
+
 	if (expanded_ || hasPulled_) {
-		for(PropertyRows::iterator it = children_.begin(); it != children_.end(); ++it){
+		for(Rows::iterator it = children_.begin(); it != children_.end(); ++it){
 			PropertyRow* row = *it;
 			if(row->visible(tree) && (nonPulled->expanded() || row->pulledUp()))
 				row->adjustVerticalPosition(tree, totalHeight);
@@ -756,6 +1265,113 @@ void PropertyRow::adjustVerticalPosition(const PropertyTree* tree, int& totalHei
 	}
 }
 
+// Elements that are near visible area get their labels parsed, are laid out
+// and positioned, the rest are accounted with their heights from layout index.
+void PropertyRow::adjustElementPositions(const PropertyTree* tree, int& totalHeight, bool expanded)
+{
+	if (!expanded) {
+		if (layoutIndex_)
+			layoutIndex_->placedBegin = layoutIndex_->placedEnd = 0;
+		return;
+	}
+
+	LayoutIndex& index = updateLayoutIndex(tree);
+	int rangeTop, rangeBottom;
+	tree->_layoutRange(&rangeTop, &rangeBottom);
+
+	int numChildren = index.size();
+	int posX = nonPulledParent()->plusRect(tree).right();
+	int i = index.find(rangeTop - totalHeight);
+	int y = totalHeight + index.offset(i);
+	index.top = totalHeight;
+	index.placedBegin = i;
+	for (; i < numChildren && y < rangeBottom; ++i) {
+		PropertyRow* row = children_[i];
+		if (row->labelChanged_ || row->layoutChanged_) {
+			row->updateLabel(tree, i);
+			row->calculateMinimalSize(tree, posX, true, 0, i);
+		}
+		int height = 0;
+		if (row->visible(tree)) {
+			int bottom = y;
+			row->adjustVerticalPosition(tree, bottom);
+			height = bottom - y;
+		}
+		index.set(i, height);
+		y += height;
+	}
+	index.placedEnd = i;
+	totalHeight += index.total;
+}
+
+int PropertyRow::layoutHeight(const PropertyTree* tree) const
+{
+	const PropertyRow* nonPulled = this;
+	while (nonPulled->pulledUp())
+		nonPulled = nonPulled->parent();
+
+	int result = 0;
+	bool expanded = expanded_;
+	if (pulledUp())
+		expanded = parent()->expanded();
+	else
+		result = size_.y() >= 0 ? size_.y() : tree->_defaultRowHeight() + floorHeight();
+
+	if (!expanded && !hasPulled_)
+		return result;
+	if (lazyLayout_ && layoutIndex_ && layoutIndex_->size() == int(children_.size()))
+		return nonPulled->expanded() ? result + layoutIndex_->total : result;
+
+	for (Rows::const_iterator it = children_.begin(); it != children_.end(); ++it) {
+		const PropertyRow* row = *it;
+		if (row->visible(tree) && (nonPulled->expanded() || row->pulledUp()))
+			result += row->layoutHeight(tree);
+	}
+	return result;
+}
+
+void PropertyRow::placedChildren(int* begin, int* end) const
+{
+	int numChildren = int(children_.size());
+	if (layoutIndex_) {
+		*begin = min(layoutIndex_->placedBegin, numChildren);
+		*end = min(layoutIndex_->placedEnd, numChildren);
+	}
+	else {
+		*begin = 0;
+		*end = numChildren;
+	}
+}
+
+bool PropertyRow::placed() const
+{
+	for (const PropertyRow* row = this; row->parent_; row = row->parent_) {
+		const PropertyRow* parent = row->parent_;
+		if (!parent->layoutIndex_)
+			continue;
+		int begin, end;
+		parent->placedChildren(&begin, &end);
+		if (std::find(parent->children_.begin() + begin, parent->children_.begin() + end, row) == parent->children_.begin() + end)
+			return false;
+	}
+	return true;
+}
+
+int PropertyRow::estimatedTop() const
+{
+	int result = pos_.y();
+	for (const PropertyRow* row = this; row->parent_; row = row->parent_) {
+		const PropertyRow* parent = row->parent_;
+		const LayoutIndex* index = parent->layoutIndex_;
+		if (!index)
+			continue;
+		int i = int(std::find(parent->children_.begin(), parent->children_.end(), row) - parent->children_.begin());
+		if ((i < index->placedBegin || i >= index->placedEnd) && i < index->size())
+			result = index->top + index->offset(i);
+	}
+	return result;
+}
+
 void PropertyRow::setTextSize(const PropertyTree* tree, int index, float mult)
 {
 	updateTextSizeInitial(tree, index);
@@ -802,35 +1418,153 @@ PropertyRow* PropertyRow::findSelected()
 
 PropertyRow* PropertyRow::find(const char* name, const char* typeName)
 {
+	if(typeName){
+		int index;
+		return findFromIndex(&index, name, typeName, 0);
+	}
+
 	iterator it;
 	for(it = children_.begin(); it != children_.end(); ++it){
 		PropertyRow* row = *it;
-		if((row->name() == name || strcmp(row->name(), name) == 0) &&
-		   (typeName == 0 || (row->typeName() != 0 && strcmp(row->typeName(), typeName) == 0)))
+		if(row->name() == name || strcmp(row->name(), name) == 0)
 			return row;
 	}
 	return 0;
 }
 
+static const int CHILD_INDEX_MIN_SIZE = 16;
+
+struct PropertyRow::ChildIndex
+{
+	// first and last child with the same name and type, open addressing
+	struct Slot
+	{
+		int head;
+		int tail;
+	};
+	std::vector<Slot> slots;
+	// next child with the same name and type, -1 for the last one
+	std::vector<int> next;
+	int usedSlots;
+};
+
+static bool matchNames(const PropertyRow* row, const char* name, const char* typeName)
+{
+	return (row->name() == name || strcmp(row->name(), name) == 0) && (row->typeName() == typeName || strcmp(row->typeName(), typeName) == 0);
+}
+
+void PropertyRow::destroyChildIndex() const
+{
+	delete childIndex_;
+	childIndex_ = 0;
+}
+
+void PropertyRow::buildChildIndex() const
+{
+	invalidateChildIndex();
+	int numChildren = (int)children_.size();
+	size_t numSlots = 32;
+	while(numSlots < size_t(numChildren) * 2)
+		numSlots *= 2;
+	childIndex_ = new ChildIndex();
+	ChildIndex::Slot emptySlot = { -1, -1 };
+	childIndex_->slots.resize(numSlots, emptySlot);
+	childIndex_->next.reserve(numSlots / 2);
+	childIndex_->usedSlots = 0;
+	for (int i = 0; i < numChildren; ++i)
+		appendToChildIndex(i);
+}
+
+void PropertyRow::appendToChildIndex(int index) const
+{
+	if(!childIndex_)
+		return;
+	ChildIndex& childIndex = *childIndex_;
+	if(int(childIndex.next.size()) != index || size_t(childIndex.usedSlots + 1) * 2 > childIndex.slots.size()){
+		buildChildIndex();
+		return;
+	}
+
+	const PropertyRow* row = children_[index];
+	size_t mask = childIndex.slots.size() - 1;
+	childIndex.next.push_back(-1);
+	for(size_t slot = row->nameHash_ & mask; ; slot = (slot + 1) & mask){
+		ChildIndex::Slot& s = childIndex.slots[slot];
+		if(s.head < 0){
+			s.head = index;
+			s.tail = index;
+			++childIndex.usedSlots;
+			return;
+		}
+		const PropertyRow* head = children_[s.head];
+		if(head->nameHash_ == row->nameHash_ && matchNames(head, row->name_, row->typeName_)){
+			childIndex.next[s.tail] = index;
+			s.tail = index;
+			return;
+		}
+	}
+}
+
 PropertyRow* PropertyRow::findFromIndex(int* outIndex, const char* name, const char* typeName, int startIndex, bool checkUpdated) const
 {
 	int numChildren = (int)children_.size();
 
-	for (int i = startIndex; i < numChildren; ++i) {
-		PropertyRow* row = children_[i];
-		if((row->name() == name || strcmp(row->name(), name) == 0) && (row->typeName() == typeName || strcmp(row->typeName(), typeName) == 0) && (!checkUpdated || !row->updated_)){
-			*outIndex = i;
+	// rows are usually serialized in the same order, so the hinted row is tried first
+	if (startIndex >= 0 && startIndex < numChildren) {
+		PropertyRow* row = children_[startIndex];
+		if(matchNames(row, name, typeName) && (!checkUpdated || !row->updated_)){
+			*outIndex = startIndex;
 			return row;
 		}
 	}
 
-	startIndex = min(startIndex, numChildren);
-	for (int i = 0; i < startIndex; ++i) {
-		PropertyRow* row = children_[i];
-		if((row->name() == name || strcmp(row->name(), name) == 0) && (row->typeName() == typeName || strcmp(row->typeName(), typeName) == 0) && (!checkUpdated || !row->updated_)){
-			*outIndex = i;
-			return row;
+	unsigned int nameHash = calculateNameHash(name, typeName);
+	if (numChildren < CHILD_INDEX_MIN_SIZE) {
+		for (int i = startIndex + 1; i < numChildren; ++i) {
+			PropertyRow* row = children_[i];
+			if(row->nameHash_ == nameHash && matchNames(row, name, typeName) && (!checkUpdated || !row->updated_)){
+				*outIndex = i;
+				return row;
+			}
+		}
+
+		startIndex = min(startIndex, numChildren);
+		for (int i = 0; i < startIndex; ++i) {
+			PropertyRow* row = children_[i];
+			if(row->nameHash_ == nameHash && matchNames(row, name, typeName) && (!checkUpdated || !row->updated_)){
+				*outIndex = i;
+				return row;
+			}
+		}
+
+		*outIndex = -1;
+		return 0;
+	}
+
+	if (!childIndex_)
+		buildChildIndex();
+	const ChildIndex& childIndex = *childIndex_;
+	size_t mask = childIndex.slots.size() - 1;
+	for (size_t slot = nameHash & mask; childIndex.slots[slot].head >= 0; slot = (slot + 1) & mask) {
+		int head = childIndex.slots[slot].head;
+		const PropertyRow* headRow = children_[head];
+		if (headRow->nameHash_ != nameHash || !matchNames(headRow, name, typeName))
+			continue;
+		// same order as sequential search: first match after startIndex, then wrap around
+		int wrapped = -1;
+		for (int i = head; i >= 0; i = childIndex.next[i]) {
+			PropertyRow* row = children_[i];
+			if (checkUpdated && row->updated_)
+				continue;
+			if (i > startIndex) {
+				*outIndex = i;
+				return row;
+			}
+			if (wrapped < 0 && i != startIndex)
+				wrapped = i;
 		}
+		*outIndex = wrapped;
+		return wrapped >= 0 ? children_[wrapped].get() : 0;
 	}
 
 	*outIndex = -1;
@@ -958,7 +1692,7 @@ void PropertyRow::drawRow(IDrawContext& context, const PropertyTree* tree, int i
 			// drawing a selection rectangle
 			context.drawSelection(selectionRect, false);
 		}
-		else{
+		else if (hasPulled_) {
 			bool pulledChildrenSelected = false;
 
 			for (size_t i = 0; i < children_.size(); ++i) {
@@ -1089,7 +1823,13 @@ void PropertyRow::dropInto(PropertyRow* parentRow, PropertyRow* cursorRow, Prope
 
 void PropertyRow::intersect(const PropertyRow* row)
 {
-	setMultiValue(multiValue() || row->multiValue() || valueAsString() != row->valueAsString());
+	// Rows are matched by name and type name, so they are of the same class and
+	// can be compared natively (containers show their size). Strings are
+	// compared only when values differ, as different values may look the same.
+	if(!multiValue()){
+		bool same = sameValue(*row) && children_.size() == row->children_.size();
+		setMultiValue(row->multiValue() || (!same && valueAsString() != row->valueAsString()));
+	}
 
 
 	int indexSource = 0;
@@ -1099,6 +1839,7 @@ void PropertyRow::intersect(const PropertyRow* row)
 		PropertyRow* matchingRow = row->findFromIndex(&indexSource, testRow->name_, testRow->typeName_, indexSource);
 		++indexSource;
 		if (matchingRow == 0) {
+			invalidateChildIndex();
 			children_.erase(children_.begin() + i);
 			--i;
 		}	
@@ -1151,15 +1892,29 @@ PropertyRow* PropertyRow::hit(const PropertyTree* tree, Point point)
     if(isContainer() && pulledUp())
         expanded = parent() ? parent()->expanded() : true;
     bool onlyPulled = !expanded;
-    PropertyRow::const_iterator it;
-    for(it = children_.begin(); it != children_.end(); ++it){
-        PropertyRow* child = *it;
-		if (!child->visible(tree))
-			continue;
-        if(!onlyPulled || child->pulledUp())
-            if(PropertyRow* result = child->hit(tree, point))
-                return result;
-    }
+	if(layoutIndex_){
+		// elements of large containers have no pulled rows, element subtrees are stacked
+		int begin, end;
+		placedChildren(&begin, &end);
+		int index = layoutIndex_->find(point.y() - layoutIndex_->top);
+		if(!onlyPulled && index >= begin && index < end){
+			PropertyRow* child = children_[index];
+			if(child->visible(tree))
+				if(PropertyRow* result = child->hit(tree, point))
+					return result;
+		}
+	}
+	else{
+		PropertyRow::const_iterator it;
+		for(it = children_.begin(); it != children_.end(); ++it){
+			PropertyRow* child = *it;
+			if (!child->visible(tree))
+				continue;
+			if(!onlyPulled || child->pulledUp())
+				if(PropertyRow* result = child->hit(tree, point))
+					return result;
+		}
+	}
 	if (Rect(pos_.x(), pos_.y(), size_.x(), size_.y()).contains(point))
         return this;
     return 0;
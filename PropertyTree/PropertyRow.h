@@ -24,6 +24,7 @@
 #include "ConstStringList.h"
 #include "IDrawContext.h"
 #include "Rect.h"
+#include "PropertyRowPool.h"
 #include "sigslot.h"
 
 class QPainter;
@@ -81,13 +82,17 @@ public:
 		WIDGET_AFTER_PULLED
 	};
 
-	typedef std::vector< yasli::SharedPtr<PropertyRow> > Rows;
+	typedef property_tree::RowArray< yasli::SharedPtr<PropertyRow> > Rows;
 	typedef Rows::iterator iterator;
 	typedef Rows::const_iterator const_iterator;
 
 	PropertyRow();
 	virtual ~PropertyRow();
 
+	// rows of all types are taken from the row pool, see PropertyRowPool.h
+	static void* operator new(size_t size) { return property_tree::allocateRowMemory(size); }
+	static void operator delete(void* row, size_t size) { property_tree::freeRowMemory(row, size); }
+
 	void setNames(const char* name, const char* label, const char* typeName);
 
 	bool selected() const{ return selected_; }
@@ -122,6 +127,8 @@ public:
 	template<class Op> bool scanChildren(Op& op, PropertyTree* tree);
 	template<class Op> bool scanChildrenReverse(Op& op, PropertyTree* tree);
 	template<class Op> bool scanChildrenBottomUp(Op& op, PropertyTree* tree);
+	// same as scanChildren, but skips elements of large containers that are not placed
+	template<class Op> bool scanPlacedChildren(Op& op, PropertyTree* tree);
 
 	PropertyRow* childByIndex(int index);
 	const PropertyRow* childByIndex(int index) const;
@@ -137,12 +144,20 @@ public:
 	const_iterator begin() const{ return children_.begin(); }
 	const_iterator end() const{ return children_.end(); }
 	std::size_t count() const{ return children_.size(); }
-	iterator erase(iterator it){ return children_.erase(it); }
-	void clear(){ children_.clear(); }
+	iterator erase(iterator it){ invalidateChildIndex(); return children_.erase(it); }
+	void clear(){ invalidateChildIndex(); children_.clear(); }
 	void erase(PropertyRow* row);
 	void swapChildren(PropertyRow* row);
 	void eraseOld();
 	void eraseOldRecursive();
+	// see PropertyOArchive::setSkipUnchanged
+	void setContentHash(unsigned int hash, bool valid) { contentHash_ = hash; contentHashValid_ = valid; }
+	bool matchContentHash(unsigned int hash) const{ return contentHashValid_ && contentHash_ == hash; }
+	void setUpdateSkipped(bool skipped) { updateSkipped_ = skipped; }
+	// row or some of its children were changed in the tree and are not applied
+	// to attached objects yet, see PropertyIArchive::setSkipUnchanged
+	bool dirty() const{ return dirty_; }
+	void setDirty(bool dirty) { dirty_ = dirty; }
 	std::size_t countUpdated() const;
 
 	void assignRowState(const PropertyRow& row, bool recurse);
@@ -150,7 +165,7 @@ public:
 	void replaceAndPreserveState(PropertyRow* oldRow, PropertyRow* newRow, bool preserveChildren = true);
 
 	const char* name() const{ return name_; }
-	void setName(const char* name) { name_ = name; }
+	void setName(const char* name) { name_ = name; updateNameHash(); if(parent_) parent_->invalidateChildIndex(); }
 	const char* label() const { return label_; }
 	const char* labelUndecorated() const { return labelUndecorated_; }
 	void setLabel(const char* label);
@@ -164,7 +179,10 @@ public:
 	void parseControlCodes(const char* label, bool changeLabel);
 	const char* typeName() const{ return typeName_; }
 	virtual const char* typeNameForFilter(PropertyTree* tree) const;
-	void setTypeName(const char* typeName) { YASLI_ASSERT(strlen(typeName)); typeName_ = typeName; }
+	void setTypeName(const char* typeName) { YASLI_ASSERT(strlen(typeName)); typeName_ = typeName; updateNameHash(); if(parent_) parent_->invalidateChildIndex(); }
+	// hash of name and typeName, used to reject mismatching rows without strcmp
+	unsigned int nameHash() const{ return nameHash_; }
+	static unsigned int calculateNameHash(const char* name, const char* typeName);
 	const char* rowText(char (&containerLabelBuffer)[16], const PropertyTree* tree, int rowIndex) const;
 
 	PropertyRow* findSelected();
@@ -192,6 +210,18 @@ public:
 	void setTextSize(const PropertyTree* tree, int rowIndex, float multiplier);
 	void calculateTotalSizes(int* minTextSize);
 	void adjustVerticalPosition(const PropertyTree* tree, int& totalHeight);
+	// height of the row together with its expanded children, rows that were not
+	// laid out yet are estimated to take one line
+	int layoutHeight(const PropertyTree* tree) const;
+
+	// Elements of large containers are laid out only when they get near visible
+	// area (see PropertyTree::_layoutRange), positions of the rest are out of date.
+	bool lazyLayout() const { return lazyLayout_; }
+	bool placed() const;
+	// position of the row or, if it is not placed, of its nearest placed parent element
+	int estimatedTop() const;
+	// range of children positioned by the last layout pass
+	void placedChildren(int* begin, int* end) const;
 
 	virtual bool isWidgetFixed() const{ return userFixedWidget_ || widgetPlacement() != WIDGET_VALUE; }
 
@@ -263,7 +293,22 @@ public:
 	PropertyRow* pulledContainer() { return pulledContainer_; }
 	const PropertyRow* pulledContainer() const{ return pulledContainer_; }
 
+	// Deep copy of the row with all children. Values are copied directly,
+	// names are interned into constStrings (global list when null).
 	yasli::SharedPtr<PropertyRow> clone(ConstStringList* constStrings) const;
+	// Same copy done through BinArchive round-trip, used for clipboard.
+	yasli::SharedPtr<PropertyRow> cloneSerialized(ConstStringList* constStrings) const;
+	// Copy of the row that reuses subtrees of previous copy (made of the same row
+	// earlier) when they are equal to current ones, including expanded/selected
+	// state. Result must not be modified: it may be shared with the previous copy.
+	// Estimated size of newly allocated rows is added to allocatedBytes.
+	yasli::SharedPtr<PropertyRow> cloneShared(PropertyRow* previous, ConstStringList* constStrings, size_t* allocatedBytes) const;
+	// creates row of the same type with copy of its value, without children
+	virtual PropertyRow* cloneRow(ConstStringList* constStrings) const;
+	// compares value with the one of row of the same type
+	virtual bool sameValue(const PropertyRow& row) const;
+	// estimated heap memory taken by the row, not including children
+	size_t memoryUsed() const;
 
 	yasli::Serializer serializer() const{ return serializer_; }
     void setSerializer(const yasli::Serializer& ser) { serializer_ = ser; }
@@ -271,20 +316,48 @@ public:
 	void YASLI_SERIALIZE_METHOD(yasli::Archive& ar);
 
 	static void setConstStrings(ConstStringList* constStrings){ constStrings_ = constStrings; }
+	// list that names read by the archive are interned into: ConstStringList
+	// passed as archive context, or the one set with setConstStrings
+	static ConstStringList* constStrings(yasli::Archive& ar);
 
 protected:
-	void init(const char* name, const char* nameAlt, const char* typeName);
+	// copies names and value, layout and children are left as after construction
+	PropertyRow(const PropertyRow& original);
 
+	void init(const char* name, const char* nameAlt, const char* typeName);
+	void updateNameHash() { nameHash_ = calculateNameHash(name_, typeName_); }
+
+	// Lookup table for findFromIndex, built for rows with many children when
+	// sequential search misses. Appending children keeps it up to date, any
+	// other change of children discards it, together with layout index.
+	struct ChildIndex;
+	void buildChildIndex() const;
+	void appendToChildIndex(int index) const;
+	void invalidateChildIndex() const { if(childIndex_) destroyChildIndex(); if(layoutIndex_) destroyLayoutIndex(); }
+	void destroyChildIndex() const;
+
+	// Heights of elements of lazily laid out container, see adjustElementPositions.
+	struct LayoutIndex;
+	LayoutIndex& updateLayoutIndex(const PropertyTree* tree);
+	void destroyLayoutIndex() const;
+	void adjustElementPositions(const PropertyTree* tree, int& totalHeight, bool expanded);
+
+	struct CloneContext;
+	PropertyRow* cloneRecursive(CloneContext& context) const;
+	PropertyRow* cloneSharedRecursive(PropertyRow* previous, CloneContext& context) const;
+	bool sameRow(const PropertyRow& row) const;
+	bool sameTree(const PropertyRow& row, CloneContext* context) const;
+
+	// Members are ordered to leave no padding, the ones read by lookup, layout
+	// and drawing of the tree come first and share the first cache lines.
+	unsigned int nameHash_; // fills the gap after RefCounter
 	const char* name_;
 	const char* label_;
 	const char* labelUndecorated_;
 	const char* typeName_;
-	yasli::Serializer serializer_;
 	PropertyRow* parent_;
 	Rows children_;
 
-	unsigned int textHash_;
-
 	// do we really need Point here? 
 	Point pos_;
 	Point size_;
@@ -312,7 +385,16 @@ protected:
 	bool hasPulled_ : 1;
 	bool multiValue_ : 1;
 	bool updated_ : 1;
+	bool updateSkipped_ : 1;
+	bool contentHashValid_ : 1;
+	bool lazyLayout_ : 1;
+	bool dirty_ : 1;
+	unsigned int textHash_;
+	unsigned int contentHash_;
 
+	yasli::Serializer serializer_;
+	mutable ChildIndex* childIndex_;
+	mutable LayoutIndex* layoutIndex_;
 	yasli::SharedPtr<PropertyRow> pulledContainer_;
 	static ConstStringList* constStrings_;
 	friend class PropertyOArchive;
@@ -408,6 +490,26 @@ bool PropertyRow::scanChildrenBottomUp(Op& op, PropertyTree* tree)
 	return true;
 }
 
+template<class Op>
+bool PropertyRow::scanPlacedChildren(Op& op, PropertyTree* tree)
+{
+	int begin, end;
+	placedChildren(&begin, &end);
+	for(int index = begin; index < end; ++index){
+		PropertyRow* child = children_[index];
+		ScanResult result = op(child, tree, index);
+		if(result == SCAN_FINISHED)
+			return false;
+		if(result == SCAN_CHILDREN || result == SCAN_CHILDREN_SIBLINGS){
+			if(!child->scanPlacedChildren(op, tree))
+				return false;
+			if(result == SCAN_CHILDREN)
+				return false;
+		}
+	}
+	return true;
+}
+
 
 #define REGISTER_PROPERTY_ROW(DataType, RowType) \
 	REGISTER_IN_FACTORY(PropertyRowFactory, yasli::TypeID::get<DataType>().name(), RowType); \
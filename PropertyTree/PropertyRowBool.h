@@ -31,6 +31,8 @@ public:
 	yasli::string valueAsString() const override{ return value_ ? "true" : "false"; }
 	WidgetPlacement widgetPlacement() const override{ return WIDGET_ICON; }
 	void serializeValue(yasli::Archive& ar) override;
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowBool(*this); }
+	bool sameValue(const PropertyRow& row) const override{ return value_ == static_cast<const PropertyRowBool&>(row).value_; }
 	int widgetSizeMin(const PropertyTree* tree) const override;
 protected:
 	bool value_;
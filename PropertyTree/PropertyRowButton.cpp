@@ -35,6 +35,11 @@ public:
 		else
 			return 60; 
 	}
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowButton(*this); }
+	bool sameValue(const PropertyRow& row) const override{
+		const Button& button = static_cast<const PropertyRowButton&>(row).value_;
+		return value_.pressed == button.pressed && value_.text == button.text;
+	}
 protected:
 	bool underMouse_;
 };
@@ -22,6 +22,8 @@ public:
 
 	bool isLeaf() const override{ return false; }
 	bool isStatic() const override{ return false; }
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowColor(*this); }
+	bool sameValue(const PropertyRow& row) const override{ return value_ == static_cast<const PropertyRowColor&>(row).value_; }
 private:
 	Color value_;
 };
@@ -260,10 +260,28 @@ void PropertyRowContainer::labelChanged()
 
 void PropertyRowContainer::serializeValue(yasli::Archive& ar)
 {
-	ar(ConstStringWrapper(constStrings_, elementTypeName_), "elementTypeName", "ElementTypeName");
+	ar(ConstStringWrapper(constStrings(ar), elementTypeName_), "elementTypeName", "ElementTypeName");
 	ar(fixedSize_, "fixedSize", "fixedSize");
 }
 
+PropertyRow* PropertyRowContainer::cloneRow(ConstStringList* constStrings) const
+{
+	PropertyRowContainer* result = new PropertyRowContainer(*this);
+	if(elementTypeName_)
+		result->elementTypeName_ = (constStrings ? constStrings : &globalConstStringList)->findOrAdd(elementTypeName_);
+	return result;
+}
+
+bool PropertyRowContainer::sameValue(const PropertyRow& row) const
+{
+	const PropertyRowContainer& container = static_cast<const PropertyRowContainer&>(row);
+	if(fixedSize_ != container.fixedSize_)
+		return false;
+	if(elementTypeName_ == container.elementTypeName_)
+		return true;
+	return elementTypeName_ && container.elementTypeName_ && strcmp(elementTypeName_, container.elementTypeName_) == 0;
+}
+
 yasli::string PropertyRowContainer::valueAsString() const
 {
 	char buf[32] = { 0 };
@@ -47,6 +47,8 @@ public:
 	PropertyRow* defaultRow(PropertyTreeModel* model);
 	const PropertyRow* defaultRow(const PropertyTreeModel* model) const;
 	void serializeValue(yasli::Archive& ar) override;
+	PropertyRow* cloneRow(ConstStringList* constStrings) const override;
+	bool sameValue(const PropertyRow& row) const override;
 
 	const char* elementTypeName() const{ return elementTypeName_; }
 	virtual void setValueAndContext(const yasli::ContainerInterface& value, yasli::Archive& ar) {
@@ -8,6 +8,8 @@ class PropertyRowHorizontalLine : public PropertyRowImpl<HorizontalLine>{
 public:
 	void redraw(IDrawContext& context) override;
 	bool isSelectable() const override{ return false; }
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowHorizontalLine(*this); }
+	bool sameValue(const PropertyRow& row) const override{ return true; }
 };
 
 void PropertyRowHorizontalLine::redraw(IDrawContext& context)
@@ -42,6 +42,11 @@ public:
 	WidgetPlacement widgetPlacement() const override{ return WIDGET_ICON; }
 	void serializeValue(Archive& ar) override{}
 	int widgetSizeMin(const PropertyTree*) const override{ return 18; }
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowIconXPM(*this); }
+	bool sameValue(const PropertyRow& row) const override{
+		const IconXPM& icon = static_cast<const PropertyRowIconXPM&>(row).icon_;
+		return icon_.source == icon.source && icon_.lineCount == icon.lineCount;
+	}
 protected:
 	IconXPM icon_;
 };
@@ -99,6 +104,11 @@ public:
 	WidgetPlacement widgetPlacement() const override{ return WIDGET_ICON; }
 
 	int widgetSizeMin(const PropertyTree*) const override{ return 18; }
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowIconToggle(*this); }
+	bool sameValue(const PropertyRow& row) const override{
+		const PropertyRowIconToggle& toggle = static_cast<const PropertyRowIconToggle&>(row);
+		return value_ == toggle.value_ && iconTrue_.source == toggle.iconTrue_.source && iconFalse_.source == toggle.iconFalse_.source;
+	}
 
 	IconXPM iconTrue_;
 	IconXPM iconFalse_;
@@ -179,6 +179,12 @@ public:
 		ar(hardMin_, "hardMin", "HardMin");
 		ar(hardMax_, "hardMax", "HardMax");
 	}
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowNumber(*this); }
+	bool sameValue(const PropertyRow& row) const override{
+		const PropertyRowNumber& number = static_cast<const PropertyRowNumber&>(row);
+		return value_ == number.value_ && softMin_ == number.softMin_ && softMax_ == number.softMax_ &&
+			   hardMin_ == number.hardMin_ && hardMax_ == number.hardMax_;
+	}
 
 	void startIncrement() override
 	{
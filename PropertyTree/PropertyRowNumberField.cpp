@@ -52,6 +52,8 @@ void PropertyRowNumberField::onMouseDrag(const PropertyDragEvent& e)
 
 void PropertyRowNumberField::onMouseStill(const PropertyDragEvent& e)
 {
+	// value is changed by dragging without rowChanged
+	e.tree->model()->setRowDirty(this);
 	e.tree->apply(true);
 }
 
@@ -25,6 +25,14 @@ bool PropertyRowObject::assignTo(Object* obj)
 	return false;
 }
 
+PropertyRow* PropertyRowObject::cloneRow(ConstStringList* constStrings) const
+{
+	// copy doesn't hold reference to the object, same as deserialized row
+	PropertyRowObject* result = new PropertyRowObject(*this);
+	result->object_ = Object();
+	return result;
+}
+
 PropertyRowObject::~PropertyRowObject()
 {
 	object_ = Object();
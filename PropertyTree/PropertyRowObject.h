@@ -34,6 +34,8 @@ public:
 	void setModel(PropertyTreeModel* model) { model_ = model; }
 	bool assignTo(Object* obj);
 	void YASLI_SERIALIZE_METHOD(Archive& ar);
+	PropertyRow* cloneRow(ConstStringList* constStrings) const override;
+	bool sameValue(const PropertyRow& row) const override{ return model_ == static_cast<const PropertyRowObject&>(row).model_; }
 	const Object& object() const{ return object_; }
 protected:
 	Object object_;
@@ -247,6 +247,13 @@ void PropertyRowPointer::serializeValue(yasli::Archive& ar)
 	ar(derivedTypeName_, "derivedTypeName", "Derived Type Name");
 }
 
+bool PropertyRowPointer::sameValue(const PropertyRow& row) const
+{
+	const PropertyRowPointer& pointer = static_cast<const PropertyRowPointer&>(row);
+	return baseType_ == pointer.baseType_ && factory_ == pointer.factory_ &&
+		   derivedTypeName_ == pointer.derivedTypeName_ && derivedLabel_ == pointer.derivedLabel_;
+}
+
 int PropertyRowPointer::widgetSizeMin(const PropertyTree* tree) const
 {
 	property_tree::Font font = derivedTypeName_.empty() ? property_tree::FONT_NORMAL : property_tree::FONT_BOLD;
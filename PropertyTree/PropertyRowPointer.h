@@ -62,6 +62,8 @@ public:
 	void redraw(IDrawContext& context) override;
 	WidgetPlacement widgetPlacement() const override{ return WIDGET_VALUE; }
 	void serializeValue(yasli::Archive& ar) override;
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowPointer(*this); }
+	bool sameValue(const PropertyRow& row) const override;
 protected:
 
 	yasli::TypeID baseType_;
@@ -0,0 +1,200 @@
+/**
+ *  yasli - Serialization Library.
+ *  Copyright (C) 2007-2013 Evgeny Andreeshchev <eugene.andreeshchev@gmail.com>
+ *                          Alexander Kotliar <alexander.kotliar@gmail.com>
+ *
+ *  This code is distributed under the MIT License:
+ *                          http://www.opensource.org/licenses/MIT
+ */
+
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include "PropertyRowPool.h"
+
+namespace property_tree {
+
+static const size_t POOL_ALIGNMENT = 16;
+static const size_t POOL_MAX_BLOCK = 512;
+static const size_t POOL_CLASS_COUNT = POOL_MAX_BLOCK / POOL_ALIGNMENT;
+static const size_t POOL_CHUNK_SIZE = 64 * 1024;
+
+struct PoolBlock
+{
+	PoolBlock* next;
+};
+
+struct PoolChunk
+{
+	PoolChunk* next;
+	char padding[POOL_ALIGNMENT - sizeof(PoolChunk*)]; // keeps blocks aligned
+};
+
+// Each size class has its own lock, chunks and statistics, so threads that
+// create rows of different types do not wait for each other.
+struct PoolClass
+{
+	std::atomic<int> locked;
+	PoolBlock* freeList;
+	char* current;
+	char* end;
+	PoolChunk* chunks;
+	size_t chunkBytes;
+	size_t usedBytes;
+	size_t blockCount;
+};
+
+// Plain data with static storage, zero-initialized before any constructor
+// runs, so rows destroyed during static destruction still find the pool in
+// place.
+static PoolClass poolClasses[POOL_CLASS_COUNT];
+// blocks of all classes, chunks are released when it gets to zero
+static std::atomic<size_t> poolBlockCount;
+static std::atomic<size_t> poolLargeBytes;
+static std::atomic<size_t> poolLargeCount;
+
+static void lockClass(PoolClass& poolClass)
+{
+	while (poolClass.locked.exchange(1, std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+static void unlockClass(PoolClass& poolClass)
+{
+	poolClass.locked.store(0, std::memory_order_release);
+}
+
+namespace {
+
+struct ClassLock
+{
+	PoolClass& poolClass;
+	explicit ClassLock(PoolClass& c) : poolClass(c) { lockClass(poolClass); }
+	~ClassLock() { unlockClass(poolClass); }
+};
+
+// Locks all classes in order of their indices, the only order in which more
+// than one class is locked.
+struct PoolLock
+{
+	PoolLock()
+	{
+		for (size_t i = 0; i < POOL_CLASS_COUNT; ++i)
+			lockClass(poolClasses[i]);
+	}
+	~PoolLock()
+	{
+		for (size_t i = POOL_CLASS_COUNT; i > 0; --i)
+			unlockClass(poolClasses[i - 1]);
+	}
+};
+
+}
+
+static void releaseChunks()
+{
+	PoolLock lock;
+	// a block could be allocated since the count got to zero
+	if (poolBlockCount.load() != 0)
+		return;
+	for (size_t i = 0; i < POOL_CLASS_COUNT; ++i) {
+		PoolClass& poolClass = poolClasses[i];
+		PoolChunk* chunk = poolClass.chunks;
+		while (chunk) {
+			PoolChunk* next = chunk->next;
+			free(chunk);
+			chunk = next;
+		}
+		poolClass.chunks = 0;
+		poolClass.freeList = 0;
+		poolClass.current = 0;
+		poolClass.end = 0;
+		poolClass.chunkBytes = 0;
+	}
+}
+
+void* allocateRowMemory(size_t size)
+{
+	if (size > POOL_MAX_BLOCK) {
+		void* memory = ::operator new(size);
+		poolLargeBytes += size;
+		++poolLargeCount;
+		return memory;
+	}
+
+	size_t classIndex = size ? (size - 1) / POOL_ALIGNMENT : 0;
+	size_t blockSize = (classIndex + 1) * POOL_ALIGNMENT;
+	PoolClass& poolClass = poolClasses[classIndex];
+	ClassLock lock(poolClass);
+	void* memory;
+	if (poolClass.freeList) {
+		memory = poolClass.freeList;
+		poolClass.freeList = poolClass.freeList->next;
+	}
+	else {
+		if (poolClass.current + blockSize > poolClass.end) {
+			PoolChunk* chunk = (PoolChunk*)malloc(POOL_CHUNK_SIZE);
+			if (!chunk)
+				throw std::bad_alloc();
+			chunk->next = poolClass.chunks;
+			poolClass.chunks = chunk;
+			poolClass.chunkBytes += POOL_CHUNK_SIZE;
+			// tail of the previous chunk is left unused
+			poolClass.current = (char*)(chunk + 1);
+			poolClass.end = (char*)chunk + POOL_CHUNK_SIZE;
+		}
+		memory = poolClass.current;
+		poolClass.current += blockSize;
+	}
+	poolClass.usedBytes += blockSize;
+	++poolClass.blockCount;
+	// counted under the lock of the class, so releaseChunks sees it
+	++poolBlockCount;
+	return memory;
+}
+
+void freeRowMemory(void* memory, size_t size)
+{
+	if (!memory)
+		return;
+	if (size > POOL_MAX_BLOCK) {
+		poolLargeBytes -= size;
+		--poolLargeCount;
+		::operator delete(memory);
+		return;
+	}
+
+	size_t classIndex = size ? (size - 1) / POOL_ALIGNMENT : 0;
+	PoolClass& poolClass = poolClasses[classIndex];
+	bool last;
+	{
+		ClassLock lock(poolClass);
+		YASLI_ASSERT(poolClass.blockCount > 0);
+		PoolBlock* block = (PoolBlock*)memory;
+		block->next = poolClass.freeList;
+		poolClass.freeList = block;
+		poolClass.usedBytes -= (classIndex + 1) * POOL_ALIGNMENT;
+		--poolClass.blockCount;
+		last = --poolBlockCount == 0;
+	}
+	if (last)
+		releaseChunks();
+}
+
+RowPoolStatistics rowPoolStatistics()
+{
+	RowPoolStatistics statistics = RowPoolStatistics();
+	{
+		PoolLock lock;
+		for (size_t i = 0; i < POOL_CLASS_COUNT; ++i) {
+			statistics.chunkBytes += poolClasses[i].chunkBytes;
+			statistics.usedBytes += poolClasses[i].usedBytes;
+			statistics.blockCount += poolClasses[i].blockCount;
+		}
+	}
+	statistics.largeBytes = poolLargeBytes.load();
+	statistics.largeCount = poolLargeCount.load();
+	return statistics;
+}
+
+}
@@ -0,0 +1,185 @@
+/**
+ *  yasli - Serialization Library.
+ *  Copyright (C) 2007-2013 Evgeny Andreeshchev <eugene.andreeshchev@gmail.com>
+ *                          Alexander Kotliar <alexander.kotliar@gmail.com>
+ *
+ *  This code is distributed under the MIT License:
+ *                          http://www.opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include <new>
+#include <algorithm>
+#include "yasli/Assert.h"
+
+namespace property_tree {
+
+// Memory for rows and arrays of their children. Blocks are cut from large
+// chunks, one free list per size class, so rows built by the same archive pass
+// lie next to each other and freed rows are reused without going to the heap.
+// Chunks are released when the last block is freed, e.g. when the last tree
+// is detached. Can be called from any thread, each size class is locked
+// separately.
+void* allocateRowMemory(size_t size);
+void freeRowMemory(void* memory, size_t size);
+
+struct RowPoolStatistics
+{
+	size_t chunkBytes;  // taken from the heap by the pool
+	size_t usedBytes;   // in blocks that are allocated now
+	size_t blockCount;
+	size_t largeBytes;  // blocks that are too big for the pool, allocated on the heap
+	size_t largeCount;
+};
+RowPoolStatistics rowPoolStatistics();
+
+// Array of smart pointers: 16 bytes instead of 24 of std::vector and storage
+// taken from the row pool. Elements are moved with memcpy, T has to hold
+// nothing but a pointer (like yasli::SharedPtr).
+template<class T>
+class RowArray
+{
+public:
+	typedef T value_type;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+
+	RowArray() : data_(0), size_(0), capacity_(0) {}
+	~RowArray() { clear(); release(); }
+
+	iterator begin() { return data_; }
+	iterator end() { return data_ + size_; }
+	const_iterator begin() const { return data_; }
+	const_iterator end() const { return data_ + size_; }
+	size_t size() const { return size_; }
+	size_t capacity() const { return capacity_; }
+	bool empty() const { return size_ == 0; }
+	T& operator[](size_t index) { return data_[index]; }
+	const T& operator[](size_t index) const { return data_[index]; }
+	T& back() { return data_[size_ - 1]; }
+
+	void reserve(size_t capacity)
+	{
+		if (capacity <= capacity_)
+			return;
+		T* data = (T*)allocateRowMemory(capacity * sizeof(T));
+		if (size_)
+			memcpy((void*)data, data_, size_ * sizeof(T));
+		release();
+		data_ = data;
+		capacity_ = unsigned(capacity);
+	}
+
+	void push_back(const T& value)
+	{
+		if (size_ == capacity_) {
+			// value may be an element of this array
+			T copy(value);
+			reserve(grownCapacity(size_ + 1));
+			new (data_ + size_) T(copy);
+		}
+		else
+			new (data_ + size_) T(value);
+		++size_;
+	}
+
+	iterator insert(iterator pos, const T& value)
+	{
+		T copy(value);
+		iterator at = makeGap(pos, 1);
+		new (at) T(copy);
+		return at;
+	}
+
+	// range must not point into this array
+	template<class Iterator>
+	void insert(iterator pos, Iterator first, Iterator last)
+	{
+		size_t count = 0;
+		for (Iterator it = first; it != last; ++it)
+			++count;
+		iterator at = makeGap(pos, count);
+		for (; first != last; ++first, ++at)
+			new (at) T(*first);
+	}
+
+	iterator erase(iterator pos)
+	{
+		YASLI_ASSERT(pos >= begin() && pos < end());
+		pos->~T();
+		memmove((void*)pos, pos + 1, (end() - pos - 1) * sizeof(T));
+		--size_;
+		return pos;
+	}
+
+	void clear()
+	{
+		for (unsigned i = 0; i < size_; ++i)
+			data_[i].~T();
+		size_ = 0;
+	}
+
+	// new elements are default-constructed
+	void resize(size_t size)
+	{
+		while (size_ > size)
+			data_[--size_].~T();
+		if (size > size_) {
+			reserve(size);
+			for (; size_ < size; ++size_)
+				new (data_ + size_) T();
+		}
+	}
+
+	void swap(RowArray& other)
+	{
+		std::swap(data_, other.data_);
+		std::swap(size_, other.size_);
+		std::swap(capacity_, other.capacity_);
+	}
+
+private:
+	RowArray(const RowArray&);
+	RowArray& operator=(const RowArray&);
+
+	// most rows have few children, so growth starts from 4
+	static size_t grownCapacity(size_t required)
+	{
+		size_t capacity = 4;
+		while (capacity < required)
+			capacity *= 2;
+		return capacity;
+	}
+
+	iterator makeGap(iterator pos, size_t count)
+	{
+		size_t index = pos - data_;
+		YASLI_ASSERT(index <= size_);
+		// data_ is null in empty arrays, memmove must not get it
+		if (count == 0)
+			return pos;
+		if (size_ + count > capacity_)
+			reserve(grownCapacity(size_ + count));
+		if (index < size_)
+			memmove((void*)(data_ + index + count), data_ + index, (size_ - index) * sizeof(T));
+		size_ += unsigned(count);
+		return data_ + index;
+	}
+
+	void release()
+	{
+		if (data_)
+			freeRowMemory(data_, capacity_ * sizeof(T));
+		data_ = 0;
+		capacity_ = 0;
+	}
+
+	T* data_;
+	unsigned size_;
+	unsigned capacity_;
+};
+
+}
@@ -28,6 +28,8 @@ public:
 	yasli::wstring valueAsWString() const override { return value_; }
 	WidgetPlacement widgetPlacement() const override{ return WIDGET_VALUE; }
 	void serializeValue(yasli::Archive& ar) override;
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowString(*this); }
+	bool sameValue(const PropertyRow& row) const override{ return value_ == static_cast<const PropertyRowString&>(row).value_; }
 	const yasli::wstring& value() const{ return value_; }
 private:
 	yasli::wstring value_;
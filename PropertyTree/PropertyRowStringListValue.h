@@ -72,6 +72,11 @@ public:
 		ar(value_, "value", "Value");
 		ar(stringList_, "stringList", "String List");
 	}
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowStringListValue(*this); }
+	bool sameValue(const PropertyRow& row) const override{
+		const PropertyRowStringListValue& listValue = static_cast<const PropertyRowStringListValue&>(row);
+		return value_ == listValue.value_ && stringList_ == listValue.stringList_;
+	}
 private:
 	yasli::StringList stringList_;
 	yasli::string value_;
@@ -131,6 +136,11 @@ public:
 		ar(value_, "value", "Value");
 		ar(stringList_, "stringList", "String List");
 	}
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowStringListStaticValue(*this); }
+	bool sameValue(const PropertyRow& row) const override{
+		const PropertyRowStringListStaticValue& listValue = static_cast<const PropertyRowStringListStaticValue&>(row);
+		return value_ == listValue.value_ && stringList_ == listValue.stringList_;
+	}
 private:
 	yasli::StringList stringList_;
 	yasli::string value_;
@@ -15,6 +15,8 @@
 #include "IDrawContext.h"
 #include "Serialization.h"
 #include "PropertyTreeModel.h"
+#include "PropertyTreeFilter.h"
+#include "PropertyTreeWorkers.h"
 
 #include "yasli/ClassFactory.h"
 
@@ -23,6 +25,8 @@
 #include "Unicode.h"
 
 #include <limits.h>
+#include <wctype.h>
+#include <thread>
 #include "PropertyTreeMenuHandler.h"
 #include "IUIFacade.h"
 #include "IMenu.h"
@@ -48,7 +52,11 @@ TreeConfig::TreeConfig()
 , sliderUpdateDelay_(25)
 , undoEnabled_(true)
 , fullUndo_(false)
+, undoMemoryBudget_(0)
 , expandLevels_(1)
+, incrementalRevert_(false)
+, parallelRevert_(false)
+, backgroundFilter_(false)
 {
 	//QFont font;
 	//QFontMetrics fm(font);
@@ -100,6 +108,9 @@ PropertyTree::PropertyTree(IUIFacade* uiFacade)
 : attachedPropertyTree_(0)
 , ui_(uiFacade)
 , autoRevert_(true)
+, batchedApply_(false)
+, updatePending_(false)
+, applyPending_(false)
 , leftBorder_(0)
 , rightBorder_(0)
 , cursorX_(0)
@@ -120,9 +131,11 @@ PropertyTree::PropertyTree(IUIFacade* uiFacade)
 , area_(0, 0, 0, 0)
 {
 	model_.reset(new PropertyTreeModel(this));
+	treeFilter_.reset(new PropertyTreeFilter(this));
 	model_->setExpandLevels(expandLevels_);
 	model_->setUndoEnabled(undoEnabled_);
 	model_->setFullUndo(fullUndo_);
+	model_->setUndoMemoryBudget(undoMemoryBudget_);
 }
 
 PropertyTree::~PropertyTree()
@@ -380,7 +393,7 @@ void PropertyTree::expandChildren(PropertyRow* root)
 	if(!root){
 		root = model()->root();
 		PropertyRow::iterator it;
-		for (PropertyRows::iterator it = root->begin(); it != root->end(); ++it){
+		for (PropertyRow::iterator it = root->begin(); it != root->end(); ++it){
 			PropertyRow* row = *it;
 			row->setExpandedRecursive(this, true);
 		}
@@ -406,7 +419,7 @@ void PropertyTree::collapseChildren(PropertyRow* root)
 		root = model()->root();
 
 		PropertyRow::iterator it;
-		for (PropertyRows::iterator it = root->begin(); it != root->end(); ++it){
+		for (PropertyRow::iterator it = root->begin(); it != root->end(); ++it){
 			PropertyRow* row = *it;
 			row->setExpandedRecursive(this, false);
 		}
@@ -482,6 +495,17 @@ void PropertyTree::ensureVisible(PropertyRow* row, bool update)
 
 	expandParents(row);
 
+	// elements of large containers are positioned only near visible area, so
+	// area is moved to estimated position first, closer with every layout
+	for (int i = 0; i < 16 && !row->placed(); ++i) {
+		int top = max(0, row->estimatedTop());
+		if (top == offset_.y())
+			break;
+		offset_.setY(top);
+		layoutVisibleRows();
+	}
+
+	int offset = offset_.y();
 	Rect rect = row->rect();
 	if(rect.top() < offset_.y()){
 		offset_.setY(max(0, rect.top()));
@@ -489,6 +513,8 @@ void PropertyTree::ensureVisible(PropertyRow* row, bool update)
 	else if(rect.bottom() > size_.y() + offset_.y()){
 		offset_.setY(max(0, rect.bottom() - size_.y()));
 	}
+	if(offset_.y() != offset)
+		layoutVisibleRows();
 	if(update)
 		repaint();
 }
@@ -523,6 +549,7 @@ bool PropertyTree::attach(const yasli::Serializers& serializers)
 	// ...as move forwarder calls copying constructor with non-const argument
 	// which invokes second templated constructor of Serializer, which is not what we need.
 	if (changed) {
+		applyPendingChanges();
 		attached_.assign(serializers.begin(), serializers.end());
 		revert();
 	}
@@ -533,6 +560,7 @@ bool PropertyTree::attach(const yasli::Serializers& serializers)
 void PropertyTree::attach(const yasli::Serializer& serializer)
 {
 	if (attached_.size() != 1 || attached_[0].serializer() != serializer) {
+		applyPendingChanges();
 		attached_.clear();
 		attached_.push_back(yasli::Object(serializer));
 		revert();
@@ -541,6 +569,7 @@ void PropertyTree::attach(const yasli::Serializer& serializer)
 
 void PropertyTree::attach(const yasli::Object& object)
 {
+	applyPendingChanges();
 	attached_.clear();
 	attached_.push_back(object);
 
@@ -551,6 +580,8 @@ void PropertyTree::detach()
 {
 	if(widget_.get())
 		widget_.reset();
+	applyPendingChanges();
+	treeFilter_->invalidate();
 	attached_.clear();
 	model()->root()->clear();
 	repaint();
@@ -580,6 +611,8 @@ bool PropertyTree::revertObject(void* objectAddress)
 
 void PropertyTree::revert()
 {
+	applyPendingChanges();
+	treeFilter_->invalidate();
 	interruptDrag();
 	widget_.reset();
 	capturedRow_ = 0;
@@ -591,22 +624,28 @@ void PropertyTree::revert()
 		PropertyOArchive oa(model_.get(), model_->root());
 		oa.setLastContext(archiveContext_);
 		oa.setFilter(filter_);
+		// intersection with other objects needs all rows to be revisited
+		oa.setSkipUnchanged(incrementalRevert_ && attached_.size() == 1);
 
 		Objects::iterator it = attached_.begin();
 		onAboutToSerialize(oa);
 		(*it)(oa);
 		oa.finalize();
 		
-		PropertyTreeModel model2(this);
-		while(++it != attached_.end()){
-			PropertyOArchive oa2(&model2, model2.root());
-			oa2.setLastContext(archiveContext_);
-			yasli::Context treeContext(oa2, this);
-			oa2.setFilter(filter_);
-			onAboutToSerialize(oa2);
-			(*it)(oa2);
-			oa2.finalize();
-			model_->root()->intersect(model2.root());
+		if (parallelRevert_ && attached_.size() > 2)
+			intersectAttachedParallel(oa);
+		else {
+			PropertyTreeModel model2(this);
+			while(++it != attached_.end()){
+				PropertyOArchive oa2(&model2, model2.root());
+				oa2.setLastContext(archiveContext_);
+				yasli::Context treeContext(oa2, this);
+				oa2.setFilter(filter_);
+				onAboutToSerialize(oa2);
+				(*it)(oa2);
+				oa2.finalize();
+				model_->root()->intersect(model2.root());
+			}
 		}
 		//revertTime_ = int(timer.elapsed());
 	}
@@ -628,6 +667,86 @@ void PropertyTree::revert()
 	onReverted();
 }
 
+// Fewer objects per thread are not worth waking a thread.
+static const int PARALLEL_REVERT_MIN_OBJECTS = 4;
+
+yasli::SharedPtr<PropertyRow> PropertyTree::intersectAttached(int begin, int end, PropertyTreeModel* model, yasli::Context* contexts)
+{
+	yasli::SharedPtr<PropertyRow> result;
+	for (int i = begin; i < end; ++i) {
+		PropertyOArchive oa(model, model->root());
+		oa.setLastContext(contexts);
+		yasli::Context treeContext(oa, this);
+		oa.setFilter(filter_);
+		attached_[i](oa);
+		oa.finalize();
+		if (result)
+			result->intersect(model->root());
+		else {
+			// rows of the first object become the result, model gets a fresh root
+			result = model->root();
+			model->setRoot(new PropertyRow());
+			model->root()->setNames("", "root", "rootType");
+		}
+	}
+	return result;
+}
+
+// Step 0 intersects ranges of attached objects, each in a model of its own.
+// Other steps intersect results pairwise, halving their number each time.
+struct PropertyTree::ParallelRevert : PropertyTreeTask
+{
+	PropertyTree* tree;
+	yasli::Context* contexts;
+	int objectCount;
+	vector<PropertyTreeModel*> models;
+	vector<yasli::SharedPtr<PropertyRow> > results;
+	int step;
+
+	void run(int part) override
+	{
+		int rangeCount = int(results.size());
+		if (step == 0) {
+			int begin = 1 + objectCount * part / rangeCount;
+			int end = 1 + objectCount * (part + 1) / rangeCount;
+			results[part] = tree->intersectAttached(begin, end, models[part], contexts);
+		}
+		else {
+			int i = part * 2 * step;
+			if (i + step < rangeCount)
+				results[i]->intersect(results[i + step]);
+		}
+	}
+};
+
+void PropertyTree::intersectAttachedParallel(const yasli::Archive& prototype)
+{
+	if (!revertWorkers_.get())
+		revertWorkers_.reset(new PropertyTreeWorkers(max(int(std::thread::hardware_concurrency()) - 1, 0)));
+
+	ParallelRevert task;
+	task.tree = this;
+	task.contexts = prototype.lastContext();
+	task.objectCount = int(attached_.size()) - 1;
+	int rangeCount = min(revertWorkers_->threadCount() + 1, task.objectCount / PARALLEL_REVERT_MIN_OBJECTS);
+	rangeCount = max(rangeCount, 1);
+
+	// Models are created here and outlive the intersection, their strings are
+	// interned into lists owned by the tree model.
+	for (int i = 0; i < rangeCount; ++i) {
+		task.models.push_back(new PropertyTreeModel(this));
+		task.models.back()->setConstStrings(model_->workerConstStrings(i));
+	}
+	task.results.resize(rangeCount);
+	for (task.step = 0; task.step < rangeCount; task.step = task.step ? task.step * 2 : 1)
+		revertWorkers_->run(task, task.step ? (rangeCount + 2 * task.step - 1) / (2 * task.step) : rangeCount);
+
+	model_->root()->intersect(task.results[0]);
+	task.results.clear();
+	for (int i = 0; i < rangeCount; ++i)
+		delete task.models[i];
+}
+
 void PropertyTree::revertNonInterrupting()
 {
 	if (!capturedRow_) {
@@ -640,17 +759,22 @@ void PropertyTree::apply(bool continuous)
 	//QElapsedTimer timer;
 	//timer.start();
 
+	applyPending_ = false;
 	if (!attached_.empty()) {
+		// when changes were tracked, only changed rows are written
+		bool skipUnchanged = model_->hasDirtyRows();
 		Objects::iterator it;
 		for(it = attached_.begin(); it != attached_.end(); ++it) {
 			PropertyIArchive ia(model_.get(), model_->root());
 			ia.setLastContext(archiveContext_);
+			ia.setSkipUnchanged(skipUnchanged);
  			yasli::Context treeContext(ia, this);
  			ia.setFilter(filter_);
 			onAboutToSerialize(ia);
 			(*it)(ia);
 		}
 	}
+	model_->clearDirtyRows();
 
 	if (continuous)
 		onContinuousChange();
@@ -797,29 +921,61 @@ void PropertyTree::onRowMenuDecompose(PropertyRow* row)
 
 void PropertyTree::onModelUpdated(const PropertyRows& rows, bool needApply)
 {
+	treeFilter_->invalidate();
 	if(widget_.get()) {
 		defocusInplaceEditor();
 		widget_.reset();
 	}
 
 	if(immediateUpdate_){
-		if (needApply)
-			apply();
-
-		if(autoRevert_)
-			revert();
-		else {
-			updateHeights();
-			updateAttachedPropertyTree(true);
-			if(!immediateUpdate_)
-				onChanged();
+		if(batchedApply_){
+			applyPending_ = applyPending_ || needApply;
+			if(!updatePending_){
+				updatePending_ = true;
+				schedulePendingApply();
+			}
+			repaint();
 		}
+		else
+			applyModelUpdate(needApply);
 	}
 	else {
 		repaint();
 	}
 }
 
+void PropertyTree::applyModelUpdate(bool needApply)
+{
+	if (needApply)
+		apply();
+
+	if(autoRevert_)
+		revert();
+	else {
+		updateHeights();
+		updateAttachedPropertyTree(true);
+		if(!immediateUpdate_)
+			onChanged();
+	}
+}
+
+void PropertyTree::flushPendingApply()
+{
+	if(!updatePending_)
+		return;
+	bool needApply = applyPending_;
+	updatePending_ = false;
+	applyPending_ = false;
+	applyModelUpdate(needApply);
+}
+
+void PropertyTree::applyPendingChanges()
+{
+	updatePending_ = false;
+	if(applyPending_)
+		apply();
+}
+
 void PropertyTree::onModelPushUndo(PropertyTreeOperator* op, bool* handled)
 {
 	onPushUndo();
@@ -928,6 +1084,12 @@ void PropertyTree::setUndoEnabled(bool enabled, bool full)
     model()->setFullUndo(full);
 }
 
+void PropertyTree::setUndoMemoryBudget(size_t bytes)
+{
+	undoMemoryBudget_ = bytes;
+	model()->setUndoMemoryBudget(bytes);
+}
+
 void PropertyTree::attachPropertyTree(PropertyTree* propertyTree) 
 { 
 	attachedPropertyTree_ = propertyTree; 
@@ -970,7 +1132,12 @@ void toLowerUtf8(char* str)
 		*str = tolower(*str);
 #else
 	std::wstring ws = toWideChar(str);
+#ifdef _WIN32
 	_wcslwr_s((wchar_t*)ws.c_str(), ws.size() + 1);
+#else
+	for(size_t i = 0; i < ws.size(); ++i)
+		ws[i] = towlower(ws[i]);
+#endif
 	std::string sl = fromWideChar(ws.c_str());
 	strcpy(str, sl.c_str());
 #endif
@@ -1054,6 +1221,8 @@ void PropertyTree::RowFilter::parse(const char* filter)
 			type = TYPE;
 			++str;
 		}
+		else if (*str == '*')
+			++str;
 		else if (*str == '\0')
 			break;
 	}
@@ -1064,16 +1233,22 @@ bool PropertyTree::RowFilter::match(const char* textOriginal, Type type, size_t*
 	YASLI_ESCAPE(textOriginal, return false);
 
 	char* text;
+	size_t textLen = strlen(textOriginal);
 	{
-		size_t textLen = strlen(textOriginal);
-        text = (char*)alloca((textLen + 1));
+		text = (char*)alloca(textLen + FILTER_TEXT_PADDING);
 		memcpy(text, textOriginal, (textLen + 1));
 		toLowerUtf8(text);
+		textLen = strlen(text);
+		memset(text + textLen, 0, FILTER_TEXT_PADDING);
 	}
-	
+	return matchLowercase(text, textLen, type, matchStart, matchEnd);
+}
+
+bool PropertyTree::RowFilter::matchLowercase(const char* text, size_t length, Type type, size_t* matchStart, size_t* matchEnd) const
+{
 	const yasli::string &start = this->start[type];
 	if (tillEnd[type]){
-		if (start == text) {
+		if (start.size() == length && memcmp(start.c_str(), text, length) == 0) {
 			if (matchStart)
 				*matchStart = 0;
 			if (matchEnd)
@@ -1087,14 +1262,14 @@ bool PropertyTree::RowFilter::match(const char* textOriginal, Type type, size_t*
 	const vector<yasli::string> &substrings = this->substrings[type];
 
 	const char* startPos = text;
+	const char* end = text + length;
 
 	if (matchStart)
 		*matchStart = 0;
 	if (matchEnd)
 		*matchEnd = 0;
 	if (!start.empty()) {
-		if (strncmp(text, start.c_str(), start.size()) != 0){
-            //_freea(text);
+		if (length < start.size() || memcmp(text, start.c_str(), start.size()) != 0){
 			return false;
 		}
 		if (matchEnd)
@@ -1104,7 +1279,7 @@ bool PropertyTree::RowFilter::match(const char* textOriginal, Type type, size_t*
 
 	size_t numSubstrings = substrings.size();
 	for (size_t i = 0; i < numSubstrings; ++i) {
-		const char* substr = strstr(startPos, substrings[i].c_str());
+		const char* substr = findSubstring(startPos, end - startPos, substrings[i].c_str(), substrings[i].size());
 		if (!substr){
 			return false;
 		}
@@ -1118,6 +1293,124 @@ bool PropertyTree::RowFilter::match(const char* textOriginal, Type type, size_t*
 	return true;
 }
 
+bool PropertyTree::RowFilter::narrows(const RowFilter& previous) const
+{
+	for (int i = 0; i < NUM_TYPES; ++i) {
+		if (!previous.tillEnd[i] && !previous.typeRelevant(Type(i)))
+			continue;
+		if (tillEnd[i] != previous.tillEnd[i])
+			return false;
+		if (tillEnd[i]) {
+			if (start[i] != previous.start[i])
+				return false;
+			continue;
+		}
+		if (start[i].compare(0, previous.start[i].size(), previous.start[i]) != 0)
+			return false;
+		// substrings are searched one after another, each of the previous ones
+		// has to be a part of the one at the same place
+		const vector<yasli::string>& previousSubstrings = previous.substrings[i];
+		if (substrings[i].size() < previousSubstrings.size())
+			return false;
+		for (size_t j = 0; j < previousSubstrings.size(); ++j)
+			if (substrings[i][j].find(previousSubstrings[j]) == yasli::string::npos)
+				return false;
+	}
+	return true;
+}
+
+struct FilterVisitor
+{
+	const PropertyTreeFilter& filter_;
+	int index_;
+
+	FilterVisitor(const PropertyTreeFilter& filter)
+	: filter_(filter)
+	, index_(0)
+	{
+	}
+
+	static void markChildrenAsBelonging(PropertyRow* row, bool belongs)
+	{
+		int count = int(row->count());
+		for (int i = 0; i < count; ++i)
+		{
+			PropertyRow* child = row->childByIndex(i);
+			child->setBelongsToFilteredRow(belongs);
+
+			markChildrenAsBelonging(child, belongs);
+		}
+	}
+
+	ScanResult operator()(PropertyRow* row, PropertyTree* tree)
+	{
+		bool matchFilter = true;
+		bool childrenMatch = true;
+		if (!filter_.matchesAll()) {
+			// rows are visited in the same order they were indexed
+			YASLI_ASSERT(index_ < filter_.rowCount() && filter_.row(index_) == row);
+			matchFilter = filter_.rowMatches(index_);
+			childrenMatch = filter_.childrenMatch(index_);
+		}
+		++index_;
+
+		int numChildren = int(row->count());
+		if (matchFilter) {
+			if (row->pulledBefore() || row->pulledUp()) {
+				// treat pulled rows as part of parent
+				PropertyRow* parent = row->parent();
+				parent->setMatchFilter(true);
+				markChildrenAsBelonging(parent, true);
+				parent->setBelongsToFilteredRow(false);
+			}
+			else {
+				markChildrenAsBelonging(row, true);
+				row->setBelongsToFilteredRow(false);
+				row->setLayoutChanged();
+				row->setLabelChanged();
+			}
+		}
+		else {
+			bool belongs = childrenMatch;
+			row->setBelongsToFilteredRow(belongs);
+			if (belongs) {
+				tree->expandRow(row, true, false);
+				for (int i = 0; i < numChildren; ++i) {
+					PropertyRow* child = row->childByIndex(i);
+					if (child->pulledUp())
+						child->setBelongsToFilteredRow(true);
+				}
+			}
+			else {
+				// descendants were visited before and collapsed already
+				if (row->expanded())
+					row->_setExpanded(false);
+				row->setLayoutChanged();
+			}
+		}
+
+		row->setMatchFilter(matchFilter);
+		return SCAN_CHILDREN_SIBLINGS;
+	}
+};
+
+void PropertyTree::matchFilter(const char* filter)
+{
+	rowFilter_.parse(filter);
+	if (treeFilter_->start(rowFilter_, backgroundFilter_))
+		applyFilterResult();
+}
+
+bool PropertyTree::applyFilterResult(bool wait)
+{
+	if (!treeFilter_->finish(wait))
+		return false;
+	FilterVisitor visitor(*treeFilter_);
+	model()->root()->scanChildrenBottomUp(visitor, this);
+	updateHeights();
+	return true;
+}
+
 PropertyRow* PropertyTree::rowByPoint(const Point& pt)
 {
 	if (!model_->root())
@@ -1132,6 +1425,38 @@ Point PropertyTree::pointToRootSpace(const Point& point) const
 	return Point(point.x() + offset_.x(), point.y() + offset_.y());
 }
 
+void PropertyTree::layoutRows(int leftBorder, int rightBorder)
+{
+	PropertyRow* root = model()->root();
+	root->updateLabel(this, 0);
+	bool force = leftBorder != leftBorder_ || rightBorder != rightBorder_;
+	leftBorder_ = leftBorder;
+	rightBorder_ = rightBorder;
+	root->calculateMinimalSize(this, leftBorder_, force, 0, 0);
+
+	size_.setX(area_.width());
+	positionRows(area_.top());
+}
+
+void PropertyTree::layoutVisibleRows()
+{
+	positionRows(model()->root()->rect().top());
+}
+
+void PropertyTree::positionRows(int top)
+{
+	int totalHeight = top;
+	model()->root()->adjustVerticalPosition(this, totalHeight);
+	size_.setY(totalHeight - area_.top());
+}
+
+void PropertyTree::_layoutRange(int* top, int* bottom) const
+{
+	int page = max(area_.height(), 0);
+	*top = offset_.y() - page;
+	*bottom = offset_.y() + area_.bottom() + page;
+}
+
 bool PropertyTree::toggleRow(PropertyRow* row)
 {
 	if(!row->canBeToggled(this))
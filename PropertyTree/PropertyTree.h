@@ -13,6 +13,8 @@ class PropertyTreeModel;
 class PropertyRow;
 typedef vector<yasli::SharedPtr<PropertyRow> > PropertyRows;
 class PropertyTreeOperator;
+class PropertyTreeFilter;
+class PropertyTreeWorkers;
 struct PropertyRowMenuHandler;
 class Entry;
 
@@ -52,7 +54,14 @@ public:
 	void setFullRowContainers(bool fullRowContainers) { fullRowContainers_ = fullRowContainers; repaint(); }
 	void setExpandLevels(int levels);
 	void setUndoEnabled(bool enabled, bool full = false);
+	void setUndoMemoryBudget(size_t bytes);
 	void setAutoRevert(bool autoRevert) { autoRevert_ = autoRevert; }
+	// Postpones apply and revert that follow row changes until flushPendingApply,
+	// so several edits made within a frame are written to objects at once.
+	// Postponed changes are also written by revert, attach and detach.
+	void setBatchedApply(bool batchedApply) { batchedApply_ = batchedApply; }
+	// Applies changes postponed with batched apply, called once per frame.
+	void flushPendingApply();
 	void setArchiveContext(yasli::Context* lastContext);
 	bool multiSelectable() const { return attachedPropertyTree_ != 0; }
 
@@ -100,6 +109,9 @@ public:
 	Point _toWidget(Point point) const;
 	virtual void repaint() = 0;
 	virtual void updateHeights() = 0;
+	// range of root space in which elements of large containers are laid out:
+	// visible area with one page above and below it
+	void _layoutRange(int* top, int* bottom) const;
 	virtual void defocusInplaceEditor() = 0;
 
 	struct RowFilter {
@@ -117,9 +129,19 @@ public:
 
 		void parse(const char* filter);
 		bool match(const char* text, Type type, size_t* matchStart, size_t* matchEnd) const;
+		// text has to be lowercase and padded, see findSubstring
+		bool matchLowercase(const char* text, size_t length, Type type, size_t* matchStart, size_t* matchEnd) const;
+		// true when every text matching this filter matches previous one as well
+		bool narrows(const RowFilter& previous) const;
 		bool typeRelevant(Type type) const{
 			return !start[type].empty() || !substrings[type].empty();
 		}
+		bool empty() const{
+			for (int i = 0; i < NUM_TYPES; ++i)
+				if (tillEnd[i] || typeRelevant(Type(i)))
+					return false;
+			return true;
+		}
 
 		RowFilter()
 		{
@@ -146,11 +168,36 @@ protected:
 
 
 	Point pointToRootSpace(const Point& pointInWindowSpace) const;
+	// Updates labels and sizes of changed rows and positions rows, used by
+	// updateHeights. Elements of large containers are laid out only within
+	// _layoutRange, see PropertyRow::lazyLayout.
+	void layoutRows(int leftBorder, int rightBorder);
+	// positions rows again after scrolling, laying out elements that got into
+	// _layoutRange; rows start where the last layout put them
+	void layoutVisibleRows();
+	// positions rows starting at top, size_ gets their height
+	void positionRows(int top);
+	// Serializes attached objects [begin, end) into model with given contexts
+	// and returns intersection of their rows.
+	yasli::SharedPtr<PropertyRow> intersectAttached(int begin, int end, PropertyTreeModel* model, yasli::Context* contexts);
+	// Intersects model with attached objects after the first one using worker
+	// threads. Contexts of prototype, already passed to onAboutToSerialize on
+	// this thread, are shared by archives of worker threads.
+	void intersectAttachedParallel(const yasli::Archive& prototype);
+	struct ParallelRevert;
 	virtual bool updateScrollBar() = 0;
 	virtual void interruptDrag() = 0;
 	virtual void _arrangeChildren() = 0;
 	virtual void startFilter(const char* text) = 0;
 	virtual void resetFilter() = 0;
+	// Parses filter and matches rows against it, with background filter rows
+	// are matched on a worker thread, see PropertyTreeFilter.
+	void matchFilter(const char* filter);
+	// hides rows that do not match the filter, returns false when matching is
+	// not finished yet, wait blocks until it is
+	bool applyFilterResult(bool wait = false);
+	// requests applyFilterResult call on the UI thread, called from the worker thread
+	virtual void scheduleFilterApply() {}
 
 	bool onContextMenu(PropertyRow* row, property_tree::IMenu& menu);
 
@@ -170,6 +217,11 @@ protected:
 	virtual void updateAttachedPropertyTree(bool revert);
 
 	void onModelUpdated(const PropertyRows& rows, bool needApply);
+	void applyModelUpdate(bool needApply);
+	// requests flushPendingApply call for the next frame, flushes at once by default
+	virtual void schedulePendingApply() { flushPendingApply(); }
+	// writes postponed changes before attached objects are reverted or replaced
+	void applyPendingChanges();
 	void onModelPushUndo(PropertyTreeOperator* op, bool* handled);
 
 private:
@@ -186,6 +238,8 @@ protected:
 	Objects attached_;
 	PropertyTree* attachedPropertyTree_;
 	RowFilter rowFilter_;
+	std::auto_ptr<PropertyTreeFilter> treeFilter_;
+	std::auto_ptr<PropertyTreeWorkers> revertWorkers_; // started by first parallel revert
 	yasli::Context* archiveContext_;
 
 	int leftBorder_;
@@ -202,6 +256,9 @@ protected:
 	PropertyRow* pressedRow_;
 
 	bool autoRevert_;
+	bool batchedApply_;
+	bool updatePending_;
+	bool applyPending_;
 	int applyTime_;
 	int revertTime_;
 
@@ -211,6 +268,7 @@ protected:
 	friend class DragWindow;
 	friend class QDrawContext;
 	friend struct FilterVisitor;
+	friend class PropertyTreeFilter;
 	friend struct PropertyTreeMenuHandler;
     friend struct ContainerMenuHandler;
 	friend class PropertyTreeModel;
@@ -0,0 +1,321 @@
+/**
+ *  yasli - Serialization Library.
+ *  Copyright (C) 2007-2013 Evgeny Andreeshchev <eugene.andreeshchev@gmail.com>
+ *                          Alexander Kotliar <alexander.kotliar@gmail.com>
+ *
+ *  This code is distributed under the MIT License:
+ *                          http://www.opensource.org/licenses/MIT
+ */
+
+#include <string.h>
+#include "PropertyTreeFilter.h"
+#include "PropertyTreeModel.h"
+#include "PropertyRow.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define PROPERTY_TREE_SSE2 1
+# ifdef _MSC_VER
+#  include <intrin.h>
+# endif
+#endif
+
+void toLowerUtf8(char* str);
+
+// rows are checked for cancellation in batches
+static const size_t FILTER_CANCEL_CHECK = 1024;
+
+#ifdef PROPERTY_TREE_SSE2
+static inline unsigned lowestBit(unsigned mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return index;
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+const char* findSubstring(const char* text, size_t length, const char* pattern, size_t patternLength)
+{
+	if (patternLength == 0)
+		return text;
+	if (patternLength > length)
+		return 0;
+	size_t lastStart = length - patternLength;
+#ifdef PROPERTY_TREE_SSE2
+	// compares first and last characters of the pattern at 16 positions at once,
+	// the rest is compared only where both of them match
+	const __m128i first = _mm_set1_epi8(pattern[0]);
+	const __m128i last = _mm_set1_epi8(pattern[patternLength - 1]);
+	for (size_t i = 0; i <= lastStart; i += 16) {
+		__m128i blockFirst = _mm_loadu_si128((const __m128i*)(text + i));
+		__m128i blockLast = _mm_loadu_si128((const __m128i*)(text + i + patternLength - 1));
+		unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast)));
+		if (lastStart - i < 15)
+			mask &= (2u << (lastStart - i)) - 1;
+		while (mask) {
+			size_t pos = i + lowestBit(mask);
+			if (patternLength <= 2 || memcmp(text + pos + 1, pattern + 1, patternLength - 2) == 0)
+				return text + pos;
+			mask &= mask - 1;
+		}
+	}
+	return 0;
+#else
+	const char* end = text + lastStart + 1;
+	for (const char* p = text; p < end; ++p) {
+		p = (const char*)memchr(p, pattern[0], end - p);
+		if (!p)
+			return 0;
+		if (memcmp(p, pattern, patternLength) == 0)
+			return p;
+	}
+	return 0;
+#endif
+}
+
+// Same as PropertyRow::labelUndecorated, which is not set for elements of large
+// containers that were not laid out yet, see PropertyRow::parseControlCodes.
+static const char* undecoratedLabel(const PropertyRow* row)
+{
+	if (row->labelUndecorated())
+		return row->labelUndecorated();
+	const char* ptr = row->label();
+	if (!ptr)
+		return "";
+	while (*ptr) {
+		if (*ptr == '>') {
+			const char* p = ++ptr;
+			while (*p >= '0' && *p <= '9')
+				++p;
+			if (*p == '>')
+				ptr = ++p;
+			continue;
+		}
+		else if (*ptr == '[') {
+			int counter = 1;
+			while (*++ptr) {
+				if (*ptr == ']' && !--counter)
+					break;
+				else if (*ptr == '[')
+					++counter;
+			}
+			if (!*ptr)
+				break;
+		}
+		else if (!strchr("^+<-~!", *ptr))
+			break;
+		++ptr;
+	}
+	return ptr;
+}
+
+// ---------------------------------------------------------------------------
+
+PropertyTreeFilter::PropertyTreeFilter(PropertyTree* tree)
+: tree_(tree)
+, loweredCount_(0)
+, indexed_(false)
+, background_(false)
+, matchesAll_(true)
+, ready_(false)
+, matched_(false)
+, cancel_(false)
+, done_(true)
+{
+}
+
+PropertyTreeFilter::~PropertyTreeFilter()
+{
+	cancel();
+}
+
+void PropertyTreeFilter::cancel()
+{
+	if (thread_.joinable()) {
+		cancel_ = true;
+		thread_.join();
+		cancel_ = false;
+	}
+}
+
+void PropertyTreeFilter::invalidate()
+{
+	cancel();
+	ready_ = false;
+	done_ = true;
+	indexed_ = false;
+	entries_.clear();
+	text_.clear();
+	loweredCount_ = 0;
+	matched_ = false;
+	matchedRows_.clear();
+	matchCounts_.clear();
+}
+
+bool PropertyTreeFilter::start(const PropertyTree::RowFilter& filter, bool background)
+{
+	cancel();
+	ready_ = false;
+	matchesAll_ = filter.empty();
+	if (matchesAll_) {
+		// nothing to match, an index is not needed
+		ready_ = true;
+		done_ = true;
+		return true;
+	}
+
+	if (!indexed_) {
+		// rows are read on the calling thread only, worker thread works with copied text
+		collect(tree_->model()->root());
+		text_.resize(text_.size() + FILTER_TEXT_PADDING, '\0');
+		indexed_ = true;
+	}
+
+	filter_ = filter;
+	background_ = background;
+	done_ = false;
+	if (background) {
+		thread_ = std::thread(&PropertyTreeFilter::run, this);
+		return false;
+	}
+	run();
+	return ready_;
+}
+
+bool PropertyTreeFilter::finish(bool wait)
+{
+	if (!wait && !done_)
+		return false;
+	if (thread_.joinable())
+		thread_.join();
+	return ready_;
+}
+
+void PropertyTreeFilter::collect(PropertyRow* parent)
+{
+	int count = int(parent->count());
+	for (int i = 0; i < count; ++i) {
+		PropertyRow* row = parent->childByIndex(i);
+		size_t first = entries_.size();
+		collect(row);
+
+		Entry entry;
+		entry.row = row;
+		entry.childCount = unsigned(entries_.size() - first);
+		addText(&entry, LABEL, undecoratedLabel(row));
+		addText(&entry, VALUE, row->valueAsString().c_str());
+		addText(&entry, TYPE, row->typeNameForFilter(tree_));
+		entries_.push_back(entry);
+	}
+}
+
+void PropertyTreeFilter::addText(Entry* entry, int index, const char* text)
+{
+	if (!text)
+		text = "";
+	size_t length = strlen(text);
+	entry->text[index] = unsigned(text_.size());
+	entry->length[index] = unsigned(length);
+	text_.insert(text_.end(), text, text + length + 1);
+}
+
+void PropertyTreeFilter::run()
+{
+	if (lowerText() && match())
+		ready_ = true;
+	done_ = true;
+	if (ready_ && background_)
+		tree_->scheduleFilterApply();
+}
+
+bool PropertyTreeFilter::lowerText()
+{
+	// progress is kept, so cancelled matching does not lower the same text again
+	size_t count = entries_.size();
+	for (; loweredCount_ < count; ++loweredCount_) {
+		if (loweredCount_ % FILTER_CANCEL_CHECK == 0 && cancel_)
+			return false;
+		Entry& entry = entries_[loweredCount_];
+		for (int i = 0; i < NUM_TEXTS; ++i) {
+			char* str = &text_[entry.text[i]];
+			bool ascii = true;
+			for (char* p = str; *p; ++p) {
+				if ((unsigned char)*p >= 0x80)
+					ascii = false;
+				else if (*p >= 'A' && *p <= 'Z')
+					*p += 'a' - 'A';
+			}
+			if (!ascii) {
+				toLowerUtf8(str);
+				entry.length[i] = unsigned(strlen(str));
+			}
+		}
+	}
+	return true;
+}
+
+bool PropertyTreeFilter::matchEntry(const Entry& entry) const
+{
+	typedef PropertyTree::RowFilter RowFilter;
+	const char* label = &text_[entry.text[LABEL]];
+	const char* value = &text_[entry.text[VALUE]];
+	size_t labelLength = entry.length[LABEL];
+	size_t valueLength = entry.length[VALUE];
+
+	bool matchFilter = filter_.matchLowercase(label, labelLength, RowFilter::NAME_VALUE, 0, 0) ||
+		filter_.matchLowercase(value, valueLength, RowFilter::NAME_VALUE, 0, 0);
+	if (matchFilter && filter_.typeRelevant(RowFilter::NAME))
+		matchFilter = filter_.matchLowercase(label, labelLength, RowFilter::NAME, 0, 0);
+	if (matchFilter && filter_.typeRelevant(RowFilter::VALUE))
+		matchFilter = filter_.matchLowercase(value, valueLength, RowFilter::VALUE, 0, 0);
+	if (matchFilter && filter_.typeRelevant(RowFilter::TYPE))
+		matchFilter = filter_.matchLowercase(&text_[entry.text[TYPE]], entry.length[TYPE], RowFilter::TYPE, 0, 0);
+	return matchFilter;
+}
+
+bool PropertyTreeFilter::match()
+{
+	vector<unsigned> rows;
+	if (matched_ && filter_.narrows(matchedFilter_)) {
+		size_t count = matchedRows_.size();
+		for (size_t i = 0; i < count; ++i) {
+			if (i % FILTER_CANCEL_CHECK == 0 && cancel_)
+				return false;
+			if (matchEntry(entries_[matchedRows_[i]]))
+				rows.push_back(matchedRows_[i]);
+		}
+	}
+	else {
+		size_t count = entries_.size();
+		for (size_t i = 0; i < count; ++i) {
+			if (i % FILTER_CANCEL_CHECK == 0 && cancel_)
+				return false;
+			if (matchEntry(entries_[i]))
+				rows.push_back(unsigned(i));
+		}
+	}
+
+	matchedRows_.swap(rows);
+	matchedFilter_ = filter_;
+	matched_ = true;
+
+	// number of matching rows before each one, lets FilterVisitor find out
+	// whether any descendant of a row matches without visiting them
+	size_t count = entries_.size();
+	matchCounts_.resize(count + 1);
+	unsigned matchCount = 0;
+	size_t next = 0;
+	for (size_t i = 0; i < count; ++i) {
+		matchCounts_[i] = matchCount;
+		if (next < matchedRows_.size() && matchedRows_[next] == i) {
+			++matchCount;
+			++next;
+		}
+	}
+	matchCounts_[count] = matchCount;
+	return true;
+}
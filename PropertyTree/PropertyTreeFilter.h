@@ -0,0 +1,90 @@
+/**
+ *  yasli - Serialization Library.
+ *  Copyright (C) 2007-2013 Evgeny Andreeshchev <eugene.andreeshchev@gmail.com>
+ *                          Alexander Kotliar <alexander.kotliar@gmail.com>
+ *
+ *  This code is distributed under the MIT License:
+ *                          http://www.opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include "PropertyTree.h"
+
+class PropertyRow;
+
+// Number of bytes that may be read past the end of text by findSubstring.
+static const size_t FILTER_TEXT_PADDING = 16;
+
+// Returns the first occurrence of pattern in text or 0. Reads up to
+// FILTER_TEXT_PADDING - 1 bytes after the end of text.
+const char* findSubstring(const char* text, size_t length, const char* pattern, size_t patternLength);
+
+// Matches rows of the tree against RowFilter. Lowercase copy of labels, values
+// and type names of rows is made once after rows change, so typing in the
+// filter box does not convert text of every row again. A filter that narrows
+// the previous one tests only rows that matched it.
+class PropertyTreeFilter
+{
+public:
+	explicit PropertyTreeFilter(PropertyTree* tree);
+	~PropertyTreeFilter();
+
+	// Starts matching, on a worker thread when background is set. Returns true
+	// when result is ready already, otherwise PropertyTree::scheduleFilterApply
+	// is called from the worker thread once it is.
+	bool start(const PropertyTree::RowFilter& filter, bool background);
+	// returns false when matching is not finished or was cancelled
+	bool finish(bool wait);
+	// Stops matching and drops copied text, has to be called before rows are
+	// changed or destroyed.
+	void invalidate();
+
+	// Rows are numbered in PropertyRow::scanChildrenBottomUp order.
+	bool matchesAll() const { return matchesAll_; }
+	int rowCount() const { return int(entries_.size()); }
+	PropertyRow* row(int index) const { return entries_[index].row; }
+	bool rowMatches(int index) const { return matchCounts_[index + 1] != matchCounts_[index]; }
+	bool childrenMatch(int index) const { return matchCounts_[index] != matchCounts_[index - entries_[index].childCount]; }
+
+private:
+	enum { LABEL, VALUE, TYPE, NUM_TEXTS };
+
+	struct Entry
+	{
+		PropertyRow* row;
+		unsigned text[NUM_TEXTS]; // offsets in text_
+		unsigned length[NUM_TEXTS];
+		unsigned childCount; // all descendants, their entries precede this one
+	};
+
+	void cancel();
+	void collect(PropertyRow* parent);
+	void addText(Entry* entry, int index, const char* text);
+	void run();
+	bool lowerText();
+	bool match();
+	bool matchEntry(const Entry& entry) const;
+
+	PropertyTree* tree_;
+	vector<Entry> entries_;
+	vector<char> text_;
+	size_t loweredCount_;
+	bool indexed_;
+
+	PropertyTree::RowFilter filter_;
+	bool background_;
+	bool matchesAll_;
+	bool ready_;
+
+	PropertyTree::RowFilter matchedFilter_;
+	bool matched_;
+	vector<unsigned> matchedRows_;
+	vector<unsigned> matchCounts_;
+
+	std::thread thread_;
+	std::atomic<bool> cancel_;
+	std::atomic<bool> done_;
+};
@@ -17,6 +17,9 @@ PropertyTreeModel::PropertyTreeModel(PropertyTree* tree)
 , expandLevels_(0)
 , undoEnabled_(true)
 , fullUndo_(false)
+, undoMemoryBudget_(0)
+, undoMemoryUsed_(0)
+, constStrings_(&ownConstStrings_)
 {
 	clear();
 }
@@ -26,6 +29,15 @@ PropertyTreeModel::~PropertyTreeModel()
 	root_ = 0;
 	defaultTypes_.clear();
 	defaultTypesPoly_.clear();
+	for (size_t i = 0; i < workerConstStrings_.size(); ++i)
+		delete workerConstStrings_[i];
+}
+
+ConstStringList* PropertyTreeModel::workerConstStrings(int index)
+{
+	while (int(workerConstStrings_.size()) <= index)
+		workerConstStrings_.push_back(new ConstStringList());
+	return workerConstStrings_[index];
 }
 
 TreePath PropertyTreeModel::pathFromRow(PropertyRow* row)
@@ -137,14 +149,16 @@ void PropertyTreeModel::applyOperator(PropertyTreeOperator* op, bool createRedo)
     if(op->type_ == PropertyTreeOperator::NONE)
         return;
     YASLI_ESCAPE(op->row_, return);
+    // snapshot can share rows with other ones, so the tree gets its own copy
+    SharedPtr<PropertyRow> newRow = op->row_->clone(constStrings_);
+    newRow->assignRowState(*op->row_, true);
+    op->row_ = 0;
     if(dest->parent())
-        dest->parent()->replaceAndPreserveState(dest, op->row_, false);
+        dest->parent()->replaceAndPreserveState(dest, newRow, false);
     else{
-        op->row_->assignRowProperties(root_);
-        root_ = op->row_;
+        newRow->assignRowProperties(root_);
+        root_ = newRow;
     }
-    PropertyRow* newRow = op->row_;
-    op->row_ = 0;
     rowChanged(newRow);
     // TODO: redo
 }
@@ -155,9 +169,54 @@ void PropertyTreeModel::undo()
 	PropertyTreeOperator op;
 	std::swap(op, undoOperators_.back());
 	undoOperators_.pop_back();
+	// rows of the last step are not shared with earlier ones
+	undoMemoryUsed_ -= op.retainedBytes_;
 	applyOperator(&op, true);
 }
 
+void PropertyTreeModel::setUndoMemoryBudget(size_t bytes)
+{
+	undoMemoryBudget_ = bytes;
+	trimUndo();
+}
+
+size_t PropertyTreeModel::undoStepMemory(int step) const
+{
+	YASLI_ESCAPE(step >= 0 && step < int(undoOperators_.size()), return 0);
+	return undoOperators_[step].retainedBytes_;
+}
+
+// Memory that is released with the row: rows referenced from elsewhere
+// (newer snapshots) stay alive together with their children.
+static size_t exclusiveMemory(const PropertyRow* row)
+{
+	if(row->refCount() > 1)
+		return 0;
+	size_t result = row->memoryUsed();
+	for(PropertyRow::const_iterator it = row->begin(); it != row->end(); ++it)
+		result += exclusiveMemory(*it);
+	return result;
+}
+
+void PropertyTreeModel::trimUndo()
+{
+	if(undoMemoryBudget_ == 0)
+		return;
+	size_t count = 0;
+	while(undoMemoryUsed_ > undoMemoryBudget_ && count + 1 < undoOperators_.size()){
+		PropertyTreeOperator& op = undoOperators_[count];
+		size_t freed = op.row_ ? exclusiveMemory(op.row_) : 0;
+		if(freed > op.retainedBytes_)
+			freed = op.retainedBytes_;
+		op.row_ = 0;
+		undoMemoryUsed_ -= freed;
+		// rows that are still shared are accounted in the next step now
+		undoOperators_[count + 1].retainedBytes_ += op.retainedBytes_ - freed;
+		++count;
+	}
+	undoOperators_.erase(undoOperators_.begin(), undoOperators_.begin() + count);
+}
+
 PropertyTreeModel::UpdateLock PropertyTreeModel::lockUpdate()
 {
 	if(updateLock_)
@@ -245,8 +304,29 @@ void PropertyTreeModel::pushUndo(const PropertyTreeOperator& op)
     PropertyTreeOperator oper = op;
     bool handled = false;
     signalPushUndo(&oper, &handled);
-    if(!handled && oper.row_ != 0)
+    if(!handled && oper.row_ != 0){
         undoOperators_.push_back(oper);
+        undoMemoryUsed_ += oper.retainedBytes_;
+        trimUndo();
+    }
+}
+
+// Snapshot of the row at path from the last undo step, if there is one.
+PropertyRow* PropertyTreeModel::lastSnapshot(const TreePath& path)
+{
+	if(undoOperators_.empty())
+		return 0;
+	const PropertyTreeOperator& op = undoOperators_.back();
+	if(!op.row_ || op.path_.size() > path.size() || !std::equal(op.path_.begin(), op.path_.end(), path.begin()))
+		return 0;
+	PropertyRow* row = op.row_;
+	for(size_t i = op.path_.size(); i < path.size(); ++i){
+		int index = path[i].index;
+		if(index < 0 || index >= int(row->count()))
+			return 0;
+		row = row->childByIndex(index);
+	}
+	return row;
 }
 
 void PropertyTreeModel::rowAboutToBeChanged(PropertyRow* row)
@@ -254,9 +334,9 @@ void PropertyTreeModel::rowAboutToBeChanged(PropertyRow* row)
     YASLI_ESCAPE(row, return);
     if(fullUndo_){
         if(undoEnabled_){
-            SharedPtr<PropertyRow> clonedRow = root()->clone(constStrings());
-            clonedRow->assignRowState(*root(), true);
-            pushUndo(PropertyTreeOperator(TreePath(), clonedRow));
+            PropertyTreeOperator op(TreePath(), 0);
+            op.row_ = root()->cloneShared(lastSnapshot(op.path_), constStrings(), &op.retainedBytes_);
+            pushUndo(op);
         }
         else{
             pushUndo(PropertyTreeOperator(TreePath(), 0));
@@ -264,9 +344,9 @@ void PropertyTreeModel::rowAboutToBeChanged(PropertyRow* row)
     }
     else{
         if(undoEnabled_){
-			SharedPtr<PropertyRow> clonedRow = row->clone(constStrings());
-            clonedRow->assignRowState(*row, true);
-            pushUndo(PropertyTreeOperator(pathFromRow(row), clonedRow));
+            PropertyTreeOperator op(pathFromRow(row), 0);
+            op.row_ = row->cloneShared(lastSnapshot(op.path_), constStrings(), &op.retainedBytes_);
+            pushUndo(op);
         }
         else{
             pushUndo(PropertyTreeOperator(pathFromRow(row), 0));
@@ -285,12 +365,44 @@ void PropertyTreeModel::rowChanged(PropertyRow* row, bool apply)
 		parentObj = parentObj->parent();
 
 	row->setMultiValue(false);
+	setRowDirty(row);
 
 	PropertyRows rows;
 	rows.push_back(parentObj);
 	requestUpdate(rows, apply);
 }
 
+static void setDirtyRecursive(PropertyRow* row)
+{
+	row->setDirty(true);
+	for(PropertyRow::iterator it = row->begin(); it != row->end(); ++it)
+		setDirtyRecursive(*it);
+}
+
+void PropertyTreeModel::setRowDirty(PropertyRow* row)
+{
+	YASLI_ESCAPE(row, return);
+	// the whole subtree is written, as rows may have been replaced or added under it
+	setDirtyRecursive(row);
+	for(PropertyRow* parent = row->parent(); parent && !parent->dirty(); parent = parent->parent())
+		parent->setDirty(true);
+}
+
+static void clearDirtyRecursive(PropertyRow* row)
+{
+	if(!row->dirty())
+		return;
+	row->setDirty(false);
+	for(PropertyRow::iterator it = row->begin(); it != row->end(); ++it)
+		clearDirtyRecursive(*it);
+}
+
+void PropertyTreeModel::clearDirtyRows()
+{
+	if(root_)
+		clearDirtyRecursive(root_);
+}
+
 bool PropertyTreeModel::defaultTypeRegistered(const char* typeName) const
 {
 	return defaultTypes_.find(typeName) != defaultTypes_.end();
@@ -89,6 +89,15 @@ public:
 	void clear();
 	bool canUndo() const{ return !undoOperators_.empty(); }
 	void undo();
+	// Undo snapshots share rows that did not change between edits. When memory
+	// estimated for them exceeds the budget, oldest steps are dropped (last one
+	// is always kept). Zero budget means unlimited history.
+	void setUndoMemoryBudget(size_t bytes);
+	size_t undoMemoryBudget() const{ return undoMemoryBudget_; }
+	size_t undoMemoryUsed() const{ return undoMemoryUsed_; }
+	int undoStepCount() const{ return int(undoOperators_.size()); }
+	// memory retained by step, 0 is the oldest one
+	size_t undoStepMemory(int step) const;
 
 	TreePath pathFromRow(PropertyRow* node);
 	PropertyRow* rowFromPath(const TreePath& path);
@@ -113,6 +122,11 @@ public:
 
 	void rowAboutToBeChanged(PropertyRow* row);
 	void rowChanged(PropertyRow* row, bool apply = true); // be careful: it can destroy 'row'
+	// Marks row with all its children and parents as dirty, so next apply writes
+	// them. Done by rowChanged, needed only when row value is changed without it.
+	void setRowDirty(PropertyRow* row);
+	bool hasDirtyRows() const{ return root_ && root_->dirty(); }
+	void clearDirtyRows();
 
 	void setUndoEnabled(bool enabled) { undoEnabled_ = enabled; }
 	void setFullUndo(bool fullUndo) { fullUndo_ = fullUndo; }
@@ -133,13 +147,22 @@ public:
 	bool defaultTypeRegistered(const yasli::TypeID& baseType, const yasli::TypeID& derivedType) const;
 	void addDefaultType(const yasli::TypeID& baseType, const PropertyDefaultTypeValue& value);
 	const PropertyDefaultTypeValue* defaultType(const yasli::TypeID& baseType, int index) const;
-	ConstStringList* constStrings() { return &constStrings_; }
+	ConstStringList* constStrings() { return constStrings_; }
+	// Lets several models share interned strings. The list has to outlive the
+	// model and should be set before any rows are created.
+	void setConstStrings(ConstStringList* constStrings) { constStrings_ = constStrings ? constStrings : &ownConstStrings_; }
+	// List for a model that fills rows for this one on worker thread number
+	// index, see PropertyTree::intersectAttachedParallel. Strings interned
+	// there stay valid as long as this model.
+	ConstStringList* workerConstStrings(int index);
 
 private:
 	void signalUpdated(const PropertyRows& rows, bool needApply);
 	void signalPushUndo(PropertyTreeOperator* op, bool* result);
 
 	void pushUndo(const PropertyTreeOperator& op);
+	PropertyRow* lastSnapshot(const TreePath& path);
+	void trimUndo();
 	void clearObjectReferences();
 
 	TreePath focusedRow_;
@@ -168,8 +191,12 @@ private:
 
 	std::vector<PropertyTreeOperator> undoOperators_;
 	std::vector<PropertyTreeOperator> redoOperators_;
+	size_t undoMemoryBudget_;
+	size_t undoMemoryUsed_;
 
-	ConstStringList constStrings_;
+	ConstStringList ownConstStrings_;
+	ConstStringList* constStrings_;
+	std::vector<ConstStringList*> workerConstStrings_;
 	PropertyTree* tree_;
 
 	friend class TreeImpl;
@@ -26,12 +26,14 @@ PropertyTreeOperator::PropertyTreeOperator(const TreePath& path, PropertyRow* ro
 , path_(path)
 , index_(-1)
 , row_(row)
+, retainedBytes_(0)
 {
 }
 
 PropertyTreeOperator::PropertyTreeOperator()
 : type_(NONE)
 , index_(-1)
+, retainedBytes_(0)
 {
 }
 
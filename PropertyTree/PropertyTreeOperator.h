@@ -53,6 +53,9 @@ private:
     TreePath path_;
     yasli::SharedPtr<PropertyRow> row_;
     int index_;
+    // estimated size of rows that were copied for this operator, rows shared
+    // with previous operators are accounted there
+    size_t retainedBytes_;
     friend class PropertyTreeModel;
 };
 
@@ -0,0 +1,71 @@
+/**
+ *  yasli - Serialization Library.
+ *  Copyright (C) 2007-2013 Evgeny Andreeshchev <eugene.andreeshchev@gmail.com>
+ *                          Alexander Kotliar <alexander.kotliar@gmail.com>
+ *
+ *  This code is distributed under the MIT License:
+ *                          http://www.opensource.org/licenses/MIT
+ */
+
+#include "PropertyTreeWorkers.h"
+
+PropertyTreeWorkers::PropertyTreeWorkers(int threadCount)
+: task_(0)
+, partCount_(0)
+, nextPart_(0)
+, pendingParts_(0)
+, stop_(false)
+{
+	for (int i = 0; i < threadCount; ++i)
+		threads_.push_back(std::thread(&PropertyTreeWorkers::work, this));
+}
+
+PropertyTreeWorkers::~PropertyTreeWorkers()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	for (size_t i = 0; i < threads_.size(); ++i)
+		threads_[i].join();
+}
+
+void PropertyTreeWorkers::run(PropertyTreeTask& task, int partCount)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	task_ = &task;
+	partCount_ = partCount;
+	nextPart_ = 0;
+	pendingParts_ = partCount;
+	if (partCount > 1)
+		wake_.notify_all();
+
+	while (runPart(lock)) {}
+	while (pendingParts_ > 0)
+		finished_.wait(lock);
+	task_ = 0;
+}
+
+bool PropertyTreeWorkers::runPart(std::unique_lock<std::mutex>& lock)
+{
+	if (!task_ || nextPart_ >= partCount_)
+		return false;
+	PropertyTreeTask* task = task_;
+	int part = nextPart_++;
+	lock.unlock();
+	task->run(part);
+	lock.lock();
+	if (--pendingParts_ == 0)
+		finished_.notify_all();
+	return true;
+}
+
+void PropertyTreeWorkers::work()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (!stop_) {
+		if (!runPart(lock))
+			wake_.wait(lock);
+	}
+}
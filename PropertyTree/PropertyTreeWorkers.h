@@ -0,0 +1,52 @@
+/**
+ *  yasli - Serialization Library.
+ *  Copyright (C) 2007-2013 Evgeny Andreeshchev <eugene.andreeshchev@gmail.com>
+ *                          Alexander Kotliar <alexander.kotliar@gmail.com>
+ *
+ *  This code is distributed under the MIT License:
+ *                          http://www.opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Work split into numbered parts that may run concurrently.
+struct PropertyTreeTask
+{
+	virtual ~PropertyTreeTask() {}
+	virtual void run(int part) = 0;
+};
+
+// Fixed set of worker threads that run parts of a task together with the
+// calling thread. Threads are started once and sleep between tasks, so
+// parallel revert does not pay for thread startup every time. Tasks are
+// run one at a time, from one thread.
+class PropertyTreeWorkers
+{
+public:
+	explicit PropertyTreeWorkers(int threadCount);
+	~PropertyTreeWorkers();
+
+	int threadCount() const { return int(threads_.size()); }
+	// Runs parts [0, partCount) of the task, returns when all of them are done.
+	void run(PropertyTreeTask& task, int partCount);
+
+private:
+	void work();
+	// runs next part of current task with mutex_ unlocked, false when there are none left
+	bool runPart(std::unique_lock<std::mutex>& lock);
+
+	std::vector<std::thread> threads_;
+	std::mutex mutex_;
+	std::condition_variable wake_;
+	std::condition_variable finished_;
+	PropertyTreeTask* task_;
+	int partCount_;
+	int nextPart_;
+	int pendingParts_;
+	bool stop_;
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <stddef.h>
 
 class TreeConfig
 {
@@ -22,8 +23,26 @@ public:
 	void setFilterWhenType(bool filterWhenType) {	filterWhenType_ = filterWhenType; }
 	void setExpandLevels(int levels) { expandLevels_ = levels; }
 	void setUndoEnabled(bool enabled, bool full = false) { undoEnabled_ = enabled; fullUndo_ = full; }
+	// Estimated memory that undo history may keep, 0 - unlimited.
+	void setUndoMemoryBudget(size_t bytes) { undoMemoryBudget_ = bytes; }
+	size_t undoMemoryBudget() const{ return undoMemoryBudget_; }
 	void setShowContainerIndices(bool showContainerIndices) { showContainerIndices_ = showContainerIndices; }
 	void setSliderUpdateDelay(int delayMS) { sliderUpdateDelay_ = delayMS; }
+	// Lets revert() skip structs whose memory did not change since the previous
+	// revert. Only safe when serialize() output depends solely on the bytes of
+	// the object, i.e. not on contexts or global state.
+	void setIncrementalRevert(bool incrementalRevert) { incrementalRevert_ = incrementalRevert; }
+	bool incrementalRevert() const{ return incrementalRevert_; }
+	// Lets revert() serialize several attached objects on worker threads. Only
+	// safe when serialize() of attached objects can run concurrently.
+	// onAboutToSerialize is called once, on the calling thread, and contexts it
+	// sets are shared by archives of all threads.
+	void setParallelRevert(bool parallelRevert) { parallelRevert_ = parallelRevert; }
+	bool parallelRevert() const{ return parallelRevert_; }
+	// Lets filter match rows on a worker thread, the tree applies the result
+	// once it is ready, see PropertyTree::scheduleFilterApply.
+	void setBackgroundFilter(bool backgroundFilter) { backgroundFilter_ = backgroundFilter; }
+	bool backgroundFilter() const{ return backgroundFilter_; }
 	bool showContainerIndices() const{ return showContainerIndices_; }
 	int _defaultRowHeight() const { return defaultRowHeight_; }
 
@@ -46,4 +65,8 @@ protected:
 	int expandLevels_;
 	bool undoEnabled_;
 	bool fullUndo_;
+	size_t undoMemoryBudget_;
+	bool incrementalRevert_;
+	bool parallelRevert_;
+	bool backgroundFilter_;
 };
@@ -13,8 +13,8 @@
 # define WIN32_LEAN_AND_MEAN
 # include <windows.h>
 #else
-# include <vector>
-# include <QString>
+# include <locale>
+# include <codecvt>
 #endif
 
 namespace property_tree {
@@ -38,7 +38,9 @@ yasli::string fromWideChar(const wchar_t* wstr)
 	}
 	return yasli::string();
 #else
-    return QString::fromWCharArray(wstr).toUtf8().data();
+	// invalid characters give empty string instead of exception
+	std::wstring_convert<std::codecvt_utf8<wchar_t> > convert("", L"");
+	return convert.to_bytes(wstr).c_str();
 #endif
 }
 
@@ -58,11 +60,8 @@ yasli::wstring toWideChar(const char* str)
     }
 	return yasli::wstring();
 #else
-    QString s = QString::fromUtf8(str);
-
-    std::vector<wchar_t> result(s.size()+1);
-    s.toWCharArray(&result[0]);
-    return &result[0];
+	std::wstring_convert<std::codecvt_utf8<wchar_t> > convert("", L"");
+	return convert.from_bytes(str).c_str();
 #endif
 }
 
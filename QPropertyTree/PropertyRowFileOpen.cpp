@@ -68,6 +68,12 @@ class PropertyRowFileOpen : public PropertyRowImpl<FileOpen>{
 public:
 
 	bool isLeaf() const override{ return true; }
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowFileOpen(*this); }
+	bool sameValue(const PropertyRow& row) const override{
+		const FileOpen& file = static_cast<const PropertyRowFileOpen&>(row).value_;
+		return value_.pathPointer == file.pathPointer && value_.path == file.path && value_.filter == file.filter &&
+			   value_.relativeToFolder == file.relativeToFolder && value_.flags == file.flags;
+	}
 
 	bool onActivate(PropertyTree* tree, bool force) override
 	{
@@ -28,6 +28,12 @@ class PropertyRowFileSave : public PropertyRowImpl<FileSave>{
 public:
 
 	bool isLeaf() const override{ return true; }
+	PropertyRow* cloneRow(ConstStringList*) const override{ return new PropertyRowFileSave(*this); }
+	bool sameValue(const PropertyRow& row) const override{
+		const FileSave& file = static_cast<const PropertyRowFileSave&>(row).value_;
+		return value_.pathPointer == file.pathPointer && value_.path == file.path && value_.filter == file.filter &&
+			   value_.relativeToFolder == file.relativeToFolder;
+	}
 
 	bool onActivate(PropertyTree* tree, bool force) override
 	{
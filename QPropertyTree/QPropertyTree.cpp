@@ -15,6 +15,7 @@
 #include "PropertyTree/IDrawContext.h"
 #include "PropertyTree/Serialization.h"
 #include "PropertyTree/PropertyTreeModel.h"
+#include "PropertyTree/PropertyTreeFilter.h"
 #include "PropertyTree/PropertyOArchive.h"
 #include "PropertyTree/PropertyIArchive.h"
 #include "PropertyTree/Unicode.h"
@@ -97,7 +98,7 @@ using yasli::Serializers;
 static QMimeData* propertyRowToMimeData(PropertyRow* row, ConstStringList* constStrings)
 {
 	PropertyRow::setConstStrings(constStrings);
-	SharedPtr<PropertyRow> clonedRow(row->clone(constStrings));
+	SharedPtr<PropertyRow> clonedRow(row->cloneSerialized(constStrings));
 	yasli::BinOArchive oa;
 	PropertyRow::setConstStrings(constStrings);
 	if (!oa(clonedRow, "row", "Row")) {
@@ -578,11 +579,15 @@ QPropertyTree::QPropertyTree(QWidget* parent)
 
 	boldFont_ = font();
 	boldFont_.setBold(true);
+
+	setBackgroundFilter(true);
 }
 #pragma warning(pop)
 
 QPropertyTree::~QPropertyTree()
 {
+	// filter thread may call scheduleFilterApply otherwise
+	treeFilter_->invalidate();
 	clearMenuHandlers();
 }
 
@@ -610,19 +615,9 @@ void QPropertyTree::updateHeights()
 
 		updateScrollBar();
 
-		model()->root()->updateLabel(this, 0);
 		int lb = compact_ ? 0 : 4;
 		int rb = widgetRect.right() - lb - scrollBarW - 2;
-		bool force = lb != leftBorder_ || rb != rightBorder_;
-		leftBorder_ = lb;
-		rightBorder_ = rb;
-		model()->root()->calculateMinimalSize(this, leftBorder_, force, 0, 0);
-
-		size_.setX(area_.width());
-
-		int totalHeight = area_.top();
-		model()->root()->adjustVerticalPosition(this, totalHeight);
-		size_.setY(totalHeight - area_.top());
+		layoutRows(lb, rb);
 
 		updateHeightsTime_ = timer.elapsed();
 	}
@@ -663,6 +658,7 @@ const QFont& QPropertyTree::boldFont() const
 void QPropertyTree::onScroll(int pos)
 {
 	offset_.setY(scrollBar_->sliderPosition());
+	layoutVisibleRows();
 	_arrangeChildren();
 	repaint();
 }
@@ -767,7 +763,11 @@ void QPropertyTree::_arrangeChildren()
 		if(row->visible(this)){
 			QWidget* w = (QWidget*)widget_->actualWidget();
 			YASLI_ASSERT(w);
-			if(w){
+			if(w && !row->placed()){
+				// element of large container scrolled far away, has no position
+				w->hide();
+			}
+			else if(w){
 				QRect rect = toQRect(row->widgetRect(this));
 				rect = QRect(rect.topLeft() - toQPoint(offset_), 
 							 rect.bottomRight() - toQPoint(offset_));
@@ -812,107 +812,22 @@ void QPropertyTree::attachPropertyTree(PropertyTree* propertyTree)
 	connect((QPropertyTree*)attachedPropertyTree_, SIGNAL(signalChanged()), this, SLOT(onAttachedTreeChanged()));
 }
 
-struct FilterVisitor
-{
-	const QPropertyTree::RowFilter& filter_;
-
-	FilterVisitor(const QPropertyTree::RowFilter& filter) 
-    : filter_(filter)
-    {
-    }
-
-	static void markChildrenAsBelonging(PropertyRow* row, bool belongs)
-	{
-		int count = int(row->count());
-		for (int i = 0; i < count; ++i)
-		{
-			PropertyRow* child = row->childByIndex(i);
-			child->setBelongsToFilteredRow(belongs);
-
-			markChildrenAsBelonging(child, belongs);
-		}
-	}
-	
-	static bool hasMatchingChildren(PropertyRow* row)
-	{
-		int numChildren = (int)row->count();
-		for (int i = 0; i < numChildren; ++i)
-		{
-			PropertyRow* child = row->childByIndex(i);
-			if (!child)
-				continue;
-			if (child->matchFilter())
-				return true;
-			if (hasMatchingChildren(child))
-				return true;
-		}
-		return false;
-	}
-
-	ScanResult operator()(PropertyRow* row, PropertyTree* _tree)
-	{
-		QPropertyTree* tree = (QPropertyTree*)_tree;
-		const char* label = row->labelUndecorated();
-		yasli::string value = row->valueAsString();
-
-		bool matchFilter = filter_.match(label, filter_.NAME_VALUE, 0, 0) || filter_.match(value.c_str(), filter_.NAME_VALUE, 0, 0);
-		if (matchFilter && filter_.typeRelevant(filter_.NAME))
-			filter_.match(label, filter_.NAME, 0, 0);
-		if (matchFilter && filter_.typeRelevant(filter_.VALUE))
-			matchFilter = filter_.match(value.c_str(), filter_.VALUE, 0, 0);
-		if (matchFilter && filter_.typeRelevant(filter_.TYPE))
-			matchFilter = filter_.match(row->typeNameForFilter(tree), filter_.TYPE, 0, 0);						   
-		
-		int numChildren = int(row->count());
-		if (matchFilter) {
-			if (row->pulledBefore() || row->pulledUp()) {
-				// treat pulled rows as part of parent
-				PropertyRow* parent = row->parent();
-				parent->setMatchFilter(true);
-				markChildrenAsBelonging(parent, true);
-				parent->setBelongsToFilteredRow(false);
-			}
-			else {
-				markChildrenAsBelonging(row, true);
-				row->setBelongsToFilteredRow(false);
-				row->setLayoutChanged();
-				row->setLabelChanged();
-			}
-		}
-		else {
-			bool belongs = hasMatchingChildren(row);
-			row->setBelongsToFilteredRow(belongs);
-			if (belongs) {
-				tree->expandRow(row, true, false);
-				for (int i = 0; i < numChildren; ++i) {
-					PropertyRow* child = row->childByIndex(i);
-					if (child->pulledUp())
-						child->setBelongsToFilteredRow(true);
-				}
-			}
-			else {
-				row->_setExpanded(false);
-				row->setLayoutChanged();
-			}
-		}
-
-		row->setMatchFilter(matchFilter);
-		return SCAN_CHILDREN_SIBLINGS;
-	}
-
-protected:
-	yasli::string labelStart_;
-};
-
-
 void QPropertyTree::onFilterChanged(const QString& text)
 {
 	QByteArray arr = filterEntry_->text().toLocal8Bit();
 	const char* filterStr = filterMode_ ? arr.data() : "";
-	rowFilter_.parse(filterStr);
-	FilterVisitor visitor(rowFilter_);
-	model()->root()->scanChildrenBottomUp(visitor, this);
-	updateHeights();
+	matchFilter(filterStr);
+}
+
+void QPropertyTree::scheduleFilterApply()
+{
+	// called from the filter thread, slot is invoked on the UI thread
+	QMetaObject::invokeMethod(this, "onFilterMatched", Qt::QueuedConnection);
+}
+
+void QPropertyTree::onFilterMatched()
+{
+	applyFilterResult();
 }
 
 void QPropertyTree::drawFilteredString(QPainter& p, const char* text, RowFilter::Type type, const QFont* font, const QRect& rect, const QColor& textColor, bool pathEllipsis, bool center) const
@@ -1022,10 +937,10 @@ void QPropertyTree::paintEvent(QPaintEvent* ev)
 
     if (model()->root()) {
         DrawVisitor selectionOp(painter, toQRect(area_), offset_.y(), true);
-        model()->root()->scanChildren(selectionOp, this);
+        model()->root()->scanPlacedChildren(selectionOp, this);
 
         DrawVisitor op(painter, toQRect(area_), offset_.y(), false);
-        model()->root()->scanChildren(op, this);
+        model()->root()->scanPlacedChildren(op, this);
     }
 
 	painter.translate(offset_.x(), offset_.y());
@@ -1235,6 +1150,17 @@ void QPropertyTree::onMouseStillTimer()
 	onMouseStill();
 }
 
+void QPropertyTree::schedulePendingApply()
+{
+	// zero timeout fires after events that are already queued, coalescing them
+	QTimer::singleShot(0, this, SLOT(onPendingApplyTimer()));
+}
+
+void QPropertyTree::onPendingApplyTimer()
+{
+	flushPendingApply();
+}
+
 void QPropertyTree::mouseMoveEvent(QMouseEvent* ev)
 {
 	if(dragController_->captured() && !ev->buttons().testFlag(Qt::LeftButton))
@@ -88,6 +88,8 @@ public slots:
 protected slots:
 	void onScroll(int pos);
 	void onMouseStillTimer();
+	void onPendingApplyTimer();
+	void onFilterMatched();
 
 protected:
 	void onAboutToSerialize(yasli::Archive& ar) override { signalAboutToSerialize(ar); }
@@ -108,6 +110,8 @@ protected:
 
 	void updateHeights() override;
 	void repaint() override { update(); }
+	void schedulePendingApply() override;
+	void scheduleFilterApply() override;
 	void resetFilter() override { onFilterChanged(QString()); }
 
 	QSize sizeHint() const override;
@@ -15,7 +15,7 @@ LOCAL_CFLAGS := -DXMATH_IN_ENGLISH
 
 LOCAL_EXPORT_C_INCLUDES := $(LOCAL_C_INCLUDES)
 
-LOCAL_SRC_FILES := XMath.cpp Recti.cpp Rectf.cpp Range.cpp Colors.cpp ExceptionStub.cpp
+LOCAL_SRC_FILES := XMath.cpp Recti.cpp Rectf.cpp Range.cpp Colors.cpp ExceptionStub.cpp MTSection.cpp XMathBatch.cpp XMathBatchAVX.cpp XMathSoA.cpp Random.cpp XClock.cpp QuantileHistogram.cpp
 
 include $(BUILD_SHARED_LIBRARY)
 
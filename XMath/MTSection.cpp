@@ -0,0 +1,215 @@
+#include "stdafx.h"
+#include <limits.h>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include "MTSection.h"
+#include "yasli/Archive.h"
+
+#if defined(__linux__)
+# include <unistd.h>
+# include <sys/syscall.h>
+# include <linux/futex.h>
+#elif defined(_WIN32)
+# include <windows.h>
+# if _WIN32_WINNT >= 0x0602
+#  define MT_WAIT_ON_ADDRESS
+#  pragma comment(lib, "Synchronization.lib")
+# endif
+#endif
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+# include <emmintrin.h>
+# define MT_PAUSE() _mm_pause()
+#else
+# define MT_PAUSE()
+#endif
+
+using namespace yasli;
+
+// upper limit of spinning before a thread goes to sleep, as in glibc
+static const int MT_MAX_SPINS = 100;
+// MTSpinLock does not sleep, it yields the thread after this
+static const int MT_SPINS_BEFORE_YIELD = 1000;
+
+// Sleeps while address holds value, may return earlier.
+static void waitOnAddress(std::atomic<int>& address, int value)
+{
+#if defined(__linux__)
+	syscall(SYS_futex, (int*)&address, FUTEX_WAIT_PRIVATE, value, 0, 0, 0);
+#elif defined(MT_WAIT_ON_ADDRESS)
+	WaitOnAddress((volatile VOID*)&address, &value, sizeof(value), INFINITE);
+#else
+	// no way to wait for a change here, callers check the lock again after a nap
+	if(address.load(std::memory_order_relaxed) == value)
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+}
+
+static void wakeAddress(std::atomic<int>& address, bool all)
+{
+#if defined(__linux__)
+	syscall(SYS_futex, (int*)&address, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, 0, 0, 0);
+#elif defined(MT_WAIT_ON_ADDRESS)
+	if(all)
+		WakeByAddressAll((PVOID)&address);
+	else
+		WakeByAddressSingle((PVOID)&address);
+#endif
+}
+
+MTLockStatistics& MTLockStatistics::operator += (const MTLockStatistics& statistics)
+{
+	acquisitions += statistics.acquisitions;
+	contentions += statistics.contentions;
+	waits += statistics.waits;
+	return *this;
+}
+
+void MTLockStatistics::serialize(Archive& ar)
+{
+	ar(acquisitions, "acquisitions", "Acquisitions");
+	ar(contentions, "contentions", "Contentions");
+	ar(waits, "waits", "Waits");
+}
+
+///////////////////////////////////////////////////////////////////////
+//	MTSpinLock
+///////////////////////////////////////////////////////////////////////
+void MTSpinLock::lockContended()
+{
+	contentions_.fetch_add(1, std::memory_order_relaxed);
+	for(int spins = 0;; ++spins){
+		if(!state_.load(std::memory_order_relaxed) && !state_.exchange(1, std::memory_order_acquire))
+			return;
+		if(spins < MT_SPINS_BEFORE_YIELD)
+			MT_PAUSE();
+		else
+			std::this_thread::yield();
+	}
+}
+
+MTLockStatistics MTSpinLock::statistics() const
+{
+	MTLockStatistics statistics;
+	statistics.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+	statistics.contentions = contentions_.load(std::memory_order_relaxed);
+	return statistics;
+}
+
+///////////////////////////////////////////////////////////////////////
+//	MTMutex
+///////////////////////////////////////////////////////////////////////
+void MTMutex::lockContended()
+{
+	contentions_.fetch_add(1, std::memory_order_relaxed);
+
+	// spins a bit longer than it took to get the lock recently
+	int spins = spins_.load(std::memory_order_relaxed);
+	int maxSpins = std::min(MT_MAX_SPINS, spins*2 + 10);
+	for(int i = 0; i < maxSpins; ++i){
+		MT_PAUSE();
+		int state = state_.load(std::memory_order_relaxed);
+		if(!state && state_.compare_exchange_weak(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed)){
+			spins_.store(spins + (i - spins)/8, std::memory_order_relaxed);
+			return;
+		}
+	}
+	spins_.store(spins + (maxSpins - spins)/8, std::memory_order_relaxed);
+
+	// Lock taken this way keeps LOCKED_WAITERS, so unlock() wakes next
+	// sleeping thread, if there is one.
+	int state = state_.exchange(LOCKED_WAITERS, std::memory_order_acquire);
+	while(state){
+		waits_.fetch_add(1, std::memory_order_relaxed);
+		waitOnAddress(state_, LOCKED_WAITERS);
+		state = state_.exchange(LOCKED_WAITERS, std::memory_order_acquire);
+	}
+}
+
+void MTMutex::wake()
+{
+	wakeAddress(state_, false);
+}
+
+MTLockStatistics MTMutex::statistics() const
+{
+	MTLockStatistics statistics;
+	statistics.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+	statistics.contentions = contentions_.load(std::memory_order_relaxed);
+	statistics.waits = waits_.load(std::memory_order_relaxed);
+	return statistics;
+}
+
+///////////////////////////////////////////////////////////////////////
+//	MTSection
+///////////////////////////////////////////////////////////////////////
+MT_THREAD_LOCAL char MTSection::threadMarker_;
+
+///////////////////////////////////////////////////////////////////////
+//	MTReadWriteSection
+///////////////////////////////////////////////////////////////////////
+void MTReadWriteSection::lockSharedContended()
+{
+	contentions_.fetch_add(1, std::memory_order_relaxed);
+	for(int spins = 0;; ++spins){
+		int state = state_.load(std::memory_order_relaxed);
+		if(!(state & (WRITER | WRITER_WAITING))){
+			if(state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed))
+				return;
+			continue; // another reader came
+		}
+		if(spins < MT_MAX_SPINS)
+			MT_PAUSE();
+		else
+			sleep(WRITER | WRITER_WAITING);
+	}
+}
+
+void MTReadWriteSection::lockContended()
+{
+	contentions_.fetch_add(1, std::memory_order_relaxed);
+	for(int spins = 0;; ++spins){
+		int state = state_.load(std::memory_order_relaxed);
+		if(!(state & (WRITER | READERS))){
+			// WRITER_WAITING is cleared, other waiting writers set it again
+			if(state_.compare_exchange_weak(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed))
+				return;
+			continue;
+		}
+		if(!(state & WRITER_WAITING))
+			state_.fetch_or(WRITER_WAITING, std::memory_order_relaxed);
+		if(spins < MT_MAX_SPINS)
+			MT_PAUSE();
+		else
+			sleep(WRITER | READERS);
+	}
+}
+
+// Unlocking thread changes state_ and then checks sleepers_, sleeping thread
+// does the opposite, so one of them sees the change made by the other one.
+void MTReadWriteSection::sleep(int blockingBits)
+{
+	sleepers_.fetch_add(1, std::memory_order_seq_cst);
+	int epoch = epoch_.load(std::memory_order_seq_cst);
+	if(state_.load(std::memory_order_seq_cst) & blockingBits){
+		waits_.fetch_add(1, std::memory_order_relaxed);
+		waitOnAddress(epoch_, epoch);
+	}
+	sleepers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void MTReadWriteSection::wake()
+{
+	epoch_.fetch_add(1, std::memory_order_seq_cst);
+	wakeAddress(epoch_, true);
+}
+
+MTLockStatistics MTReadWriteSection::statistics() const
+{
+	MTLockStatistics statistics;
+	statistics.acquisitions = sharedAcquisitions_.load(std::memory_order_relaxed) + acquisitions_.load(std::memory_order_relaxed);
+	statistics.contentions = contentions_.load(std::memory_order_relaxed);
+	statistics.waits = waits_.load(std::memory_order_relaxed);
+	return statistics;
+}
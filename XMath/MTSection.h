@@ -1,69 +1,254 @@
 #pragma once
 
-#include <Windows.h>
+#include <atomic>
 #include "yasli/Assert.h"
+#include "yasli/Config.h"
 
+#ifdef _MSC_VER
+# define MT_THREAD_LOCAL __declspec(thread)
+#else
+# define MT_THREAD_LOCAL __thread
+#endif
+
+namespace yasli { class Archive; }
+
+// Locks spin for a while when they are taken by another thread and then put
+// the thread to sleep: futex on Linux, WaitOnAddress on Windows 8+, short
+// sleeps elsewhere. Every lock counts its acquisitions and contention.
+struct MTLockStatistics
+{
+	yasli::u64 acquisitions;
+	yasli::u64 contentions; // lock was taken by another thread
+	yasli::u64 waits;       // thread went to sleep after spinning
+
+	MTLockStatistics() : acquisitions(0), contentions(0), waits(0) {}
+	MTLockStatistics& operator += (const MTLockStatistics& statistics);
+	void serialize(yasli::Archive& ar);
+};
+
+// For sections of a few instructions: never sleeps, yields the thread when
+// spinning takes too long.
+class MTSpinLock
+{
+public:
+	MTSpinLock() : state_(0), acquisitions_(0), contentions_(0) {}
+
+	void lock()
+	{
+		if(state_.exchange(1, std::memory_order_acquire))
+			lockContended();
+		acquisitions_.store(acquisitions_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+	bool tryLock()
+	{
+		if(state_.load(std::memory_order_relaxed) || state_.exchange(1, std::memory_order_acquire))
+			return false;
+		acquisitions_.store(acquisitions_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return true;
+	}
+	void unlock() { state_.store(0, std::memory_order_release); }
+
+	MTLockStatistics statistics() const;
+
+private:
+	MTSpinLock(const MTSpinLock&);
+	void operator=(const MTSpinLock&);
+
+	void lockContended();
+
+	std::atomic<int> state_;
+	std::atomic<yasli::u64> acquisitions_; // changed by the owner only
+	std::atomic<yasli::u64> contentions_;
+};
+
+// Not recursive. Number of spins before sleeping adapts to how long the lock
+// was held recently, as in adaptive mutexes of glibc.
+class MTMutex
+{
+public:
+	MTMutex() : state_(0), spins_(0), acquisitions_(0), contentions_(0), waits_(0) {}
+
+	void lock()
+	{
+		int state = 0;
+		if(!state_.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+			lockContended();
+		acquisitions_.store(acquisitions_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+	bool tryLock()
+	{
+		int state = 0;
+		if(!state_.compare_exchange_strong(state, LOCKED, std::memory_order_acquire, std::memory_order_relaxed))
+			return false;
+		acquisitions_.store(acquisitions_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return true;
+	}
+	void unlock()
+	{
+		if(state_.exchange(0, std::memory_order_release) == LOCKED_WAITERS)
+			wake();
+	}
+
+	MTLockStatistics statistics() const;
+
+private:
+	enum { LOCKED = 1, LOCKED_WAITERS = 2 };
+
+	MTMutex(const MTMutex&);
+	void operator=(const MTMutex&);
+
+	void lockContended();
+	void wake();
+
+	std::atomic<int> state_;
+	std::atomic<int> spins_;
+	std::atomic<yasli::u64> acquisitions_; // changed by the owner only
+	std::atomic<yasli::u64> contentions_;
+	std::atomic<yasli::u64> waits_;
+};
+
+// Recursive lock, the thread that holds it may lock it again.
 class MTSection
 {
 protected:
 	//      .         .
 	MTSection(const MTSection& in)
+	: owner_(0)
+	, num_lock(0)
 	{
-		InitializeCriticalSection(&cs);
-		num_lock=0;
 	}
 	void operator =(const MTSection& in) {} //Don't copy this object
 public:
 	MTSection()
+	: owner_(0)
+	, num_lock(0)
 	{
-		InitializeCriticalSection(&cs);
-		num_lock=0;
-	}
-
-	~MTSection()
-	{
-		DeleteCriticalSection(&cs);
 	}
 
-
 	void lock()
 	{
 #ifdef start_timer_auto
 		start_timer_auto();
 #endif
-		EnterCriticalSection(&cs);
-		num_lock++;
+		lockInternal();
 	}
 
 	void unlock()
 	{
-		num_lock--;
-		YASLI_ASSERT(num_lock>=0);
-		LeaveCriticalSection(&cs);
+		unlockInternal();
+	}
+
+	bool tryLock()
+	{
+		if(owner_.load(std::memory_order_relaxed) != &threadMarker_){
+			if(!mutex_.tryLock())
+				return false;
+			owner_.store(&threadMarker_, std::memory_order_relaxed);
+		}
+		num_lock.store(num_lock.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return true;
 	}
 
-	bool locked() const { return num_lock > 0; }
+	bool locked() const { return num_lock.load(std::memory_order_relaxed) > 0; }
+
+	MTLockStatistics statistics() const { return mutex_.statistics(); }
 
 private:
-	CRITICAL_SECTION cs;
-	int num_lock;
+	MTMutex mutex_;
+	// only the owner thread can find its own marker here
+	std::atomic<const char*> owner_;
+	std::atomic<int> num_lock;
+
+	static MT_THREAD_LOCAL char threadMarker_;
 
 	void lockInternal()
 	{
-		EnterCriticalSection(&cs);
-		num_lock++;
+		if(owner_.load(std::memory_order_relaxed) != &threadMarker_){
+			mutex_.lock();
+			owner_.store(&threadMarker_, std::memory_order_relaxed);
+		}
+		num_lock.store(num_lock.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 	}
 
 	void unlockInternal()
 	{
-		num_lock--;
-		YASLI_ASSERT(num_lock>=0);
-		LeaveCriticalSection(&cs);
+		YASLI_ASSERT(owner_.load(std::memory_order_relaxed) == &threadMarker_);
+		int count = num_lock.load(std::memory_order_relaxed) - 1;
+		YASLI_ASSERT(count>=0);
+		num_lock.store(count, std::memory_order_relaxed);
+		if(!count){
+			owner_.store(0, std::memory_order_relaxed);
+			mutex_.unlock();
+		}
 	}
 
 	friend class MTAutoInternal;
 };
 
+// Many readers or one writer, for read-mostly data such as registries.
+// Waiting writer stops new readers from entering. Not recursive.
+class MTReadWriteSection
+{
+public:
+	MTReadWriteSection() : state_(0), epoch_(0), sleepers_(0), sharedAcquisitions_(0), acquisitions_(0), contentions_(0), waits_(0) {}
+
+	void lockShared()
+	{
+		int state = state_.load(std::memory_order_relaxed);
+		if((state & (WRITER | WRITER_WAITING)) || !state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed))
+			lockSharedContended();
+		sharedAcquisitions_.fetch_add(1, std::memory_order_relaxed);
+	}
+	void unlockShared()
+	{
+		int state = state_.fetch_sub(1, std::memory_order_seq_cst);
+		YASLI_ASSERT(state & READERS);
+		if((state & READERS) == 1 && sleepers_.load(std::memory_order_seq_cst))
+			wake();
+	}
+
+	void lock()
+	{
+		int state = 0;
+		if(!state_.compare_exchange_strong(state, WRITER, std::memory_order_acquire, std::memory_order_relaxed))
+			lockContended();
+		acquisitions_.store(acquisitions_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+	void unlock()
+	{
+		YASLI_ASSERT(state_.load(std::memory_order_relaxed) & WRITER);
+		state_.fetch_and(~WRITER, std::memory_order_seq_cst);
+		if(sleepers_.load(std::memory_order_seq_cst))
+			wake();
+	}
+
+	MTLockStatistics statistics() const;
+
+private:
+	enum {
+		READERS = 0x3fffffff,
+		WRITER = 0x40000000,
+		WRITER_WAITING = int(0x80000000)
+	};
+
+	MTReadWriteSection(const MTReadWriteSection&);
+	void operator=(const MTReadWriteSection&);
+
+	void lockSharedContended();
+	void lockContended();
+	void sleep(int blockingBits);
+	void wake();
+
+	std::atomic<int> state_;
+	// changed on every wake, sleeping threads wait for it to change
+	std::atomic<int> epoch_;
+	std::atomic<int> sleepers_;
+	std::atomic<yasli::u64> sharedAcquisitions_;
+	std::atomic<yasli::u64> acquisitions_; // changed by the writer only
+	std::atomic<yasli::u64> contentions_;
+	std::atomic<yasli::u64> waits_;
+};
+
 class MTAuto
 {
 public:
@@ -100,3 +285,38 @@ private:
 	MTSection& section_;
 };
 
+class MTAutoRead
+{
+public:
+	MTAutoRead(MTReadWriteSection& section)
+		: section_(section)
+	{
+		section_.lockShared();
+	}
+
+	~MTAutoRead()
+	{
+		section_.unlockShared();
+	}
+
+private:
+	MTReadWriteSection& section_;
+};
+
+class MTAutoWrite
+{
+public:
+	MTAutoWrite(MTReadWriteSection& section)
+		: section_(section)
+	{
+		section_.lock();
+	}
+
+	~MTAutoWrite()
+	{
+		section_.unlock();
+	}
+
+private:
+	MTReadWriteSection& section_;
+};
@@ -2,24 +2,40 @@
 #include <functional>
 #include <algorithm>
 #include <list>
+#include <mutex>
 #include <math.h>
+#include <stdlib.h>
 
-#include "crtdbg.h"
 #include "Profiler.h"
-#include "MTSection.h"
-#include "ww/PropertyEditor.h"
+#ifdef _WIN32
+# include <windows.h>
+# include "ww/PropertyEditor.h"
+#else
+# include <time.h>
+#endif
+#ifdef _MSC_VER
+# include "crtdbg.h"
+# include <malloc.h>
+#elif defined(__APPLE__)
+# include <malloc/malloc.h>
+#else
+# include <malloc.h>
+#endif
+#include <new>
 #include "Macros.h"
+#include "MTSection.h"
 #include "yasli/TextOArchive.h"
-#include "ww/Decorators.h"
+#include "yasli/JSONOArchive.h"
+#include "yasli/decorators/HorizontalLine.h"
 #include "yasli/MemoryWriter.h"
+#include "yasli/STL.h"
 #include "yasli/STLImpl.h"
 #include "yasli/PointersImpl.h"
 
-using namespace ww;
 using namespace yasli;
 using namespace std;
 
-#if !defined(_FINAL_VERSION_) && !defined(_FINAL) && defined(WIN32)
+#if !defined(_FINAL_VERSION_) && !defined(_FINAL) && !defined(ANDROID_NDK) && !defined(__EMSCRIPTEN__)
 
 //#pragma warning (disable: 4073) // initializers put in library initialization area
 //#pragma init_seg(lib)
@@ -39,10 +55,22 @@ struct SerializeAll{
 	Profiler* profiler_;
 };
 
-__int64 getRDTSC();
-int totalMemoryUsed(); 
+// Allocations of PROFILER_MEMORY mode are counted by the allocation hook of
+// debug CRT in MSVC debug builds. Elsewhere global operator new/delete are
+// replaced only when PROFILER_OPERATOR_NEW is defined (XMATH_PROFILER_OPERATOR_NEW
+// option of CMake): the library is linked into programs that may have their
+// own allocator or a sanitizer. Such programs may report their blocks to
+// AllocationData themselves.
+#if defined(_DEBUG) && defined(_MSC_VER)
+# define PROFILER_CRT_ALLOCATION_HOOK
+# undef PROFILER_OPERATOR_NEW
+#endif
+
+#ifdef PROFILER_CRT_ALLOCATION_HOOK
 int __cdecl allocationTrackingHook( int  nAllocType, void * pvData, size_t nSize, int nBlockUse, long lRequest, const unsigned char * szFileName, int nLine  );
+#endif
 
+#ifdef _WIN32
 static bool isPressed(int vkKey) 
 {
 	if(GetAsyncKeyState(vkKey) >> 15)
@@ -50,27 +78,67 @@ static bool isPressed(int vkKey)
 	return false;
 }
 
-AllocationData AllocationData::dbgHookData_;
+static i64 performanceCounter()
+{
+	i64 counter;
+	QueryPerformanceCounter((LARGE_INTEGER*)&counter);
+	return counter;
+}
+
+static i64 performanceFrequency()
+{
+	i64 frequency;
+	QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
+	return frequency;
+}
+#else
+static i64 performanceCounter()
+{
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return i64(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+static i64 performanceFrequency()
+{
+	return 1000000000;
+}
+#endif
+
+// guards list of profilers, taken only when a thread creates its profiler and
+// when reports are made
+static MTMutex profilersLock;
+
+PROFILER_THREAD_LOCAL AllocationData* AllocationData::current_;
 
-ProfilerMode ProfilerInterface::profilerMode_ = PROFILER_ACCURATE;
-__declspec(thread) class Profiler* ProfilerInterface::profiler_;
+std::atomic<ProfilerMode> ProfilerInterface::profilerMode_(PROFILER_ACCURATE);
+PROFILER_THREAD_LOCAL class Profiler* ProfilerInterface::profiler_;
 Profiler* ProfilerInterface::profilerForSerialization_;
-MTSection ProfilerInterface::lock_;
 bool ProfilerInterface::sortByAvr_ = true;
 
+std::atomic<unsigned int> Profiler::clearRequests_(0);
+std::atomic<unsigned int> Profiler::quants_(0);
+
+std::atomic<bool> Profiler::traceRecording_(false);
+std::atomic<unsigned int> Profiler::traceGenerations_(0);
+u64 Profiler::traceSize_ = 0;
+i64 Profiler::traceStartCounter_ = 0;
+i64 Profiler::traceStartTicks_ = 0;
+
 bool Profiler::started = false;
 int Profiler::milliseconds = 0;
-__int64 Profiler::counterPrev_;
-__int64 Profiler::frequency_;
-__int64 Profiler::start_ticks = 0;
-__int64 Profiler::ticks = 0;
+i64 Profiler::counterPrev_;
+i64 Profiler::frequency_;
+i64 Profiler::start_ticks = 0;
+i64 Profiler::ticks = 0;
 double Profiler::time_factor = 0;
+int Profiler::serializedFrames_ = 1;
 
 bool Profiler::autoExit_;
 int Profiler::startLogicQuant_;
 int Profiler::endLogicQuant_;
 string Profiler::title_;
-string Profiler::profileFile_;
+string Profiler::profileFile_ = "profile";
 
 Profiler::Profilers Profiler::profilers_;
 
@@ -84,30 +152,70 @@ Profiler& ProfilerInterface::profiler()
 TimerData::TimerData(const char* title) 
 { 
 	title_ = title; 
+	index_ = 0;
+	clear(); 
+	profiler().attach(this);
+}
+
+TimerData::TimerData(const char* function, const char* title) 
+: titleStorage_(string(function) + " " + title)
+{ 
+	title_ = titleStorage_.c_str(); 
+	index_ = 0;
 	clear(); 
 	profiler().attach(this);
 }
 
+TimerData::TimerData(const TimerData& timer)
+: t0(timer.t0)
+, dt_sum(timer.dt_sum)
+, n(timer.n)
+, dt_max(timer.dt_max)
+, t_max(timer.t_max)
+, title_(timer.title_)
+, startCounter_(0)
+, serializing_(false)
+, index_(timer.index_)
+, accumulated_alloc(timer.accumulated_alloc)
+{
+}
+
+void TimerData::copyValues(const TimerData& timer)
+{
+	t0 = timer.t0;
+	dt_sum = timer.dt_sum;
+	n = timer.n;
+	dt_max = timer.dt_max;
+	t_max = timer.t_max;
+	title_ = timer.title_;
+	accumulated_alloc = timer.accumulated_alloc;
+}
+
 void TimerData::start() 
 {
-	if(profilerMode_){
-		profiler().startBuildTree(this);
-#ifdef _DEBUG
-		if(profilerMode_ == PROFILER_MEMORY)
-			last_alloc = AllocationData::dbgHookData_;
-#endif
+	Profiler& profiler = ProfilerInterface::profiler();
+	if(!profiler.depth_++)
+		profiler.enterScope();
+
+	ProfilerMode mode = profilerMode_.load(std::memory_order_relaxed);
+	if(mode){
+		// tree of the profiler is not counted as allocations of the scope
+		AllocationData::current_ = 0;
+		profiler.startBuildTree(this);
+		if(mode == PROFILER_MEMORY)
+			AllocationData::current_ = &accumulated_alloc;
 	}
 	
 	if(!startCounter_)
-		t0 = getRDTSC(); 
+		t0 = profilerTicks(); 
 	startCounter_++;
 }
 
 void TimerData::stop() 
 {
 	if(!--startCounter_){
-		__int64 t = getRDTSC();
-		__int64 dt = t - t0; 
+		i64 t = profilerTicks();
+		i64 dt = t - t0; 
 		dt_sum += dt;
 
 		if(dt_max < dt){
@@ -115,19 +223,23 @@ void TimerData::stop()
 			t_max = t;
 		}
 		n++;
+
+		if(Profiler::traceRecording_.load(std::memory_order_relaxed))
+			ProfilerInterface::profiler().recordTrace(title_, t0, t);
 	}
 	else if(startCounter_ < 0)
 		startCounter_ = 0;
 
-	if(profilerMode_){
-		profiler().stopBuildTree();
-#ifdef _DEBUG
-		if(profilerMode_ == PROFILER_MEMORY){
-			accumulated_alloc += AllocationData::dbgHookData_;
-			accumulated_alloc -= last_alloc;
-		}
-#endif
+	Profiler& profiler = ProfilerInterface::profiler();
+	ProfilerMode mode = profilerMode_.load(std::memory_order_relaxed);
+	if(mode){
+		profiler.stopBuildTree();
+		if(mode == PROFILER_MEMORY)
+			AllocationData::current_ = !profiler.stack_.empty() ? &profiler.stack_.back()->accumulated_alloc : 0;
 	}
+
+	if(profiler.depth_ > 0 && !--profiler.depth_)
+		profiler.leaveScope();
 }
 
 void TimerData::clear()
@@ -176,7 +288,7 @@ void TimerData::serialize(Archive& ar)
 	buf.setDigits(4);
 	if(profilerMode_ != PROFILER_MEMORY)
 		buf << dt_sum*100./profiler.ticks << " %, " << (n ? (double)dt_sum*profiler.time_factor/n : 0) << " ms, " 
-			<< n*1000./profiler.milliseconds << " cps, " << double(n)/profiler.frames << " cpq, max = " << (double)dt_max*profiler.time_factor << " (" << profiler.ticks2time(t_max) << ")";
+			<< n*1000./profiler.milliseconds << " cps, " << double(n)/profiler.serializedFrames_ << " cpq, max = " << (double)dt_max*profiler.time_factor << " (" << profiler.ticks2time(t_max) << ")";
 	else 
 		buf << "size = " << accumulated_alloc.size << ", blocks = " << accumulated_alloc.blocks << ", operations = " << accumulated_alloc.operations;
 
@@ -210,13 +322,39 @@ void TimerData::serialize(Archive& ar)
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //				StatisticalData
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
-StatisticalData::StatisticalData(char* title) 
+StatisticalData::StatisticalData(const char* title) 
 {
 	title_ = title; 
 	clear();
 	profiler().attach(this);
 }
 
+StatisticalData::StatisticalData(const StatisticalData& data)
+: x_sum(data.x_sum)
+, x2_sum(data.x2_sum)
+, x_max(data.x_max)
+, x_min(data.x_min)
+, t_max(data.t_max)
+, t_min(data.t_min)
+, title_(data.title_)
+, n(data.n)
+, quantiles_(data.quantiles_)
+{
+}
+
+void StatisticalData::copyValues(const StatisticalData& data)
+{
+	x_sum = data.x_sum;
+	x2_sum = data.x2_sum;
+	x_max = data.x_max;
+	x_min = data.x_min;
+	t_max = data.t_max;
+	t_min = data.t_min;
+	title_ = data.title_;
+	n = data.n;
+	quantiles_ = data.quantiles_;
+}
+
 void StatisticalData::clear() 
 { 
 	n = 0; 
@@ -224,6 +362,7 @@ void StatisticalData::clear()
 	x_max = -1e15; 
 	x_min = 1e15; 
 	t_max = t_min = 0; 
+	quantiles_.clear();
 }
 
 void StatisticalData::serialize(Archive& ar)
@@ -231,7 +370,7 @@ void StatisticalData::serialize(Archive& ar)
 	Profiler& profiler = *profilerForSerialization_;
 	MemoryWriter buf;
 	buf.setDigits(4);
-	buf << avr() << "  " << (avr() ? sigma()*100/avr() : 0) << " %, max = " << x_max << " (" << profiler.ticks2time(t_max) << "), min = " << x_min << " (" << profiler.ticks2time(t_min) << "), sampling: " << n;
+	buf << avr() << "  " << (avr() ? sigma()*100/avr() : 0) << " %, max = " << x_max << " (" << profiler.ticks2time(t_max) << "), min = " << x_min << " (" << profiler.ticks2time(t_min) << "), p50 = " << quantile(0.5) << ", p90 = " << quantile(0.9) << ", p99 = " << quantile(0.99) << ", p99.9 = " << quantile(0.999) << ", sampling: " << n;
 	string str = buf.c_str();
 	ar(str, title_, title_);
 }
@@ -248,25 +387,51 @@ void StatisticalData::add(double x)
 	x_sum += x; 
 	if(x_max < x){ 
 		x_max = x; 
-		t_max = getRDTSC(); 
+		t_max = profilerTicks(); 
 	} 
 	if(x_min > x){ 
 		x_min = x; 
-		t_min = getRDTSC(); 
+		t_min = profilerTicks(); 
 	} 
 	x2_sum += x*x;
+	quantiles_.add(x);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //				Profiler
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Copy of timers and statistics of a thread, see Profiler::publish.
+struct Profiler::Snapshot
+{
+	Timers timers;
+	Timers roots;
+	Statistics statistics;
+	int frames;
+
+	~Snapshot()
+	{
+		// children of recursive timers refer to their parents
+		Timers::iterator i;
+		FOR_EACH(timers, i)
+			(*i)->children_.clear();
+	}
+};
+
 Profiler::Profiler()
+: depth_(0)
+, clearRequest_(clearRequests_)
+, publishedQuant_(quants_)
+, snapshot_(0)
+, spareSnapshot_(0)
+, trace_(0)
+, traceMask_(0)
+, traceHead_(0)
+, traceGeneration_(0)
 {
-	MTAutoInternal lock(lock_);
+	std::lock_guard<MTMutex> lock(profilersLock);
 
-	QueryPerformanceFrequency((LARGE_INTEGER*)&frequency_);
+	frequency_ = performanceFrequency();
 
-	profileFile_ = "profile";
 	name_ = (MemoryWriter() << "Thread" << profilers_.size()).c_str();
 
 	clear();
@@ -276,6 +441,10 @@ Profiler::Profiler()
 
 Profiler::~Profiler()
 {
+	delete snapshot_.exchange(0);
+	delete spareSnapshot_;
+	delete[] trace_;
+
 	stack_.clear();
 	roots_.clear();
 
@@ -286,22 +455,17 @@ Profiler::~Profiler()
 
 void Profiler::attach(TimerData* timer)
 {
-	MTAutoInternal lock(lock_);
-
+	timer->index_ = int(timers_.size());
 	timers_.push_back(timer);
 }
 
 void Profiler::attach(StatisticalData* stats)
 {
-	MTAutoInternal lock(lock_);
-
 	statistics_.push_back(stats);
 }
 
 void Profiler::clear()
 {
-	MTAutoInternal lock(lock_);
-
 	stack_.clear();
 
 	if(profilerMode_)
@@ -319,35 +483,105 @@ void Profiler::clear()
 	quantEntered_ = false;
 }
 
-void Profiler::start_stop(ProfilerMode profilerMode)
+void Profiler::clearRequested()
 {
-	MTAutoInternal lock(lock_);
+	clearRequest_ = clearRequests_.load(std::memory_order_relaxed);
+	clear();
+}
+
+void Profiler::publish()
+{
+	publishedQuant_ = quants_.load(std::memory_order_relaxed);
+
+	// snapshot published last time, unless it is being serialized
+	Snapshot* snapshot = spareSnapshot_ ? spareSnapshot_ : new Snapshot;
+	spareSnapshot_ = 0;
+	snapshot->frames = frames;
+
+	// copy of a timer has the index of the timer, timers are never removed
+	size_t count = timers_.size();
+	while(snapshot->timers.size() < count)
+		snapshot->timers.push_back(new TimerData(*timers_[snapshot->timers.size()]));
+	for(size_t index = 0; index < count; ++index){
+		TimerData& timer = *timers_[index];
+		TimerData& copy = *snapshot->timers[index];
+		copy.copyValues(timer);
+		copy.children_.clear();
+		Timers::iterator ci;
+		FOR_EACH(timer.children_, ci)
+			if(ownTimer(*ci))
+				copy.children_.push_back(snapshot->timers[(*ci)->index_]);
+	}
+	snapshot->roots.clear();
+	Timers::iterator i;
+	FOR_EACH(roots_, i)
+		if(ownTimer(*i))
+			snapshot->roots.push_back(snapshot->timers[(*i)->index_]);
+
+	count = statistics_.size();
+	while(snapshot->statistics.size() < count)
+		snapshot->statistics.push_back(new StatisticalData(*statistics_[snapshot->statistics.size()]));
+	for(size_t index = 0; index < count; ++index)
+		snapshot->statistics[index]->copyValues(*statistics_[index]);
+
+	// previous snapshot is taken away from snapshot_ by takeSnapshot while it
+	// is being serialized, then the next publish allocates a new one
+	spareSnapshot_ = snapshot_.exchange(snapshot, std::memory_order_acq_rel);
+}
+
+Profiler::Snapshot* Profiler::takeSnapshot()
+{
+	if(this == profiler_)
+		publish();
+	return snapshot_.exchange(0, std::memory_order_acq_rel);
+}
 
+void Profiler::returnSnapshot(Snapshot* snapshot)
+{
+	// thread may have published a newer one meanwhile
+	Snapshot* empty = 0;
+	if(snapshot && !snapshot_.compare_exchange_strong(empty, snapshot, std::memory_order_acq_rel))
+		delete snapshot;
+}
+
+void Profiler::start_stop(ProfilerMode profilerMode)
+{
 	if(!started){
 		started = 1;
 		profilerMode_ = profilerMode;
 
-#ifdef _DEBUG
+#ifdef PROFILER_CRT_ALLOCATION_HOOK
 		if(profilerMode == PROFILER_MEMORY)
 			_CrtSetAllocHook( &allocationTrackingHook );			
 #endif
 
-		Profilers::iterator i;
-		FOR_EACH(profilers_, i)
-			(*i)->clear();
+		// other threads clear their timers when they enter next scope,
+		// snapshots made before are dropped
+		clearRequests_.fetch_add(1, std::memory_order_relaxed);
+		clearRequested();
+		{
+			std::lock_guard<MTMutex> lock(profilersLock);
+			Profilers::iterator i;
+			FOR_EACH(profilers_, i)
+				delete (*i)->snapshot_.exchange(0, std::memory_order_acq_rel);
+		}
 
-		QueryPerformanceCounter((LARGE_INTEGER*)&counterPrev_);
-		start_ticks = getRDTSC();
+		counterPrev_ = performanceCounter();
+		start_ticks = profilerTicks();
 	}
 	else{
-		__int64 counter;
-		QueryPerformanceCounter((LARGE_INTEGER*)&counter);
-		milliseconds = (counter - counterPrev_)*1000/frequency_;
-		ticks = getRDTSC() - start_ticks;
+		i64 counter = performanceCounter();
+		milliseconds = int((counter - counterPrev_)*1000/frequency_);
+		ticks = profilerTicks() - start_ticks;
+		quants_.fetch_add(1, std::memory_order_relaxed);
 
 		if(!endLogicQuant_){
+#ifdef _WIN32
 			string stateFileName_ = string(getenv("TEMP")) + "/profiler.tmp";
 			if(ww::edit(Serializer(SerializeAll(this)), stateFileName_.c_str())){
+#else
+			{
+#endif
 				if(!profileFile_.empty()){
 					TextOArchive oa;
 					serializeAll(oa);
@@ -386,6 +620,8 @@ void Profiler::quant(unsigned long curLogicQuant)
 		return;
 	quantEntered_ = true;
 	frames++;
+	if(started)
+		quants_.fetch_add(1, std::memory_order_relaxed);
 
 	if(endLogicQuant_){
 		if(!started){
@@ -401,6 +637,7 @@ void Profiler::quant(unsigned long curLogicQuant)
 		}
 	}
 
+#ifdef _WIN32
 	static bool wasPressed;
 	if(isPressed(VK_F6) && (isPressed(VK_CONTROL) || GetFocus())){
 		if(!wasPressed){
@@ -410,6 +647,7 @@ void Profiler::quant(unsigned long curLogicQuant)
 	}
 	else
 		wasPressed = false;
+#endif
 
 	quantEntered_ = false;
 }
@@ -428,7 +666,7 @@ void Profiler::serializeAll(Archive& ar)
 	time_factor = (double)milliseconds/ticks;
 
 	string mode;
-	switch(profilerMode_){
+	switch(profilerMode_.load()){
 		case PROFILER_ACCURATE:
 			mode = !roots_.empty() ? "Accurate sampling" :
 				"Accurate sampling. Tree should be built before!";
@@ -437,18 +675,17 @@ void Profiler::serializeAll(Archive& ar)
 			mode = "Unaccurate sampling, building tree";
 			break;
 		case PROFILER_MEMORY:
-#ifdef _DEBUG
-			mode = "Memory profiling";
+#if defined(PROFILER_CRT_ALLOCATION_HOOK) || defined(PROFILER_OPERATOR_NEW)
+			mode = "Memory profiling, allocations of scopes without nested ones";
 #else
-			mode = "Memory profiling work in DEBUG-mode only!";
+			mode = "Memory profiling: operator new is not tracked, PROFILER_OPERATOR_NEW is not defined";
 #endif
 			break;
 	}
 	ar(mode, "Mode", "!Mode");
 
 	ar(milliseconds, "Time_interval_mS", "!Time interval, mS");
-	char total_name[2048];
-	string  ticksName = _i64toa(ticks, total_name, 10);
+	string  ticksName = (MemoryWriter() << ticks).c_str();
 	ar(ticksName, "Ticks", "!Ticks");
 	float freq(ticks/(milliseconds*1000.));
 	ar(freq, "CPU_MHz", "!CPU, MHz");
@@ -458,19 +695,24 @@ void Profiler::serializeAll(Archive& ar)
 	//Profilers::iterator end = remove_if(profilers_.begin(), profilers_.end(), mem_fun(&Profiler::empty));
 	//profilers_.erase(end, profilers_.end());
 
-	ar(HLineDecorator(), "line1", "<");
+	ar(HorizontalLine(), "line1", "<");
 
-	if(profilers_.empty()){
+	Profilers profilers;
+	{
+		std::lock_guard<MTMutex> lock(profilersLock);
+		profilers = profilers_;
+	}
+	if(profilers.empty()){
 		string noData = "No data";
 		ar(noData, "noData", "!<");
 	}
-	else if(profilers_.size() == 1)
-		profilers_.front()->serialize(ar);
+	else if(profilers.size() == 1)
+		profilers.front()->serialize(ar);
 	else
-		FOR_EACH(profilers_, i, Profilers::iterator)
+		FOR_EACH(profilers, i, Profilers::iterator)
 			ar(**i, (*i)->name_.c_str(), (*i)->name_.c_str());
 
-	ar(HLineDecorator(), "line2", "<");
+	ar(HorizontalLine(), "line2", "<");
 
 	ar(sortByAvr_, "sortByAvr", "Sort by average");
 	if(ar.isEdit())
@@ -479,21 +721,28 @@ void Profiler::serializeAll(Archive& ar)
 
 void Profiler::serialize(Archive& ar)
 {
+	Snapshot* snapshot = takeSnapshot();
+	Snapshot noSnapshot;
+	noSnapshot.frames = 0;
+	Snapshot& data = snapshot ? *snapshot : noSnapshot;
+
 	if(!milliseconds)
 		milliseconds = 1;
-	if(!frames)
-		frames = 1;
+	if(!data.frames)
+		data.frames = 1;
 	if(!ticks)
 		ticks = 1;
 
 	profilerForSerialization_ = this;
+	serializedFrames_ = data.frames;
 	if(profilerMode_ != PROFILER_MEMORY){
-		ar(frames, "Frames", "!Frames");
-		float fps(frames*1000./milliseconds);
+		ar(data.frames, "Frames", "!Frames");
+		float fps(data.frames*1000./milliseconds);
 		ar(fps, "FPS", "!FPS");
 	}
 
-	Timers& list = !roots_.empty() ? roots_ : timers_;
+	// order of snapshot timers is kept, their indices are those of the timers
+	Timers list = !data.roots.empty() ? data.roots : data.timers;
 	if(profilerMode_ == PROFILER_MEMORY)
 		sort(list.begin(), list.end(), lessMemory());
 	else if(sortByAvr_)
@@ -507,16 +756,16 @@ void Profiler::serialize(Archive& ar)
 
 	if(ar.openBlock("Stat", "!Statistics")){
 		Statistics::iterator i;
-		FOR_EACH(statistics_, i)
+		FOR_EACH(data.statistics, i)
 			(*i)->serialize(ar);
 		ar.closeBlock();
 	}
+
+	returnSnapshot(snapshot);
 }
 
 void Profiler::startBuildTree(TimerData* timer)
 {
-	MTAutoInternal lock(lock_);
-
 	if(!stack_.empty()){
 		Timers& timers = stack_.back()->children_;
 		if(find(timers.begin(), timers.end(), timer) == timers.end())
@@ -550,11 +799,174 @@ bool Profiler::empty() const
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////
+//	Trace
+///////////////////////////////////////////////////////////////////////
+void Profiler::startTrace(int eventsPerThread)
+{
+	std::lock_guard<MTMutex> lock(profilersLock);
+	u64 size = 2;
+	while(size < u64(eventsPerThread))
+		size *= 2;
+	traceSize_ = size;
+	traceStartCounter_ = performanceCounter();
+	traceStartTicks_ = profilerTicks();
+	// threads allocate new rings when they record the next event
+	traceGenerations_.fetch_add(1, std::memory_order_relaxed);
+	traceRecording_.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::stopTrace()
+{
+	traceRecording_.store(false, std::memory_order_relaxed);
+}
+
+void Profiler::resizeTrace()
+{
+	std::lock_guard<MTMutex> lock(profilersLock);
+	delete[] trace_;
+	trace_ = new TraceEvent[size_t(traceSize_)];
+	traceMask_ = traceSize_ - 1;
+	traceHead_.store(0, std::memory_order_relaxed);
+	traceGeneration_ = traceGenerations_.load(std::memory_order_relaxed);
+}
+
+void Profiler::recordTrace(const char* title, i64 begin, i64 end)
+{
+	if(traceGeneration_ != traceGenerations_.load(std::memory_order_relaxed))
+		resizeTrace();
+	u64 head = traceHead_.load(std::memory_order_relaxed);
+	// reader that sees any field of this event sees the head of previous one,
+	// so it knows the slot is being overwritten
+	std::atomic_thread_fence(std::memory_order_release);
+	TraceEvent& event = trace_[head & traceMask_];
+	event.title.store(title, std::memory_order_relaxed);
+	event.begin.store(begin, std::memory_order_relaxed);
+	event.end.store(end, std::memory_order_relaxed);
+	traceHead_.store(head + 1, std::memory_order_release);
+}
+
+namespace {
+
+// Event of Chrome trace event format: "X" is a complete event with
+// duration, "M" is metadata, e.g. name of a thread.
+struct ChromeTraceEvent
+{
+	string name;
+	string phase;
+	double timestamp;
+	double duration;
+	int thread;
+	string threadName;
+
+	void serialize(Archive& ar)
+	{
+		ar(name, "name");
+		ar(phase, "ph");
+		int process = 1;
+		ar(process, "pid");
+		ar(thread, "tid");
+		if(phase == "M"){
+			ChromeTraceThreadName args = { threadName };
+			ar(args, "args");
+		}
+		else{
+			ar(timestamp, "ts");
+			ar(duration, "dur");
+		}
+	}
+
+	struct ChromeTraceThreadName
+	{
+		string name;
+		void serialize(Archive& ar) { ar(name, "name"); }
+	};
+
+	// outer scopes precede nested ones that begin at the same time
+	bool operator<(const ChromeTraceEvent& rhs) const
+	{
+		return timestamp != rhs.timestamp ? timestamp < rhs.timestamp : duration > rhs.duration;
+	}
+};
+
+struct ChromeTrace
+{
+	vector<ChromeTraceEvent> events;
+
+	void serialize(Archive& ar)
+	{
+		ar(events, "traceEvents");
+		string unit = "ms";
+		ar(unit, "displayTimeUnit");
+	}
+};
+
+}
+
+void Profiler::serializeTrace(Archive& ar)
+{
+	ChromeTrace trace;
+	{
+		std::lock_guard<MTMutex> lock(profilersLock);
+		unsigned int generation = traceGenerations_.load(std::memory_order_relaxed);
+		// ticks of profilerTicks are calibrated against performance counter
+		i64 counterTime = performanceCounter() - traceStartCounter_;
+		i64 ticksTime = profilerTicks() - traceStartTicks_;
+		double microsecondsPerTick = ticksTime > 0 ? double(counterTime)*1e6/performanceFrequency()/ticksTime : 0;
+
+		for(size_t index = 0; index < profilers_.size(); ++index){
+			Profiler& profiler = *profilers_[index];
+			if(!profiler.trace_ || profiler.traceGeneration_ != generation)
+				continue;
+
+			ChromeTraceEvent threadName;
+			threadName.name = "thread_name";
+			threadName.phase = "M";
+			threadName.thread = int(index);
+			threadName.threadName = profiler.name_;
+			trace.events.push_back(threadName);
+
+			u64 last = profiler.traceHead_.load(std::memory_order_acquire);
+			u64 first = last > traceSize_ ? last - traceSize_ : 0;
+			size_t start = trace.events.size();
+			for(u64 i = first; i < last; ++i){
+				TraceEvent& slot = profiler.trace_[i & profiler.traceMask_];
+				ChromeTraceEvent event;
+				event.name = slot.title.load(std::memory_order_relaxed);
+				event.phase = "X";
+				i64 begin = slot.begin.load(std::memory_order_relaxed);
+				i64 end = slot.end.load(std::memory_order_relaxed);
+				event.timestamp = (begin - traceStartTicks_)*microsecondsPerTick;
+				event.duration = (end - begin)*microsecondsPerTick;
+				event.thread = int(index);
+				trace.events.push_back(event);
+			}
+
+			// drops events that the thread could overwrite while they were copied
+			std::atomic_thread_fence(std::memory_order_acquire);
+			u64 written = profiler.traceHead_.load(std::memory_order_relaxed);
+			if(written >= traceSize_ && written - traceSize_ + 1 > first){
+				u64 overwritten = min(written - traceSize_ + 1, last) - first;
+				trace.events.erase(trace.events.begin() + start, trace.events.begin() + start + size_t(overwritten));
+			}
+			std::stable_sort(trace.events.begin() + start, trace.events.end());
+		}
+	}
+	ar(trace, "");
+}
+
+bool Profiler::saveTrace(const char* fileName)
+{
+	JSONOArchive oa;
+	serializeTrace(oa);
+	return oa.save(fileName);
+}
+
 
 ///////////////////////////////////////////////////////////////////////
 //	Memory Hook
 ///////////////////////////////////////////////////////////////////////
-#ifdef _DEBUG
+#ifdef PROFILER_CRT_ALLOCATION_HOOK
 #define nNoMansLandSize 4
 typedef struct _CrtMemBlockHeader
 {
@@ -575,27 +987,30 @@ typedef struct _CrtMemBlockHeader
 #define pHdr(pbData) (((_CrtMemBlockHeader *)pbData)-1)
 int __cdecl allocationTrackingHook(  int  nAllocType,  void   * pvData,  size_t nSize,  int      nBlockUse,  long     lRequest,  const unsigned char * szFileName,  int      nLine  )
 {
-	AllocationData::dbgHookData_.operations++;
+	AllocationData* data = AllocationData::current_;
+	if(!data)
+		return 1;
+	data->operations++;
 	switch(nAllocType){
 		case _HOOK_REALLOC:
 			{
 				_CrtMemBlockHeader *pHead=pHdr(pvData);
 				int dSize=(int)nSize-(int)pHead->nDataSize;
-				AllocationData::dbgHookData_.size += dSize;
+				data->size += dSize;
 				break;
 			}
 		case _HOOK_ALLOC:   
 			{
-				AllocationData::dbgHookData_.size += int(nSize);
-				AllocationData::dbgHookData_.blocks++;
+				data->size += int(nSize);
+				data->blocks++;
 				break;
 			}
 		case _HOOK_FREE:   
 			{
 				_CrtMemBlockHeader *pHead = pHdr(pvData);
 				nSize = (unsigned int)pHead->nDataSize;
-				AllocationData::dbgHookData_.size -= int(nSize);
-				AllocationData::dbgHookData_.blocks--;
+				data->size -= int(nSize);
+				data->blocks--;
 				break;
 			}
 		default:{
@@ -607,12 +1022,78 @@ int __cdecl allocationTrackingHook(  int  nAllocType,  void   * pvData,  size_t
 
 	return 1;         // Allow the memory operation to proceed
 }
-#endif //_DEBUG
+#endif //PROFILER_CRT_ALLOCATION_HOOK
+
+#ifdef PROFILER_OPERATOR_NEW
+// Blocks are measured only while tracked, so untracked allocations cost one
+// check of a thread local pointer. Usable size is used for both allocation
+// and deallocation, blocks freed in another scope are subtracted exactly.
+static size_t blockSize(void* memory)
+{
+#if defined(_MSC_VER)
+	return _msize(memory);
+#elif defined(__APPLE__)
+	return malloc_size(memory);
+#else
+	return malloc_usable_size(memory);
+#endif
+}
+
+static void* allocateTracked(size_t size)
+{
+	if(!size)
+		size = 1;
+	for(;;){
+		if(void* memory = malloc(size)){
+			if(AllocationData::tracking())
+				AllocationData::allocated(blockSize(memory));
+			return memory;
+		}
+#ifdef _MSC_VER
+		if(!_callnewh(size))
+			throw std::bad_alloc();
+#else
+		std::new_handler handler = std::get_new_handler();
+		if(!handler)
+			throw std::bad_alloc();
+		handler();
+#endif
+	}
+}
+
+static void freeTracked(void* memory)
+{
+	if(!memory)
+		return;
+	if(AllocationData::tracking())
+		AllocationData::freed(blockSize(memory));
+	free(memory);
+}
+
+void* operator new(size_t size) { return allocateTracked(size); }
+void* operator new[](size_t size) { return allocateTracked(size); }
+void operator delete(void* memory) throw() { freeTracked(memory); }
+void operator delete[](void* memory) throw() { freeTracked(memory); }
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+	try{
+		return allocateTracked(size);
+	}
+	catch(std::bad_alloc&){
+		return 0;
+	}
+}
+void* operator new[](size_t size, const std::nothrow_t& nothrow) throw() { return operator new(size, nothrow); }
+void operator delete(void* memory, const std::nothrow_t&) throw() { freeTracked(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) throw() { freeTracked(memory); }
+#endif //PROFILER_OPERATOR_NEW
 
 ///////////////////////////////////////////////////////////////////////
 //	Count by pages
 ///////////////////////////////////////////////////////////////////////
 
+#ifdef _WIN32
 int totalMemoryUsed()
 {
 	SYSTEM_INFO SystemInfo;
@@ -631,6 +1112,7 @@ int totalMemoryUsed()
 	}
 	return size;
 }
+#endif
 
 	
 #endif
\ No newline at end of file
@@ -7,29 +7,51 @@ enum ProfilerMode
 	PROFILER_MEMORY
 };
 
-#if !defined(_FINAL_VERSION_) && !defined(_FINAL) && defined(WIN32) && !defined(_WIN64)
+#if !defined(_FINAL_VERSION_) && !defined(_FINAL) && !defined(ANDROID_NDK) && !defined(__EMSCRIPTEN__)
 
 #include <vector>
 #include <string>
+#include <atomic>
 #include "XMath/round.h"
+#include "XMath/XClock.h"
+#include "XMath/QuantileHistogram.h"
+#include "yasli/Config.h"
 #include "yasli/Pointers.h"
 
-#pragma warning(disable : 4512) // assignment operator could not be generated
+#ifdef _MSC_VER
+# pragma warning(disable : 4512) // assignment operator could not be generated
+# define PROFILER_THREAD_LOCAL __declspec(thread)
+#else
+# define PROFILER_THREAD_LOCAL __thread
+#endif
 
 namespace yasli { class Archive; }
 class Profiler;
 
+// Time stamp counter where it is available, monotonic clock otherwise. Units
+// are converted to milliseconds by Profiler::start_stop, which measures the
+// same interval with the system clock.
+inline yasli::i64 profilerTicks() { return xclockTicks(); }
+
 struct AllocationData
 {
-	int size;
-	int blocks;
-	int operations;
+	yasli::i64 size;
+	yasli::i64 blocks;
+	yasli::i64 operations;
 
 	AllocationData() { size = blocks = operations = 0; }
 	AllocationData& operator += (const AllocationData& data) { size += data.size; blocks += data.blocks; operations += data.operations; return *this; }
 	AllocationData& operator -= (const AllocationData& data) { size -= data.size; blocks -= data.blocks; operations -= data.operations; return *this; }
 
-	static AllocationData dbgHookData_;
+	// Allocations of the calling thread are added to its innermost timer in
+	// PROFILER_MEMORY mode and ignored otherwise. Called by operator new/delete
+	// replaced with PROFILER_OPERATOR_NEW (see Profiler.cpp), custom allocators
+	// may report their blocks too.
+	static bool tracking() { return current_ != 0; }
+	static void allocated(size_t size) { if(AllocationData* data = current_){ data->size += size; data->blocks++; data->operations++; } }
+	static void freed(size_t size) { if(AllocationData* data = current_){ data->size -= size; data->blocks--; data->operations++; } }
+
+	static PROFILER_THREAD_LOCAL AllocationData* current_;
 };
 
 class ProfilerInterface : public yasli::PolyRefCounter
@@ -40,16 +62,22 @@ public:
 protected:
 	typedef std::vector<yasli::SharedPtr<struct TimerData> > Timers;
 
-	static ProfilerMode profilerMode_;
-	static __declspec(thread) class Profiler* profiler_;
+	static std::atomic<ProfilerMode> profilerMode_;
+	static PROFILER_THREAD_LOCAL class Profiler* profiler_;
 	static Profiler* profilerForSerialization_;
-	static class MTSection lock_;
 	static bool sortByAvr_;
 };
 
+// Timers and statistics belong to the thread that created them (see
+// start_timer macros), only this thread changes them.
 struct TimerData : public ProfilerInterface
 {
 	TimerData(const char* title = 0);
+	TimerData(const char* function, const char* title);
+	// copy for report, not attached to profiler
+	TimerData(const TimerData& timer);
+	// times and allocations of timer, children are not copied
+	void copyValues(const TimerData& timer);
 
 	void start();
 	void stop();
@@ -59,38 +87,54 @@ struct TimerData : public ProfilerInterface
 
 	bool empty() const { return !n; }
 
-	__int64 t0;
-	__int64 dt_sum;
+	yasli::i64 t0;
+	yasli::i64 dt_sum;
 	int n;
-	__int64 dt_max, t_max;
+	yasli::i64 dt_max, t_max;
 
 	const char* title_;
 	int startCounter_;
 	bool serializing_;
+	int index_; // in timers of the profiler, copies in its snapshots have the same index
 	
 	Timers children_;
 
+	// allocations made in this scope but not in nested ones
 	AllocationData accumulated_alloc;
-	AllocationData last_alloc;
+
+private:
+	std::string titleStorage_;
 };
 
 class StatisticalData : public ProfilerInterface
 {
 	double x_sum, x2_sum, x_max, x_min;
-	__int64 t_max, t_min;
+	yasli::i64 t_max, t_min;
 	const char* title_;
 	int n;
+	QuantileHistogram quantiles_;
 
 public:
-	StatisticalData(char* title = 0);
+	StatisticalData(const char* title = 0);
+	StatisticalData(const StatisticalData& data);
+	void copyValues(const StatisticalData& data);
 	void clear();
 	void add(double x);
 	double avr() const { return n ? x_sum/n : 0; }
 	double sigma() const;
+	// Percentiles of added values within 0.8%, see QuantileHistogram
+	double quantile(double q) const { return quantiles_.quantile(q); }
+	const QuantileHistogram& quantiles() const { return quantiles_; }
 	void serialize(yasli::Archive& ar);
 	bool empty() const { return !n; }
 };
 
+// One profiler per thread. Timing of a scope touches only data of the calling
+// thread, no locks are taken. Reports are made of snapshots: every thread
+// copies its timers at the end of the outermost scope that follows quant() and
+// hands the copy over through an atomic pointer, so a report of a busy thread
+// lags by at most one quant. The thread gets the previous snapshot back and
+// fills it next time, so copies are allocated only for new timers.
 class Profiler : public ProfilerInterface
 {
 public:
@@ -111,15 +155,54 @@ public:
 
 	void serializeAll(yasli::Archive& ar);
 
-	int ticks2time(__int64 t) { return t ? xround((t - start_ticks)*time_factor) : 0; }
+	int ticks2time(yasli::i64 t) { return t ? xround((t - start_ticks)*time_factor) : 0; }
 
 	static Profiler& instance() { return TimerData::profiler(); }
 
 	bool empty() const;
 
+	// Trace recording: every timer scope (the outermost one for recursive calls)
+	// is stored with its begin and end time into a ring buffer of its thread,
+	// the oldest events are overwritten.
+	// eventsPerThread is rounded up to power of two, an event takes 24 bytes.
+	// Events are kept after stopTrace, until the next startTrace.
+	static void startTrace(int eventsPerThread = 65536);
+	static void stopTrace();
+	static bool traceRecording() { return traceRecording_.load(std::memory_order_relaxed); }
+	// Writes recorded events in Chrome trace event format, which is opened by
+	// chrome://tracing and ui.perfetto.dev. Can be called while recording.
+	static void serializeTrace(yasli::Archive& ar);
+	static bool saveTrace(const char* fileName);
+
+	// Called by the first start() and the last stop() of the thread. Stack may
+	// be left not empty by scopes that were entered before profiler mode changed.
+	void enterScope() { stack_.clear(); if(clearRequest_ != clearRequests_.load(std::memory_order_relaxed)) clearRequested(); }
+	void leaveScope() { AllocationData::current_ = 0; if(publishedQuant_ != quants_.load(std::memory_order_relaxed)) publish(); }
+
 private:
+	struct Snapshot;
+
+	// fields are atomic, so events can be read while the thread overwrites them
+	struct TraceEvent
+	{
+		std::atomic<const char*> title;
+		std::atomic<yasli::i64> begin;
+		std::atomic<yasli::i64> end;
+	};
+
+	void recordTrace(const char* title, yasli::i64 begin, yasli::i64 end);
+	void resizeTrace();
+
+	void clearRequested();
+	// timers started in another thread than the one that created them are
+	// left out of snapshots
+	bool ownTimer(const TimerData* timer) const { return size_t(timer->index_) < timers_.size() && timers_[timer->index_] == timer; }
+	void publish();
+	Snapshot* takeSnapshot();
+	void returnSnapshot(Snapshot* snapshot);
+
 	Timers timers_;
-	Timers stack_;
+	std::vector<TimerData*> stack_;
 	Timers roots_;
 
 	typedef std::vector<yasli::SharedPtr<StatisticalData> > Statistics;
@@ -129,13 +212,34 @@ private:
 	bool quantEntered_;
 	std::string name_;
 
+	int depth_;
+	unsigned int clearRequest_;
+	unsigned int publishedQuant_;
+	std::atomic<Snapshot*> snapshot_;
+	Snapshot* spareSnapshot_;
+
+	TraceEvent* trace_;
+	yasli::u64 traceMask_;
+	std::atomic<yasli::u64> traceHead_;
+	unsigned int traceGeneration_;
+
+	static std::atomic<unsigned int> clearRequests_;
+	static std::atomic<unsigned int> quants_;
+
+	static std::atomic<bool> traceRecording_;
+	static std::atomic<unsigned int> traceGenerations_;
+	static yasli::u64 traceSize_;
+	static yasli::i64 traceStartCounter_;
+	static yasli::i64 traceStartTicks_;
+
 	static bool started;
 	static int milliseconds;
-	static __int64 counterPrev_;
-	static __int64 frequency_;
-	static __int64 start_ticks;
-	static __int64 ticks;
+	static yasli::i64 counterPrev_;
+	static yasli::i64 frequency_;
+	static yasli::i64 start_ticks;
+	static yasli::i64 ticks;
 	static double time_factor;
+	static int serializedFrames_;
 
 	static bool autoExit_;
 	static int startLogicQuant_;
@@ -146,8 +250,8 @@ private:
 	typedef std::vector<yasli::SharedPtr<Profiler> > Profilers;
 	static Profilers profilers_;
 
-	friend TimerData;
-	friend StatisticalData;
+	friend struct TimerData;
+	friend class StatisticalData;
 };
 
 class AutoStopTimer
@@ -158,11 +262,11 @@ public:
 	~AutoStopTimer() { timer.stop(); }
 };
 	
-#define start_timer(title) static __declspec(thread) TimerData* __timer_##title; if(!__timer_##title) __timer_##title = new TimerData(__FUNCTION__" "#title); __timer_##title->start(); 
+#define start_timer(title) static PROFILER_THREAD_LOCAL TimerData* __timer_##title; if(!__timer_##title) __timer_##title = new TimerData(__FUNCTION__, #title); __timer_##title->start(); 
 #define stop_timer(title) __timer_##title->stop();
-#define start_timer_auto() static __declspec(thread) TimerData* __timer_; if(!__timer_) __timer_ = new TimerData(__FUNCTION__); __timer_->start(); AutoStopTimer autostop_timer_(*__timer_); 
-#define start_timer_auto1(title) static __declspec(thread) TimerData* __timer_##title; if(!__timer_##title) __timer_##title = new TimerData(__FUNCTION__" "#title); __timer_##title->start(); AutoStopTimer autostop_timer_##title(*__timer_##title); 
-#define statistics_add(title, x) { static __declspec(thread) StatisticalData* stat_##title; if(!stat_##title) stat_##title = new StatisticalData(#title); stat_##title->add(x); }
+#define start_timer_auto() static PROFILER_THREAD_LOCAL TimerData* __timer_; if(!__timer_) __timer_ = new TimerData(__FUNCTION__); __timer_->start(); AutoStopTimer autostop_timer_(*__timer_); 
+#define start_timer_auto1(title) static PROFILER_THREAD_LOCAL TimerData* __timer_##title; if(!__timer_##title) __timer_##title = new TimerData(__FUNCTION__, #title); __timer_##title->start(); AutoStopTimer autostop_timer_##title(*__timer_##title); 
+#define statistics_add(title, x) { static PROFILER_THREAD_LOCAL StatisticalData* stat_##title; if(!stat_##title) stat_##title = new StatisticalData(#title); stat_##title->add(x); }
 
 inline void profiler_start_stop(ProfilerMode mode = PROFILER_REBUILD) { Profiler::instance().start_stop(mode); }
 inline void profiler_quant(int curLogicQuant = 0) { Profiler::instance().quant(curLogicQuant); }
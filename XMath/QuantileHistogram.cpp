@@ -0,0 +1,111 @@
+#include "stdafx.h"
+#include <float.h>
+#include <math.h>
+#include "QuantileHistogram.h"
+#include "yasli/Archive.h"
+#include "yasli/STL.h"
+
+void QuantileHistogram::clear()
+{
+	counts_.clear();
+	firstBucket_ = 0;
+	count_ = 0;
+	zeros_ = 0;
+	min_ = DBL_MAX;
+	max_ = -DBL_MAX;
+}
+
+// middle of the bucket
+double QuantileHistogram::bucketValue(int index)
+{
+	yasli::u64 lower = yasli::u64(index) << MANTISSA_SHIFT;
+	yasli::u64 upper = yasli::u64(index + 1) << MANTISSA_SHIFT;
+	double lowerValue, upperValue;
+	memcpy(&lowerValue, &lower, sizeof(lowerValue));
+	memcpy(&upperValue, &upper, sizeof(upperValue));
+	return lowerValue + (upperValue - lowerValue)*0.5;
+}
+
+// Range of buckets is extended to whole powers of two, so it grows
+// a few times only. Returns position of the bucket in counts_.
+int QuantileHistogram::grow(int index)
+{
+	int first = index & ~(SUB_BUCKETS - 1);
+	int last = index | (SUB_BUCKETS - 1);
+	if(counts_.empty()){
+		firstBucket_ = first;
+		counts_.resize(last - first + 1);
+	}
+	else if(index < firstBucket_){
+		counts_.insert(counts_.begin(), firstBucket_ - first, 0);
+		firstBucket_ = first;
+	}
+	else
+		counts_.resize(last - firstBucket_ + 1);
+	return index - firstBucket_;
+}
+
+void QuantileHistogram::merge(const QuantileHistogram& histogram)
+{
+	if(!histogram.count_)
+		return;
+	if(!histogram.counts_.empty()){
+		int last = histogram.firstBucket_ + int(histogram.counts_.size()) - 1;
+		if(counts_.empty() || histogram.firstBucket_ < firstBucket_)
+			grow(histogram.firstBucket_);
+		if(last >= firstBucket_ + int(counts_.size()))
+			grow(last);
+		yasli::u64* counts = &counts_[histogram.firstBucket_ - firstBucket_];
+		for(size_t i = 0; i < histogram.counts_.size(); ++i)
+			counts[i] += histogram.counts_[i];
+	}
+	count_ += histogram.count_;
+	zeros_ += histogram.zeros_;
+	if(min_ > histogram.min_)
+		min_ = histogram.min_;
+	if(max_ < histogram.max_)
+		max_ = histogram.max_;
+}
+
+double QuantileHistogram::quantile(double q) const
+{
+	if(!count_)
+		return 0;
+	if(q <= 0)
+		return min_;
+	if(q >= 1)
+		return max_;
+	// the smallest value that has at least rank values before it and itself
+	yasli::u64 rank = yasli::u64(ceil(q*double(count_)));
+	if(rank < 1)
+		rank = 1;
+	double value = 0;
+	yasli::u64 sum = zeros_;
+	if(sum < rank){
+		for(size_t i = 0; i < counts_.size(); ++i){
+			sum += counts_[i];
+			if(sum >= rank){
+				value = bucketValue(firstBucket_ + int(i));
+				break;
+			}
+		}
+	}
+	return value < min_ ? min_ : value > max_ ? max_ : value;
+}
+
+void QuantileHistogram::serialize(yasli::Archive& ar)
+{
+	ar(count_, "count", "Count");
+	ar(min_, "min", "Minimum");
+	ar(max_, "max", "Maximum");
+	ar(zeros_, "zeros", "Zeros");
+	ar(firstBucket_, "firstBucket", "First bucket");
+	ar(counts_, "counts", "Counts");
+	if(ar.isInput()){
+		yasli::u64 sum = zeros_;
+		for(size_t i = 0; i < counts_.size(); ++i)
+			sum += counts_[i];
+		if(sum != count_ || firstBucket_ < 0 || firstBucket_ + int(counts_.size()) > BUCKET_MAX + 1)
+			clear();
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string.h>
+#include <vector>
+#include "yasli/Config.h"
+
+namespace yasli { class Archive; }
+
+// Streaming quantiles of frame times, latencies and other positive values in
+// the way of HDR histogram: every power of two is split into SUB_BUCKETS
+// buckets of equal width, so quantiles are known with relative error of at
+// most 1/(2*SUB_BUCKETS), 0.8%, whatever the range of values is (above
+// DBL_MIN, denormals share one power of two). Buckets are allocated for the
+// range of added values only: 64 per power of two, a couple of thousands of
+// bytes for values from microseconds to seconds. Values that are not
+// positive are counted as zeros.
+class QuantileHistogram
+{
+public:
+	enum { SUB_BUCKETS = 64 };
+
+	QuantileHistogram() { clear(); }
+	void clear();
+	void add(double x);
+	// Histograms of several threads or runs may be merged for a report.
+	void merge(const QuantileHistogram& histogram);
+
+	yasli::u64 count() const { return count_; }
+	double minimum() const { return count_ ? min_ : 0; }
+	double maximum() const { return count_ ? max_ : 0; }
+	// Value that is not less than fraction q of added values, q in [0, 1]:
+	// quantile(0.5) is median, quantile(0.99) is 99th percentile. Exact
+	// minimum and maximum are returned for 0 and 1.
+	double quantile(double q) const;
+
+	void serialize(yasli::Archive& ar);
+
+private:
+	// High bits of positive double are its exponent and the highest bits of
+	// mantissa, so they make up an index of bucket
+	enum { MANTISSA_SHIFT = 46, BUCKET_MAX = (0x7fe << 6) | (SUB_BUCKETS - 1) };
+	static int bucket(double x)
+	{
+		yasli::u64 bits;
+		memcpy(&bits, &x, sizeof(bits));
+		int index = int(bits >> MANTISSA_SHIFT);
+		return index < BUCKET_MAX ? index : BUCKET_MAX;
+	}
+	static double bucketValue(int index);
+	int grow(int index);
+
+	std::vector<yasli::u64> counts_;
+	int firstBucket_;
+	yasli::u64 count_;
+	yasli::u64 zeros_;
+	double min_;
+	double max_;
+};
+
+inline void QuantileHistogram::add(double x)
+{
+	++count_;
+	if(min_ > x)
+		min_ = x;
+	if(max_ < x)
+		max_ = x;
+	if(!(x > 0)){
+		++zeros_;
+		return;
+	}
+	unsigned index = unsigned(bucket(x) - firstBucket_);
+	if(index >= counts_.size())
+		index = grow(bucket(x));
+	++counts_[index];
+}
@@ -0,0 +1,202 @@
+#include "stdafx.h"
+#include "Random.h"
+#include "yasli/Archive.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define XMATH_RANDOM_SSE
+#endif
+
+// jumps to other streams take as long as about 2000 values of one stream
+static const size_t FILL_STREAMS_MIN = 2048;
+
+void RandomStream::set(unsigned long long seed)
+{
+	for(int i = 0; i < 4; i += 2){
+		unsigned long long z = (seed += 0x9e3779b97f4a7c15ull);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+		z ^= z >> 31;
+		state_[i] = unsigned(z);
+		state_[i + 1] = unsigned(z >> 32);
+	}
+	// zero state is the only one that stays zero
+	if(!(state_[0] | state_[1] | state_[2] | state_[3]))
+		state_[0] = 1;
+}
+
+void RandomStream::getState(unsigned state[4]) const
+{
+	for(int i = 0; i < 4; ++i)
+		state[i] = state_[i];
+}
+
+void RandomStream::setState(const unsigned state[4])
+{
+	for(int i = 0; i < 4; ++i)
+		state_[i] = state[i];
+	if(!(state_[0] | state_[1] | state_[2] | state_[3]))
+		state_[0] = 1;
+}
+
+void RandomStream::jump(const unsigned polynomial[4])
+{
+	unsigned s[4] = { 0, 0, 0, 0 };
+	for(int i = 0; i < 4; ++i)
+		for(int b = 0; b < 32; ++b){
+			// mask instead of branch, bits are random and would be mispredicted
+			unsigned mask = 0u - ((polynomial[i] >> b) & 1);
+			for(int j = 0; j < 4; ++j)
+				s[j] ^= state_[j] & mask;
+			next32();
+		}
+	setState(s);
+}
+
+void RandomStream::jump()
+{
+	static const unsigned polynomial[4] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+	jump(polynomial);
+}
+
+void RandomStream::longJump()
+{
+	static const unsigned polynomial[4] = { 0xb523952e, 0x0b6f099f, 0xccf5a0ef, 0x1c580662 };
+	jump(polynomial);
+}
+
+namespace {
+
+// Four streams, each one 2^64 values ahead of the previous one. Values are
+// interleaved: values[4*i + k] is i-th value of stream k.
+struct FourStreams
+{
+	RandomStream streams[4];
+
+	explicit FourStreams(RandomStream& stream)
+	{
+		for(int k = 0; k < 4; ++k)
+			streams[k] = stream.split();
+	}
+
+	// the rest of values after generate
+	void generateTail(unsigned* values, size_t count)
+	{
+		for(size_t k = 0; k < count; ++k)
+			values[k] = streams[k].next32();
+	}
+
+#ifdef XMATH_RANDOM_SSE
+	static __m128i rotl(__m128i x, int k) { return _mm_or_si128(_mm_slli_epi32(x, k), _mm_srli_epi32(x, 32 - k)); }
+
+	// x * 5 and x * 9 as shifts, SSE2 has no 32-bit multiplication
+	template<class Store>
+	size_t generate(size_t count, Store store)
+	{
+		unsigned words[4][4];
+		for(int k = 0; k < 4; ++k)
+			streams[k].getState(words[k]);
+		__m128i s[4];
+		for(int j = 0; j < 4; ++j)
+			s[j] = _mm_set_epi32(int(words[3][j]), int(words[2][j]), int(words[1][j]), int(words[0][j]));
+
+		size_t n = count / 4;
+		for(size_t i = 0; i < n; ++i){
+			__m128i x5 = _mm_add_epi32(_mm_slli_epi32(s[1], 2), s[1]);
+			__m128i r = rotl(x5, 7);
+			store(i * 4, _mm_add_epi32(_mm_slli_epi32(r, 3), r));
+			__m128i t = _mm_slli_epi32(s[1], 9);
+			s[2] = _mm_xor_si128(s[2], s[0]);
+			s[3] = _mm_xor_si128(s[3], s[1]);
+			s[1] = _mm_xor_si128(s[1], s[2]);
+			s[0] = _mm_xor_si128(s[0], s[3]);
+			s[2] = _mm_xor_si128(s[2], t);
+			s[3] = rotl(s[3], 11);
+		}
+
+		for(int j = 0; j < 4; ++j){
+			unsigned lanes[4];
+			_mm_storeu_si128((__m128i*)lanes, s[j]);
+			for(int k = 0; k < 4; ++k)
+				words[k][j] = lanes[k];
+		}
+		for(int k = 0; k < 4; ++k)
+			streams[k].setState(words[k]);
+		return n * 4;
+	}
+#endif
+};
+
+#ifdef XMATH_RANDOM_SSE
+struct StoreUnsigned
+{
+	unsigned* values;
+	void operator()(size_t i, __m128i v) const { _mm_storeu_si128((__m128i*)(values + i), v); }
+};
+
+struct StoreFloat
+{
+	float* values;
+	__m128 scale;
+	__m128 offset;
+	void operator()(size_t i, __m128i v) const
+	{
+		__m128 f = _mm_cvtepi32_ps(_mm_srli_epi32(v, 8));
+		_mm_storeu_ps(values + i, _mm_add_ps(_mm_mul_ps(f, scale), offset));
+	}
+};
+#endif
+
+}
+
+void RandomStream::fill(unsigned* values, size_t count)
+{
+	if(count < FILL_STREAMS_MIN){
+		for(size_t i = 0; i < count; ++i)
+			values[i] = next32();
+		return;
+	}
+	FourStreams four(*this);
+	size_t done = 0;
+#ifdef XMATH_RANDOM_SSE
+	StoreUnsigned store = { values };
+	done = four.generate(count, store);
+#endif
+	for(; done + 4 <= count; done += 4)
+		four.generateTail(values + done, 4);
+	four.generateTail(values + done, count - done);
+}
+
+void RandomStream::fill(float* values, size_t count, float min, float max)
+{
+	// the same as frand, float(u >> 8) / 2^24, then scaled
+	float scale = (max - min) * (1.f / 16777216.f);
+	if(count < FILL_STREAMS_MIN){
+		for(size_t i = 0; i < count; ++i)
+			values[i] = float(next32() >> 8) * scale + min;
+		return;
+	}
+	FourStreams four(*this);
+	size_t done = 0;
+#ifdef XMATH_RANDOM_SSE
+	StoreFloat store = { values, _mm_set1_ps(scale), _mm_set1_ps(min) };
+	done = four.generate(count, store);
+#endif
+	unsigned bits[4];
+	for(; done < count; done += 4){
+		size_t n = count - done < 4 ? count - done : 4;
+		four.generateTail(bits, n);
+		for(size_t k = 0; k < n; ++k)
+			values[done + k] = float(bits[k] >> 8) * scale + min;
+	}
+}
+
+void RandomStream::serialize(yasli::Archive& ar)
+{
+	ar(state_[0], "s0");
+	ar(state_[1], "s1");
+	ar(state_[2], "s2");
+	ar(state_[3], "s3");
+	if(ar.isInput() && !(state_[0] | state_[1] | state_[2] | state_[3]))
+		state_[0] = 1;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stddef.h>
+
 class RandomGenerator 
 {
 	enum { max_value = 0x7fff };
@@ -24,3 +26,84 @@ inline float frnd(float x){ return xm_random_generator.frnd(x); }
 inline float fabsRnd(float x){ return xm_random_generator.fabsRnd(x); }
 
 inline unsigned rnd(unsigned m){ return xm_random_generator(m); }
+
+namespace yasli { class Archive; }
+
+// xoshiro128** of Blackman and Vigna: 128 bits of state, period 2^128 - 1,
+// passes BigCrush. Has the interface of RandomGenerator, so it may replace
+// it, but sequences differ. Each thread or task should have its own stream
+// split from a common one, streams are 2^64 values apart:
+//
+// RandomStream master(seed);
+// for(int i = 0; i < tasks; ++i)
+//     task[i].random = master.split();
+class RandomStream
+{
+public:
+	enum { max_value = 0x7fff };
+
+	RandomStream(unsigned long long seed = 1) { set(seed); }
+	// state is filled by splitmix64 from the seed
+	void set(unsigned long long seed);
+	void getState(unsigned state[4]) const;
+	void setState(const unsigned state[4]);
+
+	unsigned next32()
+	{
+		unsigned result = rotl(state_[1] * 5, 7) * 9;
+		unsigned t = state_[1] << 9;
+		state_[2] ^= state_[0];
+		state_[3] ^= state_[1];
+		state_[1] ^= state_[2];
+		state_[0] ^= state_[3];
+		state_[2] ^= t;
+		state_[3] = rotl(state_[3], 11);
+		return result;
+	}
+	unsigned long long next64() { unsigned long long high = next32(); return high << 32 | next32(); }
+
+	// [0, bound) without bias of %, by multiplication with rejection (Lemire)
+	unsigned uniform(unsigned bound)
+	{
+		unsigned long long m = (unsigned long long)next32() * bound;
+		if((unsigned)m < bound){
+			unsigned threshold = (0u - bound) % bound;
+			while((unsigned)m < threshold)
+				m = (unsigned long long)next32() * bound;
+		}
+		return unsigned(m >> 32);
+	}
+	// [min, max)
+	int uniform(int min, int max) { return min + int(uniform(unsigned(max - min))); }
+	// [0, 1) with 24 bits
+	float frand() { return float(next32() >> 8) * (1.f / 16777216.f); }
+
+	// the same as of RandomGenerator
+	int operator()() { return int(next32() >> 17); }
+	int operator()(int m) { return m > 0 ? int(uniform(unsigned(m))) : 0; } // May by used in random_shuffle
+	int operator()(int min, int max) { return min + (*this)(max - min); }
+	float frnd(float x = 1.f) { return (frand()*2.f - 1.f)*x; }
+	float fabsRnd(float x = 1.f) { return frand()*x; }
+	float fabsRnd(float min, float max) { return min + fabsRnd(max - min); }
+
+	// Advances by 2^64 values or by 2^96 for long jump, as 2^64 or 2^96 calls to next32.
+	void jump();
+	void longJump();
+	// Returns this stream and jumps, so the returned one is not overlapped by the rest of this one.
+	RandomStream split() { RandomStream stream(*this); jump(); return stream; }
+
+	// Fills with four streams at once, with SSE2 when it is present. From 2048
+	// values on they differ from successive calls of next32 and the stream
+	// jumps 4 times afterwards, results do not depend on processor.
+	void fill(unsigned* values, size_t count);
+	// [min, max)
+	void fill(float* values, size_t count, float min = 0.f, float max = 1.f);
+
+	void serialize(yasli::Archive& ar);
+
+private:
+	static unsigned rotl(unsigned x, int k) { return (x << k) | (x >> (32 - k)); }
+	void jump(const unsigned polynomial[4]);
+
+	unsigned state_[4];
+};
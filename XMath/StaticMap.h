@@ -4,8 +4,10 @@
 #include <algorithm>
 #include <functional>
 #include "yasli/Assert.h"
-
-namespace yasli { class Archive; }
+#include "yasli/Archive.h"
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <xmmintrin.h>
+#endif
 
 template<class K, class T, class Cmp=std::less<K>, class A=std::allocator<std::pair<K, T> > > 
 class StaticMap 
@@ -47,10 +49,79 @@ public:
 private:
 
 	Vec	MapVector;
+
+	// Search index built by buildSearchIndex: keys in Eytzinger (breadth-first)
+	// order of an implicit tree, children of node k are 2k and 2k + 1, so the
+	// upper levels share a few cache lines and descendants of a node lie
+	// together. Positions of keys in MapVector are kept aside. Empty when
+	// there is no index, otherwise holds PREFETCH_NODES of padding, see
+	// indexNodes.
+	std::vector<K> indexKeys_;
+	std::vector<size_type> indexPositions_;
+
+	// nodes of a cache line, descendants this many levels below are prefetched
+	enum { PREFETCH_NODES = sizeof(K) < 64 ? 64 / sizeof(K) : 1 };
+
+	// Node 0 of the index. It is placed at a cache line boundary, so nodes
+	// 16k...16k + 15 that are prefetched together share one cache line
+	// (for int keys) instead of straddling two.
+	const K* indexNodes() const {
+		size_t misalignment = size_t(&indexKeys_[0]) % 64;
+		return &indexKeys_[0] + (64 - misalignment) % 64 / sizeof(K);
+	}
+
+	struct NotLess {
+		value_compare comp;
+		NotLess(value_compare c) : comp(c) {}
+		bool operator()(const value_type& x, const value_type& y) const { return !comp(x, y); }
+	};
+
+	struct Greater {
+		value_compare comp;
+		Greater(value_compare c) : comp(c) {}
+		bool operator()(const value_type& x, const value_type& y) const { return comp(y, x); }
+	};
+
+	void dropSearchIndex() {
+		std::vector<K>().swap(indexKeys_);
+		std::vector<size_type>().swap(indexPositions_);
+	}
+
+	// in-order walk over the tree assigns sorted keys to nodes
+	void buildSearchIndex(size_type node, size_type& position, K* keys) {
+		if (node > MapVector.size())
+			return;
+		buildSearchIndex(2 * node, position, keys);
+		keys[node] = MapVector[position].first;
+		indexPositions_[node] = position++;
+		buildSearchIndex(2 * node + 1, position, keys);
+	}
+
+	size_type indexedLowerBound(const key_type& key) const {
+		size_type size = MapVector.size();
+		const K* keys = indexNodes();
+		size_type node = 1;
+		while (node <= size) {
+#if defined(__GNUC__)
+			__builtin_prefetch(keys + node * PREFETCH_NODES);
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+			_mm_prefetch((const char*)(keys + node * PREFETCH_NODES), _MM_HINT_T0);
+#endif
+			node = 2 * node + (key_comp()(keys[node], key) ? 1 : 0);
+		}
+		// the last turn to the left leads to the lower bound: drops trailing
+		// right turns and that turn, nothing is left when key is above all keys
+		while (node & 1)
+			node >>= 1;
+		node >>= 1;
+		return node ? indexPositions_[node] : size;
+	}
 	
 	iterator binary_search(iterator first, iterator last, const key_type& key) {
 		if (MapVector.empty())
 			return MapVector.end();
+		if (!indexKeys_.empty() && first == MapVector.begin() && last == MapVector.end())
+			return MapVector.begin() + indexedLowerBound(key);
         iterator vc;
 		iterator vb = first;
 		iterator ve = last - 1;
@@ -79,6 +150,8 @@ private:
 	const_iterator binary_search(const_iterator first, const_iterator last, const key_type& key) const {
 		if (MapVector.empty()) 
 			return MapVector.end();
+		if (!indexKeys_.empty() && first == MapVector.begin() && last == MapVector.end())
+			return MapVector.begin() + indexedLowerBound(key);
         const_iterator vc;
 		const_iterator vb = first;
 		const_iterator ve = last - 1;
@@ -118,9 +191,17 @@ public:
 		insert(first, last); 
 	}
 
-	StaticMap(const StaticMap& x) : MapVector(x.MapVector), lock_(0) {}
+	// index is built anew as alignment of the copy differs
+	StaticMap(const StaticMap& x) : MapVector(x.MapVector), lock_(0) {
+		if (x.hasSearchIndex())
+			buildSearchIndex();
+	}
     StaticMap& operator=(const StaticMap& x) {
 		MapVector = x.MapVector;
+		if (x.hasSearchIndex())
+			buildSearchIndex();
+		else
+			dropSearchIndex();
 		return *this; 
 	}
 	
@@ -139,7 +220,7 @@ public:
 	reverse_iterator rend() { return MapVector.rend(); }
 	const_reverse_iterator rend() const { return MapVector.rend(); }
 
-	void clear() { MapVector.clear(); }
+	void clear() { MapVector.clear(); dropSearchIndex(); }
 	bool empty() const { return MapVector.empty(); }
 	size_type size() const { return MapVector.size(); }
 
@@ -162,11 +243,12 @@ public:
 			return 0;
 		const_iterator vlb = binary_search(MapVector.begin(), MapVector.end(), key);
 		size_type sz = 0;
-		while ((!key_comp()(vlb->first, key))&&(!key_comp()(key, vlb->first))) { sz++; vlb++; }
+		while (vlb != MapVector.end() && (!key_comp()(vlb->first, key))&&(!key_comp()(key, vlb->first))) { sz++; vlb++; }
 		return sz;
 	}
 
 	std::pair<iterator, bool> insert(const value_type& x) {
+		dropSearchIndex();
 		iterator vend = MapVector.end();
 		iterator vi = binary_search(MapVector.begin(), vend, x.first);
 		if (vi!=vend) {
@@ -183,6 +265,7 @@ public:
 	}
 
 	iterator insert(iterator where, const value_type& x) {
+		dropSearchIndex();
 		iterator vend = MapVector.end();
 		iterator vi = binary_search(where, vend, x.first);
 		if (vi!=vend) {
@@ -200,14 +283,51 @@ public:
 		return vi;
 	}
 
-	void insert(const_iterator first, const_iterator last) {
-		for (const_iterator p = first;p!=last;++p) 
-			{ insert(*p); } 
-    }
+	// Elements with keys that are in the map already are skipped, as by insert
+	// of single elements, but the map is sorted once.
+	template<class InputIterator>
+	void insert(InputIterator first, InputIterator last) {
+		dropSearchIndex();
+		MapVector.insert(MapVector.end(), first, last);
+		sortUnique();
+	}
+
+	// Adds element to the end without keeping order, sortUnique has to be
+	// called before the map is searched.
+	void append(const value_type& x) { dropSearchIndex(); MapVector.push_back(x); }
+
+	// Sorts and removes elements with equal keys, the first one of them is
+	// kept. Takes O(n) for sorted elements, as of a saved map.
+	void sortUnique() {
+		iterator first = MapVector.begin();
+		iterator last = MapVector.end();
+		iterator notAscending = std::adjacent_find(first, last, NotLess(value_comp()));
+		if (notAscending == last)
+			return;
+		dropSearchIndex();
+		if (std::adjacent_find(notAscending, last, Greater(value_comp())) != last)
+			std::stable_sort(first, last, value_comp());
+		MapVector.erase(std::unique(first, last, NotLess(value_comp())), last);
+	}
+
+	// Builds the search index used by lookups of the whole map until the map
+	// is changed, except through iterators which must not change keys anyway.
+	// Takes extra memory of about the size of keys plus size_type per element.
+	void buildSearchIndex() {
+		dropSearchIndex();
+		if (MapVector.empty())
+			return;
+		indexKeys_.resize(MapVector.size() + 1 + PREFETCH_NODES);
+		indexPositions_.resize(MapVector.size() + 1);
+		size_type position = 0;
+		buildSearchIndex(1, position, const_cast<K*>(indexNodes()));
+	}
+	bool hasSearchIndex() const { return !indexKeys_.empty(); }
 
-	iterator erase(iterator where)	{ return MapVector.erase(where); }
-	iterator erase(iterator first, iterator last) { return MapVector.erase(first, last); }
+	iterator erase(iterator where)	{ dropSearchIndex(); return MapVector.erase(where); }
+	iterator erase(iterator first, iterator last) { dropSearchIndex(); return MapVector.erase(first, last); }
 	size_type erase(const key_type& key){
+		dropSearchIndex();
 		if(MapVector.empty())
 			return 0;
 		std::pair<iterator, iterator> rng = equal_range(key);
@@ -274,7 +394,7 @@ public:
 		iterator ve = MapVector.end();
 		iterator vs = binary_search(MapVector.begin(), ve, key);
 		if(vs != ve){
-			while ((!key_comp()(vs->first, key))&&(!key_comp()(key, vs->first))) { vs++; }
+			while (vs != ve && (!key_comp()(vs->first, key))&&(!key_comp()(key, vs->first))) { vs++; }
 			return vs;
 		}      
 		return ve;
@@ -284,7 +404,7 @@ public:
 		const_iterator ve = MapVector.end();
 		const_iterator vs = binary_search(MapVector.begin(), ve, key);
 		if(vs != ve) {
-			while ((!key_comp()(vs->first, key))&&(!key_comp()(key, vs->first))) { vs++; }
+			while (vs != ve && (!key_comp()(vs->first, key))&&(!key_comp()(key, vs->first))) { vs++; }
 			return vs;
 		}      
 		return ve;
@@ -292,12 +412,17 @@ public:
 
 	size_type max_size( ) const { return MapVector.max_size(); }
 	
-	void swap(StaticMap& right) { MapVector.swap(right.MapVector); }
+	void swap(StaticMap& right) {
+		MapVector.swap(right.MapVector);
+		indexKeys_.swap(right.indexKeys_);
+		indexPositions_.swap(right.indexPositions_);
+	}
 
 	mapped_type& operator[](const key_type& key) {
 		iterator vi = binary_search(MapVector.begin(), MapVector.end(), key);
 		if (vi==MapVector.end()||(key_comp()(key, vi->first))){
 			YASLI_ASSERT(!lock_ && "StaticMap is locked");
+			dropSearchIndex();
 			vi = MapVector.insert(vi, value_type(key, mapped_type()));
 		}
 		return (*vi).second;
@@ -322,7 +447,12 @@ public:
 		return it != end() ? it->second : def;
 	}
 
-	void sort() { std::sort(MapVector.begin(), MapVector.end(), value_comp()); }
+	void sort() {
+		if (std::adjacent_find(MapVector.begin(), MapVector.end(), Greater(value_comp())) != MapVector.end()) {
+			dropSearchIndex();
+			std::sort(MapVector.begin(), MapVector.end(), value_comp());
+		}
+	}
 	void reserve(size_type size) { MapVector.reserve(size);	}
 
 	bool operator==(const StaticMap& map) const { return MapVector == map.MapVector; }
@@ -330,7 +460,7 @@ public:
 	template<class K1, class T1, class Cmp1, class A1> 
 	friend bool serialize(yasli::Archive& ar, StaticMap<K1, T1, Cmp1, A1>& map, const char* name, const char* nameAlt);
 
-	Vec& vector() { return MapVector; }
+	Vec& vector() { dropSearchIndex(); return MapVector; }
 	const Vec& vector() const { return MapVector; }
 
 	struct Lock {
@@ -357,9 +487,16 @@ public:
 
 template<class K, class T, class Cmp, class A> 
 bool serialize(yasli::Archive& ar, StaticMap<K, T, Cmp, A>& map, const char* name, const char* nameAlt) {
+	if(ar.isInput())
+		map.dropSearchIndex();
 	bool nodeExists = ar(map.MapVector, name, nameAlt);
-	if(!ar.isEdit()) 
-		map.sort();
+	if(!ar.isEdit()) {
+		// saved maps are sorted, so loading takes O(n)
+		if(ar.isInput())
+			map.sortUnique();
+		else
+			map.sort();
+	}
 	return nodeExists;
 }
 
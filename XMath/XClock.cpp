@@ -1,5 +1,53 @@
 #include "stdafx.h"
-#include <windows.h>
+#include <atomic>
+#include "XClock.h"
+
+#ifdef _MSC_VER
+# include <windows.h>
+#else
+# include <time.h>
+#endif
+
+static std::atomic<double> ticksPerNanosecond(0.);
+
+double xclockTicksPerNanosecond()
+{
+	double rate = ticksPerNanosecond.load(std::memory_order_relaxed);
+	if(rate)
+		return rate;
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+	// threads that come here at once measure it each, results are close enough
+	const yasli::i64 CALIBRATION_PERIOD = 10000000;
+	yasli::i64 time0 = xclockNanoseconds();
+	yasli::i64 ticks0 = xclockTicks();
+	yasli::i64 time1;
+	do
+		time1 = xclockNanoseconds();
+	while(time1 - time0 < CALIBRATION_PERIOD);
+	rate = double(xclockTicks() - ticks0)/double(time1 - time0);
+#else
+	rate = 1.;
+#endif
+	ticksPerNanosecond.store(rate, std::memory_order_relaxed);
+	return rate;
+}
+
+#ifndef _MSC_VER
+yasli::i64 xclockNanoseconds()
+{
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return yasli::i64(time.tv_sec)*1000000000 + time.tv_nsec;
+}
+
+static yasli::i64 clockStart = xclockNanoseconds();
+
+int xclock()
+{
+	return int((xclockNanoseconds() - clockStart)/1000000);
+}
+#else
+// xclock of Windows: timeGetTime refined by the per processor counters
 #include <MMSystem.h>
 
 #pragma comment(lib, "winmm.lib")
@@ -141,6 +189,25 @@ int xclock()
 	return XClock::clocks_[getCPUID() & (PROCESSORS_MAX - 1)].time();
 } 
 
+static yasli::i64 performanceFrequency()
+{
+	yasli::i64 frequency;
+	QueryPerformanceFrequency((LARGE_INTEGER*)&frequency);
+	return frequency;
+}
+
+static const yasli::i64 frequency = performanceFrequency();
+
+yasli::i64 xclockNanoseconds()
+{
+	yasli::i64 counter;
+	QueryPerformanceCounter((LARGE_INTEGER*)&counter);
+	// counter*1000000000 overflows in a few hours
+	return counter/frequency*1000000000 + counter%frequency*1000000000/frequency;
+}
+#endif
+
+
 
 
 /*
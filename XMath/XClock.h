@@ -1,3 +1,36 @@
 #pragma once
 
-int xclock();
\ No newline at end of file
+#include "yasli/Config.h"
+
+#ifdef _MSC_VER
+# include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+# include <x86intrin.h>
+#endif
+
+// Milliseconds, monotonic. Starts from zero at the first call with MSVC and
+// at the start of the process elsewhere.
+int xclock();
+
+// Monotonic clock in nanoseconds, counted from an unspecified moment:
+// QueryPerformanceCounter with MSVC, CLOCK_MONOTONIC elsewhere. Takes about
+// 20-30 ns.
+yasli::i64 xclockNanoseconds();
+
+// Time stamp counter where it is available, xclockNanoseconds otherwise.
+// Takes a few nanoseconds, but counters of processors may differ a bit, so
+// intervals should be measured on one thread.
+inline yasli::i64 xclockTicks()
+{
+#if defined(_MSC_VER) || defined(__i386__) || defined(__x86_64__)
+	return __rdtsc();
+#else
+	return xclockNanoseconds();
+#endif
+}
+
+// Rate of xclockTicks, measured against xclockNanoseconds during 10 ms by
+// the first call, which blocks for that time. Exactly 1 without time stamp
+// counter.
+double xclockTicksPerNanosecond();
+inline double xclockTicksToNanoseconds(yasli::i64 ticks) { return ticks / xclockTicksPerNanosecond(); }
@@ -0,0 +1,327 @@
+#include "stdafx.h"
+#include <atomic>
+#include "xmath.h"
+#include "XMathBatch.h"
+#include "XMathBatchKernels.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+# define XMATH_BATCH_X86
+# ifdef _MSC_VER
+#  include <intrin.h>
+# endif
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define XMATH_BATCH_SSE
+#endif
+
+// kernels read matrices and quaternions as arrays of floats
+static_assert(sizeof(Vect3f) == 3 * sizeof(float), "Vect3f is not packed");
+static_assert(sizeof(Vect4f) == 4 * sizeof(float), "Vect4f is not packed");
+static_assert(sizeof(MatXf) == 12 * sizeof(float), "MatXf is not packed");
+static_assert(sizeof(QuatF) == 4 * sizeof(float), "QuatF is not packed");
+
+#ifdef XMATH_BATCH_SSE
+namespace {
+
+struct BatchSSE
+{
+	typedef __m128 R;
+	enum { GROUPS = 1 };
+
+	static R load(const float* p, size_t) { return _mm_loadu_ps(p); }
+	static void store(float* p, size_t, R v) { _mm_storeu_ps(p, v); }
+	static R loadWide(const float* p) { return _mm_loadu_ps(p); }
+	static void storeWide(float* p, R v) { _mm_storeu_ps(p, v); }
+	static R set1(float x) { return _mm_set1_ps(x); }
+	static R set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+	static R add(R a, R b) { return _mm_add_ps(a, b); }
+	static R sub(R a, R b) { return _mm_sub_ps(a, b); }
+	static R mul(R a, R b) { return _mm_mul_ps(a, b); }
+	static R div(R a, R b) { return _mm_div_ps(a, b); }
+	static R sqrt(R a) { return _mm_sqrt_ps(a); }
+	static R unpacklo(R a, R b) { return _mm_unpacklo_ps(a, b); }
+	static R unpackhi(R a, R b) { return _mm_unpackhi_ps(a, b); }
+	template<int imm>
+	static R shuffle(R a, R b) { return _mm_shuffle_ps(a, b, imm); }
+
+	// for FastMathKernels
+	typedef __m128 M;
+	static R signMask() { return _mm_set1_ps(-0.f); }
+	static R min(R a, R b) { return _mm_min_ps(a, b); }
+	static R max(R a, R b) { return _mm_max_ps(a, b); }
+	static R neg(R a) { return _mm_xor_ps(a, signMask()); }
+	static R abs(R a) { return _mm_andnot_ps(signMask(), a); }
+	static R copySign(R a, R s) { return _mm_or_ps(_mm_andnot_ps(signMask(), a), _mm_and_ps(signMask(), s)); }
+	static M less(R a, R b) { return _mm_cmplt_ps(a, b); }
+	static M equal(R a, R b) { return _mm_cmpeq_ps(a, b); }
+	static R select(M m, R a, R b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+	static R round(R a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+	static R rsqrtEstimate(R a) { return _mm_rsqrt_ps(a); }
+	static R rcpEstimate(R a) { return _mm_rcp_ps(a); }
+	static R pow2(R n)
+	{
+		return _mm_castsi128_ps(_mm_slli_epi32(_mm_cvtps_epi32(_mm_add_ps(n, _mm_set1_ps(127.f))), 23));
+	}
+	static R exponent(R x, R& m)
+	{
+		m = _mm_or_ps(_mm_and_ps(x, _mm_castsi128_ps(_mm_set1_epi32(0x807fffff))), _mm_set1_ps(0.5f));
+		return _mm_sub_ps(_mm_cvtepi32_ps(_mm_srli_epi32(_mm_castps_si128(x), 23)), _mm_set1_ps(126.f));
+	}
+};
+
+}
+#endif
+
+static bool processorHasAVX()
+{
+#if defined(XMATH_BATCH_X86) && defined(_MSC_VER) && _MSC_VER >= 1600
+	int info[4];
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	// OS has to save upper halves of ymm registers
+	return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#elif defined(XMATH_BATCH_X86) && defined(__GNUC__)
+	return __builtin_cpu_supports("avx") != 0;
+#else
+	return false;
+#endif
+}
+
+static const BatchKernels* kernelsOf(BatchInstructionSet set)
+{
+	switch(set){
+#ifdef XMATH_BATCH_SSE
+	case BATCH_SSE:
+		return &BatchKernelsImpl<BatchSSE>::table;
+#endif
+	case BATCH_AVX:
+		return batchKernelsAVX();
+	default:
+		return 0;
+	}
+}
+
+static BatchInstructionSet supportedInstructionSet()
+{
+	if(batchKernelsAVX() && processorHasAVX())
+		return BATCH_AVX;
+	if(kernelsOf(BATCH_SSE))
+		return BATCH_SSE;
+	return BATCH_SCALAR;
+}
+
+// -1 until the first call
+static std::atomic<int> currentInstructionSet(-1);
+static std::atomic<const BatchKernels*> currentKernels(0);
+
+BatchInstructionSet batchInstructionSet()
+{
+	int set = currentInstructionSet.load(std::memory_order_acquire);
+	if(set < 0)
+		return setBatchInstructionSet(BATCH_AVX);
+	return BatchInstructionSet(set);
+}
+
+BatchInstructionSet setBatchInstructionSet(BatchInstructionSet set)
+{
+	BatchInstructionSet supported = supportedInstructionSet();
+	if(set > supported)
+		set = supported;
+	currentKernels.store(kernelsOf(set), std::memory_order_relaxed);
+	currentInstructionSet.store(set, std::memory_order_release);
+	return set;
+}
+
+static const BatchKernels* kernels()
+{
+	if(currentInstructionSet.load(std::memory_order_acquire) < 0)
+		batchInstructionSet();
+	return currentKernels.load(std::memory_order_relaxed);
+}
+
+// ---------------------------------------------------------------------------
+// Kernels return number of processed elements, the rest is done here.
+
+void xformPoints(const MatXf& X, const Vect3f* points, Vect3f* result, size_t count)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels())
+		done = k->xformPoints(&X.R.xx, (const float*)points, (float*)result, count);
+	for(size_t i = done; i < count; ++i){
+		Vect3f p = points[i];
+		X.xformPoint(p, result[i]);
+	}
+}
+
+void xformPoints(const MatXf& X, const Vect3fSoA& points, const Vect3fSoA& result, size_t count)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels()){
+		const float* in[3] = { points.x, points.y, points.z };
+		float* out[3] = { result.x, result.y, result.z };
+		done = k->xformPointsSoA(&X.R.xx, in, out, count);
+	}
+	for(size_t i = done; i < count; ++i){
+		Vect3f p(points.x[i], points.y[i], points.z[i]);
+		X.xformPoint(p);
+		result.x[i] = p.x;
+		result.y[i] = p.y;
+		result.z[i] = p.z;
+	}
+}
+
+void xformPoints(const MatXf& X, const Vect4f* points, Vect4f* result, size_t count)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels())
+		done = k->xformPoints4(&X.R.xx, (const float*)points, (float*)result, count);
+	for(size_t i = done; i < count; ++i){
+		Vect4f p = points[i];
+		Vect3f v(p.x, p.y, p.z);
+		X.R.xform(v);
+		result[i].set(v.x + X.d.x * p.w, v.y + X.d.y * p.w, v.z + X.d.z * p.w, p.w);
+	}
+}
+
+void xformVects(const MatXf& X, const Vect3f* vects, Vect3f* result, size_t count)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels())
+		done = k->xformVects(&X.R.xx, (const float*)vects, (float*)result, count);
+	for(size_t i = done; i < count; ++i){
+		Vect3f v = vects[i];
+		X.xformVect(v, result[i]);
+	}
+}
+
+void xformVects(const MatXf& X, const Vect3fSoA& vects, const Vect3fSoA& result, size_t count)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels()){
+		const float* in[3] = { vects.x, vects.y, vects.z };
+		float* out[3] = { result.x, result.y, result.z };
+		done = k->xformVectsSoA(&X.R.xx, in, out, count);
+	}
+	for(size_t i = done; i < count; ++i){
+		Vect3f v(vects.x[i], vects.y[i], vects.z[i]);
+		X.xformVect(v);
+		result.x[i] = v.x;
+		result.y[i] = v.y;
+		result.z[i] = v.z;
+	}
+}
+
+void multMatrices(const MatXf* M, const MatXf* N, MatXf* result, size_t count)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels())
+		done = k->multMatrices((const float*)M, 12, (const float*)N, (float*)result, count);
+	for(size_t i = done; i < count; ++i){
+		MatXf product;
+		product.mult(M[i], N[i]);
+		result[i] = product;
+	}
+}
+
+void multMatrices(const MatXf& M, const MatXf* N, MatXf* result, size_t count)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels())
+		done = k->multMatrices(&M.R.xx, 0, (const float*)N, (float*)result, count);
+	for(size_t i = done; i < count; ++i){
+		MatXf product;
+		product.mult(M, N[i]);
+		result[i] = product;
+	}
+}
+
+void rotateVects(const QuatF& q, const Vect3f* vects, Vect3f* result, size_t count)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels())
+		done = k->rotateVects(&q.s_, (const float*)vects, (float*)result, count);
+	for(size_t i = done; i < count; ++i){
+		Vect3f v = vects[i];
+		q.xform(v, result[i]);
+	}
+}
+
+void rotateVects(const QuatF& q, const Vect3fSoA& vects, const Vect3fSoA& result, size_t count)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels()){
+		const float* in[3] = { vects.x, vects.y, vects.z };
+		float* out[3] = { result.x, result.y, result.z };
+		done = k->rotateVectsSoA(&q.s_, in, out, count);
+	}
+	for(size_t i = done; i < count; ++i){
+		Vect3f v(vects.x[i], vects.y[i], vects.z[i]);
+		q.xform(v);
+		result.x[i] = v.x;
+		result.y[i] = v.y;
+		result.z[i] = v.z;
+	}
+}
+
+void normalizeVects(Vect3f* vects, size_t count, float r)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels())
+		done = k->normalizeVects((float*)vects, count, r);
+	for(size_t i = done; i < count; ++i){
+		Vect3f& v = vects[i];
+		float s = r * (1.f / sqrtf(v.x * v.x + v.y * v.y + v.z * v.z));
+		v.x *= s;
+		v.y *= s;
+		v.z *= s;
+	}
+}
+
+void normalizeVects(const Vect3fSoA& vects, size_t count, float r)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels()){
+		float* coords[3] = { vects.x, vects.y, vects.z };
+		done = k->normalizeVectsSoA(coords, count, r);
+	}
+	for(size_t i = done; i < count; ++i){
+		float x = vects.x[i], y = vects.y[i], z = vects.z[i];
+		float s = r * (1.f / sqrtf(x * x + y * y + z * z));
+		vects.x[i] = x * s;
+		vects.y[i] = y * s;
+		vects.z[i] = z * s;
+	}
+}
+
+
+#define XMATH_BATCH_APPROXIMATION(name) \
+void name(const float* x, float* result, size_t count) \
+{ \
+	size_t done = 0; \
+	if(const BatchKernels* k = kernels()) \
+		done = k->name(x, result, count); \
+	for(size_t i = done; i < count; ++i) \
+		result[i] = name(x[i]); \
+}
+
+XMATH_BATCH_APPROXIMATION(invSqrtApprox)
+XMATH_BATCH_APPROXIMATION(rcpApprox)
+XMATH_BATCH_APPROXIMATION(sinApprox)
+XMATH_BATCH_APPROXIMATION(cosApprox)
+XMATH_BATCH_APPROXIMATION(acosApprox)
+XMATH_BATCH_APPROXIMATION(expApprox)
+XMATH_BATCH_APPROXIMATION(logApprox)
+
+#undef XMATH_BATCH_APPROXIMATION
+
+void atan2Approx(const float* y, const float* x, float* result, size_t count)
+{
+	size_t done = 0;
+	if(const BatchKernels* k = kernels())
+		done = k->atan2Approx(y, x, result, count);
+	for(size_t i = done; i < count; ++i)
+		result[i] = atan2Approx(y[i], x[i]);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stddef.h>
+
+class Vect3f;
+class Vect4f;
+class MatXf;
+class QuatF;
+
+// Batch versions of xform/mult/normalize for arrays of vectors and matrices.
+// Results are the same as of the methods of single objects, products are
+// summed in the same order. Work is done with SSE or AVX when the
+// processor has them, see batchInstructionSet. Result may be the same array
+// as the source one, but arrays must not overlap otherwise.
+
+// Vectors as three separate arrays of coordinates, n-th vector is
+// (x[n], y[n], z[n]).
+struct Vect3fSoA
+{
+	float* x;
+	float* y;
+	float* z;
+
+	Vect3fSoA() : x(0), y(0), z(0) {}
+	Vect3fSoA(float* x_, float* y_, float* z_) : x(x_), y(y_), z(z_) {}
+};
+
+void xformPoints(const MatXf& X, const Vect3f* points, Vect3f* result, size_t count); // X * (p 1)
+void xformPoints(const MatXf& X, const Vect3fSoA& points, const Vect3fSoA& result, size_t count);
+void xformPoints(const MatXf& X, const Vect4f* points, Vect4f* result, size_t count); // X * p, w is kept
+void xformVects(const MatXf& X, const Vect3f* vects, Vect3f* result, size_t count);   // X.R * v
+void xformVects(const MatXf& X, const Vect3fSoA& vects, const Vect3fSoA& result, size_t count);
+
+void multMatrices(const MatXf* M, const MatXf* N, MatXf* result, size_t count); // M[i] * N[i]
+void multMatrices(const MatXf& M, const MatXf* N, MatXf* result, size_t count); // M * N[i]
+
+void rotateVects(const QuatF& q, const Vect3f* vects, Vect3f* result, size_t count);
+void rotateVects(const QuatF& q, const Vect3fSoA& vects, const Vect3fSoA& result, size_t count);
+
+// Sets length of each vector to r, as Vect3f::normalize does with 1/sqrtf
+// instead of invSqrtFast of MSVC builds. Zero vectors become NaN.
+void normalizeVects(Vect3f* vects, size_t count, float r = 1.f);
+void normalizeVects(const Vect3fSoA& vects, size_t count, float r = 1.f);
+
+// Approximations of fastMath.h for arrays, result[i] is the same as the
+// scalar function returns for x[i]. Result may be the source array.
+void invSqrtApprox(const float* x, float* result, size_t count);
+void rcpApprox(const float* x, float* result, size_t count);
+void sinApprox(const float* x, float* result, size_t count);
+void cosApprox(const float* x, float* result, size_t count);
+void acosApprox(const float* x, float* result, size_t count);
+void expApprox(const float* x, float* result, size_t count);
+void logApprox(const float* x, float* result, size_t count);
+void atan2Approx(const float* y, const float* x, float* result, size_t count);
+
+enum BatchInstructionSet
+{
+	BATCH_SCALAR,
+	BATCH_SSE,
+	BATCH_AVX
+};
+
+// Best instruction set supported by processor and build is chosen on the first call.
+BatchInstructionSet batchInstructionSet();
+// Lower sets may be chosen to compare them, higher than supported are not
+// chosen. Returns chosen set.
+BatchInstructionSet setBatchInstructionSet(BatchInstructionSet set);
@@ -0,0 +1,86 @@
+#include "stdafx.h"
+#include "XMathBatchKernels.h"
+
+// Only this file is compiled with AVX (-mavx, /arch:AVX). It must not include
+// xmath.h or STL: their inline functions compiled with AVX could be chosen by
+// the linker for the rest of the library and break it on older processors.
+#if defined(__AVX__) || (defined(_MSC_VER) && _MSC_VER >= 1600 && (defined(_M_IX86) || defined(_M_X64)))
+#include <immintrin.h>
+
+namespace {
+
+struct BatchAVX
+{
+	typedef __m256 R;
+	enum { GROUPS = 2 };
+
+	static R load(const float* p, size_t stride)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + stride), 1);
+	}
+	static void store(float* p, size_t stride, R v)
+	{
+		_mm_storeu_ps(p, _mm256_castps256_ps128(v));
+		_mm_storeu_ps(p + stride, _mm256_extractf128_ps(v, 1));
+	}
+	static R loadWide(const float* p) { return _mm256_loadu_ps(p); }
+	static void storeWide(float* p, R v) { _mm256_storeu_ps(p, v); }
+	static R set1(float x) { return _mm256_set1_ps(x); }
+	static R set(float x, float y, float z, float w) { return _mm256_setr_ps(x, y, z, w, x, y, z, w); }
+	static R add(R a, R b) { return _mm256_add_ps(a, b); }
+	static R sub(R a, R b) { return _mm256_sub_ps(a, b); }
+	static R mul(R a, R b) { return _mm256_mul_ps(a, b); }
+	static R div(R a, R b) { return _mm256_div_ps(a, b); }
+	static R sqrt(R a) { return _mm256_sqrt_ps(a); }
+	static R unpacklo(R a, R b) { return _mm256_unpacklo_ps(a, b); }
+	static R unpackhi(R a, R b) { return _mm256_unpackhi_ps(a, b); }
+	template<int imm>
+	static R shuffle(R a, R b) { return _mm256_shuffle_ps(a, b, imm); }
+
+	// for FastMathKernels, AVX has no 256-bit integer operations, they are done by halves
+	typedef __m256 M;
+	static R signMask() { return _mm256_set1_ps(-0.f); }
+	static R min(R a, R b) { return _mm256_min_ps(a, b); }
+	static R max(R a, R b) { return _mm256_max_ps(a, b); }
+	static R neg(R a) { return _mm256_xor_ps(a, signMask()); }
+	static R abs(R a) { return _mm256_andnot_ps(signMask(), a); }
+	static R copySign(R a, R s) { return _mm256_or_ps(_mm256_andnot_ps(signMask(), a), _mm256_and_ps(signMask(), s)); }
+	static M less(R a, R b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static M equal(R a, R b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	// not blendv, GCC turns it into comparison of 256-bit integers that AVX does not have
+	static R select(M m, R a, R b) { return _mm256_or_ps(_mm256_and_ps(m, a), _mm256_andnot_ps(m, b)); }
+	static R round(R a) { return _mm256_cvtepi32_ps(_mm256_cvtps_epi32(a)); }
+	static R rsqrtEstimate(R a) { return _mm256_rsqrt_ps(a); }
+	static R rcpEstimate(R a) { return _mm256_rcp_ps(a); }
+	static R pow2(R n)
+	{
+		__m256i i = _mm256_cvtps_epi32(_mm256_add_ps(n, _mm256_set1_ps(127.f)));
+		__m128i lo = _mm_slli_epi32(_mm256_castsi256_si128(i), 23);
+		__m128i hi = _mm_slli_epi32(_mm256_extractf128_si256(i, 1), 23);
+		return _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+	}
+	static R exponent(R x, R& m)
+	{
+		m = _mm256_or_ps(_mm256_and_ps(x, _mm256_castsi256_ps(_mm256_set1_epi32(0x807fffff))), _mm256_set1_ps(0.5f));
+		__m128i lo = _mm_srli_epi32(_mm_castps_si128(_mm256_castps256_ps128(x)), 23);
+		__m128i hi = _mm_srli_epi32(_mm_castps_si128(_mm256_extractf128_ps(x, 1)), 23);
+		__m256i e = _mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1);
+		return _mm256_sub_ps(_mm256_cvtepi32_ps(e), _mm256_set1_ps(126.f));
+	}
+};
+
+}
+
+const BatchKernels* batchKernelsAVX()
+{
+	return &BatchKernelsImpl<BatchAVX>::table;
+}
+
+#else
+
+const BatchKernels* batchKernelsAVX()
+{
+	return 0;
+}
+
+#endif
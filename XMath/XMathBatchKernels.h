@@ -0,0 +1,397 @@
+#pragma once
+
+#include <stddef.h>
+#include "fastMathKernels.h"
+
+// Kernels of XMathBatch.h, written once for register traits V of SSE and AVX:
+//   R                   register type
+//   GROUPS              number of 4-float groups in a register (1 or 2)
+//   load(p, stride)     4 floats at p into each group, next group from p + stride
+//   loadWide(p)         4*GROUPS successive floats
+//   set(x, y, z, w)     same 4 floats in each group
+//   shuffle<imm>(a, b)  _mm_shuffle_ps within each group
+// Kernels process whole registers only and return the number of processed
+// elements, the rest is done by scalar methods. Arrays have no alignment
+// requirements. Included only by XMathBatch*.cpp, each of them is compiled
+// with its own instruction set, so the header does not include xmath.h.
+
+// Element i of result comes from a[i0], a[i1], b[i2], b[i3].
+#define BATCH_SHUFFLE(i0, i1, i2, i3) (((i3) << 6) | ((i2) << 4) | ((i1) << 2) | (i0))
+
+// Same table is filled by every instruction set; X is MatXf as 12 floats
+// (rows of R, then d), q is QuatF as s, x, y, z. stepM of multMatrices is 12,
+// or 0 to multiply every N by the same M.
+struct BatchKernels
+{
+	size_t (*xformPoints)(const float* X, const float* points, float* result, size_t count);
+	size_t (*xformVects)(const float* X, const float* vects, float* result, size_t count);
+	size_t (*xformPoints4)(const float* X, const float* points, float* result, size_t count);
+	size_t (*xformPointsSoA)(const float* X, const float* const* points, float* const* result, size_t count);
+	size_t (*xformVectsSoA)(const float* X, const float* const* vects, float* const* result, size_t count);
+	size_t (*multMatrices)(const float* M, size_t stepM, const float* N, float* result, size_t count);
+	size_t (*rotateVects)(const float* q, const float* vects, float* result, size_t count);
+	size_t (*rotateVectsSoA)(const float* q, const float* const* vects, float* const* result, size_t count);
+	size_t (*normalizeVects)(float* vects, size_t count, float r);
+	size_t (*normalizeVectsSoA)(float* const* vects, size_t count, float r);
+	size_t (*invSqrtApprox)(const float* x, float* result, size_t count);
+	size_t (*rcpApprox)(const float* x, float* result, size_t count);
+	size_t (*sinApprox)(const float* x, float* result, size_t count);
+	size_t (*cosApprox)(const float* x, float* result, size_t count);
+	size_t (*acosApprox)(const float* x, float* result, size_t count);
+	size_t (*expApprox)(const float* x, float* result, size_t count);
+	size_t (*logApprox)(const float* x, float* result, size_t count);
+	size_t (*atan2Approx)(const float* y, const float* x, float* result, size_t count);
+};
+
+template<class V>
+struct BatchKernelsImpl
+{
+	typedef typename V::R R;
+
+	static R add(R a, R b) { return V::add(a, b); }
+	static R sub(R a, R b) { return V::sub(a, b); }
+	static R mul(R a, R b) { return V::mul(a, b); }
+	template<int i0, int i1, int i2, int i3>
+	static R shuffle(R a, R b) { return V::template shuffle<BATCH_SHUFFLE(i0, i1, i2, i3)>(a, b); }
+	template<int i>
+	static R splat(R a) { return shuffle<i, i, i, i>(a, a); }
+
+	// 4 Vect3f of every group: [x0 y0 z0 x1] [y1 z1 x2 y2] [z2 x3 y3 z3]
+	static void loadVect3(const float* p, R& x, R& y, R& z)
+	{
+		R a = V::load(p, 12);
+		R b = V::load(p + 4, 12);
+		R c = V::load(p + 8, 12);
+		R xy = shuffle<2, 3, 1, 2>(b, c);
+		R yz = shuffle<1, 2, 0, 1>(a, b);
+		x = shuffle<0, 3, 0, 2>(a, xy);
+		y = shuffle<0, 2, 1, 3>(yz, xy);
+		z = shuffle<1, 3, 0, 3>(yz, c);
+	}
+
+	static void storeVect3(float* p, R x, R y, R z)
+	{
+		R xy = shuffle<0, 2, 0, 2>(x, y);
+		R yz = shuffle<1, 3, 1, 3>(y, z);
+		R zx = shuffle<0, 2, 1, 3>(z, x);
+		V::store(p, 12, shuffle<0, 2, 0, 2>(xy, zx));
+		V::store(p + 4, 12, shuffle<0, 2, 1, 3>(yz, xy));
+		V::store(p + 8, 12, shuffle<1, 3, 1, 3>(zx, yz));
+	}
+
+	// 4 Vect4f of every group, transposed
+	static void loadVect4(const float* p, R& x, R& y, R& z, R& w)
+	{
+		R r0 = V::load(p, 16);
+		R r1 = V::load(p + 4, 16);
+		R r2 = V::load(p + 8, 16);
+		R r3 = V::load(p + 12, 16);
+		R t0 = V::unpacklo(r0, r1);
+		R t1 = V::unpacklo(r2, r3);
+		R t2 = V::unpackhi(r0, r1);
+		R t3 = V::unpackhi(r2, r3);
+		x = shuffle<0, 1, 0, 1>(t0, t1);
+		y = shuffle<2, 3, 2, 3>(t0, t1);
+		z = shuffle<0, 1, 0, 1>(t2, t3);
+		w = shuffle<2, 3, 2, 3>(t2, t3);
+	}
+
+	static void storeVect4(float* p, R x, R y, R z, R w)
+	{
+		R t0 = V::unpacklo(x, y);
+		R t1 = V::unpacklo(z, w);
+		R t2 = V::unpackhi(x, y);
+		R t3 = V::unpackhi(z, w);
+		V::store(p, 16, shuffle<0, 1, 0, 1>(t0, t1));
+		V::store(p + 4, 16, shuffle<2, 3, 2, 3>(t0, t1));
+		V::store(p + 8, 16, shuffle<0, 1, 0, 1>(t2, t3));
+		V::store(p + 12, 16, shuffle<2, 3, 2, 3>(t2, t3));
+	}
+
+	// One MatXf per group as rows of its affine 4x4 form: [R.xx R.xy R.xz d.x] ...,
+	// stride is 0 when every group takes the same matrix
+	static void loadAffineRows(const float* p, size_t stride, R& r0, R& r1, R& r2)
+	{
+		R a = V::load(p, stride);     // xx xy xz yx
+		R b = V::load(p + 4, stride); // yy yz zx zy
+		R c = V::load(p + 8, stride); // zz dx dy dz
+		r0 = shuffle<0, 1, 0, 2>(a, shuffle<2, 2, 1, 1>(a, c));
+		r1 = shuffle<0, 2, 0, 2>(shuffle<3, 3, 0, 0>(a, b), shuffle<1, 1, 2, 2>(b, c));
+		r2 = shuffle<2, 3, 0, 3>(b, c);
+	}
+
+	static void storeAffineRows(float* p, R r0, R r1, R r2)
+	{
+		V::store(p, 12, shuffle<0, 1, 0, 2>(r0, shuffle<2, 2, 0, 0>(r0, r1)));
+		V::store(p + 4, 12, shuffle<1, 2, 0, 1>(r1, r2));
+		V::store(p + 8, 12, shuffle<0, 2, 0, 2>(shuffle<2, 2, 3, 3>(r2, r0), shuffle<3, 3, 3, 3>(r1, r2)));
+	}
+
+	// Same order of operations as in Mat3f::xform and MatXf::xformPoint
+	struct Transform
+	{
+		R xx, xy, xz, yx, yy, yz, zx, zy, zz, dx, dy, dz;
+
+		explicit Transform(const float* X)
+		: xx(V::set1(X[0])), xy(V::set1(X[1])), xz(V::set1(X[2]))
+		, yx(V::set1(X[3])), yy(V::set1(X[4])), yz(V::set1(X[5]))
+		, zx(V::set1(X[6])), zy(V::set1(X[7])), zz(V::set1(X[8]))
+		, dx(V::set1(X[9])), dy(V::set1(X[10])), dz(V::set1(X[11]))
+		{}
+
+		void vect(R& x, R& y, R& z) const
+		{
+			R rx = add(add(mul(xx, x), mul(xy, y)), mul(xz, z));
+			R ry = add(add(mul(yx, x), mul(yy, y)), mul(yz, z));
+			R rz = add(add(mul(zx, x), mul(zy, y)), mul(zz, z));
+			x = rx;
+			y = ry;
+			z = rz;
+		}
+
+		void point(R& x, R& y, R& z) const
+		{
+			vect(x, y, z);
+			x = add(x, dx);
+			y = add(y, dy);
+			z = add(z, dz);
+		}
+	};
+
+	static size_t xformPoints(const float* X, const float* points, float* result, size_t count)
+	{
+		Transform transform(X);
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step){
+			R x, y, z;
+			loadVect3(points + i * 3, x, y, z);
+			transform.point(x, y, z);
+			storeVect3(result + i * 3, x, y, z);
+		}
+		return n;
+	}
+
+	static size_t xformVects(const float* X, const float* vects, float* result, size_t count)
+	{
+		Transform transform(X);
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step){
+			R x, y, z;
+			loadVect3(vects + i * 3, x, y, z);
+			transform.vect(x, y, z);
+			storeVect3(result + i * 3, x, y, z);
+		}
+		return n;
+	}
+
+	// R * (x y z) + d * w, w is kept
+	static size_t xformPoints4(const float* X, const float* points, float* result, size_t count)
+	{
+		Transform transform(X);
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step){
+			R x, y, z, w;
+			loadVect4(points + i * 4, x, y, z, w);
+			transform.vect(x, y, z);
+			x = add(x, mul(transform.dx, w));
+			y = add(y, mul(transform.dy, w));
+			z = add(z, mul(transform.dz, w));
+			storeVect4(result + i * 4, x, y, z, w);
+		}
+		return n;
+	}
+
+	static size_t xformPointsSoA(const float* X, const float* const* points, float* const* result, size_t count)
+	{
+		Transform transform(X);
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step){
+			R x = V::loadWide(points[0] + i);
+			R y = V::loadWide(points[1] + i);
+			R z = V::loadWide(points[2] + i);
+			transform.point(x, y, z);
+			V::storeWide(result[0] + i, x);
+			V::storeWide(result[1] + i, y);
+			V::storeWide(result[2] + i, z);
+		}
+		return n;
+	}
+
+	static size_t xformVectsSoA(const float* X, const float* const* vects, float* const* result, size_t count)
+	{
+		Transform transform(X);
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step){
+			R x = V::loadWide(vects[0] + i);
+			R y = V::loadWide(vects[1] + i);
+			R z = V::loadWide(vects[2] + i);
+			transform.vect(x, y, z);
+			V::storeWide(result[0] + i, x);
+			V::storeWide(result[1] + i, y);
+			V::storeWide(result[2] + i, z);
+		}
+		return n;
+	}
+
+	// Row k of M * N is M.k.x * N.row0 + M.k.y * N.row1 + M.k.z * N.row2 + M.d.k * (0 0 0 1)
+	// in affine form, that gives the same sums as MatXf::mult.
+	static size_t multMatrices(const float* M, size_t stepM, const float* N, float* result, size_t count)
+	{
+		R e3 = V::set(0.f, 0.f, 0.f, 1.f);
+		size_t n = count - count % V::GROUPS;
+		for(size_t i = 0; i < n; i += V::GROUPS){
+			R m0, m1, m2, n0, n1, n2;
+			loadAffineRows(M + i * stepM, stepM, m0, m1, m2);
+			loadAffineRows(N + i * 12, 12, n0, n1, n2);
+			R r0 = add(add(add(mul(splat<0>(m0), n0), mul(splat<1>(m0), n1)), mul(splat<2>(m0), n2)), mul(splat<3>(m0), e3));
+			R r1 = add(add(add(mul(splat<0>(m1), n0), mul(splat<1>(m1), n1)), mul(splat<2>(m1), n2)), mul(splat<3>(m1), e3));
+			R r2 = add(add(add(mul(splat<0>(m2), n0), mul(splat<1>(m2), n1)), mul(splat<2>(m2), n2)), mul(splat<3>(m2), e3));
+			storeAffineRows(result + i * 12, r0, r1, r2);
+		}
+		return n;
+	}
+
+	// Same order of operations as in QuatF::xform
+	struct Rotation
+	{
+		R ux, uy, uz, s2, two;
+
+		explicit Rotation(const float* q)
+		: ux(V::set1(q[1])), uy(V::set1(q[2])), uz(V::set1(q[3]))
+		, s2(V::set1(2.f * q[0])), two(V::set1(2.f))
+		{}
+
+		void apply(R& x, R& y, R& z) const
+		{
+			R uvx = sub(mul(uy, z), mul(uz, y));
+			R uvy = sub(mul(uz, x), mul(ux, z));
+			R uvz = sub(mul(ux, y), mul(uy, x));
+			R uuvx = sub(mul(uy, uvz), mul(uz, uvy));
+			R uuvy = sub(mul(uz, uvx), mul(ux, uvz));
+			R uuvz = sub(mul(ux, uvy), mul(uy, uvx));
+			x = add(add(x, mul(uvx, s2)), mul(uuvx, two));
+			y = add(add(y, mul(uvy, s2)), mul(uuvy, two));
+			z = add(add(z, mul(uvz, s2)), mul(uuvz, two));
+		}
+	};
+
+	static size_t rotateVects(const float* q, const float* vects, float* result, size_t count)
+	{
+		Rotation rotation(q);
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step){
+			R x, y, z;
+			loadVect3(vects + i * 3, x, y, z);
+			rotation.apply(x, y, z);
+			storeVect3(result + i * 3, x, y, z);
+		}
+		return n;
+	}
+
+	static size_t rotateVectsSoA(const float* q, const float* const* vects, float* const* result, size_t count)
+	{
+		Rotation rotation(q);
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step){
+			R x = V::loadWide(vects[0] + i);
+			R y = V::loadWide(vects[1] + i);
+			R z = V::loadWide(vects[2] + i);
+			rotation.apply(x, y, z);
+			V::storeWide(result[0] + i, x);
+			V::storeWide(result[1] + i, y);
+			V::storeWide(result[2] + i, z);
+		}
+		return n;
+	}
+
+	// r / sqrt(x*x + y*y + z*z) as in Vect3f::normalize with exact invSqrtFast
+	static R normalizeScale(R x, R y, R z, R r)
+	{
+		R length2 = add(add(mul(x, x), mul(y, y)), mul(z, z));
+		return mul(r, V::div(V::set1(1.f), V::sqrt(length2)));
+	}
+
+	static size_t normalizeVects(float* vects, size_t count, float radius)
+	{
+		R r = V::set1(radius);
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step){
+			R x, y, z;
+			loadVect3(vects + i * 3, x, y, z);
+			R s = normalizeScale(x, y, z, r);
+			storeVect3(vects + i * 3, mul(x, s), mul(y, s), mul(z, s));
+		}
+		return n;
+	}
+
+	static size_t normalizeVectsSoA(float* const* vects, size_t count, float radius)
+	{
+		R r = V::set1(radius);
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step){
+			R x = V::loadWide(vects[0] + i);
+			R y = V::loadWide(vects[1] + i);
+			R z = V::loadWide(vects[2] + i);
+			R s = normalizeScale(x, y, z, r);
+			V::storeWide(vects[0] + i, mul(x, s));
+			V::storeWide(vects[1] + i, mul(y, s));
+			V::storeWide(vects[2] + i, mul(z, s));
+		}
+		return n;
+	}
+
+	template<R (*function)(R)>
+	static size_t approximate(const float* x, float* result, size_t count)
+	{
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step)
+			V::storeWide(result + i, function(V::loadWide(x + i)));
+		return n;
+	}
+
+	static size_t atan2Approx(const float* y, const float* x, float* result, size_t count)
+	{
+		size_t step = 4 * V::GROUPS;
+		size_t n = count - count % step;
+		for(size_t i = 0; i < n; i += step)
+			V::storeWide(result + i, FastMathKernels<V>::atan2(V::loadWide(y + i), V::loadWide(x + i)));
+		return n;
+	}
+
+	static const BatchKernels table;
+};
+
+template<class V>
+const BatchKernels BatchKernelsImpl<V>::table = {
+	&BatchKernelsImpl<V>::xformPoints,
+	&BatchKernelsImpl<V>::xformVects,
+	&BatchKernelsImpl<V>::xformPoints4,
+	&BatchKernelsImpl<V>::xformPointsSoA,
+	&BatchKernelsImpl<V>::xformVectsSoA,
+	&BatchKernelsImpl<V>::multMatrices,
+	&BatchKernelsImpl<V>::rotateVects,
+	&BatchKernelsImpl<V>::rotateVectsSoA,
+	&BatchKernelsImpl<V>::normalizeVects,
+	&BatchKernelsImpl<V>::normalizeVectsSoA,
+	&BatchKernelsImpl<V>::template approximate<&FastMathKernels<V>::invSqrt>,
+	&BatchKernelsImpl<V>::template approximate<&FastMathKernels<V>::rcp>,
+	&BatchKernelsImpl<V>::template approximate<&FastMathKernels<V>::sin>,
+	&BatchKernelsImpl<V>::template approximate<&FastMathKernels<V>::cos>,
+	&BatchKernelsImpl<V>::template approximate<&FastMathKernels<V>::acos>,
+	&BatchKernelsImpl<V>::template approximate<&FastMathKernels<V>::exp>,
+	&BatchKernelsImpl<V>::template approximate<&FastMathKernels<V>::log>,
+	&BatchKernelsImpl<V>::atan2Approx
+};
+
+// Defined in XMathBatchAVX.cpp, 0 when the build has no AVX kernels.
+const BatchKernels* batchKernelsAVX();
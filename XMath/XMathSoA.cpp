@@ -0,0 +1,153 @@
+#include "stdafx.h"
+#include <algorithm>
+#include "XMathSoA.h"
+#include "yasli/Archive.h"
+#include "yasli/STL.h"
+
+namespace {
+
+// Component in binary archives: size and unnamed floats, which BinOArchive
+// copies at once (see ContainerInterface::arrayData). Named elements would
+// be written with a tag each.
+struct ComponentBlock
+{
+	std::vector<float>& values;
+
+	explicit ComponentBlock(std::vector<float>& values_) : values(values_) {}
+	void serialize(yasli::Archive& ar) { ar(values, ""); }
+};
+
+}
+
+static void serializeComponents(yasli::Archive& ar, std::vector<float>* const* components, const char* const* names, int count)
+{
+	for(int i = 0; i < count; ++i){
+		if(ar.caps(yasli::Archive::BINARY)){
+			ComponentBlock block(*components[i]);
+			ar(block, names[i]);
+		}
+		else
+			ar(*components[i], names[i]);
+	}
+
+	if(ar.isInput()){
+		// components of edited or damaged data may differ in size
+		size_t size = 0;
+		for(int i = 0; i < count; ++i)
+			size = std::max(size, components[i]->size());
+		for(int i = 0; i < count; ++i)
+			components[i]->resize(size);
+	}
+}
+
+// ---------------------------------------------------------------------------
+
+void SoAVect3f::resize(size_t size, const Vect3f& value)
+{
+	x_.resize(size, value.x);
+	y_.resize(size, value.y);
+	z_.resize(size, value.z);
+}
+
+void SoAVect3f::reserve(size_t capacity)
+{
+	x_.reserve(capacity);
+	y_.reserve(capacity);
+	z_.reserve(capacity);
+}
+
+void SoAVect3f::clear()
+{
+	x_.clear();
+	y_.clear();
+	z_.clear();
+}
+
+void SoAVect3f::push_back(const Vect3f& v)
+{
+	x_.push_back(v.x);
+	y_.push_back(v.y);
+	z_.push_back(v.z);
+}
+
+void SoAVect3f::serialize(yasli::Archive& ar)
+{
+	static const char* names[] = { "x", "y", "z" };
+	std::vector<float>* components[] = { &x_, &y_, &z_ };
+	serializeComponents(ar, components, names, 3);
+}
+
+// ---------------------------------------------------------------------------
+
+SoAMatXf::Reference::operator MatXf() const
+{
+	MatXf m;
+	float* p = &m.R.xx;
+	for(int c = 0; c < COMPONENTS; ++c)
+		p[c] = array_.components_[c][index_];
+	return m;
+}
+
+SoAMatXf::Reference& SoAMatXf::Reference::operator=(const MatXf& m)
+{
+	const float* p = &m.R.xx;
+	for(int c = 0; c < COMPONENTS; ++c)
+		array_.components_[c][index_] = p[c];
+	return *this;
+}
+
+MatXf SoAMatXf::operator[](size_t i) const
+{
+	MatXf m;
+	float* p = &m.R.xx;
+	for(int c = 0; c < COMPONENTS; ++c)
+		p[c] = components_[c][i];
+	return m;
+}
+
+void SoAMatXf::resize(size_t size, const MatXf& value)
+{
+	const float* p = &value.R.xx;
+	for(int c = 0; c < COMPONENTS; ++c)
+		components_[c].resize(size, p[c]);
+}
+
+void SoAMatXf::reserve(size_t capacity)
+{
+	for(int c = 0; c < COMPONENTS; ++c)
+		components_[c].reserve(capacity);
+}
+
+void SoAMatXf::clear()
+{
+	for(int c = 0; c < COMPONENTS; ++c)
+		components_[c].clear();
+}
+
+void SoAMatXf::push_back(const MatXf& m)
+{
+	const float* p = &m.R.xx;
+	for(int c = 0; c < COMPONENTS; ++c)
+		components_[c].push_back(p[c]);
+}
+
+void SoAMatXf::serialize(yasli::Archive& ar)
+{
+	static const char* names[COMPONENTS] = { "xx", "xy", "xz", "yx", "yy", "yz", "zx", "zy", "zz", "dx", "dy", "dz" };
+	std::vector<float>* components[COMPONENTS];
+	for(int c = 0; c < COMPONENTS; ++c)
+		components[c] = &components_[c];
+	serializeComponents(ar, components, names, COMPONENTS);
+}
+
+// Columns of M.R * N.R are M.R * columns of N.R, d is M * N.d: sums are the
+// same as in MatXf::mult.
+void multMatrices(const MatXf& M, const SoAMatXf& N, SoAMatXf& result)
+{
+	SoAMatXf& source = const_cast<SoAMatXf&>(N);
+	size_t count = N.size();
+	result.resize(count);
+	for(int axis = 0; axis < 3; ++axis)
+		xformVects(M, source.column(axis), result.column(axis), count);
+	xformPoints(M, source.translation(), result.translation(), count);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include "xmath.h"
+#include "XMathBatch.h"
+
+namespace yasli { class Archive; }
+
+// Arrays of vectors and matrices kept as separate arrays of their components,
+// so functions of XMathBatch.h work on them without gathering:
+//
+// SoAVect3f points(count);
+// points[i] = Vect3f(1, 2, 3);
+// xformPoints(X, points.view(), points.view(), points.size());
+// Vect3f p = points[i];
+//
+// Binary archives write every component as one block of floats, text
+// archives as an array of numbers.
+
+class SoAVect3f
+{
+public:
+	// element proxy
+	class Reference
+	{
+	public:
+		float& x;
+		float& y;
+		float& z;
+
+		operator Vect3f() const { return Vect3f(x, y, z); }
+		Reference& operator=(const Vect3f& v) { x = v.x; y = v.y; z = v.z; return *this; }
+		Reference& operator=(const Reference& r) { return *this = Vect3f(r); }
+
+	private:
+		friend class SoAVect3f;
+		Reference(float& x_, float& y_, float& z_) : x(x_), y(y_), z(z_) {}
+	};
+
+	SoAVect3f() {}
+	explicit SoAVect3f(size_t size, const Vect3f& value = Vect3f::ZERO) { resize(size, value); }
+
+	size_t size() const { return x_.size(); }
+	bool empty() const { return x_.empty(); }
+	void resize(size_t size, const Vect3f& value = Vect3f::ZERO);
+	void reserve(size_t capacity);
+	void clear();
+	void push_back(const Vect3f& v);
+
+	Reference operator[](size_t i) { return Reference(x_[i], y_[i], z_[i]); }
+	Vect3f operator[](size_t i) const { return Vect3f(x_[i], y_[i], z_[i]); }
+
+	float* x() { return x_.data(); }
+	float* y() { return y_.data(); }
+	float* z() { return z_.data(); }
+	const float* x() const { return x_.data(); }
+	const float* y() const { return y_.data(); }
+	const float* z() const { return z_.data(); }
+
+	// valid until size is changed
+	Vect3fSoA view() { return Vect3fSoA(x(), y(), z()); }
+
+	void serialize(yasli::Archive& ar);
+
+private:
+	std::vector<float> x_;
+	std::vector<float> y_;
+	std::vector<float> z_;
+};
+
+// Components are stored in order of MatXf: rows of R, then d.
+class SoAMatXf
+{
+public:
+	enum Component { XX, XY, XZ, YX, YY, YZ, ZX, ZY, ZZ, DX, DY, DZ, COMPONENTS };
+
+	// element proxy
+	class Reference
+	{
+	public:
+		operator MatXf() const;
+		Reference& operator=(const MatXf& m);
+		Reference& operator=(const Reference& r) { return *this = MatXf(r); }
+
+	private:
+		friend class SoAMatXf;
+		Reference(SoAMatXf& array, size_t index) : array_(array), index_(index) {}
+
+		SoAMatXf& array_;
+		size_t index_;
+	};
+
+	SoAMatXf() {}
+	explicit SoAMatXf(size_t size, const MatXf& value = MatXf::ID) { resize(size, value); }
+
+	size_t size() const { return components_[0].size(); }
+	bool empty() const { return components_[0].empty(); }
+	void resize(size_t size, const MatXf& value = MatXf::ID);
+	void reserve(size_t capacity);
+	void clear();
+	void push_back(const MatXf& m);
+
+	Reference operator[](size_t i) { return Reference(*this, i); }
+	MatXf operator[](size_t i) const;
+
+	float* component(Component c) { return components_[c].data(); }
+	const float* component(Component c) const { return components_[c].data(); }
+
+	// Column of R (0 - x, 1 - y, 2 - z) and d as vectors, valid until size is changed.
+	Vect3fSoA column(int axis) { return Vect3fSoA(component(Component(XX + axis)), component(Component(YX + axis)), component(Component(ZX + axis))); }
+	Vect3fSoA translation() { return Vect3fSoA(component(DX), component(DY), component(DZ)); }
+
+	void serialize(yasli::Archive& ar);
+
+private:
+	std::vector<float> components_[COMPONENTS];
+};
+
+// result[i] = M * N[i], the same as MatXf::mult. Result may be N, it is resized
+// to the size of N.
+void multMatrices(const MatXf& M, const SoAMatXf& N, SoAMatXf& result);
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "fastMathKernels.h"
+
 #ifdef _MSC_VER
 #include <xmmintrin.h>
 
@@ -61,6 +63,29 @@ inline float fmodFast(float a, float b)
 #endif
 
 
+// Approximations, the same on every compiler. Scalar functions return the
+// same values as the batch ones of XMathBatch.h. Maximal errors against
+// double precision functions of math.h:
+//   invSqrtApprox(x)   x normal                     relative 2.5e-7
+//   rcpApprox(x)       2^-125 < |x| < 2^125         relative 2.0e-7
+//   sinApprox(x)       |x| < 8192                   absolute 9.4e-8
+//   cosApprox(x)       |x| < 8192                   absolute 9.4e-8
+//   atan2Approx(y, x)  finite, atan2(0, 0) is 0     absolute 2.7e-7
+//   acosApprox(x)      |x| <= 1                     absolute 2.9e-7
+//   expApprox(x)       0 below -87.34, inf above 88.72  relative 2.4e-7
+//   logApprox(x)       x normal                     relative 7.9e-8, absolute 4e-8 in [0.5, 2)
+// Without SSE the estimates of invSqrtApprox and rcpApprox are exact.
+// A single scalar call isn't faster than the function of math.h, speed comes
+// from the array functions of XMathBatch.h, so XMath itself doesn't use these.
+inline float invSqrtApprox(float x) { return FastMathKernels<FastMathScalar>::invSqrt(x); }
+inline float rcpApprox(float x) { return FastMathKernels<FastMathScalar>::rcp(x); }
+inline float sinApprox(float x) { return FastMathKernels<FastMathScalar>::sin(x); }
+inline float cosApprox(float x) { return FastMathKernels<FastMathScalar>::cos(x); }
+inline float atan2Approx(float y, float x) { return FastMathKernels<FastMathScalar>::atan2(y, x); }
+inline float acosApprox(float x) { return FastMathKernels<FastMathScalar>::acos(x); }
+inline float expApprox(float x) { return FastMathKernels<FastMathScalar>::exp(x); }
+inline float logApprox(float x) { return FastMathKernels<FastMathScalar>::log(x); }
+
 inline unsigned int F2DW( float f ) 
 { 
 	return *((unsigned int*)&f); 
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <string.h>
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define FAST_MATH_SSE
+#endif
+
+// Approximations of fastMath.h written once for traits V of scalar floats
+// (FastMathScalar below) and of SSE and AVX registers (XMathBatch*.cpp):
+//   R, M                       value and comparison mask
+//   add sub mul div min max    min(a, b) is a < b ? a : b, as _mm_min_ps
+//   set1 neg abs
+//   copySign(a, s)             magnitude of a with sign of s
+//   less(a, b) equal(a, b)     masks, select(m, a, b) is m ? a : b
+//   round(a)                   to nearest integer, as conversion to int
+//   rsqrtEstimate rcpEstimate  about 12 bits, as _mm_rsqrt_ps and _mm_rcp_ps
+//   pow2(n)                    2^n for integer n in [-126, 127]
+//   exponent(x, m)             e and m of x = m * 2^e, m in [0.5, 1), x positive and normal
+// Every path does the same operations in the same order, so scalar
+// functions return the same values as the batch ones on a given processor.
+template<class V>
+struct FastMathKernels
+{
+	typedef typename V::R R;
+	typedef typename V::M M;
+
+	static R c(float value) { return V::set1(value); }
+
+	// one Newton-Raphson step after the estimate: y * (1.5 - 0.5 * x * y * y)
+	static R invSqrt(R x)
+	{
+		R y = V::rsqrtEstimate(x);
+		return V::mul(y, V::sub(c(1.5f), V::mul(V::mul(c(0.5f), x), V::mul(y, y))));
+	}
+
+	// y * (2 - x * y)
+	static R rcp(R x)
+	{
+		R y = V::rcpEstimate(x);
+		return V::mul(y, V::sub(c(2.f), V::mul(x, y)));
+	}
+
+	// x = q * pi/2 + r, |r| <= pi/4; pi/2 is subtracted in three parts (Cody-Waite)
+	static R reduce(R x, R& q)
+	{
+		q = V::round(V::mul(x, c(0.636619772367581343f)));
+		R r = V::sub(x, V::mul(q, c(1.5703125f)));
+		r = V::sub(r, V::mul(q, c(4.837512969970703125e-4f)));
+		return V::sub(r, V::mul(q, c(7.54978995489188216e-8f)));
+	}
+
+	// polynomials of Cephes sinf and cosf for |r| <= pi/4
+	static R sinPolynomial(R r)
+	{
+		R z = V::mul(r, r);
+		R p = V::add(V::mul(V::add(V::mul(c(-1.9515295891e-4f), z), c(8.3321608736e-3f)), z), c(-1.6666654611e-1f));
+		return V::add(r, V::mul(V::mul(r, z), p));
+	}
+
+	static R cosPolynomial(R r)
+	{
+		R z = V::mul(r, r);
+		R p = V::add(V::mul(V::add(V::mul(c(2.443315711809948e-5f), z), c(-1.388731625493765e-3f)), z), c(4.166664568298827e-2f));
+		return V::add(V::sub(c(1.f), V::mul(c(0.5f), z)), V::mul(V::mul(z, z), p));
+	}
+
+	// Sine in quadrant q from sin and cos of the reduced argument. Bits of
+	// q are taken from fractions of q/2 and q/4, so no integer operations
+	// are needed.
+	static R sinOfQuadrant(R q, R s, R co)
+	{
+		R half = V::mul(q, c(0.5f));
+		R quarter = V::mul(q, c(0.25f));
+		M odd = V::less(c(0.25f), V::sub(half, V::round(V::sub(half, c(0.25f)))));
+		M negative = V::less(c(0.375f), V::sub(quarter, V::round(V::sub(quarter, c(0.375f)))));
+		R r = V::select(odd, co, s);
+		return V::select(negative, V::neg(r), r);
+	}
+
+	static R sin(R x)
+	{
+		R q;
+		R r = reduce(x, q);
+		return sinOfQuadrant(q, sinPolynomial(r), cosPolynomial(r));
+	}
+
+	static R cos(R x)
+	{
+		R q;
+		R r = reduce(x, q);
+		return sinOfQuadrant(V::add(q, c(1.f)), sinPolynomial(r), cosPolynomial(r));
+	}
+
+	static R atan2(R y, R x)
+	{
+		R ax = V::abs(x);
+		R ay = V::abs(y);
+		R big = V::max(ax, ay);
+		R small = V::min(ax, ay);
+		R t = V::select(V::equal(big, c(0.f)), c(0.f), V::div(small, big));
+		// above tan(pi/8) atan(t) = pi/4 + atan((t - 1) / (t + 1))
+		M reduced = V::less(c(0.414213562373095f), t);
+		R u = V::select(reduced, V::div(V::sub(t, c(1.f)), V::add(t, c(1.f))), t);
+		R z = V::mul(u, u);
+		// polynomial of Cephes atanf
+		R p = V::add(V::mul(c(8.05374449538e-2f), z), c(-1.38776856032e-1f));
+		p = V::add(V::mul(p, z), c(1.99777106478e-1f));
+		p = V::add(V::mul(p, z), c(-3.33329491539e-1f));
+		R a = V::add(V::mul(V::mul(p, z), u), u);
+		a = V::select(reduced, V::add(a, c(0.785398163397448f)), a);
+		a = V::select(V::less(ax, ay), V::sub(c(1.57079632679490f), a), a);
+		// sign bit of x, so atan2(0, -0) is pi as in atan2f
+		a = V::select(V::less(V::copySign(c(1.f), x), c(0.f)), V::sub(c(3.14159265358979f), a), a);
+		return V::copySign(a, y);
+	}
+
+	static R acos(R x)
+	{
+		return atan2(V::sqrt(V::mul(V::sub(c(1.f), x), V::add(c(1.f), x))), x);
+	}
+
+	static R exp(R x)
+	{
+		R clamped = V::min(V::max(x, c(-87.3365447f)), c(88.7228391f));
+		// x = n * ln2 + r, n is not above 127 to keep 2^n finite
+		R n = V::min(V::round(V::mul(clamped, c(1.44269504088896341f))), c(127.f));
+		R r = V::sub(clamped, V::mul(n, c(0.693359375f)));
+		r = V::sub(r, V::mul(n, c(-2.12194440e-4f)));
+		// polynomial of Cephes expf
+		R p = V::add(V::mul(c(1.9875691500e-4f), r), c(1.3981999507e-3f));
+		p = V::add(V::mul(p, r), c(8.3334519073e-3f));
+		p = V::add(V::mul(p, r), c(4.1665795894e-2f));
+		p = V::add(V::mul(p, r), c(1.6666665459e-1f));
+		p = V::add(V::mul(p, r), c(5.0000001201e-1f));
+		p = V::add(V::add(V::mul(p, V::mul(r, r)), r), c(1.f));
+		R result = V::mul(p, V::pow2(n));
+		result = V::select(V::less(x, c(-87.3365447f)), c(0.f), result);
+		result = V::select(V::less(c(88.7228391f), x), c(HUGE_VALF), result);
+		return V::select(V::equal(x, x), result, x);
+	}
+
+	static R log(R x)
+	{
+		R m;
+		R e = V::exponent(x, m);
+		// m in [sqrt(0.5), sqrt(2)) - 1
+		M small = V::less(m, c(0.707106781186547524f));
+		e = V::select(small, V::sub(e, c(1.f)), e);
+		m = V::sub(V::select(small, V::add(m, m), m), c(1.f));
+		R z = V::mul(m, m);
+		// polynomial of Cephes logf
+		R p = V::add(V::mul(c(7.0376836292e-2f), m), c(-1.1514610310e-1f));
+		p = V::add(V::mul(p, m), c(1.1676998740e-1f));
+		p = V::add(V::mul(p, m), c(-1.2420140846e-1f));
+		p = V::add(V::mul(p, m), c(1.4249322787e-1f));
+		p = V::add(V::mul(p, m), c(-1.6668057665e-1f));
+		p = V::add(V::mul(p, m), c(2.0000714765e-1f));
+		p = V::add(V::mul(p, m), c(-2.4999993993e-1f));
+		p = V::add(V::mul(p, m), c(3.3333331174e-1f));
+		R y = V::mul(V::mul(p, m), z);
+		y = V::add(y, V::mul(e, c(-2.12194440e-4f)));
+		y = V::sub(y, V::mul(c(0.5f), z));
+		R result = V::add(V::add(m, y), V::mul(e, c(0.693359375f)));
+		// log(0) is -inf, log(inf) is inf, negative numbers and NaN give NaN
+		result = V::select(V::equal(x, c(HUGE_VALF)), x, result);
+		result = V::select(V::equal(x, c(0.f)), c(-HUGE_VALF), result);
+		return V::select(V::less(x, c(0.f)), c(NAN), V::select(V::equal(x, x), result, x));
+	}
+};
+
+struct FastMathScalar
+{
+	typedef float R;
+	typedef bool M;
+
+	static unsigned bits(float x) { unsigned u; memcpy(&u, &x, sizeof(u)); return u; }
+	static float fromBits(unsigned u) { float x; memcpy(&x, &u, sizeof(x)); return x; }
+
+	static float set1(float x) { return x; }
+	static float add(float a, float b) { return a + b; }
+	static float sub(float a, float b) { return a - b; }
+	static float mul(float a, float b) { return a * b; }
+	static float div(float a, float b) { return a / b; }
+	static float min(float a, float b) { return a < b ? a : b; }
+	static float max(float a, float b) { return a > b ? a : b; }
+	static float sqrt(float a) { return sqrtf(a); }
+	static float neg(float a) { return -a; }
+	static float abs(float a) { return fromBits(bits(a) & 0x7fffffffu); }
+	static float copySign(float a, float s) { return fromBits((bits(a) & 0x7fffffffu) | (bits(s) & 0x80000000u)); }
+	static bool less(float a, float b) { return a < b; }
+	static bool equal(float a, float b) { return a == b; }
+	static float select(bool m, float a, float b) { return m ? a : b; }
+#ifdef FAST_MATH_SSE
+	static float round(float a) { return float(_mm_cvtss_si32(_mm_set_ss(a))); }
+	static float rsqrtEstimate(float a) { return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(a))); }
+	static float rcpEstimate(float a) { return _mm_cvtss_f32(_mm_rcp_ss(_mm_set_ss(a))); }
+#else
+	static float round(float a) { return float(int(a + (a < 0.f ? -0.5f : 0.5f))); }
+	static float rsqrtEstimate(float a) { return 1.f / sqrtf(a); }
+	static float rcpEstimate(float a) { return 1.f / a; }
+#endif
+	static float pow2(float n) { return fromBits(unsigned(int(n) + 127) << 23); }
+	static float exponent(float x, float& m)
+	{
+		unsigned u = bits(x);
+		m = fromBits((u & 0x807fffffu) | 0x3f000000u);
+		return float(int(u >> 23)) - 126.f;
+	}
+};
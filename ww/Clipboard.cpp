@@ -219,7 +219,7 @@ bool Clipboard::copy(PropertyRow* row)
 	Win32::Window32* window = ww::_findWindow(widget_);
 	YASLI_ASSERT(window);
 
-    SharedPtr<PropertyRow> clonedRow(row->clone(constStrings_));
+    SharedPtr<PropertyRow> clonedRow(row->cloneSerialized(constStrings_));
 	BinOArchive oa;
 	if(!oa(clonedRow, "row", "Row")){
 		PropertyRow::setConstStrings(0);
@@ -123,6 +123,12 @@ void PropertyRowBitVector::serializeValue(yasli::Archive& ar)
 	ar(flags_, "flags", "Flags");
 }
 
+bool PropertyRowBitVector::sameValue(const PropertyRow& row) const
+{
+	const PropertyRowBitVector& bitVector = static_cast<const PropertyRowBitVector&>(row);
+	return flags_ == bitVector.flags_ && valueText_ == bitVector.valueText_ && valueAlt_ == bitVector.valueAlt_;
+}
+
 REGISTER_PROPERTY_ROW(BitVectorWrapper, PropertyRowBitVector)
 DECLARE_SEGMENT(PropertyRowBitVector)
 
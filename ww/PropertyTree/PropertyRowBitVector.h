@@ -23,6 +23,7 @@ public:
 	void setValueAlt(const char* value);
 	int flags() const { return flags_; }
 	void serializeValue(yasli::Archive& ar) override;
+	bool sameValue(const PropertyRow& row) const override;
 	bool assignTo(const yasli::Serializer& ser) const override;
 	yasli::string valueAsString() const override{ return valueAlt_; }
 	void setValueAndContext(const yasli::Serializer& ser, yasli::Archive& ar) override;
@@ -52,6 +52,7 @@ public:
 		formatColor(buf, value_);
 		return string(buf);
 	}
+	bool sameValue(const PropertyRow& row) const override{ return this->value_ == static_cast<const PropertyRowColor&>(row).value_; }
 	virtual int widgetSizeMin(const PropertyTree* tree) const override{ 
 		return userWidgetSize() >= 0 ? userWidgetSize() : tree->_defaultRowHeight(); 
 	}
@@ -45,6 +45,7 @@ public:
 	WidgetPlacement widgetPlacement() const override{ return WIDGET_ICON; }
 	yasli::string valueAsString() const override{ return value_ ? label() : ""; }
 	int widgetSizeMin(const PropertyTree* tree) const override{ return 16; }
+	bool sameValue(const PropertyRow& row) const override{ return bool(value_) == bool(static_cast<const PropertyRowNot&>(row).value_); }
 };
 
 bool PropertyRowNot::onActivate(PropertyTree* tree, bool force)
@@ -74,6 +75,7 @@ public:
 	WidgetPlacement widgetPlacement() const override{ return WIDGET_ICON; }
 	yasli::string valueAsString() const override{ return value() ? label() : ""; }
 	int widgetSizeMin(const PropertyTree*) const override{ return 16; }
+	bool sameValue(const PropertyRow& row) const override{ return bool(value_) == bool(static_cast<const PropertyRowRadio&>(row).value_); }
 };
 
 bool PropertyRowRadio::onActivate(PropertyTree* tree, bool force)
@@ -48,6 +48,7 @@ public:
 
 
 	yasli::string valueAsString() const override{ return value().c_str(); }
+	bool sameValue(const PropertyRow& row) const override{ return strcmp(value_.c_str(), static_cast<const PropertyRowFileSelector&>(row).value_.c_str()) == 0; }
 
 	void serializeValue(yasli::Archive& ar) override{
 		string fileName = value_.c_str();
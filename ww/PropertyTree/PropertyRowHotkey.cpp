@@ -32,6 +32,7 @@ public:
 	bool onContextMenu(property_tree::IMenu& root, ::PropertyTree* tree) override;
 	void onMenuClear(PropertyTreeModel* model);
 	std::string valueAsString() const override{ return value().toString(false); }
+	bool sameValue(const PropertyRow& row) const override{ return value_ == static_cast<const PropertyRowHotkey&>(row).value_; }
 protected:
 };
 
@@ -56,6 +56,10 @@ public:
 	void serializeValue(Archive& ar) override{}
 	int widgetSizeMin(const ::PropertyTree* tree) const override{ return 16 + 2; }
 	int height() const{ return 16; }
+	bool sameValue(const PropertyRow& row) const override{
+		const yasli::IconXPM& icon = static_cast<const PropertyRowIcon&>(row).icon_;
+		return icon_.source == icon.source && icon_.lineCount == icon.lineCount;
+	}
 protected:
 	yasli::IconXPM icon_;
 };
@@ -84,6 +88,10 @@ public:
 
 	int widgetSizeMin(const ::PropertyTree* tree) const override{ return value().iconFalse_.width() + 1; }
 	int height() const{ return value().iconFalse_.height(); }
+	bool sameValue(const PropertyRow& row) const override{
+		const IconToggle& toggle = static_cast<const PropertyRowIconToggle&>(row).value_;
+		return value_.value_ == toggle.value_ && value_.iconTrue_.source() == toggle.iconTrue_.source() && value_.iconFalse_.source() == toggle.iconFalse_.source();
+	}
 };
 
 REGISTER_PROPERTY_ROW(Icon, PropertyRowIcon); 
@@ -213,8 +213,7 @@ void PropertyTree::updateHeights()
 		rightBorder_ = rb;
 		model()->root()->calculateMinimalSize(this, leftBorder_, force, 0, 0);
 
-		size_.y_ = area_.top() + filterAreaHeight;
-		model()->root()->adjustVerticalPosition(this, size_.y_);
+		positionRows(area_.top() + filterAreaHeight);
 	}
 	updateScrollBar();
 	update();
@@ -361,104 +360,10 @@ void PropertyTree::attachPropertyTree(::PropertyTree* propertyTree)
 	//((PropertyTree*)attachedPropertyTree_)->signalChanged().connect(this, &PropertyTree::onAttachedTreeChanged);
 }
 
-struct FilterVisitor
-{
-	const PropertyTree::RowFilter& filter_;
-
-	FilterVisitor(const PropertyTree::RowFilter& filter) 
-    : filter_(filter)
-    {
-    }
-
-	static void markChildrenAsBelonging(PropertyRow* row, bool belongs)
-	{
-		int count = int(row->count());
-		for (int i = 0; i < count; ++i)
-		{
-			PropertyRow* child = row->childByIndex(i);
-			child->setBelongsToFilteredRow(belongs);
-
-			markChildrenAsBelonging(child, belongs);
-		}
-	}
-	
-	static bool hasMatchingChildren(PropertyRow* row)
-	{
-		int numChildren = (int)row->count();
-		for (int i = 0; i < numChildren; ++i)
-		{
-			PropertyRow* child = row->childByIndex(i);
-			if (!child)
-				continue;
-			if (child->matchFilter())
-				return true;
-			if (hasMatchingChildren(child))
-				return true;
-		}
-		return false;
-	}
-
-	ScanResult operator()(PropertyRow* row, ::PropertyTree* _tree)
-	{
-		PropertyTree* tree = (PropertyTree*)_tree;
-		string label = row->labelUndecorated();
-		string value = row->valueAsString();
-		bool matchFilter = filter_.match(label.c_str(), filter_.NAME_VALUE, 0, 0) || filter_.match(value.c_str(), filter_.NAME_VALUE, 0, 0);
-		if (matchFilter && filter_.typeRelevant(filter_.NAME))
-			matchFilter = filter_.match(label.c_str(), filter_.NAME, 0, 0);
-		if (matchFilter && filter_.typeRelevant(filter_.VALUE))
-			matchFilter = filter_.match(value.c_str(), filter_.VALUE, 0, 0);
-		if (matchFilter && filter_.typeRelevant(filter_.TYPE))
-			matchFilter = filter_.match(row->typeNameForFilter(tree), filter_.TYPE, 0, 0);						   
-		
-		int numChildren = int(row->count());
-		if (matchFilter) {
-			if (row->pulledBefore() || row->pulledUp()) {
-				// treat pulled rows as part of parent
-				PropertyRow* parent = row->parent();
-				parent->setMatchFilter(true);
-				markChildrenAsBelonging(parent, true);
-				parent->setBelongsToFilteredRow(false);
-			}
-			else {
-				markChildrenAsBelonging(row, true);
-				row->setBelongsToFilteredRow(false);
-				row->setLayoutChanged();
-				row->setLabelChanged();
-			}
-		}
-		else {
-			bool belongs = hasMatchingChildren(row);
-			row->setBelongsToFilteredRow(belongs);
-			if (belongs) {
-				tree->expandRow(row, true, false);
-				for (int i = 0; i < numChildren; ++i) {
-					PropertyRow* child = row->childByIndex(i);
-					if (child->pulledUp())
-						child->setBelongsToFilteredRow(true);
-				}
-			}
-			else {
-				row->_setExpanded(false);
-				row->setLayoutChanged();
-			}
-		}
-
-		row->setMatchFilter(matchFilter);
-		return SCAN_CHILDREN_SIBLINGS;
-	}
-
-protected:
-	string labelStart_;
-};
-
 void PropertyTree::onFilterChanged()
 {
 	const char* filterStr = filterMode_ ? filterEntry_->text() : "";
-	rowFilter_.parse(filterStr);
-	FilterVisitor visitor(rowFilter_);
-	model()->root()->scanChildrenBottomUp(visitor, this);
-	updateHeights();
+	matchFilter(filterStr);
 }
 
 void PropertyTree::drawFilteredString(Gdiplus::Graphics* gr, const char* text, RowFilter::Type type, Gdiplus::Font* font, const Rect& rect, const Color& textColor, bool pathEllipsis, bool center) const
@@ -571,8 +476,8 @@ void PropertyTree::onPaint(HDC dc)
 	OffsetViewportOrgEx(dc, -offset_.x(), -offset_.y(), 0);
 	if (model()->root()) {
 		Gdiplus::Graphics gr(dc);
-		model()->root()->scanChildren(DrawVisitor(&gr, area_, offset_.y(), true), this);
-		model()->root()->scanChildren(DrawVisitor(&gr, area_, offset_.y(), false), this);
+		model()->root()->scanPlacedChildren(DrawVisitor(&gr, area_, offset_.y(), true), this);
+		model()->root()->scanPlacedChildren(DrawVisitor(&gr, area_, offset_.y(), false), this);
 	}
 	OffsetViewportOrgEx(dc, offset_.x(), offset_.y(), 0);
 
@@ -739,6 +644,7 @@ bool PropertyTree::updateScrollBar()
 void PropertyTree::onScroll(int y)
 {
 	offset_.setY(y);
+	layoutVisibleRows();
 }
 
 
@@ -803,6 +709,7 @@ void PropertyTree::onMouseWheel(int delta)
 {
 	offset_.y_ = offset_.y() - delta;
 	updateScrollBar();
+	layoutVisibleRows();
 	_arrangeChildren();
 	RedrawWindow(impl()->handle(), 0, 0, RDW_INVALIDATE | RDW_UPDATENOW);
 }
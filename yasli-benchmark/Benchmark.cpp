@@ -0,0 +1,29 @@
+#include <string.h>
+#include "Benchmark.h"
+
+Benchmark* Benchmark::first = 0;
+
+Benchmark::Benchmark(const char* name, Func func)
+: name(name)
+, func(func)
+, next(0)
+{
+	// keep registration order
+	Benchmark** last = &first;
+	while (*last)
+		last = &(*last)->next;
+	*last = this;
+}
+
+// Usage: yasli-benchmark-exe [name-substring]
+int main(int argc, char* argv[])
+{
+	const char* filter = argc > 1 ? argv[1] : "";
+	for (Benchmark* b = Benchmark::first; b; b = b->next) {
+		if (!strstr(b->name, filter))
+			continue;
+		printf("%s\n", b->name);
+		b->func();
+	}
+	return 0;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdio.h>
+#include <chrono>
+
+// Minimal benchmark registry. Each BENCHMARK body is run once by main(),
+// measuring is done explicitly with BenchmarkTimer, so that setup is not
+// included into the reported time.
+//
+// BENCHMARK(Something)
+// {
+//   prepare();
+//   BenchmarkTimer timer("Something", iterations);
+//   for (int i = 0; i < iterations; ++i)
+//     doSomething();
+// }
+
+struct Benchmark
+{
+	typedef void(*Func)();
+
+	Benchmark(const char* name, Func func);
+
+	const char* name;
+	Func func;
+	Benchmark* next;
+
+	static Benchmark* first;
+};
+
+// Prints time per iteration on destruction.
+class BenchmarkTimer
+{
+public:
+	BenchmarkTimer(const char* name, long long iterations)
+	: name_(name)
+	, iterations_(iterations)
+	, start_(std::chrono::high_resolution_clock::now())
+	{
+	}
+
+	~BenchmarkTimer()
+	{
+		double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - start_).count());
+		printf("  %-48s %12.2f ns/iter %10.3f ms total\n", name_, ns / double(iterations_ ? iterations_ : 1), ns * 1e-6);
+	}
+private:
+	const char* name_;
+	long long iterations_;
+	std::chrono::high_resolution_clock::time_point start_;
+};
+
+// Prevents compiler from optimizing away computed values.
+template<class T>
+inline void benchmarkKeep(const T& value)
+{
+	static const void* volatile sink;
+	sink = &value;
+}
+
+#define BENCHMARK(Name) \
+	static void benchmark##Name(); \
+	static Benchmark benchmarkInstance##Name(#Name, &benchmark##Name); \
+	static void benchmark##Name()
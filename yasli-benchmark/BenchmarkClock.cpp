@@ -0,0 +1,102 @@
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include "Benchmark.h"
+#include "XMath/XClock.h"
+#include "XMath/QuantileHistogram.h"
+#include "XMath/Profiler.h"
+#include "XMath/Random.h"
+#include "yasli/BinArchive.h"
+#include "yasli/JSONOArchive.h"
+
+namespace {
+
+const int CALLS = 10000000;
+const size_t SAMPLES = 1000000;
+
+// Frame times in milliseconds: 16.7 with lognormal jitter and a rare hitch
+// of 50-100 ms, tails like these are what quantiles are for.
+std::vector<double> frameTimes()
+{
+	RandomStream random(1);
+	std::vector<double> times(SAMPLES);
+	for (size_t i = 0; i < SAMPLES; ++i) {
+		double u1 = (random.next32() + 1.) / 4294967296.;
+		double u2 = random.next32() / 4294967296.;
+		double normal = sqrt(-2. * log(u1)) * cos(6.283185307179586 * u2);
+		times[i] = 16.7 * exp(0.1 * normal);
+		if (random.uniform(1000) == 0)
+			times[i] = 50. + 50. * random.frand();
+	}
+	return times;
+}
+
+}
+
+BENCHMARK(Clock)
+{
+	long long sum = 0;
+	{
+		BenchmarkTimer timer("xclock", CALLS);
+		for (int i = 0; i < CALLS; ++i)
+			sum += xclock();
+	}
+	{
+		BenchmarkTimer timer("xclockNanoseconds", CALLS);
+		for (int i = 0; i < CALLS; ++i)
+			sum += xclockNanoseconds();
+	}
+	{
+		BenchmarkTimer timer("xclockTicks", CALLS);
+		for (int i = 0; i < CALLS; ++i)
+			sum += xclockTicks();
+	}
+	{
+		BenchmarkTimer timer("std::chrono::steady_clock::now", CALLS);
+		for (int i = 0; i < CALLS; ++i)
+			sum += std::chrono::steady_clock::now().time_since_epoch().count();
+	}
+	benchmarkKeep(sum);
+	double rate;
+	{
+		BenchmarkTimer timer("xclockTicksPerNanosecond, first call", 1);
+		rate = xclockTicksPerNanosecond();
+	}
+	printf("  %.4f ticks per nanosecond\n", rate);
+
+	std::vector<double> times = frameTimes();
+	QuantileHistogram histogram;
+	{
+		BenchmarkTimer timer("QuantileHistogram::add", SAMPLES);
+		for (size_t i = 0; i < SAMPLES; ++i)
+			histogram.add(times[i]);
+	}
+	{
+		BenchmarkTimer timer("statistics_add", SAMPLES);
+		for (size_t i = 0; i < SAMPLES; ++i)
+			statistics_add(frameTime, times[i]);
+	}
+	double quantile = 0.;
+	{
+		BenchmarkTimer timer("QuantileHistogram::quantile", 1000);
+		for (int i = 0; i < 1000; ++i)
+			quantile += histogram.quantile(i / 1000.);
+	}
+	benchmarkKeep(quantile);
+
+	std::vector<double> sorted(times);
+	std::sort(sorted.begin(), sorted.end());
+	static const double levels[] = { 0.5, 0.9, 0.99, 0.999 };
+	for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+		double exact = sorted[size_t(ceil(levels[i] * SAMPLES)) - 1];
+		double estimate = histogram.quantile(levels[i]);
+		printf("  quantile %-6g exact %8.4f estimate %8.4f relative error %.5f\n", levels[i], exact, estimate, fabs(estimate - exact) / exact);
+	}
+
+	yasli::BinOArchive binary;
+	binary(histogram, "histogram");
+	yasli::JSONOArchive json;
+	json(histogram, "histogram");
+	printf("  serialized histogram: %d bytes of BinOArchive, %d bytes of JSONOArchive\n", int(binary.length()), int(json.length()));
+}
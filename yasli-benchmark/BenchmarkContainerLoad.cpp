@@ -0,0 +1,110 @@
+#include <vector>
+#include <list>
+#include <deque>
+#include <string>
+#include "Benchmark.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+#include "yasli/BinArchive.h"
+#include "yasli/JSONOArchive.h"
+#include "yasli/JSONIArchive.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Item
+{
+	std::string name;
+	int count;
+	float weight;
+
+	Item() : count(0), weight(0.0f) {}
+
+	void serialize(Archive& ar)
+	{
+		ar(name, "name");
+		ar(count, "count");
+		ar(weight, "weight");
+	}
+};
+
+const int ELEMENT_COUNT = 200000;
+
+template<class Container>
+void fill(Container& container)
+{
+	for (int i = 0; i < ELEMENT_COUNT; ++i) {
+		Item item;
+		item.name = "item";
+		item.count = i;
+		item.weight = float(i);
+		container.push_back(item);
+	}
+}
+
+template<class Container>
+void loadBin(const char* name)
+{
+	Container source;
+	fill(source);
+	BinOArchive oa;
+	oa(source, "items");
+
+	BenchmarkTimer timer(name, ELEMENT_COUNT);
+	Container loaded;
+	BinIArchive ia;
+	ia.open(oa);
+	ia(loaded, "items");
+	benchmarkKeep(loaded.size());
+}
+
+template<class Container>
+void loadJSON(const char* name)
+{
+	Container source;
+	fill(source);
+	JSONOArchive oa;
+	oa(source, "items");
+
+	BenchmarkTimer timer(name, ELEMENT_COUNT);
+	Container loaded;
+	JSONIArchive ia;
+	ia.open(oa.c_str(), oa.length());
+	ia(loaded, "items");
+	benchmarkKeep(loaded.size());
+}
+
+struct Values
+{
+	std::vector<int> values;
+
+	void serialize(Archive& ar)
+	{
+		ar(values, "values");
+	}
+};
+
+}
+
+BENCHMARK(ContainerLoad)
+{
+	loadBin<std::vector<Item> >("Bin vector<Item>, per element");
+	loadBin<std::deque<Item> >("Bin deque<Item>, per element");
+	loadBin<std::list<Item> >("Bin list<Item>, per element");
+	loadJSON<std::vector<Item> >("JSON vector<Item>, per element");
+	loadJSON<std::deque<Item> >("JSON deque<Item>, per element");
+	loadJSON<std::list<Item> >("JSON list<Item>, per element");
+
+	Values source;
+	source.values.resize(ELEMENT_COUNT * 5, 12345);
+	JSONOArchive oa;
+	oa(source, "");
+	BenchmarkTimer timer("JSON vector<int>, per element", ELEMENT_COUNT * 5);
+	Values loaded;
+	JSONIArchive ia;
+	ia.open(oa.c_str(), oa.length());
+	ia(loaded, "");
+	benchmarkKeep(loaded.values.size());
+}
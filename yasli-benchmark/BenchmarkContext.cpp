@@ -0,0 +1,59 @@
+#include "Benchmark.h"
+#include "yasli/BinArchive.h"
+
+using namespace yasli;
+
+namespace {
+
+template<int Index>
+struct ContextLevel
+{
+	int value;
+};
+
+const int LOOKUPS = 10000000;
+
+// Pushes Depth nested contexts of distinct types, then measures lookup of the
+// outermost one and of a type that is not present.
+template<int Depth, int Level = Depth>
+struct NestedContexts
+{
+	static void run(Archive& ar, const char* found, const char* missing)
+	{
+		ContextLevel<Level> level;
+		Context context(ar, &level);
+		NestedContexts<Depth, Level - 1>::run(ar, found, missing);
+	}
+};
+
+template<int Depth>
+struct NestedContexts<Depth, 0>
+{
+	static void run(Archive& ar, const char* found, const char* missing)
+	{
+		size_t count = 0;
+		{
+			BenchmarkTimer timer(found, LOOKUPS);
+			for (int i = 0; i < LOOKUPS; ++i)
+				count += ar.context<ContextLevel<Depth> >() != 0;
+		}
+		{
+			BenchmarkTimer timer(missing, LOOKUPS);
+			for (int i = 0; i < LOOKUPS; ++i)
+				count += ar.context<ContextLevel<0> >() != 0;
+		}
+		benchmarkKeep(count);
+	}
+};
+
+}
+
+BENCHMARK(ContextLookup)
+{
+	BinOArchive ar;
+	NestedContexts<1>::run(ar, "1 context, outermost", "1 context, missing");
+	NestedContexts<2>::run(ar, "2 contexts, outermost", "2 contexts, missing");
+	NestedContexts<4>::run(ar, "4 contexts, outermost", "4 contexts, missing");
+	NestedContexts<8>::run(ar, "8 contexts, outermost", "8 contexts, missing");
+	NestedContexts<16>::run(ar, "16 contexts, outermost", "16 contexts, missing");
+}
@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "Benchmark.h"
+#include "XMath/xmath.h"
+#include "XMath/XMathBatch.h"
+
+namespace {
+
+const size_t COUNT = 1024;
+const int REPEATS = 2000;
+
+float randomFloat(float minimum, float maximum)
+{
+	return minimum + float(rand()) / float(RAND_MAX) * (maximum - minimum);
+}
+
+float libmInvSqrt(float x) { return 1.f / sqrtf(x); }
+float libmRcp(float x) { return 1.f / x; }
+double exactInvSqrt(double x) { return 1. / sqrt(x); }
+double exactRcp(double x) { return 1. / x; }
+
+struct Function
+{
+	const char* name;
+	float minimum;
+	float maximum;
+	float (*libm)(float);
+	float (*approximation)(float);
+	void (*batch)(const float*, float*, size_t);
+	double (*exact)(double);
+};
+
+const Function functions[] = {
+	{ "invSqrt", 1e-3f, 1e3f, libmInvSqrt, invSqrtApprox, invSqrtApprox, exactInvSqrt },
+	{ "rcp", 1e-3f, 1e3f, libmRcp, rcpApprox, rcpApprox, exactRcp },
+	{ "sin", -100.f, 100.f, sinf, sinApprox, sinApprox, sin },
+	{ "cos", -100.f, 100.f, cosf, cosApprox, cosApprox, cos },
+	{ "acos", -1.f, 1.f, acosf, acosApprox, acosApprox, acos },
+	{ "exp", -80.f, 80.f, expf, expApprox, expApprox, exp },
+	{ "log", 1e-3f, 1e3f, logf, logApprox, logApprox, log },
+};
+
+// largest absolute and relative differences from double precision function
+void printErrors(const char* name, const float* x, const float* result, double (*exact)(double))
+{
+	double absolute = 0.;
+	double relative = 0.;
+	for (size_t i = 0; i < COUNT; ++i) {
+		double expected = exact(x[i]);
+		double difference = fabs(result[i] - expected);
+		if (difference > absolute)
+			absolute = difference;
+		if (expected != 0. && difference / fabs(expected) > relative)
+			relative = difference / fabs(expected);
+	}
+	printf("  %-48s absolute %9.3g relative %9.3g\n", name, absolute, relative);
+}
+
+void measure(const Function& function)
+{
+	std::vector<float> x(COUNT);
+	std::vector<float> result(COUNT);
+	for (size_t i = 0; i < COUNT; ++i)
+		x[i] = randomFloat(function.minimum, function.maximum);
+	long long iterations = (long long)COUNT * REPEATS;
+	char name[128];
+
+	sprintf(name, "%sf of math.h", function.name);
+	{
+		BenchmarkTimer timer(name, iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				result[j] = function.libm(x[j]);
+	}
+	printErrors("", &x[0], &result[0], function.exact);
+
+	sprintf(name, "%sApprox, float", function.name);
+	{
+		BenchmarkTimer timer(name, iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				result[j] = function.approximation(x[j]);
+	}
+	printErrors("", &x[0], &result[0], function.exact);
+
+	static const char* sets[] = { "scalar", "SSE", "AVX" };
+	for (int set = BATCH_SCALAR; set <= BATCH_AVX; ++set) {
+		if (setBatchInstructionSet(BatchInstructionSet(set)) != set)
+			continue;
+		sprintf(name, "%sApprox, array, %s", function.name, sets[set]);
+		BenchmarkTimer timer(name, iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			function.batch(&x[0], &result[0], COUNT);
+	}
+	setBatchInstructionSet(BATCH_AVX);
+	benchmarkKeep(result);
+}
+
+}
+
+BENCHMARK(FastMath)
+{
+	for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); ++i)
+		measure(functions[i]);
+
+	// atan2 takes two arguments, it is measured separately
+	std::vector<float> y(COUNT), x(COUNT), result(COUNT);
+	for (size_t i = 0; i < COUNT; ++i) {
+		y[i] = randomFloat(-10.f, 10.f);
+		x[i] = randomFloat(-10.f, 10.f);
+	}
+	long long iterations = (long long)COUNT * REPEATS;
+	{
+		BenchmarkTimer timer("atan2f of math.h", iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				result[j] = atan2f(y[j], x[j]);
+	}
+	{
+		BenchmarkTimer timer("atan2Approx, float", iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				result[j] = atan2Approx(y[j], x[j]);
+	}
+	double absolute = 0.;
+	for (size_t i = 0; i < COUNT; ++i)
+		absolute = std::max(absolute, fabs(result[i] - atan2(double(y[i]), double(x[i]))));
+	printf("  %-48s absolute %9.3g\n", "", absolute);
+	static const char* sets[] = { "scalar", "SSE", "AVX" };
+	for (int set = BATCH_SCALAR; set <= BATCH_AVX; ++set) {
+		if (setBatchInstructionSet(BatchInstructionSet(set)) != set)
+			continue;
+		char name[128];
+		sprintf(name, "atan2Approx, array, %s", sets[set]);
+		BenchmarkTimer timer(name, iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			atan2Approx(&y[0], &x[0], &result[0], COUNT);
+	}
+	setBatchInstructionSet(BATCH_AVX);
+	benchmarkKeep(result);
+}
@@ -0,0 +1,103 @@
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Benchmark.h"
+#include "XMath/MTSection.h"
+
+namespace {
+
+const int LOCKS = 10000000;
+const int THREADS = 4;
+
+template<class Lock>
+void lockLoop(Lock* lock, long long* counter, int count)
+{
+	for (int i = 0; i < count; ++i) {
+		lock->lock();
+		++*counter;
+		lock->unlock();
+	}
+}
+
+void plainLoop()
+{
+}
+
+struct SharedLock
+{
+	MTReadWriteSection& section;
+	explicit SharedLock(MTReadWriteSection& section) : section(section) {}
+	void lock() { section.lockShared(); }
+	void unlock() { section.unlockShared(); }
+};
+
+template<class Lock>
+void measure(const char* uncontended, const char* contended)
+{
+	Lock lock;
+	long long counter = 0;
+	{
+		BenchmarkTimer timer(uncontended, LOCKS);
+		lockLoop(&lock, &counter, LOCKS);
+	}
+	{
+		BenchmarkTimer timer(contended, LOCKS);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < THREADS; ++i)
+			threads.push_back(std::thread(lockLoop<Lock>, &lock, &counter, LOCKS / THREADS));
+		for (int i = 0; i < THREADS; ++i)
+			threads[i].join();
+	}
+	benchmarkKeep(counter);
+}
+
+template<class Lock>
+void printStatistics(const char* name, const Lock& lock)
+{
+	MTLockStatistics statistics = lock.statistics();
+	printf("  %-48s %llu acquisitions, %llu contentions, %llu waits\n", name,
+		(unsigned long long)statistics.acquisitions, (unsigned long long)statistics.contentions, (unsigned long long)statistics.waits);
+}
+
+}
+
+BENCHMARK(Locks)
+{
+	// glibc skips atomic operations in std::mutex until the first thread starts
+	std::thread(plainLoop).join();
+
+	measure<std::mutex>("std::mutex", "std::mutex, 4 threads");
+	measure<MTSpinLock>("MTSpinLock", "MTSpinLock, 4 threads");
+	measure<MTMutex>("MTMutex", "MTMutex, 4 threads");
+	measure<MTSection>("MTSection (recursive)", "MTSection (recursive), 4 threads");
+	measure<MTReadWriteSection>("MTReadWriteSection, exclusive", "MTReadWriteSection, exclusive, 4 threads");
+
+	// readers do not exclude each other, counter is per thread
+	MTReadWriteSection section;
+	SharedLock shared(section);
+	long long counters[THREADS] = {};
+	{
+		BenchmarkTimer timer("MTReadWriteSection, shared", LOCKS);
+		lockLoop(&shared, &counters[0], LOCKS);
+	}
+	{
+		BenchmarkTimer timer("MTReadWriteSection, shared, 4 threads", LOCKS);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < THREADS; ++i)
+			threads.push_back(std::thread(lockLoop<SharedLock>, &shared, &counters[i], LOCKS / THREADS));
+		for (int i = 0; i < THREADS; ++i)
+			threads[i].join();
+	}
+	benchmarkKeep(counters);
+
+	MTMutex mutex;
+	long long counter = 0;
+	std::vector<std::thread> threads;
+	for (int i = 0; i < THREADS; ++i)
+		threads.push_back(std::thread(lockLoop<MTMutex>, &mutex, &counter, LOCKS / THREADS));
+	for (int i = 0; i < THREADS; ++i)
+		threads[i].join();
+	benchmarkKeep(counter);
+	printStatistics("MTMutex, 4 threads", mutex);
+	printStatistics("MTReadWriteSection, shared, 4 threads", section);
+}
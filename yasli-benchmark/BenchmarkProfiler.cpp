@@ -0,0 +1,129 @@
+#include <vector>
+#include <thread>
+#include "Benchmark.h"
+#include "XMath/Profiler.h"
+#include "yasli/JSONOArchive.h"
+
+#ifdef start_timer_auto1
+
+#ifdef _MSC_VER
+# define BENCHMARK_NOINLINE __declspec(noinline)
+#else
+# define BENCHMARK_NOINLINE __attribute__((noinline))
+#endif
+
+namespace {
+
+const int SCOPES = 10000000;
+const int THREADS = 4;
+const int QUANTS = 1000000;
+
+// two nested scopes per call
+BENCHMARK_NOINLINE int profiledCall(int value)
+{
+	start_timer_auto1(outer);
+	start_timer_auto1(inner);
+	return value * 3 + 1;
+}
+
+BENCHMARK_NOINLINE int plainCall(int value)
+{
+	return value * 3 + 1;
+}
+
+const int ALLOCATIONS = 1000000;
+
+void measureAllocations(const char* name)
+{
+	start_timer_auto1(allocations);
+	BenchmarkTimer timer(name, ALLOCATIONS);
+	for (int i = 0; i < ALLOCATIONS; ++i) {
+		int* value = new int(i);
+		benchmarkKeep(*value);
+		delete value;
+	}
+}
+
+void runScopes(int* result)
+{
+	int value = 0;
+	for (int i = 0; i < SCOPES / 2; ++i)
+		value = profiledCall(value);
+	*result = value;
+}
+
+void measure(const char* name)
+{
+	int value = 0;
+	{
+		BenchmarkTimer timer(name, SCOPES);
+		runScopes(&value);
+	}
+	benchmarkKeep(value);
+}
+
+}
+
+BENCHMARK(Profiler)
+{
+	int value = 0;
+	{
+		BenchmarkTimer timer("call without scopes", SCOPES);
+		for (int i = 0; i < SCOPES / 2; ++i)
+			value = plainCall(value);
+	}
+	benchmarkKeep(value);
+
+	// report is not saved to a file
+	Profiler::instance().setAutoMode(0, 0, "", "");
+
+	measure("scope, accurate sampling");
+
+	profiler_start_stop(PROFILER_REBUILD);
+	measure("scope, building tree");
+	profiler_quant();
+	measure("scope, building tree, after quant");
+	// the first scope after each quant publishes a snapshot of the timers
+	{
+		BenchmarkTimer timer("quant and scope, snapshot", QUANTS);
+		for (int i = 0; i < QUANTS; ++i) {
+			profiler_quant();
+			value = profiledCall(value);
+		}
+	}
+	benchmarkKeep(value);
+	profiler_start_stop(PROFILER_REBUILD);
+
+	profiler_start_stop(PROFILER_ACCURATE);
+	std::vector<int> results(THREADS);
+	{
+		BenchmarkTimer timer("scope, 4 threads", SCOPES * THREADS);
+		std::vector<std::thread> threads;
+		for (int i = 0; i < THREADS; ++i)
+			threads.push_back(std::thread(runScopes, &results[i]));
+		for (int i = 0; i < THREADS; ++i)
+			threads[i].join();
+	}
+	benchmarkKeep(results);
+	profiler_start_stop(PROFILER_ACCURATE);
+
+	// with XMATH_PROFILER_OPERATOR_NEW operator new/delete check whether
+	// allocations of the thread are tracked
+	measureAllocations("new/delete, not tracked");
+	profiler_start_stop(PROFILER_MEMORY);
+	measureAllocations("new/delete, memory mode");
+	profiler_start_stop(PROFILER_MEMORY);
+
+	// default ring size, wraps many times
+	Profiler::startTrace();
+	measure("scope, recording trace");
+	Profiler::stopTrace();
+	{
+		BenchmarkTimer timer("trace export, 64K events", 65536);
+		yasli::JSONOArchive oa;
+		Profiler::serializeTrace(oa);
+		benchmarkKeep(oa.length());
+	}
+}
+
+#endif
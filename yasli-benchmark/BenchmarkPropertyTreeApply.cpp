@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "HeadlessPropertyTree.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Transform
+{
+	float position[3];
+	float rotation[4];
+	float scale;
+
+	void serialize(Archive& ar)
+	{
+		ar(position, "position", "Position");
+		ar(rotation, "rotation", "Rotation");
+		ar(scale, "scale", "Scale");
+	}
+};
+
+struct Entity
+{
+	std::string name;
+	Transform transform;
+	int layer;
+	bool visible;
+	std::vector<std::string> tags;
+
+	void serialize(Archive& ar)
+	{
+		ar(name, "name", "Name");
+		ar(transform, "transform", "Transform");
+		ar(layer, "layer", "Layer");
+		ar(visible, "visible", "Visible");
+		ar(tags, "tags", "Tags");
+	}
+};
+
+struct Scene
+{
+	std::vector<Entity> entities;
+
+	void serialize(Archive& ar)
+	{
+		ar(entities, "entities", "Entities");
+	}
+};
+
+const int ENTITY_COUNT = 5000;
+const int SELECTED_COUNT = 200;
+const int APPLIES = 20;
+const int EDITS_PER_FRAME = 10;
+
+void fill(std::vector<Entity>& entities, int count)
+{
+	entities.resize(count);
+	char name[32];
+	for (int i = 0; i < count; ++i) {
+		Entity& e = entities[i];
+		sprintf(name, "entity%d", i);
+		e.name = name;
+		for (int j = 0; j < 3; ++j)
+			e.transform.position[j] = float(i * j);
+		for (int j = 0; j < 4; ++j)
+			e.transform.rotation[j] = j == 3 ? 1.0f : 0.0f;
+		e.transform.scale = 1.0f;
+		e.layer = i % 4;
+		e.visible = true;
+		e.tags.push_back("static");
+	}
+}
+
+PropertyRow* findRow(PropertyRow* row, const char* name)
+{
+	for (PropertyRow::iterator it = row->begin(); it != row->end(); ++it)
+		if (strcmp((*it)->name(), name) == 0)
+			return *it;
+	return 0;
+}
+
+// Compares apply that writes every row with the one that writes only the
+// edited row.
+void measureApply(HeadlessPropertyTree& tree, PropertyRow* entity, const char* what)
+{
+	PropertyTreeModel* model = tree.model();
+	PropertyRow* visible = findRow(entity, "visible");
+	char label[96];
+	{
+		sprintf(label, "%s, apply all rows", what);
+		BenchmarkTimer timer(label, APPLIES);
+		for (int i = 0; i < APPLIES; ++i)
+			tree.apply();
+	}
+	{
+		sprintf(label, "%s, apply one changed row", what);
+		BenchmarkTimer timer(label, APPLIES);
+		for (int i = 0; i < APPLIES; ++i) {
+			model->setRowDirty(visible);
+			tree.apply();
+		}
+	}
+}
+
+// Edits that come one after another, e.g. when several rows are toggled by
+// dragging over their checkboxes.
+void measureEdits(bool batched)
+{
+	Scene scene;
+	fill(scene.entities, ENTITY_COUNT);
+	HeadlessPropertyTree tree;
+	tree.setUndoEnabled(false);
+	tree.setBatchedApply(batched);
+	tree.attach(Serializer(scene));
+
+	BenchmarkTimer timer(batched ? "10 edits in a frame, batched" : "10 edits in a frame, applied one by one", APPLIES);
+	for (int i = 0; i < APPLIES; ++i) {
+		for (int j = 0; j < EDITS_PER_FRAME; ++j) {
+			PropertyRow* entities = tree.model()->root()->childByIndex(0);
+			tree.model()->rowChanged(findRow(entities->childByIndex((i * EDITS_PER_FRAME + j) * 7 % ENTITY_COUNT), "visible"));
+		}
+		tree.flushPendingApply();
+	}
+}
+
+}
+
+BENCHMARK(PropertyTreeApply)
+{
+	{
+		Scene scene;
+		fill(scene.entities, ENTITY_COUNT);
+		HeadlessPropertyTree tree;
+		tree.attach(Serializer(scene));
+		PropertyRow* entities = tree.model()->root()->childByIndex(0);
+		measureApply(tree, entities->childByIndex(ENTITY_COUNT / 2), "5000 entities");
+	}
+	{
+		std::vector<Entity> entities;
+		fill(entities, SELECTED_COUNT);
+		Serializers serializers;
+		for (int i = 0; i < SELECTED_COUNT; ++i)
+			serializers.push_back(Serializer(entities[i]));
+		HeadlessPropertyTree tree;
+		tree.attach(serializers);
+		measureApply(tree, tree.model()->root(), "200 selected entities");
+	}
+	measureEdits(false);
+	measureEdits(true);
+}
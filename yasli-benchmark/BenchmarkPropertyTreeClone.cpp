@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "HeadlessPropertyTree.h"
+#include "PropertyTree/ConstStringList.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Item
+{
+	std::string label;
+	int id;
+	float weight;
+	bool visible;
+	std::string comment;
+
+	void serialize(Archive& ar)
+	{
+		ar(id, "id", "ID");
+		ar(weight, "weight", "Weight");
+		ar(visible, "visible", "Visible");
+		ar(comment, "comment", "Comment");
+	}
+};
+
+// Every element gets its own label, so the tree holds ~20k distinct strings.
+struct Inventory
+{
+	std::vector<Item> items;
+
+	void serialize(Archive& ar)
+	{
+		if (ar.openBlock("items", "Items")) {
+			for (size_t i = 0; i < items.size(); ++i)
+				ar(items[i], items[i].label.c_str(), items[i].label.c_str());
+			ar.closeBlock();
+		}
+	}
+};
+
+int countRows(const PropertyRow* row)
+{
+	int result = 1;
+	for (PropertyRow::const_iterator it = row->begin(); it != row->end(); ++it)
+		result += countRows(*it);
+	return result;
+}
+
+const int ITEM_COUNT = 20000;
+const int CLONES = 5;
+
+}
+
+BENCHMARK(PropertyTreeClone)
+{
+	Inventory inventory;
+	inventory.items.resize(ITEM_COUNT);
+	char label[32];
+	for (int i = 0; i < ITEM_COUNT; ++i) {
+		Item& item = inventory.items[i];
+		sprintf(label, "item%d", i);
+		item.label = label;
+		item.id = i;
+		item.weight = float(i);
+		item.visible = true;
+		item.comment = "comment";
+	}
+
+	HeadlessPropertyTree tree;
+	tree.attach(Serializer(inventory));
+	PropertyRow* root = tree.model()->root();
+	printf("  %d rows\n", countRows(root));
+
+	{
+		BenchmarkTimer timer("clone, strings not interned yet", CLONES);
+		for (int i = 0; i < CLONES; ++i) {
+			ConstStringList strings;
+			SharedPtr<PropertyRow> copy = root->clone(&strings);
+			benchmarkKeep(copy);
+		}
+	}
+	{
+		ConstStringList strings;
+		root->clone(&strings);
+		{
+			BenchmarkTimer timer("serialized clone, strings interned", CLONES);
+			for (int i = 0; i < CLONES; ++i) {
+				SharedPtr<PropertyRow> copy = root->cloneSerialized(&strings);
+				benchmarkKeep(copy);
+			}
+		}
+		{
+			BenchmarkTimer timer("clone, strings interned", CLONES);
+			for (int i = 0; i < CLONES; ++i) {
+				SharedPtr<PropertyRow> copy = root->clone(&strings);
+				benchmarkKeep(copy);
+			}
+		}
+	}
+	{
+		// snapshot that is taken before each edit when full undo is enabled
+		tree.setUndoEnabled(true, true);
+		tree.attach(Serializer(inventory));
+		PropertyRow* row = tree.model()->root()->childByIndex(0)->childByIndex(0);
+		BenchmarkTimer timer("full undo snapshot", CLONES);
+		for (int i = 0; i < CLONES; ++i)
+			tree.model()->rowAboutToBeChanged(row);
+	}
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "HeadlessPropertyTree.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Item
+{
+	std::string name;
+	float position[3];
+	int count;
+	bool enabled;
+
+	void serialize(Archive& ar)
+	{
+		ar(name, "name", "Name");
+		ar(position, "position", "Position");
+		ar(count, "count", "Count");
+		ar(enabled, "enabled", "Enabled");
+	}
+};
+
+struct Inventory
+{
+	std::vector<Item> items;
+
+	void serialize(Archive& ar)
+	{
+		ar(items, "items", "Items");
+	}
+};
+
+const int ITEM_COUNT = 100000;
+
+// filter as it is typed, character by character
+const char* const TYPED[] = { "s", "sw", "swo", "swor", "sword", "sword_", "sword_1", "sword_12", "sword_123" };
+const int TYPED_COUNT = sizeof(TYPED) / sizeof(TYPED[0]);
+
+// Matching the way it was done before the index: each row is converted
+// to lowercase for every filter.
+struct RescanVisitor
+{
+	const PropertyTree::RowFilter& filter;
+	int matches;
+
+	RescanVisitor(const PropertyTree::RowFilter& filter) : filter(filter), matches(0) {}
+
+	ScanResult operator()(PropertyRow* row, PropertyTree* tree)
+	{
+		const char* label = row->labelUndecorated() ? row->labelUndecorated() : "";
+		yasli::string value = row->valueAsString();
+		if (filter.match(label, filter.NAME_VALUE, 0, 0) || filter.match(value.c_str(), filter.NAME_VALUE, 0, 0))
+			++matches;
+		return SCAN_CHILDREN_SIBLINGS;
+	}
+};
+
+}
+
+BENCHMARK(PropertyTreeFilter)
+{
+	Inventory inventory;
+	inventory.items.resize(ITEM_COUNT);
+	char name[32];
+	for (int i = 0; i < ITEM_COUNT; ++i) {
+		Item& item = inventory.items[i];
+		sprintf(name, i % 2 ? "Sword_%d" : "Shield_%d", i);
+		item.name = name;
+		for (int j = 0; j < 3; ++j)
+			item.position[j] = float(i * j);
+		item.count = i % 10;
+		item.enabled = true;
+	}
+
+	HeadlessPropertyTree tree(400, 800);
+	tree.setUndoEnabled(false);
+	tree.attach(Serializer(inventory));
+	printf("  %d items, typing \"%s\"\n", ITEM_COUNT, TYPED[TYPED_COUNT - 1]);
+
+	{
+		BenchmarkTimer timer("rescan with RowFilter::match, per character", TYPED_COUNT);
+		int matches = 0;
+		for (int i = 0; i < TYPED_COUNT; ++i) {
+			PropertyTree::RowFilter filter;
+			filter.parse(TYPED[i]);
+			RescanVisitor visitor(filter);
+			tree.model()->root()->scanChildrenBottomUp(visitor, &tree);
+			matches += visitor.matches;
+		}
+		benchmarkKeep(matches);
+	}
+	{
+		BenchmarkTimer timer("first character, builds index", 1);
+		tree.matchFilter(TYPED[0]);
+	}
+	{
+		// every character narrows the filter, only rows that matched are tested
+		BenchmarkTimer timer("indexed, per character", TYPED_COUNT - 1);
+		for (int i = 1; i < TYPED_COUNT; ++i)
+			tree.matchFilter(TYPED[i]);
+	}
+	{
+		BenchmarkTimer timer("indexed, erased back to one character", 1);
+		tree.matchFilter(TYPED[0]);
+	}
+
+	tree.setBackgroundFilter(true);
+	tree.matchFilter("");
+	tree.revert();
+	{
+		// characters typed faster than rows are matched cancel previous matching
+		BenchmarkTimer timer("background, whole word typed at once", 1);
+		for (int i = 0; i < TYPED_COUNT; ++i)
+			tree.matchFilter(TYPED[i]);
+		tree.applyFilterResult(true);
+	}
+	{
+		BenchmarkTimer timer("background, per character", TYPED_COUNT);
+		for (int i = 0; i < TYPED_COUNT; ++i) {
+			tree.matchFilter(TYPED[i]);
+			tree.applyFilterResult(true);
+		}
+	}
+}
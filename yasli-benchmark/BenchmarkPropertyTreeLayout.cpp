@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <vector>
+#include "Benchmark.h"
+#include "HeadlessPropertyTree.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Point3
+{
+	float x;
+	float y;
+	float z;
+
+	void serialize(Archive& ar)
+	{
+		ar(x, "x", "X");
+		ar(y, "y", "Y");
+		ar(z, "z", "Z");
+	}
+};
+
+struct Mesh
+{
+	std::vector<Point3> vertices;
+
+	void serialize(Archive& ar)
+	{
+		ar(vertices, "vertices", "Vertices");
+	}
+};
+
+const int VERTEX_COUNT = 1000000;
+const int SCROLLS = 100;
+const int HITS = 10000;
+
+}
+
+BENCHMARK(PropertyTreeLayout)
+{
+	Mesh mesh;
+	mesh.vertices.resize(VERTEX_COUNT);
+	for (int i = 0; i < VERTEX_COUNT; ++i) {
+		mesh.vertices[i].x = float(i);
+		mesh.vertices[i].y = 0.0f;
+		mesh.vertices[i].z = 1.0f;
+	}
+
+	HeadlessPropertyTree tree(400, 800);
+	{
+		BenchmarkTimer timer("attach, 1M elements", 1);
+		tree.attach(Serializer(mesh));
+	}
+	PropertyRow* vertices = tree.model()->root()->childByIndex(0);
+	{
+		BenchmarkTimer timer("collapse and expand container", 1);
+		tree.expandRow(vertices, false);
+		tree.expandRow(vertices, true);
+	}
+	printf("  content height %d\n", tree.contentHeight());
+
+	{
+		BenchmarkTimer timer("scroll and paint", SCROLLS);
+		int rows = 0;
+		for (int i = 0; i < SCROLLS; ++i) {
+			tree.scrollTo(int((long long)tree.contentHeight() * i / SCROLLS));
+			rows += tree.paint();
+		}
+		benchmarkKeep(rows);
+	}
+	{
+		BenchmarkTimer timer("hit test", HITS);
+		for (int i = 0; i < HITS; ++i)
+			benchmarkKeep(tree.rowByPoint(Point(100, (i * 7) % 800)));
+	}
+	{
+		// expanding elements far from viewport changes estimated heights only
+		BenchmarkTimer timer("expand element and scroll to it", SCROLLS);
+		for (int i = 0; i < SCROLLS; ++i) {
+			PropertyRow* vertex = vertices->childByIndex((i * 9973) % VERTEX_COUNT);
+			tree.expandRow(vertex, true, false);
+			tree.ensureVisible(vertex->childByIndex(2));
+		}
+	}
+	printf("  content height %d\n", tree.contentHeight());
+}
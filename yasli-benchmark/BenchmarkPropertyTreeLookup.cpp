@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "HeadlessPropertyTree.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+
+using namespace yasli;
+
+namespace {
+
+// Struct with many distinctly named fields.
+struct WideStruct
+{
+	std::vector<std::string> names;
+	std::vector<float> values;
+	bool reversed;
+
+	explicit WideStruct(int count)
+	: reversed(false)
+	{
+		char name[32];
+		for (int i = 0; i < count; ++i) {
+			sprintf(name, "field%d", i);
+			names.push_back(name);
+			values.push_back(float(i));
+		}
+	}
+
+	void serialize(Archive& ar)
+	{
+		int count = int(values.size());
+		for (int i = 0; i < count; ++i) {
+			int index = reversed ? count - 1 - i : i;
+			ar(values[index], names[index].c_str(), names[index].c_str());
+		}
+	}
+};
+
+struct DeepModel
+{
+	std::vector<float> values;
+};
+
+// One level of a deeply nested model.
+struct DeepLevel
+{
+	DeepModel* model;
+	int index;
+
+	void serialize(Archive& ar)
+	{
+		ar(model->values[index], "value", "Value");
+		ar(index, "index", "Index");
+		if (index + 1 < int(model->values.size())) {
+			DeepLevel child = { model, index + 1 };
+			ar(child, "child", "+Child");
+		}
+	}
+};
+
+struct WideContainer
+{
+	std::vector<float> values;
+
+	void serialize(Archive& ar)
+	{
+		ar(values, "values", "Values");
+	}
+};
+
+const int REPEATS = 20;
+
+void wideStruct(int fieldCount, const char* attachName, const char* revertName, const char* reorderName, const char* applyName)
+{
+	WideStruct wide(fieldCount);
+	HeadlessPropertyTree tree;
+	{
+		BenchmarkTimer timer(attachName, 1);
+		tree.attach(Serializer(wide));
+	}
+	{
+		BenchmarkTimer timer(revertName, REPEATS);
+		for (int i = 0; i < REPEATS; ++i)
+			tree.revert();
+	}
+	{
+		// each revert serializes fields in order opposite to the one of rows
+		BenchmarkTimer timer(reorderName, REPEATS);
+		for (int i = 0; i < REPEATS; ++i) {
+			wide.reversed = !wide.reversed;
+			tree.revert();
+		}
+	}
+	{
+		BenchmarkTimer timer(applyName, REPEATS);
+		for (int i = 0; i < REPEATS; ++i)
+			tree.apply();
+	}
+}
+
+}
+
+BENCHMARK(PropertyTreeLookup)
+{
+	wideStruct(500, "500 fields, attach", "500 fields, revert", "500 fields, reordered revert", "500 fields, apply");
+	wideStruct(4000, "4000 fields, attach", "4000 fields, revert", "4000 fields, reordered revert", "4000 fields, apply");
+
+	{
+		WideContainer container;
+		container.values.resize(20000, 1.0f);
+		HeadlessPropertyTree tree;
+		{
+			BenchmarkTimer timer("20000 elements, attach", 1);
+			tree.attach(Serializer(container));
+		}
+		{
+			BenchmarkTimer timer("20000 elements, revert", REPEATS);
+			for (int i = 0; i < REPEATS; ++i)
+				tree.revert();
+		}
+	}
+
+	{
+		DeepModel model;
+		model.values.resize(300, 1.0f);
+		DeepLevel root = { &model, 0 };
+		HeadlessPropertyTree tree;
+		{
+			BenchmarkTimer timer("300 levels deep, attach", 1);
+			tree.attach(Serializer(root));
+		}
+		{
+			BenchmarkTimer timer("300 levels deep, revert", REPEATS);
+			for (int i = 0; i < REPEATS; ++i)
+				tree.revert();
+		}
+		{
+			BenchmarkTimer timer("300 levels deep, apply", REPEATS);
+			for (int i = 0; i < REPEATS; ++i)
+				tree.apply();
+		}
+	}
+}
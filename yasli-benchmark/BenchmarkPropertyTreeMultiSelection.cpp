@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include "Benchmark.h"
+#include "HeadlessPropertyTree.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Transform
+{
+	float position[3];
+	float rotation[4];
+	float scale;
+
+	void serialize(Archive& ar)
+	{
+		ar(position, "position", "Position");
+		ar(rotation, "rotation", "Rotation");
+		ar(scale, "scale", "Scale");
+	}
+};
+
+struct Entity
+{
+	std::string name;
+	Transform transform;
+	int layer;
+	bool visible;
+	std::vector<std::string> tags;
+
+	void serialize(Archive& ar)
+	{
+		ar(name, "name", "Name");
+		ar(transform, "transform", "Transform");
+		ar(layer, "layer", "Layer");
+		ar(visible, "visible", "Visible");
+		ar(tags, "tags", "Tags");
+	}
+};
+
+const int REVERTS = 5;
+
+// Attaches objects as a multi-selection in inspector does, all objects have
+// the same layout and most values are equal.
+void selectEntities(int count, bool parallel)
+{
+	std::vector<Entity> entities(count);
+	Serializers serializers;
+	char name[32];
+	for (int i = 0; i < count; ++i) {
+		Entity& e = entities[i];
+		sprintf(name, "entity%d", i);
+		e.name = name;
+		for (int j = 0; j < 3; ++j)
+			e.transform.position[j] = float(i * j);
+		for (int j = 0; j < 4; ++j)
+			e.transform.rotation[j] = j == 3 ? 1.0f : 0.0f;
+		e.transform.scale = 1.0f;
+		e.layer = i % 4;
+		e.visible = true;
+		e.tags.push_back("static");
+		e.tags.push_back("prop");
+		serializers.push_back(Serializer(e));
+	}
+
+	HeadlessPropertyTree tree;
+	tree.setParallelRevert(parallel);
+	tree.attach(serializers);
+
+	char label[64];
+	sprintf(label, "%d objects, %s", count, parallel ? "parallel" : "sequential");
+	BenchmarkTimer timer(label, REVERTS);
+	for (int i = 0; i < REVERTS; ++i)
+		tree.revert();
+}
+
+}
+
+BENCHMARK(PropertyTreeMultiSelection)
+{
+	printf("  %d hardware threads\n", int(std::thread::hardware_concurrency()));
+	const int counts[] = { 10, 100, 1000 };
+	for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+		selectEntities(counts[i], false);
+		selectEntities(counts[i], true);
+	}
+}
@@ -0,0 +1,104 @@
+#include <vector>
+#include "Benchmark.h"
+#include "HeadlessPropertyTree.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Transform
+{
+	float position[3];
+	float rotation[3];
+	float scale[3];
+
+	void serialize(Archive& ar)
+	{
+		ar(position, "position", "Position");
+		ar(rotation[0], "yaw", "Yaw");
+		ar(rotation[1], "pitch", "Pitch");
+		ar(rotation[2], "roll", "Roll");
+		ar(scale[0], "scaleX", "Scale X");
+		ar(scale[1], "scaleY", "Scale Y");
+		ar(scale[2], "scaleZ", "Scale Z");
+	}
+};
+
+struct Entity
+{
+	int id;
+	bool enabled;
+	float health;
+	Transform transform;
+	unsigned int flags;
+
+	void serialize(Archive& ar)
+	{
+		ar(id, "id", "ID");
+		ar(enabled, "enabled", "Enabled");
+		ar(health, "health", "Health");
+		ar(transform, "transform", "Transform");
+		ar(flags, "flags", "Flags");
+	}
+};
+
+struct Scene
+{
+	std::vector<Entity> entities;
+
+	void serialize(Archive& ar)
+	{
+		ar(entities, "entities", "Entities");
+	}
+};
+
+const int ENTITY_COUNT = 4000;
+const int REVERTS = 20;
+
+void fill(Scene& scene)
+{
+	scene.entities.resize(ENTITY_COUNT);
+	for (int i = 0; i < ENTITY_COUNT; ++i) {
+		Entity& e = scene.entities[i];
+		e.id = i;
+		e.enabled = (i & 1) != 0;
+		e.health = 100.0f;
+		for (int j = 0; j < 3; ++j) {
+			e.transform.position[j] = float(i + j);
+			e.transform.rotation[j] = 0.0f;
+			e.transform.scale[j] = 1.0f;
+		}
+		e.flags = i;
+	}
+}
+
+// Edits one field between reverts, as happens after a change in inspector.
+void revertAfterEdit(const char* name, bool incremental)
+{
+	Scene scene;
+	fill(scene);
+
+	HeadlessPropertyTree tree;
+	tree.setIncrementalRevert(incremental);
+	tree.attach(Serializer(scene));
+	tree.expandAll();
+	tree.revert();
+
+	BenchmarkTimer timer(name, REVERTS);
+	for (int i = 0; i < REVERTS; ++i) {
+		scene.entities[(i * 97) % ENTITY_COUNT].health += 1.0f;
+		tree.revert();
+	}
+	benchmarkKeep(tree.contentHeight());
+}
+
+}
+
+BENCHMARK(PropertyTreeRevert)
+{
+	revertAfterEdit("4000 entities, full revert", false);
+	revertAfterEdit("4000 entities, incremental revert", true);
+}
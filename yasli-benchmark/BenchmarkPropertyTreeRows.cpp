@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <vector>
+#include "Benchmark.h"
+#include "HeadlessPropertyTree.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Vertex
+{
+	float x;
+	float y;
+	float z;
+	int index;
+	bool selected;
+
+	void serialize(Archive& ar)
+	{
+		ar(x, "x", "X");
+		ar(y, "y", "Y");
+		ar(z, "z", "Z");
+		ar(index, "index", "Index");
+		ar(selected, "selected", "Selected");
+	}
+};
+
+struct Mesh
+{
+	std::vector<Vertex> vertices;
+
+	void serialize(Archive& ar)
+	{
+		ar(vertices, "vertices", "Vertices");
+	}
+};
+
+struct RowCounter
+{
+	int rows;
+	size_t bytes;
+	int heights;
+
+	RowCounter() : rows(0), bytes(0), heights(0) {}
+
+	ScanResult operator()(PropertyRow* row, PropertyTree* tree, int index)
+	{
+		++rows;
+		bytes += row->memoryUsed();
+		heights += row->height();
+		return SCAN_CHILDREN_SIBLINGS;
+	}
+};
+
+// one million rows, six per vertex
+const int VERTEX_COUNT = 1000000 / 6;
+const int TRAVERSALS = 10;
+
+}
+
+BENCHMARK(PropertyTreeRows)
+{
+	Mesh mesh;
+	mesh.vertices.resize(VERTEX_COUNT);
+	for (int i = 0; i < VERTEX_COUNT; ++i) {
+		Vertex& v = mesh.vertices[i];
+		v.x = float(i);
+		v.y = 0.0f;
+		v.z = 1.0f;
+		v.index = i;
+		v.selected = false;
+	}
+
+	HeadlessPropertyTree tree(400, 800);
+	tree.setUndoEnabled(false);
+	{
+		BenchmarkTimer timer("build, attach", 1);
+		tree.attach(Serializer(mesh));
+	}
+	{
+		BenchmarkTimer timer("revert, rows are reused", 1);
+		tree.revert();
+	}
+	RowCounter counter;
+	{
+		BenchmarkTimer timer("traverse", TRAVERSALS);
+		for (int i = 0; i < TRAVERSALS; ++i) {
+			counter = RowCounter();
+			tree.model()->root()->scanChildren(counter, &tree);
+		}
+		benchmarkKeep(counter.heights);
+	}
+	printf("  %d rows, %.1f MB in rows, %.1f bytes per row\n", counter.rows,
+		   double(counter.bytes) / (1024.0 * 1024.0), double(counter.bytes) / counter.rows);
+	property_tree::RowPoolStatistics pool = property_tree::rowPoolStatistics();
+	printf("  row pool: %.1f MB in chunks, %.1f MB used by %d blocks, %.1f MB in %d large blocks\n",
+		   double(pool.chunkBytes) / (1024.0 * 1024.0), double(pool.usedBytes) / (1024.0 * 1024.0), int(pool.blockCount),
+		   double(pool.largeBytes) / (1024.0 * 1024.0), int(pool.largeCount));
+	{
+		BenchmarkTimer timer("destroy, detach", 1);
+		tree.detach();
+	}
+	{
+		BenchmarkTimer timer("build again", 1);
+		tree.attach(Serializer(mesh));
+	}
+}
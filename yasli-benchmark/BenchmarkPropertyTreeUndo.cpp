@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "Benchmark.h"
+#include "HeadlessPropertyTree.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Material
+{
+	std::string name;
+	float roughness;
+	float metallic;
+	int layer;
+	bool twoSided;
+
+	void serialize(Archive& ar)
+	{
+		ar(name, "name", "Name");
+		ar(roughness, "roughness", "Roughness");
+		ar(metallic, "metallic", "Metallic");
+		ar(layer, "layer", "Layer");
+		ar(twoSided, "twoSided", "Two Sided");
+	}
+};
+
+struct Library
+{
+	std::vector<Material> materials;
+
+	void serialize(Archive& ar)
+	{
+		ar(materials, "materials", "Materials");
+	}
+};
+
+const int MATERIAL_COUNT = 10000;
+const int EDITS = 50;
+
+void fill(Library& library)
+{
+	library.materials.resize(MATERIAL_COUNT);
+	char name[32];
+	for (int i = 0; i < MATERIAL_COUNT; ++i) {
+		Material& m = library.materials[i];
+		sprintf(name, "material%d", i);
+		m.name = name;
+		m.roughness = 0.5f;
+		m.metallic = 0.0f;
+		m.layer = i % 8;
+		m.twoSided = false;
+	}
+}
+
+// Edits one field at a time with full undo, as it happens when user tweaks
+// values in inspector. Snapshot is taken before each edit.
+void editSession(const char* name, bool undo, size_t budget)
+{
+	Library library;
+	fill(library);
+
+	HeadlessPropertyTree tree;
+	tree.setUndoEnabled(undo, true);
+	tree.setUndoMemoryBudget(budget);
+	tree.attach(Serializer(library));
+	PropertyTreeModel* model = tree.model();
+	PropertyRow* materials = model->root()->childByIndex(0);
+
+	{
+		BenchmarkTimer timer(name, EDITS);
+		for (int i = 0; i < EDITS; ++i) {
+			int index = (i * 379) % MATERIAL_COUNT;
+			model->rowAboutToBeChanged(materials->childByIndex(index));
+			library.materials[index].roughness += 0.01f;
+			tree.revert();
+			materials = model->root()->childByIndex(0);
+		}
+	}
+
+	if (!undo)
+		return;
+	int steps = model->undoStepCount();
+	size_t first = steps ? model->undoStepMemory(0) : 0;
+	size_t rest = model->undoMemoryUsed() - first;
+	printf("    %d steps, %d KB total, first step %d KB, others %d bytes per step\n",
+		   steps, int(model->undoMemoryUsed() / 1024), int(first / 1024), steps > 1 ? int(rest / (steps - 1)) : 0);
+}
+
+}
+
+BENCHMARK(PropertyTreeUndo)
+{
+	editSession("60000 rows, edit without undo", false, 0);
+	editSession("60000 rows, edit with full undo", true, 0);
+	// the first step holds the whole tree (11.6 MB), the rest of the budget
+	// fits 18 steps of 80 KB
+	editSession("60000 rows, edit with full undo, 13 MB budget", true, 13 * 1024 * 1024);
+}
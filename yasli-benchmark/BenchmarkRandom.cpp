@@ -0,0 +1,120 @@
+#include <math.h>
+#include <vector>
+#include "Benchmark.h"
+#include "XMath/xmath.h"
+#include "XMath/Random.h"
+
+namespace {
+
+const size_t COUNT = 16384;
+const int REPEATS = 500;
+const int BUCKETS = 256;
+
+// Chi-square of values in buckets, about BUCKETS - 1 for uniform values,
+// above 330 happens with probability below 0.1%.
+template<class Generator>
+double chiSquare(Generator& generator)
+{
+	std::vector<int> histogram(BUCKETS);
+	const int samples = BUCKETS * 1000;
+	for (int i = 0; i < samples; ++i)
+		++histogram[generator(BUCKETS)];
+	double expected = samples / double(BUCKETS);
+	double chi = 0.;
+	for (int i = 0; i < BUCKETS; ++i)
+		chi += (histogram[i] - expected) * (histogram[i] - expected) / expected;
+	return chi;
+}
+
+// correlation of neighbouring values of frand
+template<class Generator>
+double serialCorrelation(Generator& generator)
+{
+	const int samples = 1000000;
+	double previous = generator.frand();
+	double sum = 0., sumSquares = 0., sumProducts = 0.;
+	for (int i = 0; i < samples; ++i) {
+		double value = generator.frand();
+		sum += value;
+		sumSquares += value * value;
+		sumProducts += value * previous;
+		previous = value;
+	}
+	double mean = sum / samples;
+	return (sumProducts / samples - mean * mean) / (sumSquares / samples - mean * mean);
+}
+
+}
+
+BENCHMARK(Random)
+{
+	long long iterations = (long long)COUNT * REPEATS;
+	std::vector<unsigned> values(COUNT);
+	std::vector<float> floats(COUNT);
+
+	RandomGenerator generator;
+	{
+		BenchmarkTimer timer("RandomGenerator()", iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				values[j] = generator();
+	}
+	{
+		BenchmarkTimer timer("RandomGenerator(1000)", iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				values[j] = generator(1000);
+	}
+	{
+		BenchmarkTimer timer("RandomGenerator::frand", iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				floats[j] = generator.frand();
+	}
+
+	// Values are summed, as stores to an array of unsigned could change the
+	// state and it would be reloaded after each of them.
+	RandomStream stream(1);
+	unsigned sum = 0;
+	{
+		BenchmarkTimer timer("RandomStream::next32", iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				sum += stream.next32();
+	}
+	{
+		BenchmarkTimer timer("RandomStream::uniform(1000)", iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				sum += stream.uniform(1000);
+	}
+	{
+		BenchmarkTimer timer("RandomStream::frand", iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				floats[j] = stream.frand();
+	}
+	{
+		BenchmarkTimer timer("RandomStream::fill, unsigned", iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			stream.fill(&values[0], COUNT);
+	}
+	{
+		BenchmarkTimer timer("RandomStream::fill, float", iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			stream.fill(&floats[0], COUNT);
+	}
+	{
+		BenchmarkTimer timer("RandomStream::split", REPEATS);
+		for (int i = 0; i < REPEATS; ++i)
+			values[i % COUNT] = stream.split().next32();
+	}
+	benchmarkKeep(sum);
+	benchmarkKeep(values);
+	benchmarkKeep(floats);
+
+	RandomGenerator legacy;
+	RandomStream modern(1);
+	printf("  chi-square of %d buckets: RandomGenerator %.1f, RandomStream %.1f\n", BUCKETS, chiSquare(legacy), chiSquare(modern));
+	printf("  serial correlation: RandomGenerator %.5f, RandomStream %.5f\n", serialCorrelation(legacy), serialCorrelation(modern));
+}
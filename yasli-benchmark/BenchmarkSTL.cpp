@@ -0,0 +1,121 @@
+#include <map>
+#include <vector>
+#include <string>
+#include <stdio.h>
+#include "Benchmark.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+#include "yasli/BinArchive.h"
+#include "yasli/JSONOArchive.h"
+#include "yasli/JSONIArchive.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Entry
+{
+	std::string path;
+	int flags;
+	float weight;
+
+	Entry() : flags(0), weight(0.0f) {}
+
+	void serialize(Archive& ar)
+	{
+		ar(path, "path");
+		ar(flags, "flags");
+		ar(weight, "weight");
+	}
+};
+
+// Previous implementation of std::map serialization: the map was copied into
+// a vector of pairs and reinserted on load.
+template<class K, class V>
+struct MapThroughVector
+{
+	std::map<K, V>& map;
+	explicit MapThroughVector(std::map<K, V>& map) : map(map) {}
+
+	void serialize(Archive& ar)
+	{
+		std::vector<std::pair<K, V> > temp(map.begin(), map.end());
+		if (!ar(temp, "map"))
+			return;
+		map.clear();
+		map.insert(temp.begin(), temp.end());
+	}
+};
+
+template<class K, class V>
+struct MapInPlace
+{
+	std::map<K, V>& map;
+	explicit MapInPlace(std::map<K, V>& map) : map(map) {}
+
+	void serialize(Archive& ar)
+	{
+		ar(map, "map");
+	}
+};
+
+const int ENTRY_COUNT = 100000;
+
+const char* archiveBuffer(const BinOArchive& oa) { return oa.buffer(); }
+const char* archiveBuffer(const JSONOArchive& oa) { return oa.c_str(); }
+
+void makeMap(std::map<std::string, int>& map)
+{
+	char key[32];
+	for (int i = 0; i < ENTRY_COUNT; ++i) {
+		sprintf(key, "registry/entry_%06d", i);
+		map[key] = i;
+	}
+}
+
+void makeMap(std::map<std::string, Entry>& map)
+{
+	char key[32];
+	for (int i = 0; i < ENTRY_COUNT; ++i) {
+		sprintf(key, "registry/entry_%06d", i);
+		Entry& e = map[key];
+		e.path = key;
+		e.flags = i;
+		e.weight = float(i);
+	}
+}
+
+template<class OArchive, class IArchive, class V, template<class, class> class Adapter>
+void roundTrip(const char* name)
+{
+	std::map<std::string, V> map;
+	makeMap(map);
+
+	OArchive oa;
+	{
+		BenchmarkTimer timer(name, ENTRY_COUNT);
+		Adapter<std::string, V> adapter(map);
+		oa(adapter, "");
+		std::map<std::string, V> loaded;
+		Adapter<std::string, V> loadAdapter(loaded);
+		IArchive ia;
+		ia.open(archiveBuffer(oa), oa.length());
+		ia(loadAdapter, "");
+		benchmarkKeep(loaded.size());
+	}
+}
+
+}
+
+BENCHMARK(StdMapRoundTrip)
+{
+	roundTrip<BinOArchive, BinIArchive, int, MapThroughVector>("map<string, int> Bin, through vector");
+	roundTrip<BinOArchive, BinIArchive, int, MapInPlace>("map<string, int> Bin, in place");
+	roundTrip<BinOArchive, BinIArchive, Entry, MapThroughVector>("map<string, Entry> Bin, through vector");
+	roundTrip<BinOArchive, BinIArchive, Entry, MapInPlace>("map<string, Entry> Bin, in place");
+	roundTrip<JSONOArchive, JSONIArchive, int, MapThroughVector>("map<string, int> JSON, through vector");
+	roundTrip<JSONOArchive, JSONIArchive, int, MapInPlace>("map<string, int> JSON, in place");
+	roundTrip<JSONOArchive, JSONIArchive, Entry, MapThroughVector>("map<string, Entry> JSON, through vector");
+	roundTrip<JSONOArchive, JSONIArchive, Entry, MapInPlace>("map<string, Entry> JSON, in place");
+}
@@ -0,0 +1,127 @@
+#include <vector>
+#include <string>
+#include "Benchmark.h"
+#include "yasli/STL.h"
+#include "yasli/BinArchive.h"
+#include "yasli/StaticArchive.h"
+
+using namespace yasli;
+
+namespace {
+
+struct Vec3
+{
+	float x, y, z;
+
+	template<class TArchive>
+	void serialize(TArchive& ar)
+	{
+		ar(x, "x");
+		ar(y, "y");
+		ar(z, "z");
+	}
+};
+
+struct EntityState
+{
+	int id;
+	unsigned int flags;
+	Vec3 position;
+	Vec3 velocity;
+	std::vector<unsigned char> payload;
+
+	template<class TArchive>
+	void serialize(TArchive& ar)
+	{
+		ar(id, "id");
+		ar(flags, "flags");
+		ar(position, "position");
+		ar(velocity, "velocity");
+		ar(payload, "payload");
+	}
+};
+
+struct Snapshot
+{
+	std::vector<EntityState> entities;
+
+	template<class TArchive>
+	void serialize(TArchive& ar)
+	{
+		ar(entities, "entities");
+	}
+};
+
+void makeSnapshot(Snapshot& snapshot, int count)
+{
+	snapshot.entities.resize(count);
+	for (int i = 0; i < count; ++i) {
+		EntityState& e = snapshot.entities[i];
+		e.id = i;
+		e.flags = i * 3;
+		Vec3 p = { float(i), float(i) * 2.0f, float(i) * 3.0f };
+		e.position = p;
+		e.velocity = p;
+		e.payload.assign(8, (unsigned char)i);
+	}
+}
+
+const int ENTITY_COUNT = 20000;
+const int REPEATS = 20;
+
+}
+
+BENCHMARK(StaticArchiveSave)
+{
+	Snapshot snapshot;
+	makeSnapshot(snapshot, ENTITY_COUNT);
+
+	BinOArchive oa;
+	{
+		BenchmarkTimer timer("virtual BinOArchive, per entity", ENTITY_COUNT * REPEATS);
+		for (int i = 0; i < REPEATS; ++i) {
+			oa.clear();
+			oa(snapshot, "snapshot");
+		}
+	}
+	benchmarkKeep(oa.length());
+	{
+		BenchmarkTimer timer("StaticArchive<BinOArchive>, per entity", ENTITY_COUNT * REPEATS);
+		for (int i = 0; i < REPEATS; ++i) {
+			oa.clear();
+			StaticArchive<BinOArchive> sa(oa);
+			sa(snapshot, "snapshot");
+		}
+	}
+	benchmarkKeep(oa.length());
+}
+
+BENCHMARK(StaticArchiveLoad)
+{
+	Snapshot source;
+	makeSnapshot(source, ENTITY_COUNT);
+	BinOArchive oa;
+	oa(source, "snapshot");
+
+	{
+		BenchmarkTimer timer("virtual BinIArchive, per entity", ENTITY_COUNT * REPEATS);
+		for (int i = 0; i < REPEATS; ++i) {
+			Snapshot snapshot;
+			BinIArchive ia;
+			ia.open(oa);
+			ia(snapshot, "snapshot");
+			benchmarkKeep(snapshot.entities.size());
+		}
+	}
+	{
+		BenchmarkTimer timer("StaticArchive<BinIArchive>, per entity", ENTITY_COUNT * REPEATS);
+		for (int i = 0; i < REPEATS; ++i) {
+			Snapshot snapshot;
+			BinIArchive ia;
+			ia.open(oa);
+			StaticArchive<BinIArchive> sa(ia);
+			sa(snapshot, "snapshot");
+			benchmarkKeep(snapshot.entities.size());
+		}
+	}
+}
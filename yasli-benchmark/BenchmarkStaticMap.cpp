@@ -0,0 +1,97 @@
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include "Benchmark.h"
+#include "XMath/StaticMap.h"
+#include "XMath/Random.h"
+#include "yasli/BinArchive.h"
+#include "yasli/STL.h"
+
+namespace {
+
+typedef StaticMap<int, int> Map;
+typedef std::vector<std::pair<int, int> > Pairs;
+
+const int LOOKUPS = 1000000;
+// elements are inserted one by one only into maps up to this size, it takes O(n^2)
+const size_t INSERT_ONE_BY_ONE_MAX = 100000;
+// larger archives take too much memory
+const size_t LOAD_MAX = 1000000;
+
+void measure(size_t size)
+{
+	printf("  %d elements\n", int(size));
+	RandomStream random(size);
+	Pairs pairs(size);
+	for (size_t i = 0; i < size; ++i)
+		pairs[i] = std::make_pair(int(random.next32() >> 1), int(i));
+	char name[128];
+
+	if (size <= INSERT_ONE_BY_ONE_MAX) {
+		Map map;
+		BenchmarkTimer timer("insert one by one", size);
+		for (size_t i = 0; i < size; ++i)
+			map.insert(pairs[i]);
+	}
+
+	Map map;
+	{
+		BenchmarkTimer timer("append and sortUnique", size);
+		for (size_t i = 0; i < size; ++i)
+			map.append(pairs[i]);
+		map.sortUnique();
+	}
+	{
+		Pairs sorted(map.begin(), map.end());
+		Map copy;
+		BenchmarkTimer timer("insert sorted range", size);
+		copy.insert(sorted.begin(), sorted.end());
+	}
+
+	if (size <= LOAD_MAX) {
+		yasli::BinOArchive oa;
+		oa(map, "map");
+		Map loaded;
+		yasli::BinIArchive ia;
+		ia.open(oa.buffer(), oa.length());
+		BenchmarkTimer timer("BinIArchive load", size);
+		ia(loaded, "map");
+	}
+
+	std::vector<int> keys(LOOKUPS);
+	for (int i = 0; i < LOOKUPS; ++i)
+		keys[i] = i % 2 ? pairs[random.uniform(unsigned(size))].first : int(random.next32() >> 1);
+	long long sum = 0;
+	{
+		BenchmarkTimer timer("find, binary search", LOOKUPS);
+		for (int i = 0; i < LOOKUPS; ++i) {
+			Map::const_iterator it = map.find(keys[i]);
+			if (it != map.end())
+				sum += it->second;
+		}
+	}
+	{
+		BenchmarkTimer timer("buildSearchIndex", size);
+		map.buildSearchIndex();
+	}
+	long long indexedSum = 0;
+	{
+		BenchmarkTimer timer("find, search index", LOOKUPS);
+		for (int i = 0; i < LOOKUPS; ++i) {
+			Map::const_iterator it = map.find(keys[i]);
+			if (it != map.end())
+				indexedSum += it->second;
+		}
+	}
+	if (sum != indexedSum)
+		printf("  search index finds different elements\n");
+	benchmarkKeep(sum);
+}
+
+}
+
+BENCHMARK(StaticMap)
+{
+	for (size_t size = 10000; size <= 10000000; size *= 10)
+		measure(size);
+}
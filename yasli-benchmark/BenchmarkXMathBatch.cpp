@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include "Benchmark.h"
+#include "XMath/xmath.h"
+#include "XMath/XMathBatch.h"
+
+namespace {
+
+const size_t COUNT = 1024;
+const int REPEATS = 2000;
+
+float randomFloat()
+{
+	return float(rand()) / float(RAND_MAX) * 20.f - 10.f;
+}
+
+MatXf randomMatrix()
+{
+	MatXf m;
+	float* p = &m.R.xx;
+	for (int i = 0; i < 12; ++i)
+		p[i] = randomFloat();
+	return m;
+}
+
+// largest difference between results of batch and single methods, relative
+// to magnitude of the value
+float maxError(const float* result, const float* expected, size_t count)
+{
+	float error = 0.f;
+	for (size_t i = 0; i < count; ++i) {
+		float difference = fabsf(result[i] - expected[i]) / (fabsf(expected[i]) > 1.f ? fabsf(expected[i]) : 1.f);
+		if (!(difference <= error))
+			error = difference;
+	}
+	return error;
+}
+
+struct Data
+{
+	MatXf X;
+	QuatF q;
+	std::vector<Vect3f> points;
+	std::vector<Vect4f> points4;
+	std::vector<float> x, y, z;
+	std::vector<MatXf> matrices;
+
+	Data()
+	: X(randomMatrix())
+	, q(randomFloat(), Vect3f(randomFloat(), randomFloat(), randomFloat()))
+	, points(COUNT), points4(COUNT), x(COUNT), y(COUNT), z(COUNT), matrices(COUNT)
+	{
+		for (size_t i = 0; i < COUNT; ++i) {
+			points[i].set(randomFloat(), randomFloat(), randomFloat());
+			points4[i].set(points[i].x, points[i].y, points[i].z, i % 2 ? 1.f : 0.f);
+			x[i] = points[i].x;
+			y[i] = points[i].y;
+			z[i] = points[i].z;
+			matrices[i] = randomMatrix();
+		}
+	}
+};
+
+struct Results
+{
+	std::vector<Vect3f> points;
+	std::vector<Vect4f> points4;
+	std::vector<float> x, y, z;
+	std::vector<MatXf> matrices;
+
+	Results() : points(COUNT), points4(COUNT), x(COUNT), y(COUNT), z(COUNT), matrices(COUNT) {}
+};
+
+// results of single methods of Vect3f, MatXf and QuatF
+struct Expected
+{
+	std::vector<Vect3f> xformed, rotated, normalized;
+	std::vector<Vect4f> xformed4;
+	std::vector<MatXf> multiplied;
+
+	explicit Expected(const Data& data)
+	: xformed(COUNT), rotated(COUNT), normalized(COUNT), xformed4(COUNT), multiplied(COUNT)
+	{
+		for (size_t i = 0; i < COUNT; ++i) {
+			data.X.xformPoint(data.points[i], xformed[i]);
+			data.q.xform(data.points[i], rotated[i]);
+			normalized[i] = data.points[i];
+			normalized[i].normalize(1.f);
+			const Vect4f& p = data.points4[i];
+			Vect3f v(p.x, p.y, p.z);
+			if (p.w == 1.f)
+				data.X.xformPoint(v);
+			else
+				data.X.xformVect(v);
+			xformed4[i].set(v.x, v.y, v.z, p.w);
+			multiplied[i].mult(data.X, data.matrices[i]);
+		}
+	}
+};
+
+void measure(const char* setName, const Data& data, const Expected& expected)
+{
+	Results results;
+	char name[128];
+	long long iterations = (long long)COUNT * REPEATS;
+	Vect3fSoA soa(results.x.data(), results.y.data(), results.z.data());
+	Vect3fSoA source((float*)data.x.data(), (float*)data.y.data(), (float*)data.z.data());
+
+	sprintf(name, "xformPoints, Vect3f, %s", setName);
+	{
+		BenchmarkTimer timer(name, iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			xformPoints(data.X, data.points.data(), results.points.data(), COUNT);
+	}
+	printf("  %-48s max error %g\n", "", maxError(&results.points[0].x, &expected.xformed[0].x, COUNT * 3));
+
+	sprintf(name, "xformPoints, SoA, %s", setName);
+	{
+		BenchmarkTimer timer(name, iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			xformPoints(data.X, source, soa, COUNT);
+	}
+	for (size_t i = 0; i < COUNT; ++i)
+		results.points[i].set(results.x[i], results.y[i], results.z[i]);
+	printf("  %-48s max error %g\n", "", maxError(&results.points[0].x, &expected.xformed[0].x, COUNT * 3));
+
+	sprintf(name, "xformPoints, Vect4f, %s", setName);
+	{
+		BenchmarkTimer timer(name, iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			xformPoints(data.X, data.points4.data(), results.points4.data(), COUNT);
+	}
+	printf("  %-48s max error %g\n", "", maxError(&results.points4[0].x, &expected.xformed4[0].x, COUNT * 4));
+
+	sprintf(name, "multMatrices, %s", setName);
+	{
+		BenchmarkTimer timer(name, iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			multMatrices(data.X, data.matrices.data(), results.matrices.data(), COUNT);
+	}
+	printf("  %-48s max error %g\n", "", maxError(&results.matrices[0].R.xx, &expected.multiplied[0].R.xx, COUNT * 12));
+
+	sprintf(name, "rotateVects, Vect3f, %s", setName);
+	{
+		BenchmarkTimer timer(name, iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			rotateVects(data.q, data.points.data(), results.points.data(), COUNT);
+	}
+	printf("  %-48s max error %g\n", "", maxError(&results.points[0].x, &expected.rotated[0].x, COUNT * 3));
+
+	// normalized vectors stay normalized, so the same array is normalized again
+	sprintf(name, "normalizeVects, Vect3f, %s", setName);
+	results.points = data.points;
+	{
+		BenchmarkTimer timer(name, iterations);
+		for (int i = 0; i < REPEATS; ++i)
+			normalizeVects(results.points.data(), COUNT);
+	}
+	results.points = data.points;
+	normalizeVects(results.points.data(), COUNT);
+	printf("  %-48s max error %g\n", "", maxError(&results.points[0].x, &expected.normalized[0].x, COUNT * 3));
+	benchmarkKeep(results);
+}
+
+}
+
+BENCHMARK(XMathBatch)
+{
+	Data data;
+	Expected expected(data);
+
+	// loop of single methods, for comparison with the scalar batch
+	std::vector<Vect3f> result(COUNT);
+	{
+		BenchmarkTimer timer("MatXf::xformPoint loop", (long long)COUNT * REPEATS);
+		for (int i = 0; i < REPEATS; ++i)
+			for (size_t j = 0; j < COUNT; ++j)
+				data.X.xformPoint(data.points[j], result[j]);
+	}
+	benchmarkKeep(result);
+
+	static const char* names[] = { "scalar", "SSE", "AVX" };
+	for (int set = BATCH_SCALAR; set <= BATCH_AVX; ++set) {
+		if (setBatchInstructionSet(BatchInstructionSet(set)) != set) {
+			printf("  %s is not supported\n", names[set]);
+			continue;
+		}
+		measure(names[set], data, expected);
+	}
+	setBatchInstructionSet(BATCH_AVX);
+}
@@ -0,0 +1,91 @@
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "Benchmark.h"
+#include "yasli/BinArchive.h"
+#include "yasli/JSONOArchive.h"
+#include "yasli/JSONIArchive.h"
+#include "yasli/STL.h"
+#include "XMath/xmath.h"
+#include "XMath/XMathSoA.h"
+
+namespace {
+
+const size_t POINTS = 100000;
+const int BINARY_REPEATS = 20;
+const int TRANSFORM_REPEATS = 200;
+
+float randomFloat()
+{
+	return float(rand()) / float(RAND_MAX) * 20.f - 10.f;
+}
+
+template<class Points>
+void measureRoundTrip(const char* binaryName, const char* jsonName, Points& points)
+{
+	size_t length = 0;
+	{
+		BenchmarkTimer timer(binaryName, BINARY_REPEATS);
+		for (int i = 0; i < BINARY_REPEATS; ++i) {
+			yasli::BinOArchive oa;
+			oa(points, "points");
+			length = oa.length();
+			Points loaded;
+			yasli::BinIArchive ia;
+			ia.open(oa);
+			ia(loaded, "points");
+			benchmarkKeep(loaded);
+		}
+	}
+	printf("  %-48s %12zu bytes\n", "", length);
+	{
+		BenchmarkTimer timer(jsonName, 1);
+		yasli::JSONOArchive oa;
+		oa(points, "points");
+		length = strlen(oa.c_str());
+		Points loaded;
+		yasli::JSONIArchive ia;
+		ia.open(oa.c_str(), length);
+		ia(loaded, "points");
+		benchmarkKeep(loaded);
+	}
+	printf("  %-48s %12zu bytes\n", "", length);
+}
+
+}
+
+BENCHMARK(XMathSoA)
+{
+	std::vector<Vect3f> points(POINTS);
+	SoAVect3f soaPoints;
+	for (size_t i = 0; i < POINTS; ++i) {
+		points[i].set(randomFloat(), randomFloat(), randomFloat());
+		soaPoints.push_back(points[i]);
+	}
+
+	measureRoundTrip("std::vector<Vect3f>, binary round-trip", "std::vector<Vect3f>, JSON round-trip", points);
+	measureRoundTrip("SoAVect3f, binary round-trip", "SoAVect3f, JSON round-trip", soaPoints);
+
+	MatXf X(Mat3f(Vect3f(1.f, 2.f, 3.f), 0.3f), Vect3f(10.f, 20.f, 30.f));
+	std::vector<Vect3f> transformed(POINTS);
+	{
+		BenchmarkTimer timer("std::vector<Vect3f>, MatXf::xformPoint", (long long)POINTS * TRANSFORM_REPEATS);
+		for (int i = 0; i < TRANSFORM_REPEATS; ++i)
+			for (size_t j = 0; j < POINTS; ++j)
+				X.xformPoint(points[j], transformed[j]);
+	}
+	benchmarkKeep(transformed);
+	{
+		BenchmarkTimer timer("std::vector<Vect3f>, xformPoints", (long long)POINTS * TRANSFORM_REPEATS);
+		for (int i = 0; i < TRANSFORM_REPEATS; ++i)
+			xformPoints(X, points.data(), transformed.data(), POINTS);
+	}
+	benchmarkKeep(transformed);
+	SoAVect3f soaTransformed(POINTS);
+	{
+		BenchmarkTimer timer("SoAVect3f, xformPoints", (long long)POINTS * TRANSFORM_REPEATS);
+		for (int i = 0; i < TRANSFORM_REPEATS; ++i)
+			xformPoints(X, soaPoints.view(), soaTransformed.view(), POINTS);
+	}
+	benchmarkKeep(soaTransformed);
+}
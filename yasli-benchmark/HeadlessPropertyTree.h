@@ -0,0 +1,150 @@
+#pragma once
+
+#include <string.h>
+#include "PropertyTree/PropertyTree.h"
+#include "PropertyTree/PropertyTreeModel.h"
+#include "PropertyTree/PropertyRow.h"
+#include "PropertyTree/IUIFacade.h"
+#include "PropertyTree/IDrawContext.h"
+
+// PropertyTree that has no widget behind it, used to measure model and layout
+// code without Qt. Text is measured with a fixed width per character.
+class HeadlessUIFacade : public property_tree::IUIFacade
+{
+public:
+	property_tree::IMenu* createMenu() override { return 0; }
+	void setCursor(property_tree::Cursor cursor) override {}
+	void unsetCursor() override {}
+	Point cursorPosition() override { return Point(0, 0); }
+	int textWidth(const char* text, property_tree::Font font) override { return int(strlen(text)) * 7; }
+	Point screenSize() override { return Point(1920, 1080); }
+
+	property_tree::InplaceWidget* createComboBox(property_tree::ComboBoxClientRow* client) override { return 0; }
+	property_tree::InplaceWidget* createNumberWidget(PropertyRowNumberField* row) override { return 0; }
+	property_tree::InplaceWidget* createStringWidget(PropertyRowString* row) override { return 0; }
+};
+
+// Draw context that only counts drawn rows.
+class HeadlessDrawContext : public property_tree::IDrawContext
+{
+public:
+	int rows;
+
+	HeadlessDrawContext() : rows(0) {}
+
+	void drawControlButton(const Rect& rect, const char* text, int buttonFlags, property_tree::Font font) override {}
+	void drawButton(const Rect& rect, const char* text, int buttonFlags, property_tree::Font font) override {}
+	void drawCheck(const Rect& rect, bool disabled, property_tree::CheckState checked) override {}
+	void drawColor(const Rect& rect, const Color& color) override {}
+	void drawComboBox(const Rect& rect, const char* text) override {}
+	void drawEntry(const Rect& rect, const char* text, bool pathEllipsis, bool grayBackground, int trailingOffset) override {}
+	void drawRowLine(const Rect& rect) override {}
+	void drawHorizontalLine(const Rect& rect) override {}
+	void drawIcon(const Rect& rect, const yasli::IconXPM& icon) override {}
+	void drawLabel(const char* text, property_tree::Font font, const Rect& rect, bool selected) override {}
+	void drawNumberEntry(const char* text, const Rect& rect, bool selected, bool grayed) override {}
+	void drawPlus(const Rect& rect, bool expanded, bool selected, bool grayed) override {}
+	void drawSelection(const Rect& rect, bool inlinedRow) override {}
+	void drawValueText(bool highlighted, const char* text) override {}
+};
+
+class HeadlessPropertyTree : public PropertyTree
+{
+public:
+	explicit HeadlessPropertyTree(int width = 400, int height = 800)
+	: PropertyTree(new HeadlessUIFacade())
+	{
+		area_ = Rect(0, 0, width, height);
+	}
+
+	~HeadlessPropertyTree()
+	{
+		clearMenuHandlers();
+	}
+
+	bool _isDragged(const PropertyRow* row) const override { return false; }
+	bool hasFocusOrInplaceHasFocus() const override { return false; }
+	void repaint() override {}
+	void defocusInplaceEditor() override {}
+
+	// Same steps as QPropertyTree::updateHeights.
+	void updateHeights() override
+	{
+		int lb = compact_ ? 0 : 4;
+		int rb = area_.right() - lb - 2;
+		layoutRows(lb, rb);
+	}
+
+	int contentHeight() const { return size_.y(); }
+
+	// Same steps as QPropertyTree::onScroll.
+	void scrollTo(int offset)
+	{
+		offset_.setY(offset);
+		layoutVisibleRows();
+	}
+	int scrollOffset() const { return offset_.y(); }
+
+	// Same traversal as QPropertyTree::paintEvent, returns number of drawn rows.
+	int paint()
+	{
+		HeadlessDrawContext context;
+		context.tree = this;
+		DrawVisitor op(context, offset_.y(), area_.height());
+		model()->root()->scanPlacedChildren(op, this);
+		return context.rows;
+	}
+
+	using PropertyTree::rowByPoint;
+	using PropertyTree::matchFilter;
+	using PropertyTree::applyFilterResult;
+
+protected:
+	struct DrawVisitor
+	{
+		HeadlessDrawContext& context;
+		int top;
+		int height;
+		PropertyRow* lastParent;
+
+		DrawVisitor(HeadlessDrawContext& context, int top, int height) : context(context), top(top), height(height), lastParent(0) {}
+
+		ScanResult operator()(PropertyRow* row, PropertyTree* tree, int index)
+		{
+			if(row->visible(tree) && ((row->parent()->expanded() && !lastParent) || row->pulledUp())){
+				if(row->rect().top() > top + height)
+					lastParent = row->parent();
+				if(row->rect().bottom() > top && row->rect().width() > 0){
+					row->drawRow(context, tree, index, true);
+					row->drawRow(context, tree, index, false);
+					++context.rows;
+				}
+				return SCAN_CHILDREN_SIBLINGS;
+			}
+			return SCAN_SIBLINGS;
+		}
+	};
+
+	void onAboutToSerialize(yasli::Archive& ar) override {}
+	void onChanged() override {}
+	void onContinuousChange() override {}
+	void onSelected() override {}
+	void onReverted() override {}
+	void onPushUndo() override {}
+
+	void copyRow(PropertyRow* row) override {}
+	void pasteRow(PropertyRow* row) override {}
+	bool canBePasted(PropertyRow* destination) override { return false; }
+	bool canBePasted(const char* destinationType) override { return false; }
+
+	// benchmarks call flushPendingApply themselves, once per simulated frame
+	void schedulePendingApply() override {}
+	// and wait for background filter with applyFilterResult(true)
+	void scheduleFilterApply() override {}
+
+	bool updateScrollBar() override { return false; }
+	void interruptDrag() override {}
+	void _arrangeChildren() override {}
+	void startFilter(const char* text) override {}
+	void resetFilter() override {}
+};
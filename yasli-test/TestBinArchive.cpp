@@ -2,6 +2,7 @@
 
 #include "ComplexClass.h"
 #include "yasli/BinArchive.h"
+#include "yasli/StaticArchive.h"
 
 #ifndef _MSC_VER
 # include <wchar.h>
@@ -36,4 +37,183 @@ SUITE(BinArchive)
 			CHECK(memcmp(oa.buffer(), oa2.buffer(), oa.length()) == 0);
 		}
 	}
+
+	struct StaticMember
+	{
+		int id;
+		float weight;
+		std::string name;
+
+		StaticMember() : id(0), weight(0.0f) {}
+
+		template<class TArchive>
+		void YASLI_SERIALIZE_METHOD(TArchive& ar)
+		{
+			ar(id, "id");
+			ar(weight, "weight");
+			ar(name, "name");
+		}
+	};
+
+	struct StaticDocument
+	{
+		std::vector<StaticMember> members;
+		std::vector<unsigned char> bytes;
+		ComplexClass complex;
+
+		void change()
+		{
+			members.resize(300);
+			for(size_t i = 0; i < members.size(); ++i){
+				members[i].id = int(i);
+				members[i].weight = float(i) * 0.5f;
+				members[i].name = "member";
+			}
+			bytes.assign(1000, 0x7f);
+			complex.change();
+		}
+
+		template<class TArchive>
+		void YASLI_SERIALIZE_METHOD(TArchive& ar)
+		{
+			ar(members, "members");
+			ar(bytes, "");
+			ar(complex, "complex");
+		}
+	};
+
+	TEST(StaticArchiveMatchesVirtual)
+	{
+		StaticDocument doc;
+		doc.change();
+
+		BinOArchive oa;
+		CHECK(oa(doc, "doc"));
+
+		BinOArchive staticOA;
+		StaticArchive<BinOArchive> sa(staticOA);
+		CHECK(sa(doc, "doc"));
+
+		CHECK(oa.length() == staticOA.length());
+		CHECK(memcmp(oa.buffer(), staticOA.buffer(), oa.length()) == 0);
+
+		StaticDocument loaded;
+		BinIArchive ia;
+		CHECK(ia.open(staticOA));
+		StaticArchive<BinIArchive> sia(ia);
+		CHECK(sia(loaded, "doc"));
+
+		CHECK(loaded.members.size() == doc.members.size());
+		CHECK(loaded.members[299].id == 299);
+		CHECK(loaded.members[299].weight == doc.members[299].weight);
+		CHECK(loaded.members[299].name == doc.members[299].name);
+		CHECK(loaded.bytes == doc.bytes);
+		loaded.complex.checkEquality(doc.complex);
+	}
+
+	TEST(StdMapFormatMatchesVectorOfPairs)
+	{
+		std::map<string, Member> map;
+		std::vector<std::pair<string, Member> > vector;
+		for(int i = 0; i < 300; ++i){
+			char key[16];
+			sprintf(key, "key%03d", i);
+			map[key].change(i);
+			vector.push_back(std::make_pair(string(key), map[key]));
+		}
+
+		BinOArchive oaMap;
+		CHECK(oaMap(map, "map"));
+		BinOArchive oaVector;
+		CHECK(oaVector(vector, "map"));
+		CHECK(oaMap.length() == oaVector.length());
+		CHECK(memcmp(oaMap.buffer(), oaVector.buffer(), oaMap.length()) == 0);
+
+		std::map<string, Member> loaded;
+		loaded["stale"].change(1);
+		BinIArchive ia;
+		CHECK(ia.open(oaVector));
+		CHECK(ia(loaded, "map"));
+		CHECK_EQUAL(map.size(), loaded.size());
+		CHECK(loaded.find("stale") == loaded.end());
+		loaded["key123"].checkEquality(map["key123"]);
+	}
+
+	TEST(StdAssociativeContainers)
+	{
+		std::multimap<int, string> multimap;
+		multimap.insert(std::make_pair(1, string("a")));
+		multimap.insert(std::make_pair(1, string("b")));
+		multimap.insert(std::make_pair(2, string("c")));
+		std::set<string> set;
+		set.insert("x");
+		set.insert("y");
+		std::multiset<int> multiset;
+		multiset.insert(3);
+		multiset.insert(3);
+		std::unordered_map<string, int> unorderedMap;
+		unorderedMap["one"] = 1;
+		unorderedMap["two"] = 2;
+		std::unordered_set<int> unorderedSet;
+		for(int i = 0; i < 100; ++i)
+			unorderedSet.insert(i * 7);
+
+		BinOArchive oa;
+		CHECK(oa(multimap, "multimap"));
+		CHECK(oa(set, "set"));
+		CHECK(oa(multiset, "multiset"));
+		CHECK(oa(unorderedMap, "unorderedMap"));
+		CHECK(oa(unorderedSet, ""));
+
+		std::multimap<int, string> multimap2;
+		std::set<string> set2;
+		set2.insert("stale");
+		std::multiset<int> multiset2;
+		std::unordered_map<string, int> unorderedMap2;
+		std::unordered_set<int> unorderedSet2;
+
+		BinIArchive ia;
+		CHECK(ia.open(oa));
+		CHECK(ia(multimap2, "multimap"));
+		CHECK(ia(set2, "set"));
+		CHECK(ia(multiset2, "multiset"));
+		CHECK(ia(unorderedMap2, "unorderedMap"));
+		CHECK(ia(unorderedSet2, ""));
+
+		CHECK(multimap == multimap2);
+		CHECK(set == set2);
+		CHECK(multiset == multiset2);
+		CHECK(unorderedMap == unorderedMap2);
+		CHECK(unorderedSet == unorderedSet2);
+	}
+
+	TEST(StdSequenceContainers)
+	{
+		std::deque<Member> deque(100);
+		for(size_t i = 0; i < deque.size(); ++i)
+			deque[i].change(int(i));
+		std::list<int> list;
+		for(int i = 0; i < 300; ++i)
+			list.push_back(i);
+		std::array<float, 4> array = {{ 1.0f, 2.0f, 3.0f, 4.0f }};
+
+		BinOArchive oa;
+		CHECK(oa(deque, "deque"));
+		CHECK(oa(list, "list"));
+		CHECK(oa(array, "array"));
+
+		std::deque<Member> deque2(200);
+		std::list<int> list2(5, -1);
+		std::array<float, 4> array2 = {{ 0.0f, 0.0f, 0.0f, 0.0f }};
+		BinIArchive ia;
+		CHECK(ia.open(oa));
+		CHECK(ia(deque2, "deque"));
+		CHECK(ia(list2, "list"));
+		CHECK(ia(array2, "array"));
+
+		CHECK_EQUAL(deque.size(), deque2.size());
+		deque2[99].checkEquality(deque[99]);
+		CHECK(list == list2);
+		CHECK(array == array2);
+	}
 }
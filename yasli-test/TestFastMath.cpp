@@ -0,0 +1,168 @@
+#include "UnitTest++.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <float.h>
+#include <vector>
+#include "XMath/XMathBatch.h"
+#include "XMath/fastMath.h"
+
+using std::vector;
+
+namespace {
+
+// not a multiple of register width, so the rest is done by scalar code
+const size_t COUNT = 1027;
+
+// number of floats that differ from expected ones, bit to bit
+int mismatches(const float* values, const float* expected, size_t count)
+{
+	int result = 0;
+	for (size_t i = 0; i < count; ++i)
+		if (memcmp(&values[i], &expected[i], sizeof(float)) != 0)
+			++result;
+	return result;
+}
+
+// in [0, 1)
+double randomUnit()
+{
+	return double(rand()) / (double(RAND_MAX) + 1.);
+}
+
+// largest error of approximation of function over values, relative or absolute
+typedef float (*Approximation)(float);
+double maxError(Approximation approximation, double (*exact)(double), const vector<float>& values, bool relative)
+{
+	double result = 0.;
+	for (size_t i = 0; i < values.size(); ++i) {
+		double expected = exact(values[i]);
+		double error = fabs(approximation(values[i]) - expected);
+		if (relative)
+			error /= fabs(expected);
+		if (!(error <= result))
+			result = error;
+	}
+	return result;
+}
+
+// mantissas in [1, 2) with exponents in [minExponent, maxExponent]
+vector<float> normalValues(int minExponent, int maxExponent, bool negative)
+{
+	vector<float> values;
+	for (int e = minExponent; e <= maxExponent; ++e)
+		for (int i = 0; i < 64; ++i) {
+			float x = ldexpf(1.f + float(randomUnit()), e);
+			values.push_back(negative && i % 2 ? -x : x);
+		}
+	return values;
+}
+
+vector<float> uniformValues(float min, float max, int count)
+{
+	vector<float> values(count);
+	for (int i = 0; i < count; ++i)
+		values[i] = float(min + (max - min) * randomUnit());
+	values.push_back(min);
+	return values;
+}
+
+double invSqrtExact(double x) { return 1. / sqrt(x); }
+double rcpExact(double x) { return 1. / x; }
+
+}
+
+SUITE(FastMath)
+{
+	TEST(BatchApproximationsMatchScalar)
+	{
+		srand(47);
+		vector<float> x = uniformValues(-100.f, 100.f, int(COUNT));
+		vector<float> y = uniformValues(-100.f, 100.f, int(COUNT));
+		vector<float> unit = uniformValues(-1.f, 1.f, int(COUNT));
+		vector<float> positive = uniformValues(1e-3f, 1e3f, int(COUNT));
+		size_t count = x.size();
+		vector<float> expected(count), result(count);
+
+		for (int set = BATCH_SCALAR; set <= BATCH_AVX; ++set) {
+			if (setBatchInstructionSet(BatchInstructionSet(set)) != set)
+				continue;
+
+			for (size_t i = 0; i < count; ++i) expected[i] = invSqrtApprox(positive[i]);
+			invSqrtApprox(&positive[0], &result[0], count);
+			CHECK_EQUAL(0, mismatches(&result[0], &expected[0], count));
+
+			for (size_t i = 0; i < count; ++i) expected[i] = rcpApprox(x[i]);
+			rcpApprox(&x[0], &result[0], count);
+			CHECK_EQUAL(0, mismatches(&result[0], &expected[0], count));
+
+			for (size_t i = 0; i < count; ++i) expected[i] = sinApprox(x[i]);
+			sinApprox(&x[0], &result[0], count);
+			CHECK_EQUAL(0, mismatches(&result[0], &expected[0], count));
+
+			for (size_t i = 0; i < count; ++i) expected[i] = cosApprox(x[i]);
+			cosApprox(&x[0], &result[0], count);
+			CHECK_EQUAL(0, mismatches(&result[0], &expected[0], count));
+
+			for (size_t i = 0; i < count; ++i) expected[i] = acosApprox(unit[i]);
+			acosApprox(&unit[0], &result[0], count);
+			CHECK_EQUAL(0, mismatches(&result[0], &expected[0], count));
+
+			for (size_t i = 0; i < count; ++i) expected[i] = expApprox(x[i]);
+			expApprox(&x[0], &result[0], count);
+			CHECK_EQUAL(0, mismatches(&result[0], &expected[0], count));
+
+			for (size_t i = 0; i < count; ++i) expected[i] = logApprox(positive[i]);
+			logApprox(&positive[0], &result[0], count);
+			CHECK_EQUAL(0, mismatches(&result[0], &expected[0], count));
+
+			for (size_t i = 0; i < count; ++i) expected[i] = atan2Approx(y[i], x[i]);
+			atan2Approx(&y[0], &x[0], &result[0], count);
+			CHECK_EQUAL(0, mismatches(&result[0], &expected[0], count));
+		}
+		setBatchInstructionSet(BATCH_AVX);
+	}
+
+	// bounds are the ones listed in fastMath.h
+	TEST(ApproximationErrorBounds)
+	{
+		srand(48);
+
+		CHECK(maxError(invSqrtApprox, invSqrtExact, normalValues(-126, 127, false), true) <= 2.5e-7);
+		CHECK(maxError(rcpApprox, rcpExact, normalValues(-124, 124, true), true) <= 2.0e-7);
+
+		vector<float> angles = uniformValues(-8191.f, 8191.f, 100000);
+		vector<float> small = uniformValues(-7.f, 7.f, 100000);
+		angles.insert(angles.end(), small.begin(), small.end());
+		CHECK(maxError(sinApprox, sin, angles, false) <= 9.4e-8);
+		CHECK(maxError(cosApprox, cos, angles, false) <= 9.4e-8);
+
+		vector<float> unit = uniformValues(-1.f, 1.f, 100000);
+		unit.push_back(1.f);
+		CHECK(maxError(acosApprox, acos, unit, false) <= 2.9e-7);
+
+		vector<float> exponents = uniformValues(-87.3f, 88.7f, 100000);
+		CHECK(maxError(expApprox, exp, exponents, true) <= 2.4e-7);
+		CHECK_EQUAL(0.f, expApprox(-100.f));
+		CHECK(expApprox(100.f) > FLT_MAX);
+
+		CHECK(maxError(logApprox, log, normalValues(-126, 127, false), true) <= 7.9e-8);
+		CHECK(maxError(logApprox, log, uniformValues(0.5f, 2.f, 100000), false) <= 4e-8);
+
+		double atan2Error = 0.;
+		vector<float> x = uniformValues(-1000.f, 1000.f, 100000);
+		vector<float> y = uniformValues(-1000.f, 1000.f, 100000);
+		x.push_back(0.f); y.push_back(1.f);
+		x.push_back(0.f); y.push_back(-1.f);
+		x.push_back(-1.f); y.push_back(0.f);
+		for (size_t i = 0; i < x.size(); ++i) {
+			double error = fabs(atan2Approx(y[i], x[i]) - atan2(double(y[i]), double(x[i])));
+			if (!(error <= atan2Error))
+				atan2Error = error;
+		}
+		CHECK(atan2Error <= 2.7e-7);
+		CHECK_EQUAL(0.f, atan2Approx(0.f, 0.f));
+	}
+}
+
@@ -2,9 +2,19 @@
 // We need this for CheckUtf8Conversion test.
 #include "UnitTest++.h"
 #include <vector>
+#include <deque>
+#include <list>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 #include "ComplexClass.h"
+#include "yasli/BinArchive.h"
 
 #ifndef _MSC_VER
 # include <wchar.h>
@@ -53,6 +63,72 @@ SUITE(General)
 		CHECK(b != 0);
 	}
 
+	TEST(ContextLookup)
+	{
+		int a = 1;
+		int b = 2;
+		float f = 3.0f;
+		BinOArchive ar;
+		CHECK(ar.context<int>() == 0);
+		{
+			Context contextA(ar, &a);
+			CHECK(ar.context<int>() == &a);
+			{
+				Context contextF(ar, &f);
+				{
+					Context contextB(ar, &b);
+					CHECK(ar.context<int>() == &b);
+					CHECK(ar.context<float>() == &f);
+				}
+				CHECK(ar.context<int>() == &a);
+			}
+			CHECK(ar.context<float>() == 0);
+
+			BinOArchive nested;
+			nested.setLastContext(ar.lastContext());
+			CHECK(nested.context<int>() == &a);
+			{
+				Context contextB(nested, &b);
+				CHECK(nested.context<int>() == &b);
+				CHECK(ar.context<int>() == &a);
+			}
+			CHECK(nested.context<int>() == &a);
+		}
+		CHECK(ar.context<int>() == 0);
+	}
+
+	template<int Index> struct ContextType { int value; };
+
+	// Uses more context types than YASLI_CONTEXT_SLOTS to cover fallback lookup.
+	template<int Index>
+	struct PushContexts
+	{
+		static void run(Archive& ar, int& found)
+		{
+			ContextType<Index> value;
+			CHECK(ar.context<ContextType<Index> >() == 0);
+			Context context(ar, &value);
+			found += ar.context<ContextType<Index> >() == &value;
+			PushContexts<Index - 1>::run(ar, found);
+			found += ar.context<ContextType<Index> >() == &value;
+		}
+	};
+
+	template<>
+	struct PushContexts<0>
+	{
+		static void run(Archive& ar, int& found) {}
+	};
+
+	TEST(ContextLookupManyTypes)
+	{
+		BinOArchive ar;
+		int found = 0;
+		PushContexts<YASLI_CONTEXT_SLOTS + 8>::run(ar, found);
+		CHECK_EQUAL((YASLI_CONTEXT_SLOTS + 8) * 2, found);
+		CHECK(ar.lastContext() == 0);
+	}
+
 #if YASLI_NO_RTTI
 	TEST(TypeIDNameParsing)
 	{
@@ -63,6 +139,77 @@ SUITE(General)
 		CHECK_EQUAL("GlobalPrefix", string(TypeID::get<SGlobalPrefix>().name()));
 		CHECK_EQUAL("basic_string<char>", string(TypeID::get<string>().name()));
 	}
+
+	template<int Index> struct ConcurrentType {};
+
+	typedef TypeID (*TypeIDGetter)();
+
+	template<int Index>
+	void fillTypeIDGetters(TypeIDGetter* getters)
+	{
+		getters[Index - 1] = &TypeID::get<ConcurrentType<Index> >;
+		fillTypeIDGetters<Index - 1>(getters);
+	}
+
+	template<>
+	void fillTypeIDGetters<0>(TypeIDGetter* getters) {}
+
+	TEST(TypeIDConcurrentRegistration)
+	{
+		const int typeCount = 256;
+		const int threadCount = 8;
+		TypeIDGetter getters[typeCount];
+		fillTypeIDGetters<typeCount>(getters);
+
+		std::atomic<bool> start(false);
+		std::vector<std::vector<TypeID> > results(threadCount, std::vector<TypeID>(typeCount));
+		std::vector<std::thread> threads;
+		for(int t = 0; t < threadCount; ++t){
+			threads.push_back(std::thread([&, t](){
+				while(!start.load())
+					std::this_thread::yield();
+				// half of the threads walk types backwards to collide on the first use
+				for(int i = 0; i < typeCount; ++i){
+					int index = (t & 1) ? typeCount - 1 - i : i;
+					results[t][index] = getters[index]();
+				}
+			}));
+		}
+		start.store(true);
+		for(int t = 0; t < threadCount; ++t)
+			threads[t].join();
+
+		for(int i = 0; i < typeCount; ++i){
+			CHECK(results[0][i] != TypeID());
+			for(int t = 1; t < threadCount; ++t){
+				CHECK(results[t][i] == results[0][i]);
+				CHECK(!(results[t][i] != results[0][i]));
+			}
+		}
+
+		std::vector<TypeID> sorted = results[0];
+		std::sort(sorted.begin(), sorted.end());
+		for(int i = 1; i < typeCount; ++i)
+			CHECK(sorted[i - 1] != sorted[i]);
+		CHECK_EQUAL("ConcurrentType<1>", string(TypeID::get<ConcurrentType<1> >().name()));
+	}
 #endif
+
+	TEST(ContainerMethodDetection)
+	{
+		CHECK(Helpers::HasResize<std::vector<int> >::value);
+		CHECK(Helpers::HasResize<std::deque<string> >::value);
+		CHECK(Helpers::HasResize<std::list<int> >::value);
+		CHECK(!Helpers::HasResize<std::set<int> >::value);
+		CHECK(!Helpers::HasResize<int>::value);
+
+		CHECK(Helpers::HasReserve<std::vector<int> >::value);
+		typedef std::unordered_map<string, int> UnorderedMap;
+		typedef std::map<string, int> Map;
+		CHECK(Helpers::HasReserve<UnorderedMap>::value);
+		CHECK(Helpers::HasReserve<std::unordered_set<int> >::value);
+		CHECK(!Helpers::HasReserve<Map>::value);
+		CHECK(!Helpers::HasReserve<std::list<int> >::value);
+	}
 }
 
@@ -10,6 +10,7 @@
 #include <vector>
 #include <math.h>
 #include <float.h>
+#include <stdio.h>
 using std::vector;
 
 #ifndef _MSC_VER
@@ -140,6 +141,101 @@ SUITE(JSONArchive)
 		CHECK_EQUAL("value2", elements[1].second.value);
 	}
 
+	TEST(StdMapReplacesContentOnLoad)
+	{
+		std::map<string, SimpleElement> elements;
+		elements["el1"].value = "value1";
+		elements["el2"].value = "value2";
+		elements["el3"].value = "value3";
+
+		JSONOArchive oa;
+		oa(elements);
+
+		std::map<string, SimpleElement> loaded;
+		loaded["stale1"].value = "stale";
+		loaded["stale2"].value = "stale";
+		loaded["stale3"].value = "stale";
+		loaded["stale4"].value = "stale";
+		{
+			JSONIArchive ia;
+			CHECK(ia.open(oa.c_str(), oa.length()));
+			ia(loaded);
+		}
+		CHECK_EQUAL(3, loaded.size());
+		CHECK_EQUAL("value2", loaded["el2"].value);
+
+		std::set<int> emptySet;
+		JSONOArchive oaEmpty;
+		oaEmpty(emptySet);
+
+		std::set<int> set;
+		set.insert(1);
+		{
+			JSONIArchive ia;
+			CHECK(ia.open(oaEmpty.c_str(), oaEmpty.length()));
+			ia(set);
+		}
+		CHECK(set.empty());
+	}
+
+	TEST(StdAssociativeOutputMatchesVectors)
+	{
+		std::map<int, string> map;
+		std::vector<std::pair<int, string> > mapVector;
+		std::set<string> set;
+		std::vector<string> setVector;
+		for(int i = 0; i < 5; ++i){
+			char value[16];
+			sprintf(value, "value%d", i);
+			map[i * 3] = value;
+			mapVector.push_back(std::make_pair(i * 3, string(value)));
+			set.insert(value);
+			setVector.push_back(value);
+		}
+
+		JSONOArchive oaContainers;
+		oaContainers(map, "map");
+		oaContainers(set, "set");
+		JSONOArchive oaVectors;
+		oaVectors(mapVector, "map");
+		oaVectors(setVector, "set");
+		CHECK_EQUAL(string(oaVectors.c_str()), string(oaContainers.c_str()));
+
+		std::map<int, string> loadedMap;
+		std::set<string> loadedSet;
+		{
+			JSONIArchive ia;
+			CHECK(ia.open(oaContainers.c_str(), oaContainers.length()));
+			ia(loadedMap, "map");
+			ia(loadedSet, "set");
+		}
+		CHECK(loadedMap == map);
+		CHECK(loadedSet == set);
+	}
+
+	TEST(StdSequenceContainersResizeOnLoad)
+	{
+		std::deque<SimpleElement> elements(3);
+		elements[2].value = "value2";
+		std::list<int> list(2, 7);
+
+		JSONOArchive oa;
+		oa(elements, "elements");
+		oa(list, "list");
+
+		std::deque<SimpleElement> longer(10);
+		std::list<int> shorter;
+		{
+			JSONIArchive ia;
+			CHECK(ia.open(oa.c_str(), oa.length()));
+			ia(longer, "elements");
+			ia(shorter, "list");
+		}
+		CHECK_EQUAL(3, longer.size());
+		CHECK_EQUAL("value2", longer[2].value);
+		CHECK(shorter == list);
+	}
+
 	TEST(RegressionStdPairStringToInt)
 	{
 		const char* json =
@@ -0,0 +1,182 @@
+#include "UnitTest++.h"
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "XMath/MTSection.h"
+
+using std::vector;
+
+namespace {
+
+const int THREADS = 4;
+const int INCREMENTS = 2000;
+
+// Counter is not atomic, so lost increments show a broken lock. Lock is held
+// over yields, so that other threads find it taken even on one core.
+template<class Lock>
+void increment(Lock* lock, int* counter)
+{
+	for (int i = 0; i < INCREMENTS; ++i) {
+		lock->lock();
+		int value = *counter;
+		if (i % 16 == 0)
+			std::this_thread::yield();
+		*counter = value + 1;
+		lock->unlock();
+	}
+}
+
+// inner locks of the owner don't wait for the lock
+void incrementRecursive(MTSection* section, int* counter)
+{
+	for (int i = 0; i < INCREMENTS; ++i) {
+		MTAuto outer(*section);
+		int value = *counter;
+		if (i % 16 == 0)
+			std::this_thread::yield();
+		{
+			MTAuto inner(*section);
+			if (section->tryLock()) {
+				*counter = value + 1;
+				section->unlock();
+			}
+		}
+	}
+}
+
+template<class Lock, class Function>
+int contendedCount(Lock& lock, Function function)
+{
+	int counter = 0;
+	vector<std::thread*> threads;
+	for (int i = 0; i < THREADS; ++i)
+		threads.push_back(new std::thread(function, &lock, &counter));
+	for (int i = 0; i < THREADS; ++i) {
+		threads[i]->join();
+		delete threads[i];
+	}
+	return counter;
+}
+
+void tryLockSection(MTSection* section, std::atomic<int>* result)
+{
+	bool locked = section->tryLock();
+	if (locked)
+		section->unlock();
+	result->store(locked ? 1 : 0);
+}
+
+int tryLockFromOtherThread(MTSection& section)
+{
+	std::atomic<int> result(-1);
+	std::thread thread(tryLockSection, &section, &result);
+	thread.join();
+	return result.load();
+}
+
+struct ReadWriteState
+{
+	MTReadWriteSection section;
+	std::atomic<int> readers;
+	std::atomic<int> writers;
+	std::atomic<int> maxReaders;
+	std::atomic<int> violations;
+
+	ReadWriteState() : readers(0), writers(0), maxReaders(0), violations(0) {}
+};
+
+void reader(ReadWriteState* state)
+{
+	for (int i = 0; i < INCREMENTS; ++i) {
+		MTAutoRead lock(state->section);
+		int readers = ++state->readers;
+		if (state->writers.load())
+			++state->violations;
+		if (readers > state->maxReaders.load())
+			state->maxReaders.store(readers);
+		std::this_thread::yield();
+		--state->readers;
+	}
+}
+
+void writer(ReadWriteState* state)
+{
+	for (int i = 0; i < INCREMENTS / 10; ++i) {
+		MTAutoWrite lock(state->section);
+		int writers = ++state->writers;
+		if (writers != 1 || state->readers.load())
+			++state->violations;
+		std::this_thread::yield();
+		--state->writers;
+	}
+}
+
+}
+
+SUITE(MTSection)
+{
+	TEST(MutexExcludesThreads)
+	{
+		MTMutex mutex;
+		CHECK_EQUAL(THREADS * INCREMENTS, contendedCount(mutex, increment<MTMutex>));
+		MTLockStatistics statistics = mutex.statistics();
+		CHECK_EQUAL(THREADS * INCREMENTS, int(statistics.acquisitions));
+		CHECK(statistics.contentions > 0);
+
+		CHECK(mutex.tryLock());
+		CHECK(!mutex.tryLock());
+		mutex.unlock();
+	}
+
+	TEST(SectionExcludesThreads)
+	{
+		MTSection section;
+		CHECK_EQUAL(THREADS * INCREMENTS, contendedCount(section, increment<MTSection>));
+		CHECK(!section.locked());
+
+		// only the outermost lock takes the mutex
+		MTSection recursive;
+		CHECK_EQUAL(THREADS * INCREMENTS, contendedCount(recursive, incrementRecursive));
+		CHECK(!recursive.locked());
+		MTLockStatistics statistics = recursive.statistics();
+		CHECK_EQUAL(THREADS * INCREMENTS, int(statistics.acquisitions));
+		CHECK(statistics.contentions > 0);
+	}
+
+	TEST(SectionIsRecursive)
+	{
+		MTSection section;
+		section.lock();
+		section.lock();
+		CHECK(section.locked());
+		CHECK(section.tryLock());
+		CHECK_EQUAL(0, tryLockFromOtherThread(section));
+		section.unlock();
+		section.unlock();
+		CHECK(section.locked());
+		CHECK_EQUAL(0, tryLockFromOtherThread(section));
+		section.unlock();
+		CHECK(!section.locked());
+		CHECK_EQUAL(1, tryLockFromOtherThread(section));
+		CHECK(!section.locked());
+	}
+
+	TEST(ReadersExcludeWriters)
+	{
+		ReadWriteState state;
+		std::thread readers[THREADS - 1];
+		for (int i = 0; i < THREADS - 1; ++i)
+			readers[i] = std::thread(reader, &state);
+		std::thread writerThread(writer, &state);
+		for (int i = 0; i < THREADS - 1; ++i)
+			readers[i].join();
+		writerThread.join();
+
+		CHECK_EQUAL(0, state.violations.load());
+		// readers hold the lock together
+		CHECK(state.maxReaders.load() > 1);
+		MTLockStatistics statistics = state.section.statistics();
+		CHECK_EQUAL((THREADS - 1) * INCREMENTS + INCREMENTS / 10, int(statistics.acquisitions));
+	}
+}
@@ -0,0 +1,182 @@
+#include "UnitTest++.h"
+
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <atomic>
+#include "XMath/Profiler.h"
+#include "yasli/JSONOArchive.h"
+
+#ifdef start_timer_auto1
+
+using std::string;
+
+namespace {
+
+struct ProfilerReport
+{
+	void serialize(yasli::Archive& ar) { Profiler::instance().serializeAll(ar); }
+};
+
+string report()
+{
+	yasli::JSONOArchive oa;
+	ProfilerReport profilerReport;
+	oa(profilerReport, "");
+	return oa.c_str();
+}
+
+// text of timer or statistics in report, empty if it is not there
+string line(const string& text, const char* title)
+{
+	string key = string("\"") + title + "\": \"";
+	size_t begin = text.find(key);
+	if (begin == string::npos)
+		return string();
+	begin += key.size();
+	return text.substr(begin, text.find('"', begin) - begin);
+}
+
+int samples(const string& text, const char* title)
+{
+	string value = line(text, title);
+	size_t position = value.find("sampling: ");
+	return position != string::npos ? atoi(value.c_str() + position + 10) : -1;
+}
+
+double callsPerQuant(const string& text, const char* title)
+{
+	string value = line(text, title);
+	size_t position = value.find(" cps, ");
+	return position != string::npos ? atof(value.c_str() + position + 6) : -1.;
+}
+
+// timer is a block with its line and the blocks of its children
+bool nested(const string& text, const char* parent, const char* child)
+{
+	size_t begin = text.find(string("\"") + parent + "\": {");
+	if (begin == string::npos)
+		return false;
+	size_t end = text.find('{', begin);
+	for (int depth = 0; end < text.size(); ++end) {
+		if (text[end] == '{')
+			++depth;
+		else if (text[end] == '}' && !--depth)
+			break;
+	}
+	return text.find(string("\"") + child + "\"", begin + 1) < end;
+}
+
+void treeLeaf()
+{
+	start_timer_auto1(leaf);
+}
+
+void treeRoot()
+{
+	start_timer_auto1(root);
+	treeLeaf();
+	treeLeaf();
+	statistics_add(treeValue, 1.);
+}
+
+void workerScope()
+{
+	start_timer_auto1(work);
+	statistics_add(workerValue, 1.);
+}
+
+const int WORKER_CALLS = 4;
+
+// makes one call to workerScope for each request
+void worker(std::atomic<int>* requested, std::atomic<int>* done)
+{
+	for (int call = 1; call <= WORKER_CALLS; ++call) {
+		while (requested->load() < call)
+			std::this_thread::yield();
+		workerScope();
+		done->store(call);
+	}
+}
+
+void growingChild()
+{
+	start_timer_auto1(child);
+}
+
+void growingRoot(bool withChild)
+{
+	start_timer_auto1(root);
+	if (withChild)
+		growingChild();
+	statistics_add(growingValue, 1.);
+}
+
+}
+
+SUITE(Profiler)
+{
+	TEST(ReportHasTreeOfScopes)
+	{
+		Profiler::instance().setAutoMode(0, 0, "", "");
+		profiler_start_stop(PROFILER_REBUILD);
+		for (int i = 0; i < 10; ++i) {
+			treeRoot();
+			profiler_quant();
+		}
+		profiler_start_stop(PROFILER_REBUILD);
+
+		string text = report();
+		CHECK_CLOSE(1., callsPerQuant(text, "treeRoot root"), 1e-3);
+		CHECK_CLOSE(2., callsPerQuant(text, "treeLeaf leaf"), 1e-3);
+		CHECK_EQUAL(10, samples(text, "treeValue"));
+		CHECK(nested(text, "treeRoot root", "treeLeaf leaf"));
+		CHECK(!nested(text, "treeLeaf leaf", "treeRoot root"));
+	}
+
+	// Other threads publish their snapshots at the end of the first outermost
+	// scope after a quant, reports show the last published one.
+	TEST(SnapshotsOfOtherThread)
+	{
+		Profiler::instance().setAutoMode(0, 0, "", "");
+		profiler_start_stop(PROFILER_REBUILD);
+		std::atomic<int> requested(0);
+		std::atomic<int> done(0);
+		std::thread thread(worker, &requested, &done);
+		int expected[WORKER_CALLS] = { -1, 2, 2, 4 };
+		for (int call = 1; call <= WORKER_CALLS; ++call) {
+			if (call % 2 == 0)
+				profiler_quant();
+			requested.store(call);
+			while (done.load() < call)
+				std::this_thread::yield();
+			CHECK_EQUAL(expected[call - 1], samples(report(), "workerValue"));
+		}
+		thread.join();
+		profiler_start_stop(PROFILER_REBUILD);
+	}
+
+	TEST(TimersAddedAfterSnapshot)
+	{
+		Profiler::instance().setAutoMode(0, 0, "", "");
+		profiler_start_stop(PROFILER_REBUILD);
+		growingRoot(false);
+		profiler_quant();
+		growingRoot(false);
+		string text = report();
+		CHECK_EQUAL(2, samples(text, "growingValue"));
+		CHECK(line(text, "growingChild child").empty());
+
+		// the snapshot is filled again with one more timer
+		growingRoot(true);
+		profiler_quant();
+		growingRoot(true);
+		text = report();
+		CHECK_EQUAL(4, samples(text, "growingValue"));
+		CHECK(nested(text, "growingRoot root", "growingChild child"));
+		CHECK_CLOSE(1., callsPerQuant(text, "growingChild child"), 1e-3);
+		profiler_start_stop(PROFILER_REBUILD);
+	}
+}
+
+#endif
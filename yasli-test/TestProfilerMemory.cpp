@@ -0,0 +1,96 @@
+#include "UnitTest++.h"
+
+#include <string>
+#include "XMath/Profiler.h"
+#include "yasli/JSONOArchive.h"
+
+#ifdef start_timer_auto1
+
+using std::string;
+
+namespace {
+
+struct ProfilerReport
+{
+	void serialize(yasli::Archive& ar) { Profiler::instance().serializeAll(ar); }
+};
+
+// "size = , blocks = , operations = " line of timer in report
+string memoryLine(const char* title)
+{
+	yasli::JSONOArchive oa;
+	ProfilerReport profilerReport;
+	oa(profilerReport, "");
+	string text = oa.c_str();
+	string key = string("\"") + title + "\": \"";
+	size_t begin = text.find(key);
+	if (begin == string::npos)
+		return string();
+	begin += key.size();
+	return text.substr(begin, text.find('"', begin) - begin);
+}
+
+// operator new isn't replaced in tests, blocks are reported as custom
+// allocators would do
+void memoryInner()
+{
+	start_timer_auto1(inner);
+	AllocationData::allocated(100);
+}
+
+void memoryOuter()
+{
+	start_timer_auto1(outer);
+	AllocationData::allocated(16);
+	memoryInner();
+	AllocationData::allocated(32);
+	AllocationData::freed(16);
+	memoryInner();
+}
+
+bool trackedScope()
+{
+	start_timer_auto1(tracked);
+	return AllocationData::tracking();
+}
+
+}
+
+SUITE(ProfilerMemory)
+{
+	TEST(ScopesCountOwnAllocations)
+	{
+		Profiler::instance().setAutoMode(0, 0, "", "");
+		profiler_start_stop(PROFILER_MEMORY);
+		for (int i = 0; i < 3; ++i)
+			memoryOuter();
+		// outside of scopes
+		AllocationData::allocated(1000);
+		// stop returns to time mode, so report is made before
+		CHECK_EQUAL("size = 96, blocks = 3, operations = 9", memoryLine("memoryOuter outer"));
+		CHECK_EQUAL("size = 600, blocks = 6, operations = 6", memoryLine("memoryInner inner"));
+		profiler_start_stop(PROFILER_MEMORY);
+
+		// counters are cleared by next start
+		profiler_start_stop(PROFILER_MEMORY);
+		memoryInner();
+		CHECK_EQUAL("size = 100, blocks = 1, operations = 1", memoryLine("memoryInner inner"));
+		profiler_start_stop(PROFILER_MEMORY);
+	}
+
+	TEST(TrackingOnlyInMemoryMode)
+	{
+		Profiler::instance().setAutoMode(0, 0, "", "");
+		profiler_start_stop(PROFILER_MEMORY);
+		CHECK(!AllocationData::tracking());
+		CHECK(trackedScope());
+		CHECK(!AllocationData::tracking());
+		profiler_start_stop(PROFILER_MEMORY);
+
+		profiler_start_stop(PROFILER_REBUILD);
+		CHECK(!trackedScope());
+		profiler_start_stop(PROFILER_REBUILD);
+	}
+}
+
+#endif
@@ -0,0 +1,191 @@
+#include "UnitTest++.h"
+
+#include <string>
+#include <vector>
+#include <thread>
+#include "XMath/Profiler.h"
+#include "yasli/STL.h"
+#include "yasli/JSONIArchive.h"
+#include "yasli/JSONOArchive.h"
+
+#ifdef start_timer_auto1
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// fields of Chrome trace events that Profiler::serializeTrace writes
+struct TraceEvent
+{
+	string name;
+	string ph;
+	int tid;
+	double ts;
+	double dur;
+
+	TraceEvent() : tid(-1), ts(0.), dur(0.) {}
+
+	void serialize(yasli::Archive& ar)
+	{
+		ar(name, "name");
+		ar(ph, "ph");
+		ar(tid, "tid");
+		ar(ts, "ts");
+		ar(dur, "dur");
+	}
+};
+
+struct Trace
+{
+	vector<TraceEvent> traceEvents;
+
+	void serialize(yasli::Archive& ar)
+	{
+		ar(traceEvents, "traceEvents");
+	}
+
+	// complete events of thread that recorded title, all of them if title is null
+	vector<TraceEvent> events(const char* title) const
+	{
+		int thread = -1;
+		for (size_t i = 0; i < traceEvents.size(); ++i)
+			if (title && traceEvents[i].name == title)
+				thread = traceEvents[i].tid;
+		vector<TraceEvent> result;
+		for (size_t i = 0; i < traceEvents.size(); ++i)
+			if (traceEvents[i].ph == "X" && (!title || traceEvents[i].tid == thread))
+				result.push_back(traceEvents[i]);
+		return result;
+	}
+
+	bool hasThreadName(int thread) const
+	{
+		for (size_t i = 0; i < traceEvents.size(); ++i)
+			if (traceEvents[i].ph == "M" && traceEvents[i].name == "thread_name" && traceEvents[i].tid == thread)
+				return true;
+		return false;
+	}
+};
+
+Trace exportTrace()
+{
+	yasli::JSONOArchive oa;
+	Profiler::serializeTrace(oa);
+	string text = oa.c_str();
+	Trace trace;
+	yasli::JSONIArchive ia;
+	if (ia.open(text.c_str(), text.size()))
+		ia(trace, "");
+	return trace;
+}
+
+void traceInner()
+{
+	start_timer_auto1(inner);
+}
+
+void traceFirst()
+{
+	start_timer_auto1(first);
+	traceInner();
+}
+
+void traceLast()
+{
+	start_timer_auto1(last);
+	traceInner();
+}
+
+void traceRecursive(int depth)
+{
+	start_timer_auto1(recursive);
+	if (depth > 0)
+		traceRecursive(depth - 1);
+}
+
+void traceWorker()
+{
+	for (int i = 0; i < 10; ++i)
+		traceLast();
+}
+
+}
+
+SUITE(ProfilerTrace)
+{
+	TEST(RingKeepsNewestEvents)
+	{
+		Profiler::startTrace(16);
+		for (int i = 0; i < 50; ++i)
+			traceFirst();
+		// 16 events, inner scope of each pair is recorded first
+		for (int i = 0; i < 8; ++i)
+			traceLast();
+		Profiler::stopTrace();
+		traceLast();
+
+		// oldest slot of a full ring could be written over while exported, so it is dropped
+		vector<TraceEvent> events = exportTrace().events("traceLast last");
+		CHECK_EQUAL(15, int(events.size()));
+		int last = 0;
+		int inner = 0;
+		for (size_t i = 0; i < events.size(); ++i) {
+			last += events[i].name == "traceLast last";
+			inner += events[i].name == "traceInner inner";
+		}
+		CHECK_EQUAL(8, last);
+		CHECK_EQUAL(7, inner);
+	}
+
+	TEST(OuterScopesPrecedeNestedOnes)
+	{
+		Profiler::startTrace(256);
+		for (int i = 0; i < 10; ++i)
+			traceLast();
+		// only the outermost call of a recursive timer is recorded
+		traceRecursive(3);
+		Profiler::stopTrace();
+
+		vector<TraceEvent> events = exportTrace().events("traceLast last");
+		CHECK_EQUAL(21, int(events.size()));
+		int wrong = 0;
+		for (size_t i = 0; i < events.size(); ++i) {
+			wrong += events[i].dur < 0.;
+			if (i > 0)
+				wrong += events[i].ts < events[i - 1].ts;
+			if (events[i].name == "traceInner inner") {
+				const TraceEvent& outer = events[i - 1];
+				wrong += outer.name != "traceLast last";
+				wrong += outer.ts > events[i].ts || outer.ts + outer.dur < events[i].ts + events[i].dur;
+			}
+		}
+		CHECK_EQUAL(0, wrong);
+		CHECK_EQUAL("traceRecursive recursive", events.back().name);
+	}
+
+	TEST(ThreadsHaveOwnRings)
+	{
+		Profiler::startTrace(64);
+		std::thread thread(traceWorker);
+		thread.join();
+		traceFirst();
+		Profiler::stopTrace();
+
+		Trace trace = exportTrace();
+		vector<TraceEvent> own = trace.events("traceFirst first");
+		vector<TraceEvent> worker = trace.events("traceLast last");
+		CHECK_EQUAL(2, int(own.size()));
+		CHECK_EQUAL(20, int(worker.size()));
+		CHECK(own.front().tid != worker.front().tid);
+		CHECK(trace.hasThreadName(own.front().tid));
+		CHECK(trace.hasThreadName(worker.front().tid));
+
+		// events of previous recording are dropped
+		Profiler::startTrace(64);
+		Profiler::stopTrace();
+		CHECK_EQUAL(0, int(exportTrace().events(0).size()));
+	}
+}
+
+#endif
@@ -0,0 +1,162 @@
+#include "UnitTest++.h"
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "HeadlessPropertyTree.h"
+#include "yasli/STL.h"
+#include "yasli/Archive.h"
+#include "yasli/STLImpl.h"
+
+using std::vector;
+using namespace yasli;
+
+namespace {
+
+struct Item
+{
+	std::string name;
+	float value;
+	int layer;
+
+	void serialize(Archive& ar)
+	{
+		ar(name, "name", "Name");
+		ar(value, "value", "Value");
+		ar(layer, "layer", "Layer");
+	}
+};
+
+struct Items
+{
+	vector<Item> items;
+
+	void serialize(Archive& ar)
+	{
+		ar(items, "items", "Items");
+	}
+};
+
+const int ITEM_COUNT = 1000;
+const int EDITS = 20;
+
+struct UndoHistory
+{
+	size_t used;
+	vector<size_t> steps;
+	// values of the first edited item after all edits and after undo of all steps
+	float edited;
+	float undone;
+};
+
+// Edits one value at a time with full undo, as BenchmarkPropertyTreeUndo
+// does, budget is set before edits or after them.
+UndoHistory editSession(size_t budget, bool budgetAfterEdits)
+{
+	Items items;
+	items.items.resize(ITEM_COUNT);
+	char name[32];
+	for (int i = 0; i < ITEM_COUNT; ++i) {
+		sprintf(name, "item%d", i);
+		items.items[i].name = name;
+		items.items[i].value = 0.f;
+		items.items[i].layer = i % 8;
+	}
+
+	HeadlessPropertyTree tree;
+	tree.setUndoEnabled(true, true);
+	if (!budgetAfterEdits)
+		tree.setUndoMemoryBudget(budget);
+	tree.attach(Serializer(items));
+	PropertyTreeModel* model = tree.model();
+	for (int i = 0; i < EDITS; ++i) {
+		PropertyRow* row = model->root()->childByIndex(0)->childByIndex((i * 37 + 1) % ITEM_COUNT);
+		model->rowAboutToBeChanged(row);
+		// every edit changes item 0 too, so it shows how many steps undo goes back
+		items.items[0].value += 1.f;
+		items.items[(i * 37 + 1) % ITEM_COUNT].value += 0.5f;
+		tree.revert();
+	}
+	if (budgetAfterEdits)
+		tree.setUndoMemoryBudget(budget);
+
+	UndoHistory result;
+	result.used = model->undoMemoryUsed();
+	for (int i = 0; i < model->undoStepCount(); ++i)
+		result.steps.push_back(model->undoStepMemory(i));
+	result.edited = items.items[0].value;
+	while (model->canUndo()) {
+		model->undo();
+		tree.apply();
+	}
+	result.undone = items.items[0].value;
+	return result;
+}
+
+size_t sum(const vector<size_t>& values)
+{
+	size_t result = 0;
+	for (size_t i = 0; i < values.size(); ++i)
+		result += values[i];
+	return result;
+}
+
+// The oldest kept step holds the whole tree and every later step only the
+// rows it copied, so a history of k steps takes the first step of the full
+// history and the last k - 1 steps of it.
+size_t historySize(const vector<size_t>& full, int steps)
+{
+	size_t result = full[0];
+	for (int i = int(full.size()) - steps + 1; i < int(full.size()); ++i)
+		result += full[i];
+	return result;
+}
+
+}
+
+SUITE(PropertyTreeUndo)
+{
+	TEST(StepsShareRows)
+	{
+		UndoHistory full = editSession(0, false);
+		CHECK_EQUAL(EDITS, int(full.steps.size()));
+		CHECK_EQUAL(sum(full.steps), full.used);
+		// later steps copy the changed item and the children of the container
+		int large = 0;
+		for (size_t i = 1; i < full.steps.size(); ++i)
+			large += full.steps[i] * 10 > full.steps[0];
+		CHECK_EQUAL(0, large);
+		CHECK_EQUAL(float(EDITS), full.edited);
+		CHECK_EQUAL(0.f, full.undone);
+	}
+
+	TEST(BudgetKeepsNewestSteps)
+	{
+		UndoHistory full = editSession(0, false);
+		CHECK_EQUAL(EDITS, int(full.steps.size()));
+
+		for (int kept = 1; kept <= EDITS; kept += 3) {
+			// half a step more than kept steps take
+			size_t budget = historySize(full.steps, kept);
+			if (kept < EDITS)
+				budget += full.steps[EDITS - kept] / 2;
+			for (int after = 0; after < 2; ++after) {
+				UndoHistory trimmed = editSession(budget, after != 0);
+				CHECK_EQUAL(kept, int(trimmed.steps.size()));
+				CHECK_EQUAL(historySize(full.steps, kept), trimmed.used);
+				CHECK_EQUAL(sum(trimmed.steps), trimmed.used);
+				CHECK(trimmed.used <= budget);
+				CHECK_EQUAL(float(EDITS - kept), trimmed.undone);
+			}
+		}
+	}
+
+	TEST(NewestStepIsKept)
+	{
+		UndoHistory full = editSession(0, false);
+		UndoHistory trimmed = editSession(1, false);
+		CHECK_EQUAL(1, int(trimmed.steps.size()));
+		CHECK_EQUAL(full.steps[0], trimmed.used);
+		CHECK_EQUAL(float(EDITS - 1), trimmed.undone);
+	}
+}
@@ -0,0 +1,134 @@
+#include "UnitTest++.h"
+
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include "XMath/QuantileHistogram.h"
+#include "XMath/Random.h"
+#include "yasli/BinArchive.h"
+#include "yasli/JSONIArchive.h"
+#include "yasli/JSONOArchive.h"
+
+using std::vector;
+
+namespace {
+
+// error of a bucket value is at most half of a bucket: 1 / (2 * SUB_BUCKETS)
+const double RELATIVE_ERROR = 1. / (2 * QuantileHistogram::SUB_BUCKETS);
+
+const double LEVELS[] = { 0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 0.999 };
+
+// values over several orders of magnitude with a long tail
+vector<double> samples(RandomStream& random, size_t count)
+{
+	vector<double> values(count);
+	for (size_t i = 0; i < count; ++i)
+		values[i] = exp(10. * random.frand() - 3.) * (random.uniform(100) == 0 ? 100. : 1.);
+	return values;
+}
+
+double exactQuantile(vector<double> values, double q)
+{
+	std::sort(values.begin(), values.end());
+	size_t rank = size_t(ceil(q * values.size()));
+	return values[rank > 0 ? rank - 1 : 0];
+}
+
+// number of levels with error larger than the bound
+int wrongQuantiles(const QuantileHistogram& histogram, const vector<double>& values)
+{
+	int result = 0;
+	for (size_t i = 0; i < sizeof(LEVELS) / sizeof(LEVELS[0]); ++i) {
+		double exact = exactQuantile(values, LEVELS[i]);
+		if (fabs(histogram.quantile(LEVELS[i]) - exact) > exact * RELATIVE_ERROR)
+			++result;
+	}
+	return result;
+}
+
+}
+
+SUITE(QuantileHistogram)
+{
+	TEST(Quantiles)
+	{
+		RandomStream random(52);
+		vector<double> values = samples(random, 100000);
+		QuantileHistogram histogram;
+		for (size_t i = 0; i < values.size(); ++i)
+			histogram.add(values[i]);
+
+		CHECK_EQUAL(values.size(), size_t(histogram.count()));
+		CHECK_EQUAL(0, wrongQuantiles(histogram, values));
+		double minimum = *std::min_element(values.begin(), values.end());
+		double maximum = *std::max_element(values.begin(), values.end());
+		CHECK_EQUAL(minimum, histogram.minimum());
+		CHECK_EQUAL(maximum, histogram.maximum());
+		CHECK_EQUAL(minimum, histogram.quantile(0.));
+		CHECK_EQUAL(maximum, histogram.quantile(1.));
+	}
+
+	TEST(Zeros)
+	{
+		QuantileHistogram histogram;
+		CHECK_EQUAL(0., histogram.quantile(0.5));
+		for (int i = 0; i < 10; ++i)
+			histogram.add(0.);
+		for (int i = 0; i < 10; ++i)
+			histogram.add(3.);
+		CHECK_EQUAL(0., histogram.quantile(0.5));
+		CHECK_CLOSE(3., histogram.quantile(0.55), 3. * RELATIVE_ERROR);
+	}
+
+	TEST(Merge)
+	{
+		RandomStream random(53);
+		vector<double> first = samples(random, 20000);
+		vector<double> second = samples(random, 30000);
+		QuantileHistogram a, b;
+		for (size_t i = 0; i < first.size(); ++i)
+			a.add(first[i] * 1000.);
+		for (size_t i = 0; i < second.size(); ++i)
+			b.add(second[i]);
+		a.merge(b);
+
+		vector<double> all(second);
+		for (size_t i = 0; i < first.size(); ++i)
+			all.push_back(first[i] * 1000.);
+		CHECK_EQUAL(all.size(), size_t(a.count()));
+		CHECK_EQUAL(0, wrongQuantiles(a, all));
+		CHECK_EQUAL(*std::min_element(all.begin(), all.end()), a.minimum());
+		CHECK_EQUAL(*std::max_element(all.begin(), all.end()), a.maximum());
+	}
+
+	TEST(SaveAndLoad)
+	{
+		RandomStream random(54);
+		vector<double> values = samples(random, 10000);
+		QuantileHistogram histogram;
+		for (size_t i = 0; i < values.size(); ++i)
+			histogram.add(values[i]);
+
+		yasli::BinOArchive oa;
+		CHECK(oa(histogram, "histogram"));
+		QuantileHistogram binary;
+		yasli::BinIArchive ia;
+		CHECK(ia.open(oa.buffer(), oa.length()));
+		CHECK(ia(binary, "histogram"));
+
+		yasli::JSONOArchive joa;
+		CHECK(joa(histogram, "histogram"));
+		std::string text = joa.c_str();
+		QuantileHistogram loaded;
+		yasli::JSONIArchive jia;
+		CHECK(jia.open(text.c_str(), text.size()));
+		CHECK(jia(loaded, "histogram"));
+
+		CHECK_EQUAL(histogram.count(), binary.count());
+		CHECK_EQUAL(histogram.count(), loaded.count());
+		for (size_t i = 0; i < sizeof(LEVELS) / sizeof(LEVELS[0]); ++i) {
+			CHECK_EQUAL(histogram.quantile(LEVELS[i]), binary.quantile(LEVELS[i]));
+			CHECK_EQUAL(histogram.quantile(LEVELS[i]), loaded.quantile(LEVELS[i]));
+		}
+	}
+}
@@ -0,0 +1,159 @@
+#include "UnitTest++.h"
+
+#include <vector>
+#include "XMath/Random.h"
+#include "yasli/BinArchive.h"
+
+using std::vector;
+
+namespace {
+
+// Values of the reference implementation of xoshiro128** by Blackman and
+// Vigna (prng.di.unimi.it) for state { 1, 2, 3, 4 }
+const unsigned REFERENCE_STATE[4] = { 1, 2, 3, 4 };
+const unsigned REFERENCE_VALUES[10] = { 11520u, 0u, 5927040u, 70819200u, 2031721883u, 1637235492u, 1287239034u, 3734860849u, 3729100597u, 4258142804u };
+const unsigned JUMP_STATE[4] = { 0xa9765206, 0x797aa168, 0x5b62e331, 0x02abd971 };
+const unsigned JUMP_VALUES[4] = { 1194304935u, 745561276u, 25819468u, 3320478005u };
+const unsigned LONG_JUMP_STATE[4] = { 0x6014af26, 0x7eb5a852, 0x399fbba1, 0xbe5ebfce };
+const unsigned LONG_JUMP_VALUES[4] = { 4148901660u, 60341234u, 3638978148u, 2927796021u };
+
+RandomStream referenceStream()
+{
+	RandomStream stream;
+	stream.setState(REFERENCE_STATE);
+	return stream;
+}
+
+bool hasState(const RandomStream& stream, const unsigned expected[4])
+{
+	unsigned state[4];
+	stream.getState(state);
+	return state[0] == expected[0] && state[1] == expected[1] && state[2] == expected[2] && state[3] == expected[3];
+}
+
+}
+
+SUITE(RandomStream)
+{
+	TEST(ReferenceSequence)
+	{
+		RandomStream stream = referenceStream();
+		for (int i = 0; i < 10; ++i)
+			CHECK_EQUAL(REFERENCE_VALUES[i], stream.next32());
+	}
+
+	TEST(Jumps)
+	{
+		RandomStream stream = referenceStream();
+		stream.jump();
+		CHECK(hasState(stream, JUMP_STATE));
+		for (int i = 0; i < 4; ++i)
+			CHECK_EQUAL(JUMP_VALUES[i], stream.next32());
+
+		stream = referenceStream();
+		stream.longJump();
+		CHECK(hasState(stream, LONG_JUMP_STATE));
+		for (int i = 0; i < 4; ++i)
+			CHECK_EQUAL(LONG_JUMP_VALUES[i], stream.next32());
+
+		// split returns the stream as it was and jumps
+		stream = referenceStream();
+		RandomStream part = stream.split();
+		CHECK(hasState(part, REFERENCE_STATE));
+		CHECK(hasState(stream, JUMP_STATE));
+	}
+
+	TEST(Seeds)
+	{
+		RandomStream a(12345);
+		RandomStream b(12345);
+		RandomStream c(12346);
+		int same = 0;
+		for (int i = 0; i < 100; ++i) {
+			unsigned value = a.next32();
+			CHECK_EQUAL(value, b.next32());
+			same += value == c.next32();
+		}
+		CHECK(same < 2);
+
+		// zero seed does not make zero state, which would give only zeros
+		RandomStream zero(0);
+		unsigned sum = 0;
+		for (int i = 0; i < 10; ++i)
+			sum |= zero.next32();
+		CHECK(sum != 0);
+	}
+
+	TEST(FillMatchesStreams)
+	{
+		// short arrays are filled by next32
+		RandomStream stream(7);
+		RandomStream expected(stream);
+		vector<unsigned> values(100);
+		stream.fill(&values[0], values.size());
+		for (size_t i = 0; i < values.size(); ++i)
+			CHECK_EQUAL(expected.next32(), values[i]);
+		CHECK_EQUAL(expected.next32(), stream.next32());
+
+		// long ones by four split streams, interleaved
+		values.resize(5003);
+		stream.fill(&values[0], values.size());
+		RandomStream streams[4];
+		for (int k = 0; k < 4; ++k)
+			streams[k] = expected.split();
+		int different = 0;
+		for (size_t i = 0; i < values.size(); ++i)
+			different += values[i] != streams[i % 4].next32();
+		CHECK_EQUAL(0, different);
+		CHECK_EQUAL(expected.next32(), stream.next32());
+
+		vector<float> floats(5003);
+		RandomStream floatStream(8);
+		RandomStream unsignedStream(floatStream);
+		floatStream.fill(&floats[0], floats.size(), -2.f, 6.f);
+		unsignedStream.fill(&values[0], values.size());
+		different = 0;
+		int outside = 0;
+		for (size_t i = 0; i < floats.size(); ++i) {
+			different += floats[i] != float(values[i] >> 8) * (8.f / 16777216.f) - 2.f;
+			outside += floats[i] < -2.f || floats[i] >= 6.f;
+		}
+		CHECK_EQUAL(0, different);
+		CHECK_EQUAL(0, outside);
+	}
+
+	TEST(Uniform)
+	{
+		RandomStream stream(9);
+		int counts[3] = { 0, 0, 0 };
+		int outside = 0;
+		for (int i = 0; i < 30000; ++i) {
+			unsigned value = stream.uniform(3);
+			if (value < 3)
+				++counts[value];
+			else
+				++outside;
+			int ranged = stream.uniform(-5, 5);
+			outside += ranged < -5 || ranged >= 5;
+			float f = stream.frand();
+			outside += f < 0.f || f >= 1.f;
+		}
+		CHECK_EQUAL(0, outside);
+		for (int i = 0; i < 3; ++i)
+			CHECK(counts[i] > 9500 && counts[i] < 10500);
+	}
+
+	TEST(SaveAndLoad)
+	{
+		RandomStream stream(10);
+		stream.next32();
+		yasli::BinOArchive oa;
+		CHECK(oa(stream, "stream"));
+		RandomStream loaded(11);
+		yasli::BinIArchive ia;
+		CHECK(ia.open(oa.buffer(), oa.length()));
+		CHECK(ia(loaded, "stream"));
+		for (int i = 0; i < 10; ++i)
+			CHECK_EQUAL(stream.next32(), loaded.next32());
+	}
+}
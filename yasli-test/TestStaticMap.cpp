@@ -0,0 +1,132 @@
+#include "UnitTest++.h"
+
+#include <vector>
+#include <algorithm>
+#include "XMath/StaticMap.h"
+#include "XMath/Random.h"
+
+using std::vector;
+
+namespace {
+
+typedef StaticMap<int, int> Map;
+
+// Even keys 0, 2, ... so that odd keys are missing ones. Values are the
+// positions of keys.
+void fillMap(Map& map, vector<int>& keys, int size, RandomStream& random)
+{
+	keys.clear();
+	for (int i = 0; i < size; ++i)
+		keys.push_back(i * 2);
+	vector<int> shuffled(keys);
+	std::random_shuffle(shuffled.begin(), shuffled.end(), random);
+	for (int i = 0; i < size; ++i)
+		map.append(std::make_pair(shuffled[i], shuffled[i] / 2));
+	map.sortUnique();
+}
+
+// number of lookups that differ from std::lower_bound over the sorted keys
+int wrongLookups(const Map& map, const vector<int>& keys)
+{
+	int result = 0;
+	int last = keys.empty() ? 0 : keys.back() + 2;
+	for (int key = -1; key <= last; ++key) {
+		int expected = int(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin());
+		bool present = expected < int(keys.size()) && keys[expected] == key;
+
+		Map::const_iterator lower = map.lower_bound(key);
+		Map::const_iterator found = map.find(key);
+		Map::const_iterator upper = map.upper_bound(key);
+		if (lower - map.begin() != expected)
+			++result;
+		if (present ? (found == map.end() || found->second != expected) : found != map.end())
+			++result;
+		if (upper - map.begin() != expected + (present ? 1 : 0))
+			++result;
+		if (map.count(key) != (present ? 1 : 0))
+			++result;
+	}
+	return result;
+}
+
+}
+
+SUITE(StaticMap)
+{
+	TEST(SearchIndexMatchesLowerBound)
+	{
+		RandomStream random(49);
+		// sizes around powers of two and complete trees of the index
+		static const int sizes[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 127, 128, 129, 255, 256, 1000, 1023, 1024, 1025, 4097 };
+		for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i) {
+			Map map;
+			vector<int> keys;
+			fillMap(map, keys, sizes[i], random);
+			CHECK_EQUAL(0, wrongLookups(map, keys));
+			map.buildSearchIndex();
+			CHECK_EQUAL(sizes[i] > 0, map.hasSearchIndex());
+			CHECK_EQUAL(0, wrongLookups(map, keys));
+		}
+	}
+
+	TEST(CopiesKeepSearchIndex)
+	{
+		RandomStream random(50);
+		for (int size = 1; size < 100; size += 7) {
+			Map map;
+			vector<int> keys;
+			fillMap(map, keys, size, random);
+			map.buildSearchIndex();
+
+			Map copy(map);
+			Map assigned;
+			assigned = map;
+			CHECK(copy.hasSearchIndex());
+			CHECK(assigned.hasSearchIndex());
+			map.clear();
+			CHECK(!map.hasSearchIndex());
+			CHECK_EQUAL(0, wrongLookups(copy, keys));
+			CHECK_EQUAL(0, wrongLookups(assigned, keys));
+		}
+	}
+
+	TEST(ChangesDropSearchIndex)
+	{
+		Map map;
+		vector<int> keys;
+		RandomStream random(51);
+		fillMap(map, keys, 50, random);
+		map.buildSearchIndex();
+		map.insert(std::make_pair(1, 100));
+		CHECK(!map.hasSearchIndex());
+		CHECK_EQUAL(100, map.find(1)->second);
+		map.buildSearchIndex();
+		map.erase(1);
+		CHECK(!map.hasSearchIndex());
+		CHECK(map.find(1) == map.end());
+	}
+
+	TEST(SortUniqueKeepsFirstElement)
+	{
+		Map map;
+		map.append(std::make_pair(3, 1));
+		map.append(std::make_pair(1, 2));
+		map.append(std::make_pair(3, 3));
+		map.append(std::make_pair(2, 4));
+		map.append(std::make_pair(1, 5));
+		map.sortUnique();
+		CHECK_EQUAL(3, int(map.size()));
+		CHECK_EQUAL(2, map.find(1)->second);
+		CHECK_EQUAL(4, map.find(2)->second);
+		CHECK_EQUAL(1, map.find(3)->second);
+
+		// elements of the range with keys in the map are skipped
+		vector<std::pair<int, int> > range;
+		range.push_back(std::make_pair(4, 6));
+		range.push_back(std::make_pair(2, 7));
+		map.insert(range.begin(), range.end());
+		CHECK_EQUAL(4, int(map.size()));
+		CHECK_EQUAL(4, map.find(2)->second);
+		CHECK_EQUAL(6, map.find(4)->second);
+	}
+}
@@ -0,0 +1,149 @@
+#include "UnitTest++.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "XMath/xmath.h"
+#include "XMath/XMathBatch.h"
+
+using std::vector;
+
+namespace {
+
+// not a multiple of register width, so the rest is done by scalar code
+const size_t COUNT = 1027;
+
+float randomFloat()
+{
+	return float(rand()) / float(RAND_MAX) * 20.f - 10.f;
+}
+
+Vect3f randomVect()
+{
+	return Vect3f(randomFloat(), randomFloat(), randomFloat());
+}
+
+MatXf randomMatrix()
+{
+	MatXf m;
+	float* p = &m.R.xx;
+	for (int i = 0; i < 12; ++i)
+		p[i] = randomFloat();
+	return m;
+}
+
+// number of floats that differ from expected ones, bit to bit
+int mismatches(const float* values, const float* expected, size_t count)
+{
+	int result = 0;
+	for (size_t i = 0; i < count; ++i)
+		if (memcmp(&values[i], &expected[i], sizeof(float)) != 0)
+			++result;
+	return result;
+}
+
+struct SoAVectors
+{
+	vector<float> x, y, z;
+
+	explicit SoAVectors(size_t count) : x(count), y(count), z(count) {}
+	explicit SoAVectors(const vector<Vect3f>& vects)
+	: x(vects.size()), y(vects.size()), z(vects.size())
+	{
+		for (size_t i = 0; i < vects.size(); ++i) {
+			x[i] = vects[i].x;
+			y[i] = vects[i].y;
+			z[i] = vects[i].z;
+		}
+	}
+	Vect3fSoA view() { return Vect3fSoA(&x[0], &y[0], &z[0]); }
+
+	vector<Vect3f> vects() const
+	{
+		vector<Vect3f> result(x.size());
+		for (size_t i = 0; i < x.size(); ++i)
+			result[i].set(x[i], y[i], z[i]);
+		return result;
+	}
+};
+
+float normalizeScale(const Vect3f& v, float r)
+{
+	return r * (1.f / sqrtf(v.x * v.x + v.y * v.y + v.z * v.z));
+}
+
+}
+
+SUITE(XMathBatch)
+{
+	TEST(BatchMatchesSingleMethods)
+	{
+		srand(45);
+		MatXf X = randomMatrix();
+		QuatF q(randomFloat(), randomVect());
+		vector<Vect3f> vects(COUNT);
+		vector<Vect4f> vects4(COUNT);
+		vector<MatXf> matrices(COUNT);
+		vector<MatXf> matrices2(COUNT);
+		for (size_t i = 0; i < COUNT; ++i) {
+			vects[i] = randomVect();
+			vects4[i].set(vects[i].x, vects[i].y, vects[i].z, i % 2 ? 1.f : 0.f);
+			matrices[i] = randomMatrix();
+			matrices2[i] = randomMatrix();
+		}
+
+		vector<Vect3f> points(COUNT), directions(COUNT), rotated(COUNT), normalized(COUNT);
+		vector<Vect4f> points4(COUNT);
+		vector<MatXf> products(COUNT), pairProducts(COUNT);
+		for (size_t i = 0; i < COUNT; ++i) {
+			X.xformPoint(vects[i], points[i]);
+			X.xformVect(vects[i], directions[i]);
+			q.xform(vects[i], rotated[i]);
+			normalized[i] = vects[i] * normalizeScale(vects[i], 2.f);
+			Vect3f v = i % 2 ? points[i] : directions[i];
+			points4[i].set(v.x, v.y, v.z, vects4[i].w);
+			products[i].mult(X, matrices[i]);
+			pairProducts[i].mult(matrices[i], matrices2[i]);
+		}
+
+		for (int set = BATCH_SCALAR; set <= BATCH_AVX; ++set) {
+			if (setBatchInstructionSet(BatchInstructionSet(set)) != set)
+				continue;
+
+			vector<Vect3f> result(COUNT);
+			xformPoints(X, &vects[0], &result[0], COUNT);
+			CHECK_EQUAL(0, mismatches(&result[0].x, &points[0].x, COUNT * 3));
+			xformVects(X, &vects[0], &result[0], COUNT);
+			CHECK_EQUAL(0, mismatches(&result[0].x, &directions[0].x, COUNT * 3));
+			rotateVects(q, &vects[0], &result[0], COUNT);
+			CHECK_EQUAL(0, mismatches(&result[0].x, &rotated[0].x, COUNT * 3));
+			result = vects;
+			normalizeVects(&result[0], COUNT, 2.f);
+			CHECK_EQUAL(0, mismatches(&result[0].x, &normalized[0].x, COUNT * 3));
+
+			vector<Vect4f> result4(COUNT);
+			xformPoints(X, &vects4[0], &result4[0], COUNT);
+			CHECK_EQUAL(0, mismatches(&result4[0].x, &points4[0].x, COUNT * 4));
+
+			vector<MatXf> resultMatrices(COUNT);
+			multMatrices(X, &matrices[0], &resultMatrices[0], COUNT);
+			CHECK_EQUAL(0, mismatches(&resultMatrices[0].R.xx, &products[0].R.xx, COUNT * 12));
+			multMatrices(&matrices[0], &matrices2[0], &resultMatrices[0], COUNT);
+			CHECK_EQUAL(0, mismatches(&resultMatrices[0].R.xx, &pairProducts[0].R.xx, COUNT * 12));
+
+			SoAVectors source(vects);
+			SoAVectors soa(COUNT);
+			xformPoints(X, source.view(), soa.view(), COUNT);
+			CHECK_EQUAL(0, mismatches(&soa.vects()[0].x, &points[0].x, COUNT * 3));
+			xformVects(X, source.view(), soa.view(), COUNT);
+			CHECK_EQUAL(0, mismatches(&soa.vects()[0].x, &directions[0].x, COUNT * 3));
+			rotateVects(q, source.view(), soa.view(), COUNT);
+			CHECK_EQUAL(0, mismatches(&soa.vects()[0].x, &rotated[0].x, COUNT * 3));
+			// in place
+			normalizeVects(source.view(), COUNT, 2.f);
+			CHECK_EQUAL(0, mismatches(&source.vects()[0].x, &normalized[0].x, COUNT * 3));
+		}
+		setBatchInstructionSet(BATCH_AVX);
+	}
+}
@@ -0,0 +1,157 @@
+#include "UnitTest++.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "XMath/xmath.h"
+#include "XMath/XMathSoA.h"
+#include "yasli/BinArchive.h"
+#include "yasli/JSONIArchive.h"
+#include "yasli/JSONOArchive.h"
+
+using std::vector;
+using std::string;
+using namespace yasli;
+
+namespace {
+
+const size_t COUNT = 1027;
+
+float randomFloat()
+{
+	return float(rand()) / float(RAND_MAX) * 20.f - 10.f;
+}
+
+Vect3f randomVect()
+{
+	return Vect3f(randomFloat(), randomFloat(), randomFloat());
+}
+
+MatXf randomMatrix()
+{
+	MatXf m;
+	float* p = &m.R.xx;
+	for (int i = 0; i < 12; ++i)
+		p[i] = randomFloat();
+	return m;
+}
+
+// number of floats that differ from expected ones, bit to bit
+int mismatches(const float* values, const float* expected, size_t count)
+{
+	int result = 0;
+	for (size_t i = 0; i < count; ++i)
+		if (memcmp(&values[i], &expected[i], sizeof(float)) != 0)
+			++result;
+	return result;
+}
+
+// Vect3f has no operator==
+bool same(const Vect3f& a, const Vect3f& b)
+{
+	return mismatches(&a.x, &b.x, 3) == 0;
+}
+
+}
+
+SUITE(XMathSoA)
+{
+	TEST(SoAVect3fElements)
+	{
+		SoAVect3f vects(2, Vect3f(1.f, 2.f, 3.f));
+		vects.push_back(Vect3f(4.f, 5.f, 6.f));
+		vects[0] = Vect3f(7.f, 8.f, 9.f);
+		vects[1] = vects[2];
+		CHECK_EQUAL(3, int(vects.size()));
+		const SoAVect3f& constVects = vects;
+		CHECK(same(constVects[0], Vect3f(7.f, 8.f, 9.f)));
+		CHECK(same(constVects[1], Vect3f(4.f, 5.f, 6.f)));
+		CHECK(same(vects[2], Vect3f(4.f, 5.f, 6.f)));
+		CHECK_EQUAL(8.f, vects.y()[0]);
+		vects.clear();
+		CHECK(vects.empty());
+	}
+
+	TEST(SoAMatchesArrayOfStructures)
+	{
+		srand(46);
+		MatXf X = randomMatrix();
+		SoAVect3f vects;
+		SoAMatXf matrices;
+		vector<Vect3f> points(COUNT);
+		vector<MatXf> products(COUNT);
+		for (size_t i = 0; i < COUNT; ++i) {
+			Vect3f v = randomVect();
+			vects.push_back(v);
+			X.xformPoint(v, points[i]);
+			MatXf m = randomMatrix();
+			matrices.push_back(m);
+			products[i].mult(X, m);
+		}
+
+		xformPoints(X, vects.view(), vects.view(), vects.size());
+		int different = 0;
+		for (size_t i = 0; i < COUNT; ++i)
+			different += !same(vects[i], points[i]);
+		CHECK_EQUAL(0, different);
+
+		multMatrices(X, matrices, matrices);
+		different = 0;
+		for (size_t i = 0; i < COUNT; ++i) {
+			MatXf m = matrices[i];
+			different += mismatches(&m.R.xx, &products[i].R.xx, 12) != 0;
+		}
+		CHECK_EQUAL(0, different);
+	}
+
+	TEST(SoASaveAndLoad)
+	{
+		srand(47);
+		SoAVect3f vects;
+		SoAMatXf matrices;
+		for (int i = 0; i < 100; ++i) {
+			vects.push_back(randomVect());
+			matrices.push_back(randomMatrix());
+		}
+
+		BinOArchive oa;
+		CHECK(oa(vects, "vects"));
+		CHECK(oa(matrices, "matrices"));
+		SoAVect3f binaryVects;
+		SoAMatXf binaryMatrices;
+		BinIArchive ia;
+		CHECK(ia.open(oa.buffer(), oa.length()));
+		CHECK(ia(binaryVects, "vects"));
+		CHECK(ia(binaryMatrices, "matrices"));
+
+		JSONOArchive joa;
+		CHECK(joa(vects, "vects"));
+		CHECK(joa(matrices, "matrices"));
+		string text = joa.c_str();
+		SoAVect3f textVects;
+		SoAMatXf textMatrices;
+		JSONIArchive jia;
+		CHECK(jia.open(text.c_str(), text.size()));
+		CHECK(jia(textVects, "vects"));
+		CHECK(jia(textMatrices, "matrices"));
+
+		CHECK_EQUAL(100, int(binaryVects.size()));
+		CHECK_EQUAL(100, int(binaryMatrices.size()));
+		CHECK_EQUAL(100, int(textVects.size()));
+		CHECK_EQUAL(100, int(textMatrices.size()));
+		// binary archives keep floats as they are, JSON has 6 significant digits
+		int different = 0;
+		for (size_t i = 0; i < vects.size(); ++i) {
+			different += !same(vects[i], binaryVects[i]);
+			different += !Vect3f(vects[i]).eq(textVects[i], 1e-4f);
+			for (int c = 0; c < SoAMatXf::COMPONENTS; ++c) {
+				SoAMatXf::Component component = SoAMatXf::Component(c);
+				different += matrices.component(component)[i] != binaryMatrices.component(component)[i];
+				different += fabsf(matrices.component(component)[i] - textMatrices.component(component)[i]) > 1e-4f;
+			}
+		}
+		CHECK_EQUAL(0, different);
+	}
+}
@@ -33,6 +33,40 @@ EnumDescription& getEnumDescription();
 template <class Enum>
 bool serializeEnum(const EnumDescription& desc, Archive& ar, Enum& value, const char* name, const char* label);
 
+namespace Helpers{
+
+inline unsigned int generateContextSlot()
+{
+	static std::atomic<unsigned int> counter(0);
+	return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<class T>
+struct ContextSlot{
+	// slot index + 1, zero until the type is used as a context for the first time
+	static std::atomic<unsigned int> index;
+};
+
+template<class T>
+std::atomic<unsigned int> ContextSlot<T>::index;
+
+// Dense per-type index into Archive::contextSlots_. A slot may be wasted
+// when two threads assign it to the same type at once, that is harmless.
+template<class T>
+unsigned int contextSlot()
+{
+	unsigned int index = ContextSlot<T>::index.load(std::memory_order_relaxed);
+	if (!index) {
+		unsigned int expected = 0;
+		index = generateContextSlot() + 1;
+		if (!ContextSlot<T>::index.compare_exchange_strong(expected, index, std::memory_order_relaxed))
+			index = expected;
+	}
+	return index - 1;
+}
+
+}
+
 // Context is used to pass arguments to nested serialization functions.
 // Example of usage:
 //
@@ -49,15 +83,18 @@ bool serializeEnum(const EnumDescription& desc, Archive& ar, Enum& value, const
 //   }
 // }
 //
-// You may have multiple contexts of different types, but note that the context
-// lookup complexity is O(n) in respect to number of contexts.
+// You may have multiple contexts of different types. Lookup takes constant
+// time for the first YASLI_CONTEXT_SLOTS context types used in the program
+// and is linear in respect to number of contexts for the rest.
 struct Context {
 	void* object;
 	TypeID type;
 	Context* previousContext;
 	Archive* archive;
+	unsigned int slot;
+	Context* previousInSlot;
 
-	Context() : object(0), previousContext(0) {}
+	Context() : object(0), previousContext(0), archive(0), slot(~0u), previousInSlot(0) {}
 	template<class T>
 	void set(T* object);
 	template<class T>
@@ -85,6 +122,8 @@ public:
 	, caps_(caps)
 	, filter_(YASLI_DEFAULT_FILTER)
 	{
+		for (int i = 0; i < YASLI_CONTEXT_SLOTS; ++i)
+			contextSlots_[i] = 0;
 	}
 	virtual ~Archive() {}
 
@@ -138,20 +177,48 @@ public:
 
 	template<class T>
 	T* context() const {
+		unsigned int slot = Helpers::contextSlot<T>();
+		if (slot < YASLI_CONTEXT_SLOTS) {
+			Context* current = contextSlots_[slot];
+			return current ? (T*)current->object : 0;
+		}
 		TypeID type = TypeID::get<T>();
 		for (Context* current = lastContext_; current != 0; current = current->previousContext)
 			if (current->type == type)
 				return (T*)current->object;
 		return 0;
 	}
+	// Replaces whole list of contexts, e.g. to pass contexts to a nested archive.
 	Context* setLastContext(Context* context) {
 		Context* previousContext = lastContext_;
 		lastContext_ = context;
+		for (int i = 0; i < YASLI_CONTEXT_SLOTS; ++i)
+			contextSlots_[i] = 0;
+		for (Context* current = context; current != 0; current = current->previousContext)
+			if (current->slot < YASLI_CONTEXT_SLOTS && !contextSlots_[current->slot])
+				contextSlots_[current->slot] = current;
 		return previousContext;
 	}
 	Context* lastContext() const{ return lastContext_; }
+
+	void pushContext(Context* context) {
+		context->previousContext = lastContext_;
+		lastContext_ = context;
+		if (context->slot < YASLI_CONTEXT_SLOTS) {
+			context->previousInSlot = contextSlots_[context->slot];
+			contextSlots_[context->slot] = context;
+		}
+	}
+	void popContext(Context* context) {
+		YASLI_ASSERT(lastContext_ == context && "Contexts should be destroyed in reverse order");
+		lastContext_ = context->previousContext;
+		if (context->slot < YASLI_CONTEXT_SLOTS)
+			contextSlots_[context->slot] = context->previousInSlot;
+	}
 protected:
 	Context* lastContext_;
+	// most recent context for each context type, indexed by Helpers::contextSlot<T>()
+	Context* contextSlots_[YASLI_CONTEXT_SLOTS];
 	int caps_;
 
 private:
@@ -196,16 +263,16 @@ Context::Context(Archive& ar, T* context) {
 	archive = &ar;
 	object = (void*)context;
 	type = TypeID::get<T>();
-	if (archive)
-		previousContext = ar.setLastContext(this);
-	else
-		previousContext = 0;
+	slot = Helpers::contextSlot<T>();
+	previousInSlot = 0;
+	ar.pushContext(this);
 }
 
 template<class T>
 Context::Context(T* context) {
     archive = 0;
     previousContext = 0;
+    previousInSlot = 0;
     set<T>(context);
 }
 
@@ -213,11 +280,12 @@ template<class T>
 void Context::set(T* object) {
 	this->object = (void*)object;
 	type = TypeID::get<T>();
+	slot = Helpers::contextSlot<T>();
 }
 
 inline Context::~Context() {
 	if (archive)
-		archive->setLastContext(previousContext);
+		archive->popContext(this);
 }
 
 template<class T>
@@ -59,7 +59,7 @@ bool BinOArchive::save(const char* filename)
     return true;
 }
 
-inline void BinOArchive::openNode(const char* name, bool size8)
+void BinOArchive::openNode(const char* name, bool size8)
 {
 #ifdef YASLI_BIN_ARCHIVE_CHECK_EMPTY_NAME_MIX
 	YASLI_ASSERT(blockTypes_.back() == UNDEFINED || blockTypes_.back() == (!strlen(name) ? POD : NON_POD), "Mixing empty and non-empty names is dangerous for BinArchives");
@@ -79,7 +79,7 @@ inline void BinOArchive::openNode(const char* name, bool size8)
 		stream_.write((unsigned short)0); 
 }
 
-inline void BinOArchive::closeNode(const char* name, bool size8)
+void BinOArchive::closeNode(const char* name, bool size8)
 {
 #ifdef YASLI_BIN_ARCHIVE_CHECK_EMPTY_NAME_MIX
 	blockTypes_.pop_back();
@@ -119,10 +119,7 @@ inline void BinOArchive::closeNode(const char* name, bool size8)
 
 bool BinOArchive::operator()(bool& value, const char* name, const char* label)
 {
-	openNode(name);
-	stream_.write(value);
-	closeNode(name);
-	return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(StringInterface& value, const char* name, const char* label)
@@ -147,90 +144,57 @@ bool BinOArchive::operator()(WStringInterface& value, const char* name, const ch
 
 bool BinOArchive::operator()(float& value, const char* name, const char* label)
 {
-    openNode(name);
-	stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(double& value, const char* name, const char* label)
 {
-    openNode(name);
-	stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(i16& value, const char* name, const char* label)
 {
-    openNode(name);
-	stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(i8& value, const char* name, const char* label)
 {
-    openNode(name);
-	stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(u8& value, const char* name, const char* label)
 {
-    openNode(name);
-	stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(char& value, const char* name, const char* label)
 {
-    openNode(name);
-	stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(u16& value, const char* name, const char* label)
 {
-    openNode(name);
-	stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(i32& value, const char* name, const char* label)
 {
-    openNode(name);
-	stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(u32& value, const char* name, const char* label)
 {
-    openNode(name);
-	stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(i64& value, const char* name, const char* label)
 {
-    openNode(name);
-    stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(u64& value, const char* name, const char* label)
 {
-    openNode(name);
-    stream_.write(value);
-    closeNode(name);
-    return true;
+	return writeValue(value, name);
 }
 
 bool BinOArchive::operator()(const Serializer& ser, const char* name, const char* label)
@@ -241,45 +205,75 @@ bool BinOArchive::operator()(const Serializer& ser, const char* name, const char
     return true;
 }
 
-bool BinOArchive::operator()(ContainerInterface& ser, const char* name, const char* label)
+bool BinOArchive::openContainer(const char* name, size_t& size)
 {
 	openNode(name, false);
 
-	unsigned int size = (unsigned int)ser.size();
-	if(size < SIZE16)
-		stream_.write((unsigned char)size);
-	else if(size < 0x10000){
+	unsigned int size32 = (unsigned int)size;
+	if(size32 < SIZE16)
+		stream_.write((unsigned char)size32);
+	else if(size32 < 0x10000){
 		stream_.write(SIZE16);
-		stream_.write((unsigned short)size);
+		stream_.write((unsigned short)size32);
 	}
 	else{
 		stream_.write(SIZE32);
-		stream_.write(size);
+		stream_.write(size32);
 	}
+	return true;
+}
+
+void BinOArchive::closeContainer(const char* name)
+{
+	closeNode(name, false);
+}
+
+// Numbers that are written as they are in memory when they have no name,
+// so unnamed elements of ContainerInterface::arrayData can be copied at once.
+static size_t arrayElementSize(const TypeID& type)
+{
+#ifdef YASLI_BIN_ARCHIVE_CHECK_EMPTY_NAME_MIX
+	return 0;
+#else
+	if(type == TypeID::get<float>() || type == TypeID::get<i32>() || type == TypeID::get<u32>())
+		return 4;
+	if(type == TypeID::get<double>() || type == TypeID::get<i64>() || type == TypeID::get<u64>())
+		return 8;
+	if(type == TypeID::get<i16>() || type == TypeID::get<u16>())
+		return 2;
+	if(type == TypeID::get<char>() || type == TypeID::get<i8>() || type == TypeID::get<u8>())
+		return 1;
+	return 0;
+#endif
+}
+
+bool BinOArchive::operator()(ContainerInterface& ser, const char* name, const char* label)
+{
+	size_t size = ser.size();
+	openContainer(name, size);
 
 	if(strlen(name)){
 		if(size > 0){
 			int i = 0;
 			do {
 				char buffer[16];
-#ifdef _MSC_VER
-				_itoa(i++, buffer, 10);
-#else
-				sprintf(buffer, "%d", i++);
-#endif
+				Helpers::formatIndex(buffer, i++);
 				ser(*this, buffer, "");
 			} while (ser.next());
 		}
-
-		closeNode(name, false);
 	}
-	else{
-		if(size > 0)
+	else if(size > 0){
+		void* data = ser.arrayData();
+		size_t elementSize = data ? arrayElementSize(ser.elementType()) : 0;
+		if(elementSize)
+			stream_.write(data, size * elementSize);
+		else
 			do 
 				ser(*this, "", "");
 				while (ser.next());
 	}
 
+	closeContainer(name);
     return true;
 }
 
@@ -389,17 +383,7 @@ void BinIArchive::closeNode(const char* name, bool check)
 
 bool BinIArchive::operator()(bool& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(StringInterface& value, const char* name, const char* label)
@@ -442,168 +426,58 @@ bool BinIArchive::operator()(WStringInterface& value, const char* name, const ch
 
 bool BinIArchive::operator()(float& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(double& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(i16& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(u16& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 
 bool BinIArchive::operator()(i32& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(u32& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(i64& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(u64& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(i8& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(u8& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(char& value, const char* name, const char* label)
 {
-	if(!strlen(name)){
-		read(value);
-		return true;
-	}
-
-	if(!openNode(name))
-		return false;
-
-	read(value);
-	closeNode(name);
-	return true;
+	return readValue(value, name);
 }
 
 bool BinIArchive::operator()(const Serializer& ser, const char* name, const char* label)
@@ -621,26 +495,31 @@ bool BinIArchive::operator()(const Serializer& ser, const char* name, const char
 	return true;
 }
 
-bool BinIArchive::operator()(ContainerInterface& ser, const char* name, const char* label)
+bool BinIArchive::openContainer(const char* name, size_t& size)
 {
-	if(strlen(name)){
+	if(*name){
 		if(!openNode(name))
 			return false;
-
 		currentBlock().setDisableCheck();
+	}
+	size = currentBlock().readPackedSize();
+	return true;
+}
+
+bool BinIArchive::operator()(ContainerInterface& ser, const char* name, const char* label)
+{
+	if(strlen(name)){
+		size_t size = 0;
+		if(!openContainer(name, size))
+			return false;
 
-		size_t size = currentBlock().readPackedSize();
 		ser.resize(size);
 
 		if(size > 0){
 			int i = 0;
 			do{
 				char buffer[16];
-#ifdef _MSC_VER
-				_itoa(i++, buffer, 10);
-#else
-				sprintf(buffer, "%d", i++);
-#endif
+				Helpers::formatIndex(buffer, i++);
 				ser(*this, buffer, "");
 			}
 			while(ser.next());
@@ -652,9 +531,14 @@ bool BinIArchive::operator()(ContainerInterface& ser, const char* name, const ch
 		size_t size = currentBlock().readPackedSize();
 		ser.resize(size);
 		if(size > 0){
-			do
-				ser(*this, "", "");
-				while(ser.next());
+			void* data = ser.arrayData();
+			size_t elementSize = data ? arrayElementSize(ser.elementType()) : 0;
+			if(elementSize)
+				currentBlock().read(data, int(size * elementSize));
+			else
+				do
+					ser(*this, "", "");
+					while(ser.next());
 		}
 		return true;
 	}
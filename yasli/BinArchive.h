@@ -106,8 +106,30 @@ public:
 
 	using Archive::operator();
 
+	// Non-virtual entry points used by StaticArchive<BinOArchive>, see yasli/StaticArchive.h
+	template<class T>
+	bool primitive(T& value, const char* name) { return writeValue(value, name); }
+	bool openStruct(const char* name) { openNode(name, false); return true; }
+	void closeStruct(const char* name) { closeNode(name, false); }
+	bool openContainer(const char* name, size_t& size);
+	void closeContainer(const char* name);
+
 private:
-	void openContainer(const char* name, int size, const char* typeName);
+	template<class T>
+	bool writeValue(const T& value, const char* name)
+	{
+#ifndef YASLI_BIN_ARCHIVE_CHECK_EMPTY_NAME_MIX
+		if(!*name){
+			stream_.write(value);
+			return true;
+		}
+#endif
+		openNode(name);
+		stream_.write(value);
+		closeNode(name);
+		return true;
+	}
+
 	void openNode(const char* name, bool size8 = true);
 	void closeNode(const char* name, bool size8 = true);
 
@@ -155,6 +177,14 @@ public:
 
 	using Archive::operator();
 
+	// Non-virtual entry points used by StaticArchive<BinIArchive>, see yasli/StaticArchive.h
+	template<class T>
+	bool primitive(T& value, const char* name) { return readValue(value, name); }
+	bool openStruct(const char* name) { return !*name || openNode(name); }
+	void closeStruct(const char* name) { if(*name) closeNode(name, false); }
+	bool openContainer(const char* name, size_t& size);
+	void closeContainer(const char* name) { if(*name) closeNode(name); }
+
 private:
 	class Block
 	{
@@ -244,6 +274,21 @@ private:
 	Block& currentBlock() { return blocks_.back(); }
 	template<class T>
 	void read(T& t) { currentBlock().read(t); }
+	template<class T>
+	bool readValue(T& value, const char* name)
+	{
+		if(!*name){
+			read(value);
+			return true;
+		}
+
+		if(!openNode(name))
+			return false;
+
+		read(value);
+		closeNode(name);
+		return true;
+	}
 };
 
 }
@@ -38,6 +38,12 @@
 #define YASLI_STD_PAIR_FIRST_SECOND 0
 #endif
 
+// Number of context types with constant-time Archive::context<T>() lookup.
+// Types beyond this limit are looked up by walking list of contexts.
+#ifndef YASLI_CONTEXT_SLOTS
+#define YASLI_CONTEXT_SLOTS 32
+#endif
+
 #ifdef _DEBUG
 // BinArchives use short hash of name to compact and speed up. Collision on particular level of hierarchy could cause to wrong result.
 //#define YASLI_BIN_ARCHIVE_CHECK_HASH_COLLISION 
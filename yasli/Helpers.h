@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 namespace yasli{
 
 class Archive;
@@ -69,6 +71,43 @@ public:
     enum{ value = (sizeof(function_helper<T>(0)) == sizeof(YesType))};
 };
 
+// Whether container C has resize(size_type) and reserve(size_type)
+template<class C>
+struct HasResize{
+private:
+    struct NoType{ char dummy; };
+    struct YesType{ char dummy[100]; };
+
+    template<class U, void (U::*)(typename U::size_type)>
+    struct Method{};
+
+    template<class U>
+    static YesType function_helper(Method<U, &U::resize>*);
+
+    template<class U>
+    static NoType function_helper(...);
+public:
+    enum{ value = (sizeof(function_helper<C>(0)) == sizeof(YesType))};
+};
+
+template<class C>
+struct HasReserve{
+private:
+    struct NoType{ char dummy; };
+    struct YesType{ char dummy[100]; };
+
+    template<class U, void (U::*)(typename U::size_type)>
+    struct Method{};
+
+    template<class U>
+    static YesType function_helper(Method<U, &U::reserve>*);
+
+    template<class U>
+    static NoType function_helper(...);
+public:
+    enum{ value = (sizeof(function_helper<C>(0)) == sizeof(YesType))};
+};
+
 template<int Size, class S8, class S16, class S32, class S64>
 struct SelectIntSize {};
 template<class S8, class S16, class S32, class S64> struct SelectIntSize<1, S8, S16, S32, S64> { typedef S8 type; };
@@ -83,6 +122,20 @@ template<> struct IsSigned<signed int> { enum { value = true }; };
 template<> struct IsSigned<signed long> { enum { value = true }; };
 template<> struct IsSigned<signed long long> { enum { value = true }; };
 
+// Formats container element index the same way as sprintf("%d") does.
+inline void formatIndex(char (&buffer)[16], size_t index)
+{
+	char digits[16];
+	int count = 0;
+	do{
+		digits[count++] = char('0' + index % 10);
+		index /= 10;
+	}while(index && count < 15);
+	for(int i = 0; i < count; ++i)
+		buffer[i] = digits[count - 1 - i];
+	buffer[count] = '\0';
+}
+
 }
 }
 
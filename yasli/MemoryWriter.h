@@ -10,6 +10,7 @@
 #pragma once
 
 #include <cstddef>
+#include <string.h>
 #include "Pointers.h"
 
 #ifdef realloc
@@ -47,7 +48,13 @@ public:
 	// Binary interface (does not writes trailing '\0')
 	template<class T>
 	void write(const T& value){
-		write(&value, sizeof(value));
+		// inlined fast path for the common case when the value fits
+		if(size_ - position() > sizeof(value)){
+			memcpy(position_, &value, sizeof(value));
+			position_ += sizeof(value);
+		}
+		else
+			write(&value, sizeof(value));
 	}
 	void write(char c);
 	void write(const char* str);
@@ -11,7 +11,12 @@
 
 #include <vector>
 #include <list>
+#include <deque>
+#include <array>
 #include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <algorithm>
 
 #include "yasli/Serializer.h"
@@ -19,6 +24,16 @@
 
 namespace yasli{ class Archive; }
 
+// Other sequences with STL-compatible interface, e.g. small vectors, can be
+// serialized with ContainerSTL from STLImpl.h:
+//
+// template<class T, unsigned N>
+// bool serialize(yasli::Archive& ar, SmallVector<T, N>& container, const char* name, const char* label)
+// {
+//   yasli::ContainerSTL<SmallVector<T, N>, T> ser(&container);
+//   return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
+// }
+
 namespace std{ // not nice, but needed for argument-dependent lookup to work
 
 template<class T, class Alloc>
@@ -27,9 +42,30 @@ bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::vector<T, Alloc>& contain
 template<class T, class Alloc>
 bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::list<T, Alloc>& container, const char* name, const char* label);
 
+template<class T, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::deque<T, Alloc>& container, const char* name, const char* label);
+
+template<class T, size_t Size>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::array<T, Size>& container, const char* name, const char* label);
+
 template<class K, class V, class C, class Alloc>
 bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::map<K, V, C, Alloc>& container, const char* name, const char* label);
 
+template<class K, class V, class C, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::multimap<K, V, C, Alloc>& container, const char* name, const char* label);
+
+template<class K, class C, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::set<K, C, Alloc>& container, const char* name, const char* label);
+
+template<class K, class C, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::multiset<K, C, Alloc>& container, const char* name, const char* label);
+
+template<class K, class V, class H, class E, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::unordered_map<K, V, H, E, Alloc>& container, const char* name, const char* label);
+
+template<class K, class H, class E, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::unordered_set<K, H, E, Alloc>& container, const char* name, const char* label);
+
 bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::string& value, const char* name, const char* label);
 bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::wstring& value, const char* name, const char* label);
 
@@ -10,6 +10,9 @@
 #pragma once
 
 #include <list>
+#include <string>
+#include <vector>
+#include <type_traits>
 #include "yasli/Archive.h"
 #include "yasli/Serializer.h"
 #include "yasli/KeyValue.h"
@@ -28,23 +31,28 @@ public:
 		YASLI_ASSERT(container_ != 0);
 	}
 
-	template<class T, class A>
-	void resizeHelper(size_t _size, std::vector<T, A>& _v) const
-	{
-		_v.resize( _size );
-	}
+	// Containers with resize() (vector, deque, list, small vectors) are
+	// resized at once, others grow and shrink element by element.
+	template<class C, bool hasResize = Helpers::HasResize<C>::value>
+	struct Resize{
+		static void invoke(C& container, size_t size){
+			container.resize(size);
+		}
+	};
 
-	void resizeHelper(size_t _size, ...) const
-	{
-		while(container_->size() > _size)
-		{
-			typename Container::iterator it = container_->end();
-			--it;
-			container_->erase(it);
+	template<class C>
+	struct Resize<C, false>{
+		static void invoke(C& container, size_t size){
+			while(container.size() > size)
+			{
+				typename C::iterator it = container.end();
+				--it;
+				container.erase(it);
+			}
+			while(container.size() < size)
+				container.insert(container.end(), Element());
 		}
-		while(container_->size() < _size)
-			container_->insert(container_->end(), Element());
-	}
+	};
 
 	// from ContainerInterface
 	size_t size() const{
@@ -53,13 +61,31 @@ public:
 	}
 	size_t resize(size_t size){
 		YASLI_ESCAPE(container_ != 0, return 0);
-		resizeHelper(size, container_);
+		Resize<Container>::invoke(*container_, size);
 		it_ = container_->begin();
 		size_ = size;
 		return size;
 	}
 
+	// std::vector of numbers (but not of bools) keeps them in a plain array
+	template<class E, class A>
+	static typename std::enable_if<std::is_arithmetic<E>::value && !std::is_same<E, bool>::value, void*>::type
+	arrayDataHelper(std::vector<E, A>& container, int)
+	{
+		return container.empty() ? 0 : &container[0];
+	}
+
+	template<class C>
+	static void* arrayDataHelper(C& container, ...)
+	{
+		return 0;
+	}
+
 	void* pointer() const{ return reinterpret_cast<void*>(container_); }
+	void* arrayData() const{
+		YASLI_ESCAPE(container_ != 0, return 0);
+		return arrayDataHelper(*container_, 0);
+	}
 	TypeID elementType() const{ return TypeID::get<Element>(); }
 	TypeID containerType() const{ return TypeID::get<Container>(); }
 
@@ -102,6 +128,192 @@ protected:
 	size_t size_;
 };/*}}}*/
 
+
+// Fields of std::pair, shared by maps on input and on output.
+template<class K, class V>
+void serializeStdPairFields(Archive& ar, K& first, V& second)
+{
+#if YASLI_STD_PAIR_FIRST_SECOND
+	ar(first, "first", "^");
+	ar(second, "second", "^");
+#else
+	ar(first, "key");
+	ar(second, "value");
+#endif
+}
+
+// Elements of maps and sets on output. Keys are const within the container,
+// they are passed to the archive by const reference, which output archives
+// do not change; strings are read through StringInterface. Values of maps
+// are serialized in place. The format is the one of std::pair<K, V> and K.
+template<class K, class V>
+struct StdPairOutput
+{
+	StdPairOutput(const K& key, V& value) : key_(key), value_(value) {}
+	void YASLI_SERIALIZE_METHOD(Archive& ar)
+	{
+		serializeStdPairFields(ar, key_, value_);
+	}
+	const K& key_;
+	V& value_;
+};
+
+template<class V>
+struct StdStringPairOutput : KeyValueInterface
+{
+	StdStringPairOutput(const std::string& key, V& value) : key_(key), value_(value) {}
+	const char* get() const { return key_.c_str(); }
+	void set(const char* key) { YASLI_ASSERT(0 && "Key of a map element can not be changed on output"); }
+	bool serializeValue(Archive& ar, const char* name, const char* label) { return ar(value_, name, label); }
+	const std::string& key_;
+	V& value_;
+};
+
+class ConstStringSTL : public StringInterface
+{
+public:
+	ConstStringSTL(const std::string& str) : str_(str) {}
+	void set(const char* value) { YASLI_ASSERT(0 && "Element of a set can not be changed on output"); }
+	const char* get() const { return str_.c_str(); }
+private:
+	const std::string& str_;
+};
+
+template<class K, class V>
+bool serializeAssociativeElement(Archive& ar, std::pair<const K, V>& element, const char* name, const char* label)
+{
+	StdPairOutput<K, V> pair(element.first, element.second);
+	return ar(pair, name, label);
+}
+
+template<class V>
+bool serializeAssociativeElement(Archive& ar, std::pair<const std::string, V>& element, const char* name, const char* label)
+{
+	StdStringPairOutput<V> keyValue(element.first, element.second);
+	return ar(static_cast<KeyValueInterface&>(keyValue), name, label);
+}
+
+template<class K>
+bool serializeAssociativeElement(Archive& ar, const K& element, const char* name, const char* label)
+{
+	return ar(element, name, label);
+}
+
+inline bool serializeAssociativeElement(Archive& ar, const std::string& element, const char* name, const char* label)
+{
+	ConstStringSTL str(element);
+	return ar(static_cast<StringInterface&>(str), name, label);
+}
+
+// Adapter for maps and sets. Elements are serialized in place on output (see
+// serializeAssociativeElement) and are emplaced at the end on input, so no
+// intermediate copy of the container is made. Element is the serialized type: std::pair<K, V> for maps (same as
+// std::vector<std::pair<K, V> > which is format-compatible) and K for sets.
+template<class Container, class Element>
+class ContainerAssociativeSTL : public ContainerInterface/*{{{*/
+{
+public:
+	explicit ContainerAssociativeSTL(Container* container = 0)
+	: container_(container)
+	, it_(container->begin())
+	, loading_(false)
+	, index_(0)
+	, size_(0)
+	{
+		YASLI_ASSERT(container_ != 0);
+	}
+
+	// from ContainerInterface
+	size_t size() const{
+		YASLI_ESCAPE(container_ != 0, return 0);
+		return loading_ ? size_ : container_->size();
+	}
+	// Keys can not be assigned in place, so resize() starts loading: the
+	// container is cleared and elements are inserted as they are read.
+	size_t resize(size_t size){
+		YASLI_ESCAPE(container_ != 0, return 0);
+		// text archives call resize() after reading to trim the container
+		if(!loading_){
+			beginLoading();
+			Reserve<Container>::invoke(*container_, size);
+		}
+		size_ = size;
+		return size;
+	}
+
+	void* pointer() const{ return reinterpret_cast<void*>(container_); }
+	TypeID elementType() const{ return TypeID::get<Element>(); }
+	TypeID containerType() const{ return TypeID::get<Container>(); }
+
+	bool next()
+	{
+		if(loading_)
+			return ++index_ < size_;
+		YASLI_ESCAPE(container_ && it_ != container_->end(), return false);
+		++it_;
+		return it_ != container_->end();
+	}
+
+	// elements being loaded are not in the container yet
+	void* elementPointer() const{ return it_ != container_->end() ? (void*)&*it_ : 0; }
+
+	bool operator()(Archive& ar, const char* name, const char* label){
+		YASLI_ESCAPE(container_, return false);
+		if(ar.isInput()){
+			if(!loading_){
+				beginLoading();
+				size_ = container_->size();
+			}
+			ElementInitializer element;
+			if(!ar(element.value, name, label))
+				return false;
+			it_ = container_->emplace_hint(container_->end(), std::move(element.value));
+			return true;
+		}
+		YASLI_ESCAPE(it_ != container_->end(), return false);
+		return serializeAssociativeElement(ar, *it_, name, label);
+	}
+	operator bool() const{ return container_ != 0; }
+
+	struct ElementInitializer
+	{
+		Element value;
+		ElementInitializer() : value() {}
+	};
+	void serializeNewElement(Archive& ar, const char* name = "", const char* label = 0) const{
+		ElementInitializer element;
+		ar(element.value, name, label);
+	}
+	// ^^^
+protected:
+	// unordered containers allocate buckets once
+	template<class C, bool hasReserve = Helpers::HasReserve<C>::value>
+	struct Reserve{
+		static void invoke(C& container, size_t size){
+			container.reserve(size);
+		}
+	};
+
+	template<class C>
+	struct Reserve<C, false>{
+		static void invoke(C& container, size_t size){}
+	};
+
+	void beginLoading()
+	{
+		container_->clear();
+		it_ = container_->end();
+		loading_ = true;
+		index_ = 0;
+	}
+
+	Container* container_;
+	typename Container::iterator it_;
+	bool loading_;
+	size_t index_;
+	size_t size_;
+};/*}}}*/
+
 }
 
 namespace std{
@@ -113,6 +325,13 @@ bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::vector<T, Alloc>& contain
 	return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
 }
 
+template<class T, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::deque<T, Alloc>& container, const char* name, const char* label)
+{
+	yasli::ContainerSTL<std::deque<T, Alloc>, T> ser(&container);
+	return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
+}
+
 template<class T, class Alloc>
 bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::list<T, Alloc>& container, const char* name, const char* label)
 {
@@ -120,6 +339,13 @@ bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::list<T, Alloc>& container
 	return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
 }
 
+template<class T, size_t Size>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::array<T, Size>& container, const char* name, const char* label)
+{
+	yasli::ContainerArray<T, Size> ser(container.data());
+	return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
+}
+
 }
 
 // ---------------------------------------------------------------------------
@@ -154,13 +380,43 @@ namespace std {
 template<class K, class V, class C, class Alloc>
 bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::map<K, V, C, Alloc>& container, const char* name, const char* label)
 {
-	std::vector<std::pair<K, V> > temp(container.begin(), container.end());
-	if (!ar(temp, name, label))
-		return false;
-	
-	container.clear();
-	container.insert(temp.begin(), temp.end());
-	return true;
+	yasli::ContainerAssociativeSTL<std::map<K, V, C, Alloc>, std::pair<K, V> > ser(&container);
+	return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
+}
+
+template<class K, class V, class C, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::multimap<K, V, C, Alloc>& container, const char* name, const char* label)
+{
+	yasli::ContainerAssociativeSTL<std::multimap<K, V, C, Alloc>, std::pair<K, V> > ser(&container);
+	return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
+}
+
+template<class K, class C, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::set<K, C, Alloc>& container, const char* name, const char* label)
+{
+	yasli::ContainerAssociativeSTL<std::set<K, C, Alloc>, K> ser(&container);
+	return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
+}
+
+template<class K, class C, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::multiset<K, C, Alloc>& container, const char* name, const char* label)
+{
+	yasli::ContainerAssociativeSTL<std::multiset<K, C, Alloc>, K> ser(&container);
+	return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
+}
+
+template<class K, class V, class H, class E, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::unordered_map<K, V, H, E, Alloc>& container, const char* name, const char* label)
+{
+	yasli::ContainerAssociativeSTL<std::unordered_map<K, V, H, E, Alloc>, std::pair<K, V> > ser(&container);
+	return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
+}
+
+template<class K, class H, class E, class Alloc>
+bool YASLI_SERIALIZE_OVERRIDE(yasli::Archive& ar, std::unordered_set<K, H, E, Alloc>& container, const char* name, const char* label)
+{
+	yasli::ContainerAssociativeSTL<std::unordered_set<K, H, E, Alloc>, K> ser(&container);
+	return ar(static_cast<yasli::ContainerInterface&>(ser), name, label);
 }
 
 }
@@ -219,13 +475,7 @@ struct StdPair : std::pair<K, V>
 {
 	void YASLI_SERIALIZE_METHOD(yasli::Archive& ar) 
 	{
-#if YASLI_STD_PAIR_FIRST_SECOND
-		ar(this->first, "first", "^");
-		ar(this->second, "second", "^");
-#else
-		ar(this->first, "key");
-		ar(this->second, "value");
-#endif
+		serializeStdPairFields(ar, this->first, this->second);
 	}
 };
 
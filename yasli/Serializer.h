@@ -110,6 +110,9 @@ public:
 	virtual bool next() = 0;
 
 	virtual void* elementPointer() const = 0;
+	// Elements as a plain array of numbers of elementType(), lets binary
+	// archives copy unnamed elements at once. 0 for other containers.
+	virtual void* arrayData() const{ return 0; }
 
 	virtual bool operator()(Archive& ar, const char* name, const char* label) = 0;
 	virtual operator bool() const = 0;
@@ -0,0 +1,181 @@
+/**
+ *  yasli - Serialization Library.
+ *  Copyright (C) 2007-2013 Evgeny Andreeshchev <eugene.andreeshchev@gmail.com>
+ *                          Alexander Kotliar <alexander.kotliar@gmail.com>
+ *
+ *  This code is distributed under the MIT License:
+ *                          http://www.opensource.org/licenses/MIT
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "yasli/Archive.h"
+#include "yasli/STL.h"
+
+namespace yasli{
+
+// StaticArchive is a statically dispatched front-end for a concrete archive
+// type. Regular serialization goes through virtual Archive::operator() for
+// every field and through the type-erased Serializer for every struct, which
+// prevents inlining. When the archive type is known at the call site and
+// serialize methods are templated on archive type, StaticArchive resolves all
+// primitives, strings, std::vectors and nested structs at compile time:
+//
+// struct Packet
+// {
+//   int id;
+//   std::vector<float> values;
+//
+//   template<class TArchive>
+//   void serialize(TArchive& ar)
+//   {
+//     ar(id, "id");
+//     ar(values, "values");
+//   }
+// };
+//
+// BinOArchive oa;
+// StaticArchive<BinOArchive> sa(oa);
+// sa(packet, "packet");
+//
+// Output is byte-to-byte identical to the one produced through Archive&,
+// so data written on one path can be read on the other. Types without
+// templated serialize method of their own (enums, pointers, non-intrusive
+// serialize overrides, serialize(Archive&) methods and methods inherited
+// from base classes) fall back to the virtual path of the underlying archive.
+// Saving benefits most: BinIArchive spends most of its time looking up named
+// fields, so loading is only marginally faster than through Archive&.
+//
+// Concrete archive has to provide following non-virtual methods:
+//   template<class T> bool primitive(T& value, const char* name);
+//   bool openStruct(const char* name);
+//   void closeStruct(const char* name);
+//   bool openContainer(const char* name, size_t& size); // reads or writes size
+//   void closeContainer(const char* name);
+// Currently these are implemented by BinOArchive and BinIArchive.
+template<class TArchive>
+class StaticArchive{
+public:
+	explicit StaticArchive(TArchive& ar) : ar_(ar) {}
+
+	TArchive& archive() const{ return ar_; }
+	operator Archive&() const{ return ar_; }
+
+	bool isInput() const{ return ar_.isInput(); }
+	bool isOutput() const{ return ar_.isOutput(); }
+	bool isEdit() const{ return ar_.isEdit(); }
+	bool caps(int caps) const{ return ar_.caps(caps); }
+	bool filter(int flags) const{ return ar_.filter(flags); }
+	void warning(const char* message){ ar_.warning(message); }
+
+	template<class T>
+	T* context() const{ return ar_.template context<T>(); }
+
+	bool operator()(bool& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(char& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(u8& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(i8& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(i16& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(u16& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(i32& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(u32& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(i64& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(u64& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(float& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+	bool operator()(double& value, const char* name = "", const char* label = 0) { return ar_.primitive(value, name); }
+
+	// Qualified calls below are not dispatched through vtable.
+	bool operator()(StringInterface& value, const char* name = "", const char* label = 0) { return ar_.TArchive::operator()(value, name, label); }
+	bool operator()(WStringInterface& value, const char* name = "", const char* label = 0) { return ar_.TArchive::operator()(value, name, label); }
+	bool operator()(std::string& value, const char* name = "", const char* label = 0)
+	{
+		StringSTL str(value);
+		return ar_.TArchive::operator()(static_cast<StringInterface&>(str), name, label);
+	}
+	bool operator()(std::wstring& value, const char* name = "", const char* label = 0)
+	{
+		WStringSTL str(value);
+		return ar_.TArchive::operator()(static_cast<WStringInterface&>(str), name, label);
+	}
+
+	template<class T, class Alloc>
+	bool operator()(std::vector<T, Alloc>& container, const char* name = "", const char* label = 0)
+	{
+		size_t size = container.size();
+		if(!ar_.openContainer(name, size))
+			return false;
+		if(container.size() != size)
+			container.resize(size);
+
+		if(*name){
+			char elementName[16];
+			for(size_t i = 0; i < size; ++i){
+				Helpers::formatIndex(elementName, i);
+				operator()(container[i], elementName, "");
+			}
+		}
+		else{
+			for(size_t i = 0; i < size; ++i)
+				operator()(container[i], "", "");
+		}
+
+		ar_.closeContainer(name);
+		return true;
+	}
+
+	template<class T>
+	bool operator()(T& value, const char* name = "", const char* label = 0)
+	{
+		return Dispatch<T, HasSerializeMethod<T>::value>::invoke(*this, value, name, label);
+	}
+
+	template<class T>
+	bool operator()(const T& value, const char* name = "", const char* label = 0)
+	{
+		return operator()(const_cast<T&>(value), name, label);
+	}
+
+private:
+	template<class T>
+	struct HasSerializeMethod{
+	private:
+		struct NoType{ char dummy; };
+		struct YesType{ char dummy[100]; };
+
+		template<class U, void (U::*)(StaticArchive&)>
+		struct Method{};
+
+		template<class U>
+		static YesType function_helper(Method<U, &U::YASLI_SERIALIZE_METHOD>*);
+		template<class U>
+		static NoType function_helper(...);
+	public:
+		enum{ value = (sizeof(function_helper<T>(0)) == sizeof(YesType)) };
+	};
+
+	template<class T, bool hasSerializeMethod>
+	struct Dispatch{
+		static bool invoke(StaticArchive& ar, T& value, const char* name, const char* label){
+			if(!ar.ar_.openStruct(name))
+				return false;
+			value.YASLI_SERIALIZE_METHOD(ar);
+			ar.ar_.closeStruct(name);
+			return true;
+		}
+	};
+
+	template<class T>
+	struct Dispatch<T, false>{
+		static bool invoke(StaticArchive& ar, T& value, const char* name, const char* label){
+			return static_cast<Archive&>(ar.ar_)(value, name, label);
+		}
+	};
+
+	TArchive& ar_;
+};
+
+}
+
+// vim: ts=4 sw=4:
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <typeinfo>
+#include <atomic>
 #include "yasli/Config.h"
 #include "yasli/Assert.h"
 #include <string.h>
@@ -229,10 +230,11 @@ struct TypeInfo
 
 	static unsigned int generateTypeID()
 	{
-		// on gcc 4.6.3: if we start this counter from the zero
-		// then the first two calls of this function returns same value
-		static unsigned int counter = 1;
-		return counter++;
+		// Types may be registered concurrently from different threads. Zero
+		// is reserved for an empty TypeID. Counter is constant-initialized,
+		// so it is usable during static initialization too.
+		static std::atomic<unsigned int> counter(1);
+		return counter.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	TypeInfo(size_t size, const char* templatedFunctionName)
@@ -243,6 +245,31 @@ struct TypeInfo
 		id.typeInfo_ = this;
 	}
 };
+
+// Per-type registration slot. Pointer is zero-initialized before any dynamic
+// initialization, so unlike function-local static it needs neither guard
+// variable nor compiler support for thread-safe statics. Lookup is a single
+// acquire load, first use publishes TypeInfo with compare-and-swap.
+template<class T>
+struct TypeInfoSlot
+{
+	static std::atomic<TypeInfo*> instance;
+
+	static TypeInfo* create(size_t size, const char* templatedFunctionName)
+	{
+		TypeInfo* typeInfo = new TypeInfo(size, templatedFunctionName);
+		TypeInfo* registered = 0;
+		if(!instance.compare_exchange_strong(registered, typeInfo, std::memory_order_acq_rel, std::memory_order_acquire)){
+			// another thread was first, its id is used everywhere
+			delete typeInfo;
+			return registered;
+		}
+		return typeInfo;
+	}
+};
+
+template<class T>
+std::atomic<TypeInfo*> TypeInfoSlot<T>::instance;
 #endif
 
 #ifdef __APPLE__
@@ -253,16 +280,19 @@ template<class T>
 TypeID TypeID::get()
 {
 #if YASLI_NO_RTTI
+	TypeInfo* typeInfo = TypeInfoSlot<T>::instance.load(std::memory_order_acquire);
+	if(!typeInfo){
 # ifdef _MSC_VER
-	static TypeInfo typeInfo(sizeof(T), __FUNCSIG__);
+		typeInfo = TypeInfoSlot<T>::create(sizeof(T), __FUNCSIG__);
 # else
 #if defined(__APPLE__)
-    static TypeInfo typeInfo(sizeof(T), funcNameHelper((T*)0));
+		typeInfo = TypeInfoSlot<T>::create(sizeof(T), funcNameHelper((T*)0));
 #else
-	static TypeInfo typeInfo(sizeof(T), __PRETTY_FUNCTION__);
+		typeInfo = TypeInfoSlot<T>::create(sizeof(T), __PRETTY_FUNCTION__);
 #endif
 # endif
-	return typeInfo.id;
+	}
+	return typeInfo->id;
 #else
 	static TypeID result(typeid(T));
 	return result;